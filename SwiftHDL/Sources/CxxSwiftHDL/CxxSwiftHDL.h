@@ -12,4 +12,80 @@ inline MLIRContext *
 MLIRContextCreate() { // NOLINT: readibility-identifier-naming
   return new MLIRContext();
 }
+/// Destroys an `MLIRContext` created by `MLIRContextCreate`
+inline void
+MLIRContextDestroy( // NOLINT: readibility-identifier-naming
+    MLIRContext *context) {
+  delete context;
+}
 } // namespace mlir
+
+namespace swift_hdl {
+/**
+ Utility methods for `BulkBuilder`
+ - note: Like `MLIRContext`, `BulkBuilder` is immovable and can only be used
+ from Swift through a pointer, so we forward its methods through free functions
+ */
+inline BulkBuilder *
+BulkBuilderCreate( // NOLINT: readibility-identifier-naming
+    mlir::MLIRContext *context) {
+  return BulkBuilder::create(context);
+}
+inline void
+BulkBuilderDestroy( // NOLINT: readibility-identifier-naming
+    BulkBuilder *builder) {
+  BulkBuilder::destroy(builder);
+}
+inline void
+BulkBuilderInternNames( // NOLINT: readibility-identifier-naming
+    BulkBuilder *builder, const char *data, const uint32_t *offsets,
+    size_t count, NameID *result) {
+  builder->internNames(data, offsets, count, result);
+}
+inline bool
+BulkBuilderBeginModule( // NOLINT: readibility-identifier-naming
+    BulkBuilder *builder, NameID name, const BulkPort *ports, size_t count) {
+  return builder->beginModule(name, ports, count);
+}
+inline bool
+BulkBuilderAppend( // NOLINT: readibility-identifier-naming
+    BulkBuilder *builder, const BulkInstruction *instructions, size_t count) {
+  return builder->append(instructions, count);
+}
+inline bool
+BulkBuilderEndModule( // NOLINT: readibility-identifier-naming
+    BulkBuilder *builder, const ValueID *outputs, size_t count) {
+  return builder->endModule(outputs, count);
+}
+inline size_t
+BulkBuilderGetNumValues( // NOLINT: readibility-identifier-naming
+    BulkBuilder *builder) {
+  return builder->getNumValues();
+}
+inline std::string
+BulkBuilderPrint( // NOLINT: readibility-identifier-naming
+    BulkBuilder *builder) {
+  return builder->print();
+}
+
+/**
+ Utility methods for building `BulkInstruction`s and `BulkPort`s
+ - note: Swift mirrors these in its own public types, which cannot expose the
+ imported C++ types, so it converts through these functions
+ */
+inline BulkInstruction
+BulkInstructionCreate( // NOLINT: readibility-identifier-naming
+    uint8_t opcode, uint32_t width, ValueID operand0, ValueID operand1,
+    ValueID operand2, NameID name, uint64_t immediate) {
+  return {static_cast<BulkOpcode>(opcode),
+          width,
+          {operand0, operand1, operand2},
+          name,
+          immediate};
+}
+inline BulkPort
+BulkPortCreate( // NOLINT: readibility-identifier-naming
+    NameID name, uint32_t width, bool isOutput, bool isClock) {
+  return {name, width, isOutput, isClock};
+}
+} // namespace swift_hdl
@@ -0,0 +1,154 @@
+@_implementationOnly import CxxSwiftHDL
+
+/// The operations a `BulkInstruction` can create, mirroring
+/// `swift_hdl::BulkOpcode`.
+public enum BulkOpcode: UInt8 {
+  /// `hw.constant` of `width` bits with the value `immediate`.
+  case constant
+  /// Binary `comb` operations on `operands.0` and `operands.1`.
+  case add, sub, mul, and, or, xor, shl, shrU
+  /// `comb.icmp` of `operands.0` and `operands.1`, producing an `i1`.
+  case icmpEq, icmpNe, icmpULT
+  /// `comb.mux` selecting `operands.1` if `operands.0` is set, and
+  /// `operands.2` otherwise.
+  case mux
+  /// `comb.concat` of `operands.0` (high bits) and `operands.1`.
+  case concat
+  /// `comb.extract` of `width` bits of `operands.0`, starting at bit
+  /// `immediate`.
+  case extract
+  /// `seq.compreg` of `width` bits clocked by `operands.0`, whose input is set
+  /// later with `registerNext`.
+  case register
+  /// Set the input of the register `operands.0` to `operands.1`. This
+  /// instruction does not produce a value.
+  case registerNext
+}
+
+/// A single operation to create with a `BulkBuilder`. Values are referred to
+/// by ID: input ports come first, followed by the results of instructions in
+/// the order they were appended.
+public struct BulkInstruction {
+  public var opcode: BulkOpcode
+  /// The bit width of the result, where the opcode does not imply it.
+  public var width: UInt32
+  public var operands: (UInt32, UInt32, UInt32)
+  /// The name of the result, or `0` for none.
+  public var name: UInt32
+  public var immediate: UInt64
+
+  public init(
+    _ opcode: BulkOpcode, width: UInt32 = 0,
+    operands: (UInt32, UInt32, UInt32) = (0, 0, 0), name: UInt32 = 0,
+    immediate: UInt64 = 0
+  ) {
+    self.opcode = opcode
+    self.width = width
+    self.operands = operands
+    self.name = name
+    self.immediate = immediate
+  }
+}
+
+/// A port of a module created by a `BulkBuilder`.
+public struct BulkPort {
+  public var name: UInt32
+  public var width: UInt32
+  public var isOutput: Bool
+  /// Whether this is a `!seq.clock` port, in which case `width` is ignored.
+  public var isClock: Bool
+
+  public init(
+    name: UInt32, width: UInt32, isOutput: Bool = false, isClock: Bool = false
+  ) {
+    self.name = name
+    self.width = width
+    self.isOutput = isOutput
+    self.isClock = isClock
+  }
+}
+
+/**
+ Builds operations through `swift_hdl::BulkBuilder`, so that names cross the
+ language boundary once and operations are created from buffers owned by Swift
+ rather than one bridged call at a time.
+ */
+public final class BulkBuilder {
+  private let context: UnsafeMutablePointer<mlir.MLIRContext>
+  private let builder: UnsafeMutablePointer<swift_hdl.BulkBuilder>
+
+  public init() {
+    context = mlir.MLIRContextCreate()
+    builder = swift_hdl.BulkBuilderCreate(context)
+  }
+
+  deinit {
+    // The builder's module lives in the context, so it goes first.
+    swift_hdl.BulkBuilderDestroy(builder)
+    mlir.MLIRContextDestroy(context)
+  }
+
+  /// Intern `names`, returning the ID of each name in order.
+  public func internNames(_ names: [String]) -> [UInt32] {
+    var storage: [CChar] = []
+    var offsets: [UInt32] = [0]
+    offsets.reserveCapacity(names.count + 1)
+    for name in names {
+      storage.append(contentsOf: name.utf8.map { CChar(bitPattern: $0) })
+      offsets.append(UInt32(storage.count))
+    }
+    var result = [UInt32](repeating: 0, count: names.count)
+    storage.withUnsafeBufferPointer { storage in
+      offsets.withUnsafeBufferPointer { offsets in
+        result.withUnsafeMutableBufferPointer { result in
+          swift_hdl.BulkBuilderInternNames(
+            builder, storage.baseAddress, offsets.baseAddress, names.count,
+            result.baseAddress)
+        }
+      }
+    }
+    return result
+  }
+
+  /// Begin a new module. Its input ports are assigned the first value IDs.
+  public func beginModule(name: UInt32, ports: [BulkPort]) -> Bool {
+    let ports = ports.map {
+      swift_hdl.BulkPortCreate($0.name, $0.width, $0.isOutput, $0.isClock)
+    }
+    return ports.withUnsafeBufferPointer { ports in
+      swift_hdl.BulkBuilderBeginModule(
+        builder, name, ports.baseAddress, ports.count)
+    }
+  }
+
+  /// Append operations to the module being built. If any instruction is
+  /// malformed, none of them are applied and this returns `false`.
+  public func append(_ instructions: [BulkInstruction]) -> Bool {
+    let instructions = instructions.map {
+      swift_hdl.BulkInstructionCreate(
+        $0.opcode.rawValue, $0.width, $0.operands.0, $0.operands.1,
+        $0.operands.2, $0.name, $0.immediate)
+    }
+    return instructions.withUnsafeBufferPointer { instructions in
+      swift_hdl.BulkBuilderAppend(
+        builder, instructions.baseAddress, instructions.count)
+    }
+  }
+
+  /// Finish the module being built, driving its output ports with `outputs`.
+  public func endModule(outputs: [UInt32]) -> Bool {
+    outputs.withUnsafeBufferPointer { outputs in
+      swift_hdl.BulkBuilderEndModule(builder, outputs.baseAddress, outputs.count)
+    }
+  }
+
+  /// The ID the next value-producing instruction will be assigned.
+  public var numValues: Int {
+    swift_hdl.BulkBuilderGetNumValues(builder)
+  }
+
+  /// Print the modules built so far.
+  public func print() -> String {
+    String(swift_hdl.BulkBuilderPrint(builder))
+  }
+}
@@ -0,0 +1,44 @@
+import SwiftHDL
+import XCTest
+
+final class BulkBuilderTests: XCTestCase {
+  func testCounter() throws {
+    let builder = BulkBuilder()
+    let names = builder.internNames(["Counter", "clock", "enable", "count", "next"])
+    let (counter, clock, enable, count, next) = (names[0], names[1], names[2], names[3], names[4])
+
+    XCTAssertTrue(
+      builder.beginModule(
+        name: counter,
+        ports: [
+          BulkPort(name: clock, width: 0, isClock: true),
+          BulkPort(name: enable, width: 1),
+          BulkPort(name: count, width: 8, isOutput: true),
+        ]))
+    XCTAssertEqual(builder.numValues, 2)
+    XCTAssertTrue(
+      builder.append([
+        BulkInstruction(.constant, width: 8, immediate: 1),
+        BulkInstruction(.register, width: 8, operands: (0, 0, 0), name: count),
+        BulkInstruction(.add, operands: (3, 2, 0), name: next),
+        BulkInstruction(.mux, operands: (1, 4, 3)),
+        BulkInstruction(.registerNext, operands: (3, 5, 0)),
+      ]))
+    XCTAssertEqual(builder.numValues, 6)
+
+    // A malformed batch is rejected as a whole.
+    XCTAssertFalse(
+      builder.append([
+        BulkInstruction(.constant, width: 8, immediate: 2),
+        BulkInstruction(.add, operands: (1, 6, 0)),
+      ]))
+    XCTAssertEqual(builder.numValues, 6)
+
+    XCTAssertTrue(builder.endModule(outputs: [3]))
+    let output = builder.print()
+    XCTAssertTrue(output.contains("hw.module @Counter("))
+    XCTAssertTrue(output.contains("%count = seq.compreg"))
+    XCTAssertTrue(output.contains("comb.add %count, %c1_i8 {sv.namehint = \"next\"}"))
+    XCTAssertFalse(output.contains("%c2_i8"))
+  }
+}
@@ -110,6 +110,7 @@ DECLARE_FIRTOOL_OPTION(CkgTestEnableName, MlirStringRef);
 DECLARE_FIRTOOL_OPTION(ExportModuleHierarchy, bool);
 DECLARE_FIRTOOL_OPTION(StripFirDebugInfo, bool);
 DECLARE_FIRTOOL_OPTION(StripDebugInfo, bool);
+DECLARE_FIRTOOL_OPTION(EmissionCacheDirectory, MlirStringRef);
 
 #undef DECLARE_FIRTOOL_OPTION
 
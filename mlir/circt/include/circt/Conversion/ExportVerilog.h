@@ -31,7 +31,9 @@ std::unique_ptr<mlir::Pass> createExportVerilogPass(llvm::raw_ostream &os);
 std::unique_ptr<mlir::Pass> createExportVerilogPass();
 
 std::unique_ptr<mlir::Pass>
-createExportSplitVerilogPass(llvm::StringRef directory = "./");
+createExportSplitVerilogPass(llvm::StringRef directory = "./",
+                             llvm::StringRef cacheDirectory = "",
+                             unsigned shardIndex = 0, unsigned numShards = 1);
 
 /// Export a module containing HW, and SV dialect code. Requires that the SV
 /// dialect is loaded in to the context.
@@ -40,9 +42,21 @@ mlir::LogicalResult exportVerilog(mlir::ModuleOp module, llvm::raw_ostream &os);
 /// Export a module containing HW, and SV dialect code, as one file per SV
 /// module. Requires that the SV dialect is loaded in to the context.
 ///
-/// Files are created in the directory indicated by \p dirname.
+/// Files are created in the directory indicated by \p dirname. If \p
+/// cacheDirname is not empty, the contents of each file are cached in that
+/// directory, keyed by a hash of the IR they are emitted from, and reused
+/// when a later run emits the same file from unchanged IR.
+///
+/// If \p numShards is greater than one, only the files assigned to shard \p
+/// shardIndex are emitted, and the file lists are only written by shard 0.
+/// Running every shard on the same IR, e.g. in separate processes, produces
+/// the same output as a single unsharded run. Each shard still needs the
+/// entire IR, so sharding divides the emission time but not the memory.
 mlir::LogicalResult exportSplitVerilog(mlir::ModuleOp module,
-                                       llvm::StringRef dirname);
+                                       llvm::StringRef dirname,
+                                       llvm::StringRef cacheDirname = "",
+                                       unsigned shardIndex = 0,
+                                       unsigned numShards = 1);
 
 } // namespace circt
 
@@ -25,11 +25,13 @@ namespace arc {
 #define GEN_PASS_DECL
 #include "circt/Dialect/Arc/ArcPasses.h.inc"
 
+std::unique_ptr<mlir::Pass> createAddDirtyFlagsPass();
 std::unique_ptr<mlir::Pass>
 createAddTapsPass(std::optional<bool> tapPorts = {},
                   std::optional<bool> tapWires = {},
                   std::optional<bool> tapNamedValues = {});
-std::unique_ptr<mlir::Pass> createAllocateStatePass();
+std::unique_ptr<mlir::Pass>
+createAllocateStatePass(std::optional<unsigned> batch = {});
 std::unique_ptr<mlir::Pass> createArcCanonicalizerPass();
 std::unique_ptr<mlir::Pass> createDedupPass();
 std::unique_ptr<mlir::Pass> createGroupResetsAndEnablesPass();
@@ -50,6 +52,8 @@ std::unique_ptr<mlir::Pass> createLowerVectorizationsPass(
 std::unique_ptr<mlir::Pass> createMakeTablesPass();
 std::unique_ptr<mlir::Pass> createMuxToControlFlowPass();
 std::unique_ptr<mlir::Pass>
+createPartitionClockTreesPass(std::optional<unsigned> numPartitions = {});
+std::unique_ptr<mlir::Pass>
 createPrintStateInfoPass(llvm::StringRef stateFile = "");
 std::unique_ptr<mlir::Pass> createSimplifyVariadicOpsPass();
 std::unique_ptr<mlir::Pass> createSplitLoopsPass();
@@ -14,13 +14,19 @@
 #ifndef CIRCT_DIALECT_LLHD_SIMULATOR_STATE_H
 #define CIRCT_DIALECT_LLHD_SIMULATOR_STATE_H
 
-#include "llvm/ADT/APInt.h"
 #include "llvm/ADT/SmallVector.h"
 #include "llvm/ADT/StringMap.h"
 
+#include <cstring>
+#include <deque>
 #include <map>
-#include <queue>
-#include <regex>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace llvm {
+class raw_ostream;
+} // namespace llvm
 
 namespace circt {
 namespace llhd {
@@ -72,47 +78,30 @@ struct SignalDetail {
   uint64_t globalIndex;
 };
 
+/// An index into the name table of the simulation state. Signal and instance
+/// names are interned once, such that they can be compared as integers.
+using NameID = unsigned;
+
 /// The simulator's internal representation of a signal.
 class Signal {
 public:
   /// Construct an "empty" signal.
-  Signal(std::string name, std::string owner)
-      : name(name), owner(owner), size(0), value(nullptr) {}
-
-  /// Construct a signal with the given name, owner and initial value.
-  Signal(std::string name, std::string owner, uint8_t *value, uint64_t size)
-      : name(name), owner(owner), size(size), value(value) {}
+  Signal(NameID name, NameID owner, bool isAnonymous)
+      : name(name), owner(owner), isAnonymous(isAnonymous), size(0),
+        value(nullptr) {}
 
   /// Default move constructor.
   Signal(Signal &&) = default;
 
-  /// Free 'value' since it is allocated using 'malloc' in the LLVM code
-  /// generated by LLHDToLLVM.
-  ~Signal();
+  bool isOwner(NameID rhs) const { return owner == rhs; };
 
-  /// Returns true if the signals match in name, owner, size and value.
-  bool operator==(const Signal &rhs) const {
-    if (owner != rhs.owner || name != rhs.name || size != rhs.size)
-      return false;
-    return std::memcmp(value, rhs.value, size);
-  }
+  NameID getOwnerID() const { return owner; }
 
-  /// Returns true if the owner name is lexically smaller than rhs's owner, or
-  /// the name is lexically smaller than rhs's name, in case they share the same
-  /// owner.
-  bool operator<(const Signal &rhs) const {
-    return (owner < rhs.owner || (owner == rhs.owner && name < rhs.name));
-  }
-
-  bool isOwner(const std::string &rhs) const { return owner == rhs; };
-
-  std::string getOwner() const { return owner; }
-
-  bool isValidSigName() const {
-    return std::regex_match(name, std::regex("(sig)?[0-9]*"));
-  }
+  /// Returns true if the signal has no name given by the user, i.e. its name
+  /// is of the form `(sig)?[0-9]*`.
+  bool isValidSigName() const { return isAnonymous; }
 
-  std::string getName() const { return name; }
+  NameID getNameID() const { return name; }
 
   uint64_t getSize() const { return size; }
 
@@ -132,7 +121,7 @@ public:
     elements.push_back(val);
   }
 
-  /// Store JIT allocated signal pointer and size.
+  /// Store signal value pointer and size. The signal does not own the value.
   void store(uint8_t *v, uint64_t s) {
     value = v;
     size = s;
@@ -192,8 +181,9 @@ public:
   std::string toHexString(unsigned) const;
 
 private:
-  std::string name;
-  std::string owner;
+  NameID name;
+  NameID owner;
+  bool isAnonymous;
   // The list of instances this signal triggers.
   std::vector<unsigned> instanceIndices;
   uint64_t size;
@@ -201,68 +191,117 @@ private:
   std::vector<std::pair<unsigned, unsigned>> elements;
 };
 
+/// A pending change to a signal. The driven value is stored in the change
+/// buffer of the slot holding the change.
+struct SignalChange {
+  unsigned signal;
+  unsigned bitOffset;
+  unsigned width;
+  // Byte offset of the value in the slot's change buffer. Since values are
+  // appended to the buffer, this also orders the changes by insertion.
+  unsigned data;
+
+  bool operator<(const SignalChange &rhs) const {
+    return signal < rhs.signal || (signal == rhs.signal && data < rhs.data);
+  }
+};
+
 /// The simulator's internal representation of one queue slot.
 struct Slot {
   /// Create a new empty slot.
   Slot(Time time) : time(time) {}
 
-  /// Returns true if the slot's time is smaller than the compared slot's time.
-  bool operator<(const Slot &rhs) const;
-
-  /// Returns true if the slot's time is greater than the compared slot's time.
-  bool operator>(const Slot &rhs) const;
-
   /// Insert a change.
-  void insertChange(int index, int bitOffset, uint8_t *bytes, unsigned width);
+  void insertChange(unsigned index, unsigned bitOffset, const uint8_t *bytes,
+                    unsigned width);
 
   /// Insert a scheduled process wakeup.
   void insertChange(unsigned inst);
 
-  // A map from signal indexes to change buffers. Makes it easy to sort the
-  // changes such that we can process one signal at a time.
-  llvm::SmallVector<std::pair<unsigned, unsigned>, 32> changes;
-  // Buffers for the signal changes.
-  llvm::SmallVector<std::pair<unsigned, llvm::APInt>, 32> buffers;
-  // The number of used change buffers in the slot.
-  size_t changesSize = 0;
+  /// Sort the changes such that all changes to the same signal are in
+  /// succession, in the order they were inserted.
+  void sortChanges();
+
+  /// Get the value driven by a change.
+  const uint8_t *getChangeData(const SignalChange &change) const {
+    return buffer.data() + change.data;
+  }
+
+  /// Reset the slot such that it can be reused, retaining its storage.
+  void clear();
+
+  llvm::SmallVector<SignalChange, 32> changes;
+  // The values driven by the changes, back to back.
+  llvm::SmallVector<uint8_t, 128> buffer;
 
   // Processes with scheduled wakeup.
   llvm::SmallVector<unsigned, 4> scheduled;
   Time time;
-  bool unused = false;
 };
 
-/// This is equivalent to and std::priorityQueue<Slot> ordered using the greater
-/// operator, which adds an insertion method to add changes to a slot.
-class UpdateQueue : public llvm::SmallVector<Slot, 8> {
-  unsigned topSlot = 0;
-  llvm::SmallVector<unsigned, 4> unused;
-
+/// The queue of pending events, implemented as a timing wheel. The slots for
+/// the real times in a window of `wheelSize` picoseconds, starting at the
+/// earliest pending event, are kept in the bucket for their real time modulo
+/// the wheel size, sorted by delta and epsilon. Finding the slot for a time in
+/// the window and popping the earliest slot thus take constant time. Slots
+/// beyond the window are kept in an ordered overflow map, and move into the
+/// wheel as the window advances. Popped slots are recycled, such that a
+/// simulation in steady state schedules events without allocating memory.
+class UpdateQueue {
 public:
-  /// Check wheter a slot for the given time already exists. If that's the case,
-  /// add the new change to it, else create a new slot and push it to the queue.
-  void insertOrUpdate(Time time, int index, int bitOffset, uint8_t *bytes,
-                      unsigned width);
-
-  /// Check wheter a slot for the given time already exists. If that's the case,
-  /// add the scheduled wakeup to it, else create a new slot and push it to the
-  /// queue.
+  static constexpr uint64_t wheelSize = 1024;
+
+  UpdateQueue() : wheel(wheelSize) {}
+
+  /// Find or create the slot for the given time and add the new change to it.
+  void insertOrUpdate(Time time, unsigned index, unsigned bitOffset,
+                      const uint8_t *bytes, unsigned width);
+
+  /// Find or create the slot for the given time and add the scheduled wakeup
+  /// to it.
   void insertOrUpdate(Time time, unsigned inst);
 
   /// Return a reference to a slot with the given timestamp. If such a slot
   /// already exists, a reference to it will be returned. Otherwise a reference
-  /// to a fresh slot is returned.
+  /// to a fresh slot is returned. The time must not be earlier than the time
+  /// of the current top of the queue.
   Slot &getOrCreateSlot(Time time);
 
   /// Get a reference to the current top of the queue (the earliest event
-  /// available).
-  const Slot &top();
+  /// available). The queue must not be empty.
+  Slot &top();
 
-  /// Pop the current top of the queue. This marks the current top slot as
-  /// unused and resets its internal structures such that they can be reused.
+  /// Pop the current top of the queue, recycling its slot.
   void pop();
 
+  /// Return true if there are no pending events.
+  bool empty() const { return events == 0; }
+
+  /// The number of pending slots.
   unsigned events = 0;
+
+private:
+  static constexpr unsigned noSlot = ~0u;
+
+  /// Take a slot from the pool of unused slots, or create a new one.
+  unsigned allocSlot(Time time);
+  /// Insert a slot into the bucket for its time, keeping the bucket sorted.
+  void insertIntoWheel(unsigned slot);
+  /// Advance the window to the earliest pending slot, and make it the top.
+  void findTop();
+
+  /// All slots, used or not. A deque keeps references to slots stable while
+  /// new ones are created.
+  std::deque<Slot> slots;
+  llvm::SmallVector<unsigned, 8> unused;
+  /// The buckets of the wheel, holding the indices of their slots.
+  std::vector<llvm::SmallVector<unsigned, 2>> wheel;
+  unsigned wheelEvents = 0;
+  /// The slots beyond the window of the wheel.
+  std::map<Time, unsigned> overflow;
+  /// The real time of the first bucket of the window.
+  uint64_t windowStart = 0;
+  unsigned topSlot = noSlot;
 };
 
 /// State structure for process persistence across suspension.
@@ -311,27 +350,40 @@ struct State {
   /// correctly free'd.
   ~State();
 
-  /// Pop the head of the queue and update the simulation time.
-  Slot popQueue();
-
   /// Push a new scheduled wakeup event in the event queue.
   void pushQueue(Time time, unsigned inst);
 
   /// Find an instance in the instances list by name and return an
   /// iterator for it.
   llvm::SmallVectorTemplateCommon<Instance>::iterator
-  getInstanceIterator(std::string instName);
+  getInstanceIterator(llvm::StringRef instName);
+
+  /// Build the index used to look up instances by name. Must be called once
+  /// all instances have been added.
+  void indexInstances();
+
+  /// Intern a name, returning its ID.
+  NameID internName(llvm::StringRef name);
+
+  /// Get the name with the given ID.
+  llvm::StringRef getName(NameID id) const { return names[id]; }
 
   /// Add a new signal to the state. Returns the index of the new signal.
-  int addSignal(std::string name, std::string owner);
+  int addSignal(llvm::StringRef name, llvm::StringRef owner);
 
-  int addSignalData(int index, std::string owner, uint8_t *value,
+  int addSignalData(int index, llvm::StringRef owner, uint8_t *value,
                     uint64_t size);
 
+  /// Move the signal values, allocated individually by the code generated by
+  /// LLHDToLLVM, into one contiguous arena, and free the original
+  /// allocations. Must be called after the state is initialized and before
+  /// the simulation starts.
+  void packSignals();
+
   void addSignalElement(unsigned, unsigned, unsigned);
 
   /// Add a pointer to the process persistence state to a process instance.
-  void addProcPtr(std::string name, ProcState *procStatePtr);
+  void addProcPtr(llvm::StringRef name, ProcState *procStatePtr);
 
   /// Dump a signal to the out stream. One entry is added for every instance
   /// the signal appears in.
@@ -348,6 +400,15 @@ struct State {
   llvm::SmallVector<Instance, 0> instances;
   llvm::SmallVector<Signal, 0> signals;
   UpdateQueue queue;
+
+private:
+  /// The interned names, indexed by their ID.
+  std::vector<llvm::StringRef> names;
+  llvm::StringMap<NameID> nameIDs;
+  /// The index of the first instance with each name.
+  llvm::StringMap<unsigned> instanceIndices;
+  /// The arena holding all signal values once `packSignals` has been called.
+  std::unique_ptr<uint64_t[]> signalArena;
 };
 
 } // namespace sim
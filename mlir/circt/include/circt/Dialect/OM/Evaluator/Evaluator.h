@@ -21,8 +21,10 @@
 #include "mlir/IR/MLIRContext.h"
 #include "mlir/IR/SymbolTable.h"
 #include "mlir/Support/LogicalResult.h"
+#include "llvm/ADT/DenseSet.h"
 #include "llvm/ADT/SmallPtrSet.h"
 #include "llvm/ADT/SmallString.h"
+#include "llvm/Support/Allocator.h"
 
 #include <queue>
 #include <utility>
@@ -41,6 +43,35 @@ using EvaluatorValuePtr = std::shared_ptr<EvaluatorValue>;
 /// refinement is expected.
 using ObjectFields = SmallDenseMap<StringAttr, EvaluatorValuePtr>;
 
+/// An allocator for `std::allocate_shared` which places values and their
+/// control blocks in a bump-pointer arena owned by the Evaluator.
+/// Deallocating an individual value is a no-op; the memory is released at once
+/// when the Evaluator goes away.
+template <typename T>
+struct ArenaAllocator {
+  using value_type = T;
+
+  ArenaAllocator(llvm::BumpPtrAllocator &arena) : arena(&arena) {}
+  template <typename U>
+  ArenaAllocator(const ArenaAllocator<U> &other) : arena(other.arena) {}
+
+  T *allocate(size_t n) {
+    return static_cast<T *>(arena->Allocate(n * sizeof(T), alignof(T)));
+  }
+  void deallocate(T *, size_t) {}
+
+  template <typename U>
+  bool operator==(const ArenaAllocator<U> &other) const {
+    return arena == other.arena;
+  }
+  template <typename U>
+  bool operator!=(const ArenaAllocator<U> &other) const {
+    return arena != other.arena;
+  }
+
+  llvm::BumpPtrAllocator *arena;
+};
+
 /// Base class for evaluator runtime values.
 /// Enables the shared_from_this functionality so Evaluator Value pointers can
 /// be passed through the CAPI and unwrapped back into C++ smart pointers with
@@ -69,6 +100,11 @@ struct EvaluatorValue : std::enable_shared_from_this<EvaluatorValue> {
   // Finalize the evaluator value. Strip intermidiate reference values.
   LogicalResult finalize();
 
+  /// Release the values this value refers to. The Evaluator does this for all
+  /// values it allocated before it frees them, which breaks the reference
+  /// cycles that placeholders and graph regions create.
+  void dropReferences();
+
   // Return the Location associated with the Value.
   Location getLoc() const { return loc; }
   // Set the Location associated with the Value.
@@ -110,6 +146,8 @@ struct ReferenceValue : EvaluatorValue {
   // Finalize the value.
   LogicalResult finalizeImpl();
 
+  void dropReferencesImpl() { value.reset(); }
+
   // Return the first non-reference value that is reachable from the reference.
   FailureOr<EvaluatorValuePtr> getStrippedValue() const {
     llvm::SmallPtrSet<ReferenceValue *, 4> visited;
@@ -147,6 +185,7 @@ struct AttributeValue : EvaluatorValue {
 
   // Finalize the value.
   LogicalResult finalizeImpl() { return success(); }
+  void dropReferencesImpl() {}
 
   Type getType() const { return attr.cast<TypedAttr>().getType(); }
 
@@ -183,6 +222,7 @@ struct ListValue : EvaluatorValue {
 
   // Finalize the value.
   LogicalResult finalizeImpl();
+  void dropReferencesImpl() { elements.clear(); }
 
   // Partially evaluated value.
   ListValue(om::ListType type, Location loc)
@@ -224,6 +264,7 @@ struct MapValue : EvaluatorValue {
 
   // Finalize the evaluator value.
   LogicalResult finalizeImpl();
+  void dropReferencesImpl() { elements.clear(); }
 
   /// Return the type of the value, which is a MapType.
   om::MapType getMapType() const { return type; }
@@ -286,6 +327,7 @@ struct ObjectValue : EvaluatorValue {
 
   // Finalize the evaluator value.
   LogicalResult finalizeImpl();
+  void dropReferencesImpl() { fields.clear(); }
 
 private:
   om::ClassOp cls;
@@ -317,6 +359,8 @@ struct TupleValue : EvaluatorValue {
 
     return success();
   }
+  void dropReferencesImpl() { elements.clear(); }
+
   /// Implement LLVM RTTI.
   static bool classof(const EvaluatorValue *e) {
     return e->getKind() == Kind::Tuple;
@@ -346,6 +390,7 @@ struct BasePathValue : EvaluatorValue {
 
   /// Finalize the evaluator value.
   LogicalResult finalizeImpl() { return success(); }
+  void dropReferencesImpl() {}
 
   /// Implement LLVM RTTI.
   static bool classof(const EvaluatorValue *e) {
@@ -380,6 +425,7 @@ struct PathValue : EvaluatorValue {
 
   // Finalize the evaluator value.
   LogicalResult finalizeImpl() { return success(); }
+  void dropReferencesImpl() {}
 
   /// Implement LLVM RTTI.
   static bool classof(const EvaluatorValue *e) {
@@ -405,9 +451,17 @@ getEvaluatorValuesFromAttributes(MLIRContext *context,
 
 /// An Evaluator, which is constructed with an IR module and can instantiate
 /// Objects. Further refinement is expected.
+///
+/// The values the Evaluator creates are allocated in an arena it owns, and must
+/// not outlive it.
 struct Evaluator {
-  /// Construct an Evaluator with an IR module.
-  Evaluator(ModuleOp mod);
+  /// Construct an Evaluator with an IR module. If `memoizeInstances` is set,
+  /// instances of a class with the same actual parameters share the values
+  /// evaluated for the class body instead of evaluating it again.
+  Evaluator(ModuleOp mod, bool memoizeInstances = true);
+
+  /// Break the reference cycles between the values and free them.
+  ~Evaluator();
 
   /// Instantiate an Object with its class name and actual parameters.
   FailureOr<evaluator::EvaluatorValuePtr>
@@ -424,6 +478,25 @@ struct Evaluator {
 
   using ObjectKey = std::pair<Value, ActualParameters>;
 
+  /// The actual parameters of an instance of a class, compared by value. The
+  /// hash is computed once, when the key is created, as the parameters may be
+  /// evaluated further afterwards.
+  struct InstanceKey {
+    StringAttr className;
+    ArrayRef<EvaluatorValuePtr> params;
+    unsigned hash;
+  };
+  struct InstanceKeyInfo {
+    static InstanceKey getEmptyKey() {
+      return {DenseMapInfo<StringAttr>::getEmptyKey(), {}, 0};
+    }
+    static InstanceKey getTombstoneKey() {
+      return {DenseMapInfo<StringAttr>::getTombstoneKey(), {}, 0};
+    }
+    static unsigned getHashValue(const InstanceKey &key) { return key.hash; }
+    static bool isEqual(const InstanceKey &lhs, const InstanceKey &rhs);
+  };
+
 private:
   bool isFullyEvaluated(Value value, ActualParameters key) {
     return isFullyEvaluated({value, key});
@@ -483,17 +556,52 @@ private:
                     Location loc);
 
   FailureOr<ActualParameters>
-  createParametersFromOperands(ValueRange range, ActualParameters actualParams,
-                               Location loc);
+  createParametersFromOperands(StringAttr className, ValueRange range,
+                               ActualParameters actualParams, Location loc);
+
+  /// Return the parameter storage for an instance of `className`. When
+  /// memoizing, instances with the same actual parameters get the same
+  /// storage, and therefore share the evaluated values of the class body.
+  ActualParameters
+  getActualParameters(StringAttr className,
+                      SmallVector<evaluator::EvaluatorValuePtr> params);
+
+  /// Allocate an evaluator value in the value arena.
+  template <typename T, typename... Args>
+  std::shared_ptr<T> allocateValue(Args &&...args) {
+    auto value = std::allocate_shared<T>(
+        evaluator::ArenaAllocator<T>(valueArena), std::forward<Args>(args)...);
+    allocatedValues.push_back(value);
+    return value;
+  }
 
   /// The symbol table for the IR module the Evaluator was constructed with.
   /// Used to look up class definitions.
   SymbolTable symbolTable;
 
+  /// Whether instances with identical actual parameters are shared.
+  bool memoizeInstances;
+
+  /// The arena all evaluator values are allocated in.
+  llvm::BumpPtrAllocator valueArena;
+
+  /// Every value allocated in the arena, so that their references can be
+  /// dropped before the arena goes away.
+  std::vector<std::weak_ptr<evaluator::EvaluatorValue>> allocatedValues;
+
   /// This uniquely stores vectors that represent parameters.
-  SmallVector<
-      std::unique_ptr<SmallVector<std::shared_ptr<evaluator::EvaluatorValue>>>>
-      actualParametersBuffers;
+  llvm::SpecificBumpPtrAllocator<
+      SmallVector<std::shared_ptr<evaluator::EvaluatorValue>>>
+      actualParametersAllocator;
+
+  /// The parameter storage of each instantiated class, keyed by the class name
+  /// and the values of the actual parameters.
+  DenseMap<InstanceKey, ActualParameters, InstanceKeyInfo> instances;
+
+  /// The parameter storages whose class body has been allocated and queued for
+  /// evaluation. As the storage is shared between parameters with equal values,
+  /// this holds one entry per distinct instance.
+  DenseSet<ActualParameters> evaluatedInstances;
 
   /// A worklist that tracks values which needs to be fully evaluated.
   std::queue<ObjectKey> worklist;
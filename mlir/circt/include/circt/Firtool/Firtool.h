@@ -120,6 +120,12 @@ struct FirtoolOptions {
       llvm::cl::desc("Disable deduplication of structurally identical modules"),
       llvm::cl::init(false), llvm::cl::cat(category)};
 
+  llvm::cl::opt<bool> dedupFastHash{
+      "dedup-fast-hash",
+      llvm::cl::desc("Use a fast non-cryptographic hash to find modules to "
+                     "deduplicate, confirming matches structurally"),
+      llvm::cl::init(false), llvm::cl::cat(category)};
+
   llvm::cl::opt<firrtl::CompanionMode> companionMode{
       "grand-central-companion-mode",
       llvm::cl::desc("Specifies the handling of Grand Central companions"),
@@ -297,6 +303,26 @@ struct FirtoolOptions {
           "Disable source fir locator information in output Verilog"),
       llvm::cl::init(true), llvm::cl::cat(category)};
 
+  llvm::cl::opt<std::string> emissionCacheDirectory{
+      "emission-cache-dir",
+      llvm::cl::desc("Directory in which to cache split Verilog output across "
+                     "runs, such that only changed modules are re-emitted"),
+      llvm::cl::value_desc("path"), llvm::cl::init(""),
+      llvm::cl::cat(category)};
+
+  llvm::cl::opt<unsigned> splitVerilogNumShards{
+      "split-verilog-num-shards",
+      llvm::cl::desc("Number of processes the split Verilog output is divided "
+                     "among, each emitting one shard of the files. Every "
+                     "process still compiles the whole design"),
+      llvm::cl::init(1), llvm::cl::cat(category)};
+
+  llvm::cl::opt<unsigned> splitVerilogShardIndex{
+      "split-verilog-shard-index",
+      llvm::cl::desc("The shard of the split Verilog output to emit, from 0 "
+                     "to split-verilog-num-shards - 1"),
+      llvm::cl::init(0), llvm::cl::cat(category)};
+
   llvm::cl::opt<bool> stripDebugInfo{
       "strip-debug-info",
       llvm::cl::desc("Disable source locator information in output Verilog"),
@@ -22,6 +22,7 @@
 #include "mlir/IR/Value.h"
 #include "llvm/ADT/StringRef.h"
 #include "llvm/ADT/Twine.h"
+#include <optional>
 #include <string>
 #include <z3++.h>
 
@@ -34,7 +35,8 @@ namespace circt {
 /// declaring new constraints over a Z3 context.
 class Solver::Circuit {
 public:
-  Circuit(llvm::Twine name, Solver &solver) : name(name.str()), solver(solver) {
+  Circuit(llvm::Twine name, Solver &solver, bool useCutPoints = false)
+      : name(name.str()), useCutPoints(useCutPoints), solver(solver) {
     assignments = 0;
   };
   /// Add an input to the circuit; internally a new value gets allocated.
@@ -93,6 +95,15 @@ private:
   /// express, simulating an assignment.
   void constrainResult(mlir::Value &result, z3::expr &expr);
 
+  /// Returns the cut point class of a value of the circuit's module, if it has
+  /// one.
+  std::optional<unsigned> getCutPointClass(mlir::Value value);
+  /// Reuses the expression of an equivalent value allocated by either circuit.
+  /// Returns true on success.
+  bool bindCutPoint(mlir::Value value);
+  /// Records the expression of a value for equivalent values to reuse.
+  void recordCutPoint(mlir::Value value, const z3::expr &expr);
+
   /// Convert from bitvector to bool sort.
   z3::expr bvToBool(const z3::expr &condition);
   /// Convert from a boolean sort to the corresponding 1-width bitvector.
@@ -104,6 +115,12 @@ private:
   /// name new values as they have to be represented within the logical engine's
   /// context.
   unsigned assignments;
+  /// Whether the circuit shares the expressions of structurally identical
+  /// values with the other circuit.
+  bool useCutPoints;
+  /// The cut point classes of the values of the circuit's module, computed on
+  /// first use.
+  std::optional<llvm::DenseMap<mlir::Value, unsigned>> cutPointClasses;
   /// The solver environment the circuit belongs to.
   Solver &solver;
   /// The list for the circuit's inputs.
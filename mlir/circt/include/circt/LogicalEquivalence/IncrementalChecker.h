@@ -0,0 +1,137 @@
+//===-- IncrementalChecker.h - Hierarchical equivalence check ---*- C++ -*-===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+///
+/// This file defines a driver for the `circt-lec` tool which checks two module
+/// hierarchies for equivalence one pair of modules at a time.
+///
+//===----------------------------------------------------------------------===//
+
+// NOLINTNEXTLINE
+#ifndef TOOLS_CIRCT_LEC_INCREMENTALCHECKER_H
+#define TOOLS_CIRCT_LEC_INCREMENTALCHECKER_H
+
+#include "circt/Dialect/HW/HWOps.h"
+#include "circt/Support/LLVM.h"
+#include "mlir/IR/MLIRContext.h"
+#include "mlir/Support/LogicalResult.h"
+#include "llvm/ADT/EquivalenceClasses.h"
+#include "llvm/ADT/MapVector.h"
+#include "llvm/ADT/StringSet.h"
+#include "llvm/Support/Allocator.h"
+#include "llvm/Support/StringSaver.h"
+#include <string>
+
+namespace circt {
+
+/// An equivalence checker decomposing the problem along instance boundaries.
+///
+/// Starting from the two top-level modules, instances with the same name and
+/// port types are paired up, recursively. The module pairs are then checked
+/// bottom-up, each with a separate `Solver`:
+/// - structurally identical modules are equivalent without a proof;
+/// - pairs proven by an earlier run are found in a cache, keyed by the
+///   structural hash of the two modules;
+/// - otherwise, the instances of modules already proven equivalent are
+///   modeled as shared uninterpreted functions, and the two circuits share
+///   the logic they have in common.
+///
+/// An abstracted proof can fail even though the modules are equivalent, in
+/// which case the pair is checked again with all instances inlined. The pairs
+/// which don't depend on each other are checked in parallel.
+class IncrementalChecker {
+public:
+  IncrementalChecker(mlir::MLIRContext *context, bool statisticsOpt)
+      : context(context), statisticsOpt(statisticsOpt) {}
+
+  /// Solve the equivalence problem between two modules, then present the
+  /// results to the user.
+  mlir::LogicalResult solve(hw::HWModuleOp c1, hw::HWModuleOp c2);
+
+  /// Add the proofs stored in a cache file. A missing file is an empty cache.
+  mlir::LogicalResult loadCache(llvm::StringRef path);
+  /// Store the loaded proofs and those made since in a cache file.
+  mlir::LogicalResult saveCache(llvm::StringRef path);
+
+private:
+  /// The modules to be proven equivalent, along with the pairs of modules
+  /// they instantiate.
+  struct ModulePair {
+    hw::HWModuleOp modules[2];
+    SmallVector<unsigned> children;
+    /// The height of the pair in the instance hierarchy; leaves are zero.
+    unsigned level = 0;
+  };
+
+  /// Pair up two modules and, recursively, the modules they instantiate.
+  /// Returns the index of the pair.
+  unsigned addPair(hw::HWModuleOp m1, hw::HWModuleOp m2);
+
+  /// Pick the instanced modules to abstract when checking a pair, mapped to
+  /// the identifier of their uninterpreted functions.
+  llvm::MapVector<Operation *, unsigned>
+  getAbstractions(const ModulePair &pair);
+
+  /// Check a pair with a fresh solver. Returns true if the modules are
+  /// equivalent.
+  mlir::FailureOr<bool>
+  checkPair(const ModulePair &pair,
+            const llvm::MapVector<Operation *, unsigned> &abstractions);
+
+  /// Return the structural hash of a module, including the modules it
+  /// instantiates. Names don't contribute to the hash.
+  StringRef getModuleHash(hw::HWModuleOp module);
+  /// Return the cache key of a pair checked with the given abstractions.
+  std::string
+  getPairKey(const ModulePair &pair,
+             const llvm::MapVector<Operation *, unsigned> &abstractions);
+  /// Print the structure of a module for hashing. `printInstance` prints what
+  /// an instance refers to.
+  void printModule(hw::HWModuleOp module, llvm::raw_ostream &os,
+                   llvm::function_ref<void(hw::InstanceOp)> printInstance);
+  /// Return the textual form of an attribute or type, for stable hashing.
+  StringRef print(const void *opaque, llvm::function_ref<void(raw_ostream &)>);
+
+  /// Record that two modules are equivalent.
+  void addProof(hw::HWModuleOp m1, hw::HWModuleOp m2);
+
+  /// Print the statistics about the decomposition.
+  void printStatistics();
+
+  /// The MLIR context of reference, owning all the MLIR entities.
+  mlir::MLIRContext *context;
+  /// The value of the `statistics` command-line option.
+  bool statisticsOpt;
+
+  /// The module pairs, in pre-order of the instance hierarchy.
+  SmallVector<ModulePair> pairs;
+  llvm::DenseMap<std::pair<Operation *, Operation *>, unsigned> pairIndices;
+
+  /// The modules known to be equivalent to each other.
+  llvm::EquivalenceClasses<Operation *> equivalentModules;
+
+  /// The cache keys of the proven pairs.
+  llvm::StringSet<> cache;
+
+  /// Memoized structural hashes and printed attributes and types, saved by
+  /// `saver`.
+  llvm::DenseMap<Operation *, StringRef> moduleHashes;
+  llvm::DenseMap<const void *, StringRef> printed;
+  llvm::BumpPtrAllocator allocator;
+  llvm::StringSaver saver{allocator};
+
+  /// Statistics.
+  unsigned numIdentical = 0;
+  unsigned numCached = 0;
+  unsigned numProven = 0;
+  unsigned numFallbacks = 0;
+  unsigned numDifferent = 0;
+};
+
+} // namespace circt
+
+#endif // TOOLS_CIRCT_LEC_INCREMENTALCHECKER_H
@@ -17,6 +17,7 @@
 #include "circt/Support/LLVM.h"
 #include "mlir/IR/MLIRContext.h"
 #include "mlir/IR/Value.h"
+#include "llvm/Support/Allocator.h"
 #include <z3++.h>
 
 namespace circt {
@@ -31,16 +32,34 @@ namespace circt {
 class Solver {
 public:
   Solver(mlir::MLIRContext *mlirCtx, bool statisticsOpt);
-  ~Solver() = default;
+  ~Solver();
 
   /// Solve the equivalence problem between the two circuits, then present the
   /// results to the user.
   mlir::LogicalResult solve();
 
+  /// Solve the equivalence problem between the two circuits without reporting
+  /// anything. Returns true if they are equivalent and false if there is a
+  /// counterexample.
+  mlir::FailureOr<bool> checkEquivalence();
+
   class Circuit;
   /// Create a new circuit to be compared and return it.
   Circuit *addCircuit(llvm::StringRef name);
 
+  /// Model the instances of `module` as uninterpreted functions, shared by all
+  /// the modules abstracted with the same `id`. This is only sound if those
+  /// modules are known to be equivalent. Must be called before the circuits
+  /// are exported.
+  void abstractModule(mlir::Operation *module, unsigned id) {
+    abstractedModules[module] = id;
+  }
+
+  /// Let the two circuits share the logical representation of values which
+  /// are computed by structurally identical logic from the same inputs. Must
+  /// be called before adding the circuits.
+  void enableCutPoints() { cutPointsEnabled = true; }
+
 private:
   /// Prints a model satisfying the solved constraints.
   void printModel();
@@ -59,6 +78,9 @@ private:
   /// the inputs and outputs of the circuits.
   mlir::LogicalResult constrainCircuits();
 
+  /// Return the cut point class identified by `key`, creating it if needed.
+  unsigned getCutPointClass(llvm::ArrayRef<uintptr_t> key);
+
   /// A map from internal solver symbols to the IR values they represent.
   llvm::DenseMap<mlir::StringAttr, mlir::Value> symbolTable;
   /// The two circuits to be compared.
@@ -72,6 +94,19 @@ private:
   z3::solver solver;
   /// The value of the `statistics` command-line option.
   bool statisticsOpt;
+
+  /// The modules whose instances are modeled as uninterpreted functions,
+  /// mapped to the identifier of the function.
+  llvm::DenseMap<mlir::Operation *, unsigned> abstractedModules;
+  /// Whether the circuits share the expressions of structurally identical
+  /// values.
+  bool cutPointsEnabled = false;
+  /// The cut point classes, keyed by the operation computing the values along
+  /// with the classes of its operands.
+  llvm::DenseMap<llvm::ArrayRef<uintptr_t>, unsigned> cutPointClasses;
+  llvm::BumpPtrAllocator cutPointKeyAllocator;
+  /// The logical representation of each cut point class.
+  llvm::DenseMap<unsigned, z3::expr> cutPointExprs;
 };
 
 } // namespace circt
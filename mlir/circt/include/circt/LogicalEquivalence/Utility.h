@@ -20,26 +20,115 @@
 #include "llvm/ADT/APInt.h"
 #include "llvm/Support/Debug.h"
 #include "llvm/Support/raw_ostream.h"
+#include <mutex>
+#include <string>
 #include <z3++.h>
 
 namespace lec {
+namespace detail {
+/// Unbuffered stream that forwards to `target`, or appends to `buffer` while
+/// the output of the current thread is being collected by `BufferedOutput`.
+class ThreadStream : public llvm::raw_ostream {
+public:
+  explicit ThreadStream(llvm::raw_ostream &target) : target(target) {
+    SetUnbuffered();
+  }
+
+  llvm::raw_ostream &target;
+  std::string *buffer = nullptr;
+
+private:
+  void write_impl(const char *ptr, size_t size) override {
+    if (buffer)
+      buffer->append(ptr, size);
+    else
+      target.write(ptr, size);
+    position += size;
+  }
+  uint64_t current_pos() const override { return position; }
+
+  uint64_t position = 0;
+};
+
+inline ThreadStream &dbgs() {
+  thread_local ThreadStream stream(llvm::dbgs());
+  return stream;
+}
+
+inline ThreadStream &errs() {
+  thread_local ThreadStream stream(llvm::errs());
+  return stream;
+}
+
+inline ThreadStream &outs() {
+  thread_local ThreadStream stream(llvm::outs());
+  return stream;
+}
+
+/// Serializes the writes of collected output to the underlying streams.
+inline std::mutex &outputMutex() {
+  static std::mutex mutex;
+  return mutex;
+}
+} // namespace detail
+
 // Defining persistent output streams such that text will be printed in
-// accordance with the globally set indentation level.
+// accordance with the indentation level set by the current thread. Each thread
+// has its own streams, so that circuits can be checked in parallel.
 inline mlir::raw_indented_ostream &dbgs() {
-  static auto stream = mlir::raw_indented_ostream(llvm::dbgs());
+  thread_local auto stream = mlir::raw_indented_ostream(detail::dbgs());
   return stream;
 }
 
 inline mlir::raw_indented_ostream &errs() {
-  static auto stream = mlir::raw_indented_ostream(llvm::errs());
+  thread_local auto stream = mlir::raw_indented_ostream(detail::errs());
   return stream;
 }
 
 inline mlir::raw_indented_ostream &outs() {
-  static auto stream = mlir::raw_indented_ostream(llvm::outs());
+  thread_local auto stream = mlir::raw_indented_ostream(detail::outs());
   return stream;
 }
 
+/// RAII struct to collect the output of the current thread and write it out in
+/// one piece when it goes out of scope, such that the output of checks running
+/// in parallel does not interleave. Nested instances have no effect.
+class BufferedOutput {
+public:
+  BufferedOutput() : active(!detail::outs().buffer) {
+    if (!active)
+      return;
+    detail::dbgs().buffer = &dbgsBuffer;
+    detail::errs().buffer = &errsBuffer;
+    detail::outs().buffer = &outsBuffer;
+  }
+
+  ~BufferedOutput() {
+    if (!active)
+      return;
+    detail::dbgs().buffer = nullptr;
+    detail::errs().buffer = nullptr;
+    detail::outs().buffer = nullptr;
+    std::lock_guard<std::mutex> lock(detail::outputMutex());
+    for (auto [stream, buffer] :
+         {std::make_pair(&detail::dbgs(), &dbgsBuffer),
+          std::make_pair(&detail::errs(), &errsBuffer),
+          std::make_pair(&detail::outs(), &outsBuffer)}) {
+      if (buffer->empty())
+        continue;
+      stream->target << *buffer;
+      stream->target.flush();
+    }
+  }
+
+  BufferedOutput(const BufferedOutput &) = delete;
+  BufferedOutput &operator=(const BufferedOutput &) = delete;
+
+private:
+  bool active;
+  std::string dbgsBuffer, errsBuffer, outsBuffer;
+};
+
 /// RAII struct to indent the output streams.
 struct Scope {
   mlir::raw_indented_ostream::DelimitedScope indentDbgs = lec::dbgs().scope();
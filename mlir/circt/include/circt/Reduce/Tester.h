@@ -15,6 +15,7 @@
 
 #include "circt/Support/LLVM.h"
 #include "mlir/IR/BuiltinOps.h"
+#include "llvm/ADT/DenseMap.h"
 #include "llvm/ADT/SmallString.h"
 #include "llvm/Support/Error.h"
 #include "llvm/Support/FileSystem.h"
@@ -47,6 +48,11 @@ public:
   /// Return whether the file in the given path is interesting.
   bool isInteresting(llvm::StringRef testCase) const;
 
+  /// Run the tester on multiple test cases concurrently, each in a separate
+  /// process. Subsequent calls to `isInteresting()` on the test cases return
+  /// the result immediately.
+  void runConcurrently(llvm::ArrayRef<TestCase *> testCases) const;
+
   /// Create a new test case for the given `module`.
   TestCase get(mlir::ModuleOp module) const;
 
@@ -54,6 +60,16 @@ public:
   TestCase get(llvm::Twine filepath) const;
 
 private:
+  friend class TestCase;
+
+  /// Start the testing script on a test case file, without waiting for it to
+  /// finish.
+  llvm::sys::ProcessInfo startTest(llvm::StringRef testCase) const;
+
+  /// Wait for a test started with `startTest` to finish and return whether the
+  /// test case is interesting.
+  bool finishTest(const llvm::sys::ProcessInfo &process) const;
+
   /// The binary to execute in order to check a reduction attempt for
   /// interestingness.
   llvm::StringRef testScript;
@@ -64,6 +80,11 @@ private:
   /// Consider the testcase to be interesting if it fails rather than on exit
   /// code 0.
   bool testMustFail;
+
+  /// The results of the test cases tested so far, by hash of their contents.
+  /// Reductions frequently produce identical test cases, for example when a
+  /// pattern makes no change or different chunks reduce to the same IR.
+  mutable llvm::DenseMap<std::pair<uint64_t, uint64_t>, bool> testedHashes;
 };
 
 /// A single test case to be run by a tester.
@@ -110,6 +131,9 @@ private:
   /// file on disk.
   void ensureFileOnDisk();
 
+  /// Record the result of running the tester on this test case.
+  void setInteresting(bool result);
+
   /// The tester that is used to run this test case.
   const Tester &tester;
   /// The module to be tested.
@@ -128,6 +152,9 @@ private:
   /// Whether the size of the test case on disk has already been determined, and
   /// if yes, that size.
   std::optional<size_t> size;
+  /// The hash of the test case contents, if it has been written to disk by
+  /// this test case.
+  std::optional<std::pair<uint64_t, uint64_t>> hash;
   /// Whether the tester has run on this test case, and its result.
   std::optional<bool> interesting;
 };
@@ -24,11 +24,19 @@ namespace scheduling {
 /// name). Fails if the dependence graph contains cycles.
 LogicalResult scheduleASAP(Problem &prob);
 
+/// How the simplex schedulers store their tableau. The sparse tableau's size
+/// and the cost of its pivot steps scale with the number of non-zero entries,
+/// which makes it suitable for large problems. The dense tableau stores all
+/// |deps| * |ops| entries; it is kept as a reference.
+enum class SimplexTableauKind { Sparse, Dense };
+
 /// Solve the basic problem using linear programming and a handwritten
 /// implementation of the simplex algorithm. The objective is to minimize the
 /// start time of the given \p lastOp. Fails if the dependence graph contains
 /// cycles, or \p prob does not include \p lastOp.
-LogicalResult scheduleSimplex(Problem &prob, Operation *lastOp);
+LogicalResult
+scheduleSimplex(Problem &prob, Operation *lastOp,
+                SimplexTableauKind tableau = SimplexTableauKind::Sparse);
 
 /// Solve the resource-free cyclic problem using linear programming and a
 /// handwritten implementation of the simplex algorithm. The objectives are to
@@ -36,13 +44,17 @@ LogicalResult scheduleSimplex(Problem &prob, Operation *lastOp);
 /// start time of the given \p lastOp. Fails if the dependence graph contains
 /// cycles that do not include at least one edge with a non-zero distance, or
 /// \p prob does not include \p lastOp.
-LogicalResult scheduleSimplex(CyclicProblem &prob, Operation *lastOp);
+LogicalResult
+scheduleSimplex(CyclicProblem &prob, Operation *lastOp,
+                SimplexTableauKind tableau = SimplexTableauKind::Sparse);
 
 /// Solve the acyclic problem with shared operators using a linear
 /// programming-based heuristic. The approach tries to minimize the start time
 /// of the given \p lastOp, but optimality is not guaranteed. Fails if the
 /// dependence graph contains cycles, or \p prob does not include \p lastOp.
-LogicalResult scheduleSimplex(SharedOperatorsProblem &prob, Operation *lastOp);
+LogicalResult
+scheduleSimplex(SharedOperatorsProblem &prob, Operation *lastOp,
+                SimplexTableauKind tableau = SimplexTableauKind::Sparse);
 
 /// Solve the modulo scheduling problem using a linear programming-based
 /// heuristic. The approach tries to determine the smallest feasible initiation
@@ -51,7 +63,9 @@ LogicalResult scheduleSimplex(SharedOperatorsProblem &prob, Operation *lastOp);
 /// that do not include at least one edge with a non-zero distance, \p prob
 /// does not include \p lastOp, or \p lastOp is not the unique sink of the
 /// dependence graph.
-LogicalResult scheduleSimplex(ModuloProblem &prob, Operation *lastOp);
+LogicalResult
+scheduleSimplex(ModuloProblem &prob, Operation *lastOp,
+                SimplexTableauKind tableau = SimplexTableauKind::Sparse);
 
 /// Solve the acyclic, chaining-enabled problem using linear programming and a
 /// handwritten implementation of the simplex algorithm. This approach strictly
@@ -59,8 +73,9 @@ LogicalResult scheduleSimplex(ModuloProblem &prob, Operation *lastOp);
 /// start time of the given \p lastOp. Fails if the dependence graph contains
 /// cycles, or individual operator types have delays larger than \p cycleTime,
 /// or \p prob does not include \p lastOp.
-LogicalResult scheduleSimplex(ChainingProblem &prob, Operation *lastOp,
-                              float cycleTime);
+LogicalResult
+scheduleSimplex(ChainingProblem &prob, Operation *lastOp, float cycleTime,
+                SimplexTableauKind tableau = SimplexTableauKind::Sparse);
 
 /// Solve the basic problem using linear programming and an external LP solver.
 /// The objective is to minimize the start time of the given \p lastOp. Fails if
@@ -18,6 +18,7 @@
 #include "llvm/ADT/GraphTraits.h"
 #include "llvm/ADT/STLExtras.h"
 #include "llvm/ADT/iterator.h"
+#include "llvm/Support/Allocator.h"
 #include "llvm/Support/DOTGraphTraits.h"
 
 /// The InstanceGraph op interface, see InstanceGraphInterface.td for more
@@ -47,6 +48,7 @@ struct AddressIterator
 };
 } // namespace detail
 
+class InstanceGraph;
 class InstanceGraphNode;
 
 /// This is an edge in the InstanceGraph. This tracks a specific instantiation
@@ -94,6 +96,21 @@ private:
   InstanceRecord *prevUse = nullptr;
 };
 
+} // namespace igraph
+} // namespace circt
+
+/// Instance records and graph nodes are allocated in the InstanceGraph's
+/// arena, so the lists holding them only have to run their destructors.
+template <>
+struct llvm::ilist_alloc_traits<circt::igraph::InstanceRecord> {
+  static void deleteNode(circt::igraph::InstanceRecord *record) {
+    record->~InstanceRecord();
+  }
+};
+
+namespace circt {
+namespace igraph {
+
 /// This is a Node in the InstanceGraph.  Each node represents a Module in a
 /// Circuit.  Both external modules and regular modules can be represented by
 /// this class. It is possible to efficiently iterate all modules instantiated
@@ -102,7 +119,10 @@ class InstanceGraphNode : public llvm::ilist_node<InstanceGraphNode> {
   using InstanceList = llvm::iplist<InstanceRecord>;
 
 public:
-  InstanceGraphNode() : module(nullptr) {}
+  /// Create a node owned by `graph`. Instance records added to this node are
+  /// allocated by the graph.
+  explicit InstanceGraphNode(InstanceGraph *graph)
+      : graph(graph), module(nullptr) {}
 
   /// Get the module that this node is tracking.
   template <typename TTarget = ModuleOpInterface>
@@ -168,6 +188,9 @@ private:
   /// Record that a module instantiates this module.
   void recordUse(InstanceRecord *record);
 
+  /// The graph which owns this node.
+  InstanceGraph *graph;
+
   /// The module.
   ModuleOpInterface module;
 
@@ -183,6 +206,19 @@ private:
   friend class InstanceGraph;
 };
 
+} // namespace igraph
+} // namespace circt
+
+template <>
+struct llvm::ilist_alloc_traits<circt::igraph::InstanceGraphNode> {
+  static void deleteNode(circt::igraph::InstanceGraphNode *node) {
+    node->~InstanceGraphNode();
+  }
+};
+
+namespace circt {
+namespace igraph {
+
 /// This graph tracks modules and where they are instantiated. This is intended
 /// to be used as a cached analysis on circuits.  This class can be used
 /// to walk the modules efficiently in a bottom-up or top-down order.
@@ -240,6 +276,23 @@ public:
   iterator begin() { return nodes.begin(); }
   iterator end() { return nodes.end(); }
 
+  /// Get the nodes in post-order, i.e. every module comes after all of the
+  /// modules it instantiates. If there is a top-level node, this is the same
+  /// order as `llvm::post_order(this)`, otherwise it covers every node. The
+  /// order is computed once and cached until the graph changes, so passes
+  /// sharing the graph through the analysis manager don't each recompute it.
+  ///
+  /// The returned array is only valid until the graph is next modified. Copy
+  /// it to modify the graph while walking the order.
+  ArrayRef<InstanceGraphNode *> getPostOrder();
+
+  /// Get the nodes of the post-order partitioned into levels. Level 0 holds
+  /// the modules which don't instantiate anything and every other module is one
+  /// level above the highest module it instantiates. No module instantiates a
+  /// module in the same or a higher level, so each level can be processed in
+  /// parallel once the levels below it are done. Cached like getPostOrder.
+  ArrayRef<ArrayRef<InstanceGraphNode *>> getLevels();
+
   //===-------------------------------------------------------------------------
   // Methods to keep an InstanceGraph up to date.
   //
@@ -268,9 +321,43 @@ protected:
   /// yet, it will be created.
   InstanceGraphNode *getOrAddNode(StringAttr name);
 
+  /// Allocate a new node in the graph's arena. The node is not added to the
+  /// graph.
+  InstanceGraphNode *createNode();
+
+  /// Allocate storage for a node or instance record, reusing the storage of an
+  /// erased one from `freeList` if there is any.
+  template <typename T>
+  void *allocate(SmallVectorImpl<void *> &freeList) {
+    if (!freeList.empty())
+      return freeList.pop_back_val();
+    return allocator.Allocate<T>();
+  }
+
+  /// Drop the cached traversal orders. Called on any change to the edges or
+  /// nodes of the graph, so that the orders never refer to erased nodes.
+  void invalidateOrders() {
+    ordersValid = false;
+    postOrder.clear();
+    levelOrder.clear();
+    levels.clear();
+  }
+
+  /// Compute the post-order and the levels.
+  void computeOrders();
+
   /// The node under which all modules are nested.
   Operation *parent;
 
+  /// The arena for nodes and instance records. This must outlive the lists
+  /// holding them, which only run their destructors.
+  llvm::BumpPtrAllocator allocator;
+
+  /// The storage of erased nodes and instance records, which is handed out
+  /// again before allocating more from the arena.
+  SmallVector<void *> freeNodes;
+  SmallVector<void *> freeRecords;
+
   /// The storage for graph nodes, with deterministic iteration.
   NodeList nodes;
 
@@ -279,6 +366,16 @@ protected:
 
   /// A caching of the inferred top level module(s).
   llvm::SmallVector<InstanceGraphNode *> inferredTopLevelNodes;
+
+  /// The cached post-order. The nodes are sorted by level in `levelOrder`,
+  /// which `levels` points into.
+  bool ordersValid = false;
+  std::vector<InstanceGraphNode *> postOrder;
+  std::vector<InstanceGraphNode *> levelOrder;
+  SmallVector<ArrayRef<InstanceGraphNode *>> levels;
+
+  friend class InstanceGraphNode;
+  friend class InstanceRecord;
 };
 
 struct InstancePathCache;
@@ -12,8 +12,11 @@
 #include "circt/Support/LLVM.h"
 #include "mlir/Pass/Pass.h"
 #include "mlir/Pass/PassInstrumentation.h"
+#include "llvm/ADT/StringMap.h"
 #include "llvm/Support/Chrono.h"
 #include "llvm/Support/Format.h"
+#include <mutex>
+#include <vector>
 
 namespace circt {
 // This class prints logs before and after of pass executions when its pass
@@ -56,6 +59,121 @@ public:
   }
 };
 
+/// This class counts how many times each analysis is computed and the time
+/// spent computing it, and prints a report when it is destroyed (i.e. when the
+/// pass manager is). An analysis which isn't preserved by a pass is computed
+/// again by the next pass that needs it, so the counts show which passes fail
+/// to preserve analyses. Analyses may be computed in parallel on nested
+/// operations; these are counted together.
+class AnalysisStatisticsInstrumentation : public mlir::PassInstrumentation {
+public:
+  AnalysisStatisticsInstrumentation(llvm::raw_ostream &out) : out(out) {}
+  ~AnalysisStatisticsInstrumentation() override;
+
+  void runBeforeAnalysis(StringRef name, TypeID id, Operation *op) override;
+  void runAfterAnalysis(StringRef name, TypeID id, Operation *op) override;
+
+  /// Print the report.
+  void print(llvm::raw_ostream &os);
+
+private:
+  using TimePoint = llvm::sys::TimePoint<>;
+  struct Statistics {
+    unsigned count = 0;
+    std::chrono::nanoseconds time{0};
+  };
+
+  /// Where the report is printed on destruction.
+  llvm::raw_ostream &out;
+  std::mutex mutex;
+  /// The statistics for each analysis, keyed by name.
+  llvm::StringMap<Statistics> statistics;
+  /// Start times of the analyses being computed on each thread. Computing an
+  /// analysis may compute others it depends on, so these form a stack.
+  DenseMap<uint64_t, SmallVector<TimePoint>> startTimes;
+};
+
+namespace detail {
+/// The implementation of `MemoryStatisticsInstrumentation`, which doesn't
+/// depend on the logged operation types.
+class MemoryStatisticsInstrumentationImpl : public mlir::PassInstrumentation {
+public:
+  MemoryStatisticsInstrumentationImpl(llvm::raw_ostream &out) : out(out) {}
+  ~MemoryStatisticsInstrumentationImpl() override;
+
+  /// Print the report as JSON.
+  void print(llvm::raw_ostream &os);
+
+protected:
+  void beginPass(Pass *pass, Operation *op);
+  void endPass(Operation *op, bool failed);
+
+private:
+  using TimePoint = llvm::sys::TimePoint<>;
+  struct PassRecord {
+    std::string name;
+    std::string opName;
+    bool failed = false;
+    double wall = 0;
+    size_t opsBefore = 0;
+    size_t opsAfter = 0;
+    int64_t rssDelta = 0;
+    int64_t heapDelta = 0;
+    uint64_t peakRSS = 0;
+    /// The passes run by this one, if it is a pipeline.
+    std::vector<PassRecord> passes;
+
+    /// The state when the pass started.
+    TimePoint startTime;
+    uint64_t startRSS = 0;
+    size_t startHeap = 0;
+  };
+
+  /// Count the operations nested in `op`, reusing the count from the end of
+  /// the previous pass if nothing can have run on `op` since then.
+  size_t countOperations(Operation *op);
+
+  /// Where the report is printed on destruction.
+  llvm::raw_ostream &out;
+  /// The passes which have finished, in order.
+  std::vector<PassRecord> passes;
+  /// The passes which are currently running, outermost first.
+  std::vector<PassRecord> activePasses;
+  /// The last operation counted and its number of nested operations.
+  Operation *countedOp = nullptr;
+  size_t countedOps = 0;
+};
+} // namespace detail
+
+/// This class records the memory usage of each pass whose operation is in
+/// `LoggedOpTypes` and writes a JSON report when it is destroyed. For every pass
+/// it records the change in resident set size and heap usage, the peak resident
+/// set size so far, and the number of operations before and after. Passes are
+/// nested in the pipelines that run them, like in the timing report. Memory is
+/// measured for the whole process, so like `VerbosePassInstrumentation`,
+/// `LoggedOpTypes` must be a set of operations whose passes are run
+/// sequentially.
+template <class... LoggedOpTypes>
+class MemoryStatisticsInstrumentation
+    : public detail::MemoryStatisticsInstrumentationImpl {
+public:
+  using MemoryStatisticsInstrumentationImpl::
+      MemoryStatisticsInstrumentationImpl;
+
+  void runBeforePass(Pass *pass, Operation *op) override {
+    if (isa<LoggedOpTypes...>(op))
+      beginPass(pass, op);
+  }
+  void runAfterPass(Pass *pass, Operation *op) override {
+    if (isa<LoggedOpTypes...>(op))
+      endPass(op, /*failed=*/false);
+  }
+  void runAfterPassFailed(Pass *pass, Operation *op) override {
+    if (isa<LoggedOpTypes...>(op))
+      endPass(op, /*failed=*/true);
+  }
+};
+
 /// Create a simple canonicalizer pass.
 std::unique_ptr<Pass> createSimpleCanonicalizerPass();
 
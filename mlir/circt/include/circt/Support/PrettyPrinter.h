@@ -11,7 +11,7 @@
 // https://dx.doi.org/10.1145/357114.357115
 //
 // This was selected as it is linear in number of tokens O(n) and requires
-// memory O(linewidth).
+// memory O(linewidth), or O(lookahead limit) when one is set.
 //
 // See PrettyPrinter.cpp for more information.
 //
@@ -27,7 +27,6 @@
 #include "llvm/Support/SaveAndRestore.h"
 
 #include <cstdint>
-#include <deque>
 #include <limits>
 
 namespace circt {
@@ -168,6 +167,72 @@ struct CallbackToken : public TokenBase<CallbackToken, Token::Kind::Callback> {
   CallbackToken() = default;
 };
 
+//===----------------------------------------------------------------------===//
+// RingBuffer
+//===----------------------------------------------------------------------===//
+
+namespace detail {
+
+/// Queue that can also be popped from the back, stored in a ring buffer.
+/// Capacity doubles when full and is kept when cleared, so a long-lived queue
+/// stops allocating once it has reached its largest size.
+template <typename T>
+class RingBuffer {
+public:
+  bool empty() const { return count == 0; }
+  size_t size() const { return count; }
+  size_t capacity() const { return storage.size(); }
+
+  T &operator[](size_t i) {
+    assert(i < count && "index out of range");
+    return storage[(head + i) & (storage.size() - 1)];
+  }
+  T &front() { return (*this)[0]; }
+  T &back() { return (*this)[count - 1]; }
+
+  void push_back(const T &value) {
+    if (count == storage.size()) {
+      // `value` may refer to one of our elements, which `grow` frees.
+      T copy = value;
+      grow(copy);
+      storage[(head + count++) & (storage.size() - 1)] = std::move(copy);
+      return;
+    }
+    storage[(head + count++) & (storage.size() - 1)] = value;
+  }
+  void pop_front() {
+    assert(!empty());
+    head = (head + 1) & (storage.size() - 1);
+    --count;
+  }
+  void pop_back() {
+    assert(!empty());
+    --count;
+  }
+  void clear() { head = count = 0; }
+
+private:
+  /// Double the capacity, unwrapping the elements to the start. `filler`
+  /// initializes the new slots.
+  void grow(const T &filler) {
+    size_t newCapacity = std::max<size_t>(16, storage.size() * 2);
+    SmallVector<T, 0> newStorage;
+    newStorage.reserve(newCapacity);
+    for (size_t i = 0; i < count; ++i)
+      newStorage.push_back((*this)[i]);
+    newStorage.resize(newCapacity, filler);
+    storage = std::move(newStorage);
+    head = 0;
+  }
+
+  /// The slots, a power of two of them.
+  SmallVector<T, 0> storage;
+  size_t head = 0;
+  size_t count = 0;
+};
+
+} // end namespace detail
+
 //===----------------------------------------------------------------------===//
 // PrettyPrinter
 //===----------------------------------------------------------------------===//
@@ -227,6 +292,18 @@ public:
   void setListener(Listener *newListener) { listener = newListener; };
   auto *getListener() const { return listener; }
 
+  /// Bound the number of tokens buffered while waiting to know whether a
+  /// group fits (0 = unbounded, the default). When the buffer is full, the
+  /// oldest pending group or break is deemed not to fit, as if the line were
+  /// full, so the layout only differs from the unbounded one for groups too
+  /// long to fit anyway.
+  void setLookaheadLimit(uint32_t limit) { lookaheadLimit = limit; }
+
+  /// Number of tokens added so far.
+  uint64_t getNumTokens() const { return numTokens; }
+  /// Largest number of tokens buffered at once so far.
+  size_t getPeakLookahead() const { return peakLookahead; }
+
   static constexpr uint32_t kInfinity = (1U << 15) - 1;
 
 private:
@@ -257,6 +334,9 @@ private:
   /// If scan size is wider than line, it's infinity.
   void checkStream();
 
+  /// Print tokens until the buffer is below the lookahead limit.
+  void enforceLookaheadLimit();
+
   /// Print a token, maintaining printStack for context.
   void print(const FormattedToken &f);
 
@@ -279,12 +359,19 @@ private:
   int32_t rightTotal;
 
   /// Unprinted tokens, combination of 'token' and 'size' in Oppen.
-  std::deque<FormattedToken> tokens;
+  detail::RingBuffer<FormattedToken> tokens;
   /// index of first token, for resolving scanStack entries.
   uint32_t tokenOffset = 0;
 
   /// Stack of begin/break tokens, adjust by tokenOffset to index into tokens.
-  std::deque<uint32_t> scanStack;
+  detail::RingBuffer<uint32_t> scanStack;
+
+  /// Maximum number of buffered tokens, 0 if unbounded.
+  uint32_t lookaheadLimit = 0;
+
+  /// Statistics.
+  uint64_t numTokens = 0;
+  size_t peakLookahead = 0;
 
   /// Stack of printing contexts (indentation + breaking behavior).
   SmallVector<PrintEntry> printStack;
@@ -39,17 +39,29 @@ struct EmitHGLDDOptions {
   StringRef outputDirectory = "";
 };
 
+/// Statistics about HGLDD emission, accumulated across calls.
+struct EmitHGLDDStatistics {
+  /// The number of HGLDD files emitted.
+  uint64_t numFiles = 0;
+  /// The number of modules, instances, and variables described.
+  uint64_t numObjects = 0;
+  /// The number of bytes of HGLDD emitted.
+  uint64_t numBytes = 0;
+};
+
 /// Serialize the debug information in the given `module` into the HGLDD format
-/// and writes it to `output`.
+/// and writes it to `output`. The files are emitted in parallel.
 LogicalResult emitHGLDD(Operation *module, llvm::raw_ostream &os,
-                        const EmitHGLDDOptions &options = {});
+                        const EmitHGLDDOptions &options = {},
+                        EmitHGLDDStatistics *statistics = nullptr);
 
 /// Serialize the debug information in the given `module` into the HGLDD format
 /// and emit one companion HGLDD file per emitted HDL file. This requires that
 /// a prior emission pass such as `ExportVerilog` has annotated emission
-/// locations on the operations in `module`.
+/// locations on the operations in `module`. The files are emitted in parallel.
 LogicalResult emitSplitHGLDD(Operation *module,
-                             const EmitHGLDDOptions &options = {});
+                             const EmitHGLDDOptions &options = {},
+                             EmitHGLDDStatistics *statistics = nullptr);
 
 } // namespace debug
 } // namespace circt
@@ -24,3 +24,15 @@ try:
   assert False, "above should have thrown exception"
 except capnp.lib.capnp.KjException:
   pass
+
+# Issue several requests before waiting on any of them. Each response must be
+# paired with its own request.
+addrs = [8 * i for i in range(1, 9)]
+writes = [c.low.writeMMIO(addr, addr * 3 + 1) for addr in addrs]
+for w in writes:
+  w.wait()
+reads = [c.low.readMMIO(addr) for addr in addrs]
+for addr, read in reversed(list(zip(addrs, reads))):
+  r = read.wait()
+  print(f"data resp for 0x{addr:x}: 0x{r.data:x}")
+  assert r.data == addr * 3 + 1
@@ -1,5 +1,6 @@
 // REQUIRES: esi-cosim, esi-runtime
 // RUN: esi-cosim-runner.py --exec %s.py %s
+// RUN: env COSIM_SHM=esi_basic_mmio_shm esi-cosim-runner.py --exec %S/basic_mmio_shm.py %s
 
 // Test the low level cosim MMIO functionality. This test has 1024 64-bit
 // registers as a memory. It is an error to write to register 0.
@@ -26,3 +26,11 @@ try:
   assert False, "above should have thrown exception"
 except Exception:
   print("caught expected exception")
+
+# Keep several accesses in flight at once and check that each read comes back
+# with its own register's value.
+addrs = [8 * i for i in range(1, 9)]
+mmio.write_batch([(addr, addr * 3 + 1) for addr in addrs])
+values = mmio.read_batch(addrs)
+print(f"batch resp: {values}")
+assert values == [addr * 3 + 1 for addr in addrs]
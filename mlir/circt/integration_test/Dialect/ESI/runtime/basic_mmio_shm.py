@@ -0,0 +1,54 @@
+# Run basic_mmio.sv through the shared memory backend. The simulation opens the
+# region because COSIM_SHM is set. The RPC host and port arguments are unused.
+
+import esi
+import os
+import subprocess
+import sys
+import threading
+import time
+
+shm = os.environ["COSIM_SHM"]
+
+if len(sys.argv) > 1 and sys.argv[1] == "--die-attached":
+  # Attach, put requests in flight and exit without detaching, like a client
+  # which crashed would.
+  acc = esi.Accelerator("cosim-shm", shm)
+  mmio = acc.get_service_mmio()
+  addrs = [8 * i for i in range(1, 1024)]
+  threading.Thread(target=lambda: mmio.read_batch(addrs), daemon=True).start()
+  time.sleep(0.1)
+  os._exit(0)
+
+subprocess.run([sys.executable, "-u", __file__, "--die-attached"], check=True)
+
+# The dead client's process ID is still in the region. Attaching must take over
+# from it and skip the responses to its requests.
+acc = esi.Accelerator("cosim-shm", shm)
+mmio = acc.get_service_mmio()
+
+try:
+  mmio.read(0)
+except Exception:
+  print("caught expected exception")
+else:
+  assert False, "above should have thrown exception"
+
+mmio.write(32, 86)
+r = mmio.read(32)
+print(f"data resp: 0x{r:x}")
+assert r == 86
+
+addrs = [8 * i for i in range(1, 9)]
+mmio.write_batch([(addr, addr * 3 + 1) for addr in addrs])
+values = mmio.read_batch(addrs)
+print(f"batch resp: {values}")
+assert values == [addr * 3 + 1 for addr in addrs]
+
+# Only one live client may be attached at a time.
+try:
+  esi.Accelerator("cosim-shm", shm)
+except Exception:
+  print("caught expected exception")
+else:
+  assert False, "above should have thrown exception"
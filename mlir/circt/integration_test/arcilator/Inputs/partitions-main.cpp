@@ -0,0 +1,15 @@
+#include "Counters.h"
+
+void print(CountersView &view);
+
+int main() {
+  Counters model;
+  for (unsigned i = 0; i < 5; ++i) {
+    model.view.clock = 0;
+    model.eval();
+    model.view.clock = 1;
+    model.eval();
+  }
+  print(model.view);
+  return 0;
+}
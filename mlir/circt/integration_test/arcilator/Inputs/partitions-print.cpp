@@ -0,0 +1,8 @@
+#include "Counters.h"
+
+#include <iostream>
+
+void print(CountersView &view) {
+  std::cout << "a = " << unsigned(view.a) << ", b = " << unsigned(view.b)
+            << "\n";
+}
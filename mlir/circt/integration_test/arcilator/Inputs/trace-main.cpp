@@ -0,0 +1,21 @@
+#include "Counter.h"
+
+#include <fstream>
+
+int main(int argc, char **argv) {
+  if (argc != 2)
+    return 1;
+  std::ofstream os(argv[1], std::ios::binary);
+  Counter model;
+  auto trace = model.trace(os);
+  for (unsigned i = 0; i < 3; ++i) {
+    model.view.clock = 1;
+    model.eval();
+    trace->writeTimestep(1);
+    model.view.clock = 0;
+    model.eval();
+    trace->writeTimestep(1);
+  }
+  trace->close();
+  return 0;
+}
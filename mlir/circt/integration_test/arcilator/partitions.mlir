@@ -0,0 +1,23 @@
+// REQUIRES: arcilator-cxx, python
+// RUN: rm -rf %t && mkdir -p %t
+// RUN: arcilator %s --partitions=2 --state-file=%t/state.json -o %t/model.ll
+// RUN: %PYTHON% %CIRCT_SOURCE%/tools/arcilator/arcilator-header-cpp.py %t/state.json > %t/Counters.h
+// RUN: llc -O1 -filetype=obj -relocation-model=pic %t/model.ll -o %t/model.o
+// RUN: %host_cxx -std=c++17 -O1 -I%t -I%CIRCT_SOURCE%/tools/arcilator %S/Inputs/partitions-main.cpp %S/Inputs/partitions-print.cpp %t/model.o -o %t/counters -lpthread
+// RUN: %t/counters | FileCheck %s
+
+// The generated header is included from two translation units, which must link
+// without duplicate definitions. The two counters end up in different
+// partitions, which run on separate threads.
+
+// CHECK: a = 5, b = 15
+
+hw.module @Counters(in %clock: !seq.clock, out a: i8, out b: i8) {
+  %c1_i8 = hw.constant 1 : i8
+  %c3_i8 = hw.constant 3 : i8
+  %a = seq.compreg %0, %clock : i8
+  %b = seq.compreg %1, %clock : i8
+  %0 = comb.add %a, %c1_i8 : i8
+  %1 = comb.add %b, %c3_i8 : i8
+  hw.output %a, %b : i8, i8
+}
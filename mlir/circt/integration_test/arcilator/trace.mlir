@@ -0,0 +1,48 @@
+// REQUIRES: arcilator-cxx, python
+// RUN: rm -rf %t && mkdir -p %t
+// RUN: arcilator %s --state-file=%t/state.json -o %t/model.ll
+// RUN: %PYTHON% %CIRCT_SOURCE%/tools/arcilator/arcilator-header-cpp.py %t/state.json > %t/Counter.h
+// RUN: llc -O1 -filetype=obj -relocation-model=pic %t/model.ll -o %t/model.o
+// RUN: %host_cxx -std=c++17 -O1 -I%t -I%CIRCT_SOURCE%/tools/arcilator %S/Inputs/trace-main.cpp %t/model.o -o %t/counter -lpthread
+// RUN: %t/counter %t/counter.trace
+// RUN: %PYTHON% %CIRCT_SOURCE%/tools/arcilator/arcilator-trace-to-vcd.py %t/counter.trace -o %t/counter.vcd
+// RUN: FileCheck %s < %t/counter.vcd
+
+// The trace of a model with dirty flags only visits the states written in each
+// timestep, and must convert to the same waveform.
+// RUN: arcilator %s --dirty-flags --state-file=%t/state-dirty.json -o %t/model-dirty.ll
+// RUN: mkdir -p %t/dirty
+// RUN: %PYTHON% %CIRCT_SOURCE%/tools/arcilator/arcilator-header-cpp.py %t/state-dirty.json > %t/dirty/Counter.h
+// RUN: llc -O1 -filetype=obj -relocation-model=pic %t/model-dirty.ll -o %t/model-dirty.o
+// RUN: %host_cxx -std=c++17 -O1 -I%t/dirty -I%CIRCT_SOURCE%/tools/arcilator %S/Inputs/trace-main.cpp %t/model-dirty.o -o %t/counter-dirty -lpthread
+// RUN: %t/counter-dirty %t/counter-dirty.trace
+// RUN: %PYTHON% %CIRCT_SOURCE%/tools/arcilator/arcilator-trace-to-vcd.py %t/counter-dirty.trace -o %t/counter-dirty.vcd
+// RUN: diff %t/counter.vcd %t/counter-dirty.vcd
+
+// CHECK:      $scope module Counter $end
+// CHECK-DAG:  $var wire 1 [[CLOCK:.+]] clock $end
+// CHECK-DAG:  $var wire 8 [[COUNT:.+]] count [7:0] $end
+// CHECK:      $enddefinitions $end
+// CHECK-NEXT: $dumpvars
+// CHECK-DAG:  0[[CLOCK]]
+// CHECK-DAG:  b00000000 [[COUNT]]
+// CHECK:      #1
+// CHECK-DAG:  1[[CLOCK]]
+// CHECK-DAG:  b00000001 [[COUNT]]
+// CHECK:      #2
+// CHECK-NOT:  [[COUNT]]
+// CHECK:      0[[CLOCK]]
+// CHECK-NOT:  [[COUNT]]
+// CHECK:      #3
+// CHECK-DAG:  1[[CLOCK]]
+// CHECK-DAG:  b00000010 [[COUNT]]
+// CHECK:      #5
+// CHECK-DAG:  1[[CLOCK]]
+// CHECK-DAG:  b00000011 [[COUNT]]
+
+hw.module @Counter(in %clock: !seq.clock, out count: i8) {
+  %c1_i8 = hw.constant 1 : i8
+  %count = seq.compreg %0, %clock : i8
+  %0 = comb.add %count, %c1_i8 : i8
+  hw.output %count : i8
+}
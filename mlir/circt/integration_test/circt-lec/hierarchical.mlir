@@ -0,0 +1,66 @@
+// These tests will be only enabled if circt-lec is built.
+// REQUIRES: circt-lec
+
+hw.module @addAB(in %a: i4, in %b: i4, out out: i4) {
+  %sum = comb.add bin %a, %b : i4
+  hw.output %sum : i4
+}
+
+hw.module @addBA(in %a: i4, in %b: i4, out out: i4) {
+  %sum = comb.add bin %b, %a : i4
+  hw.output %sum : i4
+}
+
+hw.module @subAB(in %a: i4, in %b: i4, out out: i4) {
+  %diff = comb.sub bin %a, %b : i4
+  hw.output %diff : i4
+}
+
+hw.module @top1(in %a: i4, in %b: i4, in %c: i4, out out: i4) {
+  %sum = hw.instance "adder" @addAB(a: %a: i4, b: %b: i4) -> (out: i4)
+  %out = comb.xor bin %sum, %c : i4
+  hw.output %out : i4
+}
+
+hw.module @top2(in %a: i4, in %b: i4, in %c: i4, out out: i4) {
+  %sum = hw.instance "adder" @addBA(a: %a: i4, b: %b: i4) -> (out: i4)
+  %out = comb.xor bin %c, %sum : i4
+  hw.output %out : i4
+}
+
+hw.module @top3(in %a: i4, in %b: i4, in %c: i4, out out: i4) {
+  %diff = hw.instance "adder" @subAB(a: %a: i4, b: %b: i4) -> (out: i4)
+  %out = comb.xor bin %diff, %c : i4
+  hw.output %out : i4
+}
+
+// Equivalent hierarchies
+//  RUN: circt-lec %s -c1=top1 -c2=top2 -hierarchical -s -v=false | FileCheck %s --check-prefix=EQUAL
+//  EQUAL: c1 == c2
+//  EQUAL: Decomposition statistics:
+//  EQUAL: module pairs : 2
+//  EQUAL: identical : 0
+//  EQUAL: cached : 0
+//  EQUAL: proven : 2
+//  EQUAL: inlined rechecks : 0
+//  EQUAL: not equivalent : 0
+
+// Identical modules
+//  RUN: circt-lec %s -c1=top1 -c2=top1 -hierarchical -s -v=false | FileCheck %s --check-prefix=IDENTICAL
+//  IDENTICAL: c1 == c2
+//  IDENTICAL: identical : 2
+
+// Different instanced modules
+//  RUN: not circt-lec %s -c1=top1 -c2=top3 -hierarchical -s -v=false | FileCheck %s --check-prefix=DIFFERENT
+//  DIFFERENT: c1 != c2
+//  DIFFERENT: Decomposition statistics:
+//  DIFFERENT: not equivalent : 2
+
+// Proofs reused from the cache
+//  RUN: rm -f %t.cache
+//  RUN: circt-lec %s -c1=top1 -c2=top2 --cache=%t.cache -v=false | FileCheck %s --check-prefix=SOLVED
+//  SOLVED: c1 == c2
+//  RUN: circt-lec %s -c1=top1 -c2=top2 --cache=%t.cache -s -v=false | FileCheck %s --check-prefix=CACHED
+//  CACHED: c1 == c2
+//  CACHED: cached : 2
+//  CACHED: proven : 0
@@ -200,6 +200,14 @@ if config.clang_tidy_path != "":
 if config.have_systemc != "":
   config.available_features.add('systemc')
 
+# Enable arcilator tests that compile the model and its C++ header into an
+# executable, if a C++ compiler and llc are available.
+tools.append('arcilator')
+if config.host_cxx != "" and shutil.which('llc', path=config.llvm_tools_dir):
+  tools.append('llc')
+  config.available_features.add('arcilator-cxx')
+  config.substitutions.append(('%host_cxx', config.host_cxx))
+
 # Enable circt-lec tests if it is built.
 if config.lec_enabled != "":
   config.available_features.add('circt-lec')
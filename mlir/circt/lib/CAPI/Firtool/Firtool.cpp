@@ -231,6 +231,7 @@ DEFINE_FIRTOOL_OPTION_STRING(CkgTestEnableName, ckgTestEnableName)
 DEFINE_FIRTOOL_OPTION_BOOL(ExportModuleHierarchy, exportModuleHierarchy)
 DEFINE_FIRTOOL_OPTION_BOOL(StripFirDebugInfo, stripFirDebugInfo)
 DEFINE_FIRTOOL_OPTION_BOOL(StripDebugInfo, stripDebugInfo)
+DEFINE_FIRTOOL_OPTION_STRING(EmissionCacheDirectory, emissionCacheDirectory)
 
 #undef DEFINE_FIRTOOL_OPTION_STRING
 #undef DEFINE_FIRTOOL_OPTION_BOOL
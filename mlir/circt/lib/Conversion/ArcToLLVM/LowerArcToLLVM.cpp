@@ -20,6 +20,7 @@
 #include "mlir/Conversion/LLVMCommon/ConversionTarget.h"
 #include "mlir/Conversion/LLVMCommon/TypeConverter.h"
 #include "mlir/Conversion/SCFToControlFlow/SCFToControlFlow.h"
+#include "mlir/Dialect/Arith/IR/Arith.h"
 #include "mlir/Dialect/ControlFlow/IR/ControlFlow.h"
 #include "mlir/Dialect/Func/IR/FuncOps.h"
 #include "mlir/Dialect/LLVMIR/LLVMAttrs.h"
@@ -47,6 +48,8 @@ struct ModelOpLowering : public OpConversionPattern<arc::ModelOp> {
   LogicalResult
   matchAndRewrite(arc::ModelOp op, OpAdaptor adaptor,
                   ConversionPatternRewriter &rewriter) const final {
+    if (auto batchAttr = op->getAttrOfType<IntegerAttr>("batch"))
+      return lowerBatch(op, batchAttr.getValue().getZExtValue(), rewriter);
     {
       IRRewriter::InsertionGuard guard(rewriter);
       rewriter.setInsertionPointToEnd(&op.getBodyBlock());
@@ -61,6 +64,30 @@ struct ModelOpLowering : public OpConversionPattern<arc::ModelOp> {
     rewriter.eraseOp(op);
     return success();
   }
+
+  /// Lower a batched model. The eval function only takes the storage, and
+  /// evaluates the model's body once for every copy of the design, one after
+  /// the other.
+  LogicalResult lowerBatch(arc::ModelOp op, uint64_t batchSize,
+                           ConversionPatternRewriter &rewriter) const {
+    auto loc = op.getLoc();
+    auto storageType = op.getBodyBlock().getArgument(0).getType();
+    auto funcName = rewriter.getStringAttr(op.getName() + "_eval");
+    auto funcType = rewriter.getFunctionType({storageType}, {});
+    auto func = rewriter.create<mlir::func::FuncOp>(loc, funcName, funcType);
+    auto *entryBlock = rewriter.createBlock(
+        &func.getBody(), func.getBody().end(), {storageType}, {loc});
+    Value lowerBound = rewriter.create<arith::ConstantIndexOp>(loc, 0);
+    Value upperBound = rewriter.create<arith::ConstantIndexOp>(loc, batchSize);
+    Value step = rewriter.create<arith::ConstantIndexOp>(loc, 1);
+    auto forOp = rewriter.create<scf::ForOp>(loc, lowerBound, upperBound, step);
+    rewriter.create<func::ReturnOp>(loc);
+    rewriter.inlineBlockBefore(
+        &op.getBodyBlock(), forOp.getBody()->getTerminator(),
+        ValueRange{entryBlock->getArgument(0), forOp.getInductionVar()});
+    rewriter.eraseOp(op);
+    return success();
+  }
 };
 
 struct AllocStorageOpLowering
@@ -174,6 +201,33 @@ struct StorageGetOpLowering : public OpConversionPattern<arc::StorageGetOp> {
   }
 };
 
+struct StorageGetCopyOpLowering
+    : public OpConversionPattern<arc::StorageGetCopyOp> {
+  using OpConversionPattern::OpConversionPattern;
+  LogicalResult
+  matchAndRewrite(arc::StorageGetCopyOp op, OpAdaptor adaptor,
+                  ConversionPatternRewriter &rewriter) const final {
+    // Compute `offset + copy * copyStride` as a 64 bit byte offset.
+    auto loc = op.getLoc();
+    auto i64Type = rewriter.getI64Type();
+    Value copy = rewriter.create<arith::IndexCastUIOp>(loc, i64Type,
+                                                       adaptor.getCopy());
+    Value copyStride = rewriter.create<LLVM::ConstantOp>(
+        loc, i64Type, rewriter.getI64IntegerAttr(op.getCopyStride()));
+    Value offset = rewriter.create<LLVM::ConstantOp>(
+        loc, i64Type, rewriter.getI64IntegerAttr(op.getOffset()));
+    Value copyOffset = rewriter.create<LLVM::MulOp>(loc, copy, copyStride);
+    offset = rewriter.create<LLVM::AddOp>(loc, offset, copyOffset);
+    Value ptr = rewriter.create<LLVM::GEPOp>(
+        loc, adaptor.getStorage().getType(), adaptor.getStorage(), offset);
+    auto type = typeConverter->convertType(op.getType());
+    if (type != ptr.getType())
+      ptr = rewriter.create<LLVM::BitcastOp>(loc, type, ptr);
+    rewriter.replaceOp(op, ptr);
+    return success();
+  }
+};
+
 struct MemoryAccess {
   Value ptr;
   Value withinBounds;
@@ -353,9 +407,10 @@ static void populateLegality(ConversionTarget &target) {
   target.addIllegalOp<arc::PassThroughOp>();
 
   target.addDynamicallyLegalOp<func::FuncOp>([](func::FuncOp op) {
-    auto argsConverted = llvm::none_of(op.getBlocks(), [](auto &block) {
-      return hasArcType(block.getArguments());
-    });
+    auto argsConverted = !hasArcType(op.getArgumentTypes()) &&
+                         llvm::none_of(op.getBlocks(), [](auto &block) {
+                           return hasArcType(block.getArguments());
+                         });
     auto resultsConverted = !hasArcType(op.getResultTypes());
     return argsConverted && resultsConverted;
   });
@@ -380,6 +435,7 @@ static void populateTypeConversion(TypeConverter &typeConverter) {
   });
   typeConverter.addConversion([](hw::ArrayType type) { return type; });
   typeConverter.addConversion([](mlir::IntegerType type) { return type; });
+  typeConverter.addConversion([](mlir::IndexType type) { return type; });
 }
 
 static void populateOpConversion(RewritePatternSet &patterns,
@@ -402,6 +458,7 @@ static void populateOpConversion(RewritePatternSet &patterns,
     ReturnOpLowering,
     StateReadOpLowering,
     StateWriteOpLowering,
+    StorageGetCopyOpLowering,
     StorageGetOpLowering,
     ZeroCountOpLowering
   >(typeConverter, context);
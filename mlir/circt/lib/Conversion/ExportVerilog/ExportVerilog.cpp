@@ -45,11 +45,17 @@
 #include "mlir/Support/FileUtilities.h"
 #include "llvm/ADT/MapVector.h"
 #include "llvm/ADT/STLExtras.h"
+#include "llvm/ADT/Sequence.h"
+#include "llvm/ADT/StringExtras.h"
 #include "llvm/ADT/StringSet.h"
 #include "llvm/ADT/TypeSwitch.h"
+#include "llvm/Support/CachePruning.h"
 #include "llvm/Support/FileSystem.h"
 #include "llvm/Support/FormattedStream.h"
+#include "llvm/Support/MemoryBuffer.h"
 #include "llvm/Support/Path.h"
+#include "llvm/Support/Process.h"
+#include "llvm/Support/SHA256.h"
 #include "llvm/Support/SaveAndRestore.h"
 #include "llvm/Support/ToolOutputFile.h"
 #include "llvm/Support/raw_ostream.h"
@@ -1026,6 +1032,10 @@ public:
         verilogLocMap(verilogLocMap), pp(os, options.emittedLineLength),
         fileName(fileName) {
     pp.setListener(&saver);
+    // Bound the tokens buffered by the pretty printer. Strings come with a
+    // handful of zero-width tokens at most, so this only affects the layout of
+    // groups far wider than a line.
+    pp.setLookaheadLimit(std::max(8192U, 16 * options.emittedLineLength));
   }
   /// This is the root mlir::ModuleOp that holds the whole design being emitted.
   ModuleOp designOp;
@@ -1070,6 +1080,24 @@ public:
   /// Pretty printer.
   PrettyPrinter pp;
 
+  /// Token buffer lent to the expression and property emitters, so that its
+  /// storage is reused across statements.
+  SmallVector<Token> reusableTokens;
+
+  /// Lend `reusableTokens` to an emitter's empty token buffer.
+  void borrowTokens(SmallVectorImpl<Token> &tokens) {
+    assert(tokens.empty());
+    tokens.swap(reusableTokens);
+  }
+
+  /// Take back a buffer lent by `borrowTokens`. When emitters are nested, only
+  /// the largest buffer is kept.
+  void returnTokens(SmallVectorImpl<Token> &tokens) {
+    tokens.clear();
+    if (tokens.capacity() > reusableTokens.capacity())
+      tokens.swap(reusableTokens);
+  }
+
   /// Name of the output file, used for debug information.
   StringAttr fileName;
 
@@ -2054,6 +2082,13 @@ public:
         emittedExprs(emittedExprs), buffer(tokens),
         ps(buffer, state.saver, state.options.emitVerilogLocations) {
     assert(state.pp.getListener() == &state.saver);
+    if (&buffer.tokens == &localTokens)
+      state.borrowTokens(localTokens);
+  }
+
+  ~ExprEmitter() {
+    if (&buffer.tokens == &localTokens)
+      state.returnTokens(localTokens);
   }
 
   /// Emit the specified value as an expression.  If this is an inline-emitted
@@ -3273,6 +3308,13 @@ public:
         buffer(tokens),
         ps(buffer, state.saver, state.options.emitVerilogLocations) {
     assert(state.pp.getListener() == &state.saver);
+    if (&buffer.tokens == &localTokens)
+      state.borrowTokens(localTokens);
+  }
+
+  ~PropertyEmitter() {
+    if (&buffer.tokens == &localTokens)
+      state.returnTokens(localTokens);
   }
 
   /// Emit the specified value as an SVA property or sequence. This is the entry
@@ -6140,10 +6182,12 @@ static void emitOperation(VerilogEmitterState &state, Operation *op) {
 }
 
 /// Actually emit the collected list of operations and strings to the
-/// specified file.
-void SharedEmitterState::emitOps(EmissionList &thingsToEmit,
-                                 llvm::formatted_raw_ostream &os,
-                                 StringAttr fileName, bool parallelize) {
+/// specified file. Returns failure if an error was encountered while emitting
+/// them.
+LogicalResult SharedEmitterState::emitOps(EmissionList &thingsToEmit,
+                                          llvm::formatted_raw_ostream &os,
+                                          StringAttr fileName,
+                                          bool parallelize) {
   MLIRContext *context = designOp->getContext();
 
   // Disable parallelization overhead if MLIR threading is disabled.
@@ -6175,11 +6219,12 @@ void SharedEmitterState::emitOps(EmissionList &thingsToEmit,
 
     if (state.encounteredError)
       encounteredError = true;
-    return;
+    return failure(state.encounteredError);
   }
 
   // If we are parallelizing emission, we emit each independent operation to a
   // string buffer in parallel, then concat at the end.
+  std::atomic<bool> failed = false;
   parallelForEach(context, thingsToEmit, [&](StringOrOpToEmit &stringOrOp) {
     auto *op = stringOrOp.getOperation();
     if (!op)
@@ -6200,6 +6245,8 @@ void SharedEmitterState::emitOps(EmissionList &thingsToEmit,
                               globalNames, rs, fileName,
                               stringOrOp.verilogLocs);
     emitOperation(state, op);
+    if (state.encounteredError)
+      failed = true;
     stringOrOp.setString(buffer);
   });
 
@@ -6224,7 +6271,10 @@ void SharedEmitterState::emitOps(EmissionList &thingsToEmit,
                               globalNames, os, fileName, entry.verilogLocs);
     emitOperation(state, op);
     state.addVerilogLocToOps(0, fileName);
+    if (state.encounteredError)
+      failed = true;
   }
+  return failure(failed);
 }
 
 //===----------------------------------------------------------------------===//
@@ -6269,8 +6319,8 @@ static LogicalResult exportVerilogImpl(ModuleOp module, llvm::raw_ostream &os) {
   // Finally, emit all the ops we collected.
   // output file name is not known, it can be specified as command line
   // argument.
-  emitter.emitOps(list, rs, StringAttr::get(module.getContext(), ""),
-                  /*parallelize=*/true);
+  (void)emitter.emitOps(list, rs, StringAttr::get(module.getContext(), ""),
+                        /*parallelize=*/true);
   return failure(emitter.encounteredError);
 }
 
@@ -6362,9 +6412,173 @@ createOutputFile(StringRef fileName, StringRef dirname,
   return output;
 }
 
+namespace {
+/// A stream that feeds everything written to it into a SHA256 hash. This is
+/// used to compute content hashes of the IR without materializing its textual
+/// form in memory.
+class HashingOStream : public llvm::raw_ostream {
+public:
+  ~HashingOStream() override { flush(); }
+
+  /// Return the hash of everything written so far as a hex string.
+  std::string getHexDigest() {
+    flush();
+    return llvm::toHex(sha.final(), /*LowerCase=*/true);
+  }
+
+private:
+  void write_impl(const char *ptr, size_t size) override {
+    sha.update(ArrayRef<uint8_t>(reinterpret_cast<const uint8_t *>(ptr), size));
+    pos += size;
+  }
+  uint64_t current_pos() const override { return pos; }
+
+  llvm::SHA256 sha;
+  uint64_t pos = 0;
+};
+} // namespace
+
+/// Compute the key under which the emitted contents of an output file are
+/// stored in the emission cache. The key covers everything the emitter looks
+/// at: the name of the file relative to the output directory, the operations
+/// in the file (including their locations), the signatures and Verilog names
+/// of any symbols they refer to, such as instantiated modules, the Verilog
+/// names of the ports and declarations that inner symbol references resolve
+/// to, e.g. in verbatim substitutions, the lowering options, and the compiler
+/// version. Returns `std::nullopt` if the file cannot be cached because its
+/// contents depend on IR we do not track.
+static std::optional<std::string>
+getEmissionCacheKey(StringAttr fileName,
+                    const SharedEmitterState::EmissionList &list,
+                    SharedEmitterState &emitter) {
+  // Emitting Verilog locations mutates the IR, which a cache hit would skip.
+  if (emitter.options.emitVerilogLocations)
+    return std::nullopt;
+
+  HashingOStream os;
+  os << getCirctVersion() << '\0' << emitter.options.toString() << '\0'
+     << fileName.getValue() << '\0';
+
+  auto flags = OpPrintingFlags()
+                   .useLocalScope()
+                   .printGenericOpForm()
+                   .enableDebugInfo();
+  auto signatureFlags = OpPrintingFlags(flags).skipRegions();
+
+  // Hash the legalized names of the parameters of a module-like operation.
+  auto hashParameters = [&](Operation *op) {
+    auto params = op->getAttrOfType<ArrayAttr>("parameters");
+    if (!params)
+      return;
+    for (auto param : params.getAsRange<ParamDeclAttr>())
+      os << emitter.globalNames.getParameterVerilogName(op, param.getName())
+         << '\0';
+  };
+
+  SmallPtrSet<Operation *, 8> referencedOps;
+  SmallVector<InnerRefAttr> innerRefs;
+  for (auto &entry : list) {
+    auto *op = entry.getOperation();
+    if (!op) {
+      os << entry.getStringData() << '\0';
+      continue;
+    }
+
+    // Binds and XMRs reach into the bodies of other modules, which are not
+    // covered by the hash.
+    bool isCacheable = true;
+    op->walk([&](Operation *nested) {
+      if (isa<BindOp, BindInterfaceOp, XMRRefOp>(nested)) {
+        isCacheable = false;
+        return WalkResult::interrupt();
+      }
+      nested->getAttrDictionary().walk([&](Attribute attr) {
+        if (auto innerRef = dyn_cast<InnerRefAttr>(attr)) {
+          innerRefs.push_back(innerRef);
+          return;
+        }
+        auto ref = dyn_cast<SymbolRefAttr>(attr);
+        if (!ref)
+          return;
+        auto *def = emitter.symbolCache.getDefinition(ref.getRootReference());
+        if (!def)
+          return;
+        if (def != op)
+          referencedOps.insert(def);
+        // Paths are emitted as the names of each step along them.
+        if (auto path = dyn_cast<HierPathOp>(def))
+          for (auto step : path.getNamepathAttr())
+            if (auto innerRef = dyn_cast<InnerRefAttr>(step))
+              innerRefs.push_back(innerRef);
+      });
+      return WalkResult::advance();
+    });
+    if (!isCacheable)
+      return std::nullopt;
+
+    op->print(os, flags);
+    hashParameters(op);
+  }
+
+  // The output also depends on the interface of the symbols referenced from
+  // this file, e.g. the port names of instantiated modules.
+  SmallVector<Operation *> sortedReferencedOps(referencedOps.begin(),
+                                               referencedOps.end());
+  llvm::sort(sortedReferencedOps, [](Operation *lhs, Operation *rhs) {
+    return SymbolTable::getSymbolName(lhs).getValue() <
+           SymbolTable::getSymbolName(rhs).getValue();
+  });
+  for (auto *op : sortedReferencedOps) {
+    op->print(os, signatureFlags);
+    os << getSymOpName(op) << '\0';
+    hashParameters(op);
+  }
+
+  // Inner symbol references resolve to ports and declarations in the bodies of
+  // other modules, which the signatures above do not cover. Hash the names
+  // they are emitted as.
+  llvm::sort(innerRefs, [](InnerRefAttr lhs, InnerRefAttr rhs) {
+    return std::make_pair(lhs.getModule().getValue(),
+                          lhs.getName().getValue()) <
+           std::make_pair(rhs.getModule().getValue(), rhs.getName().getValue());
+  });
+  innerRefs.erase(std::unique(innerRefs.begin(), innerRefs.end()),
+                  innerRefs.end());
+  for (auto innerRef : innerRefs) {
+    os << innerRef.getModule().getValue() << "::"
+       << innerRef.getName().getValue() << '\0';
+    if (auto *module = emitter.symbolCache.getDefinition(innerRef.getModule()))
+      os << getSymOpName(module);
+    os << '\0';
+    auto item = emitter.symbolCache.getInnerDefinition(innerRef);
+    if (auto *target = item.getOp())
+      os << (item.hasPort() ? getPortVerilogName(target, item.getPort())
+                            : getSymOpName(target));
+    os << '\0';
+  }
+
+  return os.getHexDigest();
+}
+
+/// Copy the emitted output file into the cache. The file is written under a
+/// temporary name and renamed into place, such that concurrent compilations
+/// sharing a cache directory never observe partially written entries.
+static void storeInEmissionCache(StringRef outputPath, StringRef cachePath) {
+  SmallString<128> tempPath;
+  int fd;
+  if (llvm::sys::fs::createUniqueFile(cachePath + ".tmp-%%%%%%%%", fd,
+                                      tempPath))
+    return;
+  llvm::sys::Process::SafelyCloseFileDescriptor(fd);
+  if (llvm::sys::fs::copy_file(outputPath, tempPath) ||
+      llvm::sys::fs::rename(tempPath, cachePath))
+    llvm::sys::fs::remove(tempPath);
+}
+
 static void createSplitOutputFile(StringAttr fileName, FileInfo &file,
-                                  StringRef dirname,
-                                  SharedEmitterState &emitter) {
+                                  StringRef dirname, StringRef cacheDirname,
+                                  SharedEmitterState &emitter,
+                                  std::atomic<unsigned> &numCacheHits) {
   auto output = createOutputFile(fileName, dirname, emitter);
   if (!output)
     return;
@@ -6373,19 +6587,84 @@ static void createSplitOutputFile(StringAttr fileName, FileInfo &file,
   emitter.collectOpsForFile(file, list,
                             emitter.options.emitReplicatedOpsToHeader);
 
-  llvm::formatted_raw_ostream rs(output->os());
-  // Emit the file, copying the global options into the individual module
-  // state.  Don't parallelize emission of the ops within this file - we
-  // already parallelize per-file emission and we pay a string copy overhead
-  // for parallelization.
-  emitter.emitOps(list, rs,
-                  StringAttr::get(fileName.getContext(), output->getFilename()),
-                  /*parallelize=*/false);
+  // If we have an emission cache, check whether this exact file has been
+  // emitted before and reuse its contents.
+  SmallString<128> cachePath;
+  if (!cacheDirname.empty()) {
+    if (auto key = getEmissionCacheKey(fileName, list, emitter)) {
+      cachePath = cacheDirname;
+      // `pruneCache` only ever deletes files with the "llvmcache-" prefix.
+      llvm::sys::path::append(cachePath, "llvmcache-" + *key + ".sv");
+      if (auto buffer = llvm::MemoryBuffer::getFile(cachePath)) {
+        output->os() << (*buffer)->getBuffer();
+        output->keep();
+        ++numCacheHits;
+        return;
+      }
+    }
+  }
+
+  LogicalResult result = success();
+  {
+    llvm::formatted_raw_ostream rs(output->os());
+    // Emit the file, copying the global options into the individual module
+    // state.  Don't parallelize emission of the ops within this file - we
+    // already parallelize per-file emission and we pay a string copy overhead
+    // for parallelization.
+    result = emitter.emitOps(
+        list, rs, StringAttr::get(fileName.getContext(), output->getFilename()),
+        /*parallelize=*/false);
+  }
   output->keep();
+
+  // Never cache the output of a file whose emission failed.
+  if (!cachePath.empty() && succeeded(result)) {
+    output->os().flush();
+    storeInEmissionCache(output->getFilename(), cachePath);
+  }
+}
+
+/// Decide which of the `numShards` shards emits each file, balancing the number
+/// of operations emitted per shard. Returns the shard of each file, in the
+/// order of `emitter.files`. The assignment only depends on the IR, such that
+/// separate processes emitting different shards of the same IR agree on it.
+static SmallVector<unsigned>
+assignFilesToShards(const SharedEmitterState &emitter, unsigned numShards) {
+  auto numFiles = emitter.files.size();
+  SmallVector<size_t> fileSizes;
+  fileSizes.reserve(numFiles);
+  for (auto &it : emitter.files) {
+    size_t size = 1;
+    for (auto &opInfo : it.second.ops)
+      opInfo.op->walk([&](Operation *) { ++size; });
+    fileSizes.push_back(size);
+  }
+
+  // Hand out the largest files first, each to the shard with the fewest
+  // operations so far.
+  SmallVector<unsigned> order(llvm::seq<unsigned>(0, numFiles));
+  llvm::stable_sort(order, [&](unsigned a, unsigned b) {
+    return fileSizes[a] > fileSizes[b];
+  });
+  SmallVector<size_t> shardSizes(numShards, 0);
+  SmallVector<unsigned> fileShards(numFiles, 0);
+  for (auto file : order) {
+    auto *shard = llvm::min_element(shardSizes);
+    *shard += fileSizes[file];
+    fileShards[file] = shard - shardSizes.begin();
+  }
+  return fileShards;
 }
 
-static LogicalResult exportSplitVerilogImpl(ModuleOp module,
-                                            StringRef dirname) {
+static LogicalResult exportSplitVerilogImpl(ModuleOp module, StringRef dirname,
+                                            StringRef cacheDirname = {},
+                                            unsigned *numCacheHits = nullptr,
+                                            unsigned shardIndex = 0,
+                                            unsigned numShards = 1) {
+  if (numShards == 0 || shardIndex >= numShards)
+    return module.emitError("invalid shard ")
+           << shardIndex << " of " << numShards << " shards";
+
   // Prepare the ops in the module for emission and legalize the names that will
   // end up in the output.
   LoweringOptions options(module);
@@ -6411,12 +6690,48 @@ static LogicalResult exportSplitVerilogImpl(ModuleOp module,
     }
   }
 
+  // Create the emission cache directory if needed.
+  if (!cacheDirname.empty()) {
+    if (auto error = llvm::sys::fs::create_directories(cacheDirname)) {
+      module.emitError("cannot create emission cache directory \"")
+          << cacheDirname << "\": " << error.message();
+      return failure();
+    }
+  }
+
+  // When sharding, only emit the files assigned to this shard. Every shard
+  // legalizes names and gathers files for the entire design, such that the
+  // emitted files are identical to the ones an unsharded run would produce.
+  SmallVector<std::pair<StringAttr, FileInfo> *> filesToEmit;
+  filesToEmit.reserve(emitter.files.size());
+  if (numShards == 1) {
+    for (auto &it : emitter.files)
+      filesToEmit.push_back(&it);
+  } else {
+    auto fileShards = assignFilesToShards(emitter, numShards);
+    for (auto [shard, it] : llvm::zip(fileShards, emitter.files))
+      if (shard == shardIndex)
+        filesToEmit.push_back(&it);
+  }
+
   // Emit each file in parallel if context enables it.
-  parallelForEach(module->getContext(), emitter.files.begin(),
-                  emitter.files.end(), [&](auto &it) {
-                    createSplitOutputFile(it.first, it.second, dirname,
-                                          emitter);
-                  });
+  std::atomic<unsigned> cacheHits = 0;
+  parallelForEach(module->getContext(), filesToEmit, [&](auto *it) {
+    createSplitOutputFile(it->first, it->second, dirname, cacheDirname,
+                          emitter, cacheHits);
+  });
+  if (numCacheHits)
+    *numCacheHits = cacheHits;
+
+  // Drop cache entries which have not been used in a while, using the same
+  // default policy as the ThinLTO cache. The timestamp file in the directory
+  // keeps concurrent and back-to-back runs from all scanning it.
+  if (!cacheDirname.empty())
+    llvm::pruneCache(cacheDirname, llvm::CachePruningPolicy());
+
+  // The file lists are written by the first shard only.
+  if (shardIndex != 0)
+    return failure(emitter.encounteredError);
 
   // Write the file list.
   SmallString<128> filelistPath(dirname);
@@ -6448,7 +6763,10 @@ static LogicalResult exportSplitVerilogImpl(ModuleOp module,
   return failure(emitter.encounteredError);
 }
 
-LogicalResult circt::exportSplitVerilog(ModuleOp module, StringRef dirname) {
+LogicalResult circt::exportSplitVerilog(ModuleOp module, StringRef dirname,
+                                        StringRef cacheDirname,
+                                        unsigned shardIndex,
+                                        unsigned numShards) {
   LoweringOptions options(module);
   SmallVector<HWModuleOp> modulesToPrepare;
   module.walk([&](HWModuleOp op) { modulesToPrepare.push_back(op); });
@@ -6457,15 +6775,21 @@ LogicalResult circt::exportSplitVerilog(ModuleOp module, StringRef dirname) {
           [&](auto op) { return prepareHWModule(op, options); })))
     return failure();
 
-  return exportSplitVerilogImpl(module, dirname);
+  return exportSplitVerilogImpl(module, dirname, cacheDirname,
+                                /*numCacheHits=*/nullptr, shardIndex,
+                                numShards);
 }
 
 namespace {
 
 struct ExportSplitVerilogPass
     : public ExportSplitVerilogBase<ExportSplitVerilogPass> {
-  ExportSplitVerilogPass(StringRef directory) {
+  ExportSplitVerilogPass(StringRef directory, StringRef cacheDirectory,
+                         unsigned shardIndex, unsigned numShards) {
     directoryName = directory.str();
+    cacheDirectoryName = cacheDirectory.str();
+    this->shardIndex = shardIndex;
+    this->numShards = numShards;
   }
   void runOnOperation() override {
     // Prepare the ops in the module for emission.
@@ -6475,13 +6799,20 @@ struct ExportSplitVerilogPass
     if (failed(runPipeline(preparePM, getOperation())))
       return signalPassFailure();
 
-    if (failed(exportSplitVerilogImpl(getOperation(), directoryName)))
+    unsigned cacheHits = 0;
+    if (failed(exportSplitVerilogImpl(getOperation(), directoryName,
+                                      cacheDirectoryName, &cacheHits,
+                                      shardIndex, numShards)))
       return signalPassFailure();
+    numCacheHits += cacheHits;
   }
 };
 } // end anonymous namespace
 
 std::unique_ptr<mlir::Pass>
-circt::createExportSplitVerilogPass(StringRef directory) {
-  return std::make_unique<ExportSplitVerilogPass>(directory);
+circt::createExportSplitVerilogPass(StringRef directory,
+                                    StringRef cacheDirectory,
+                                    unsigned shardIndex, unsigned numShards) {
+  return std::make_unique<ExportSplitVerilogPass>(directory, cacheDirectory,
+                                                  shardIndex, numShards);
 }
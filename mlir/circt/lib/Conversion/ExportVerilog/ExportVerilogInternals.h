@@ -373,8 +373,9 @@ struct SharedEmitterState {
 
   void collectOpsForFile(const FileInfo &fileInfo, EmissionList &thingsToEmit,
                          bool emitHeader = false);
-  void emitOps(EmissionList &thingsToEmit, llvm::formatted_raw_ostream &os,
-               StringAttr fileName, bool parallelize);
+  LogicalResult emitOps(EmissionList &thingsToEmit,
+                        llvm::formatted_raw_ostream &os, StringAttr fileName,
+                        bool parallelize);
 };
 
 //===----------------------------------------------------------------------===//
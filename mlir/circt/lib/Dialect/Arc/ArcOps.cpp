@@ -249,8 +249,16 @@ void RootOutputOp::getAsmResultNames(OpAsmSetValueNameFn setNameFn) {
 //===----------------------------------------------------------------------===//
 
 LogicalResult ModelOp::verify() {
-  if (getBodyBlock().getArguments().size() != 1)
+  // Batched models, which simulate several copies of the design, additionally
+  // take the index of the copy to evaluate as a second argument.
+  if (getOperation()->hasAttr("batch")) {
+    if (getBodyBlock().getArguments().size() != 2)
+      return emitOpError("with batch must have exactly two arguments");
+    if (!getBodyBlock().getArgument(1).getType().isIndex())
+      return emitOpError("copy argument must be of index type");
+  } else if (getBodyBlock().getArguments().size() != 1) {
     return emitOpError("must have exactly one argument");
+  }
   if (auto type = getBodyBlock().getArgument(0).getType();
       !isa<StorageType>(type))
     return emitOpError("argument must be of storage type");
@@ -0,0 +1,115 @@
+//===- AddDirtyFlags.cpp --------------------------------------------------===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+
+#include "circt/Dialect/Arc/ArcOps.h"
+#include "circt/Dialect/Arc/ArcPasses.h"
+#include "circt/Dialect/HW/HWOps.h"
+#include "mlir/IR/ImplicitLocOpBuilder.h"
+#include "mlir/Pass/Pass.h"
+#include "llvm/Support/Debug.h"
+
+#define DEBUG_TYPE "arc-add-dirty-flags"
+
+namespace circt {
+namespace arc {
+#define GEN_PASS_DEF_ADDDIRTYFLAGS
+#include "circt/Dialect/Arc/ArcPasses.h.inc"
+} // namespace arc
+} // namespace circt
+
+using namespace mlir;
+using namespace circt;
+using namespace arc;
+
+//===----------------------------------------------------------------------===//
+// Pass Implementation
+//===----------------------------------------------------------------------===//
+
+namespace {
+struct AddDirtyFlagsPass
+    : public arc::impl::AddDirtyFlagsBase<AddDirtyFlagsPass> {
+  void runOnOperation() override;
+};
+} // namespace
+
+void AddDirtyFlagsPass::runOnOperation() {
+  ModelOp modelOp = getOperation();
+  LLVM_DEBUG(llvm::dbgs() << "Adding dirty flags to `" << modelOp.getName()
+                          << "`\n");
+
+  if (modelOp->hasAttr("batch")) {
+    modelOp.emitOpError(
+        "dirty flags are not supported in batched models");
+    return signalPassFailure();
+  }
+
+  auto storageArg = modelOp.getBody().getArgument(0);
+  auto storageType = storageArg.getType().cast<StorageType>();
+
+  // Assign a flag to every named state, output, and memory, in the bytes
+  // following the existing storage. States are identified by their offset,
+  // which is all the accessors created by `arc-allocate-state` carry.
+  OpBuilder builder(modelOp);
+  unsigned flagsOffset = storageType.getSize();
+  DenseMap<uint32_t, IntegerAttr> flagsByOffset;
+  for (auto &op : modelOp.getBodyBlock()) {
+    if (!isa<AllocStateOp, RootOutputOp, AllocMemoryOp>(&op))
+      continue;
+    auto name = op.getAttrOfType<StringAttr>("name");
+    if (!name || name.getValue().empty())
+      continue;
+    auto offset = op.getAttrOfType<IntegerAttr>("offset");
+    if (!offset) {
+      op.emitOpError("without allocated offset; run state allocation first");
+      return signalPassFailure();
+    }
+    auto flag = builder.getI32IntegerAttr(flagsOffset + flagsByOffset.size());
+    auto it =
+        flagsByOffset.try_emplace(offset.getValue().getZExtValue(), flag).first;
+    op.setAttr("dirtyFlag", it->second);
+  }
+  if (flagsByOffset.empty())
+    return markAllAnalysesPreserved();
+
+  // Set the flag alongside every write to one of the flagged states, under
+  // the same condition as the write itself.
+  auto i8Type = builder.getI8Type();
+  auto flagType = StateType::get(i8Type);
+  modelOp.walk([&](Operation *op) {
+    Value target, condition;
+    if (auto writeOp = dyn_cast<StateWriteOp>(op)) {
+      target = writeOp.getState();
+      condition = writeOp.getCondition();
+    } else if (auto writeOp = dyn_cast<MemoryWriteOp>(op)) {
+      target = writeOp.getMemory();
+      condition = writeOp.getEnable();
+    } else {
+      return;
+    }
+    auto getOp = target.getDefiningOp<StorageGetOp>();
+    if (!getOp || getOp.getStorage() != storageArg)
+      return;
+    auto flag = flagsByOffset.lookup(getOp.getOffset());
+    if (!flag)
+      return;
+    ImplicitLocOpBuilder builder(op->getLoc(), op);
+    auto flagState = builder.create<StorageGetOp>(flagType, storageArg, flag);
+    auto one = builder.create<hw::ConstantOp>(i8Type, 1);
+    builder.create<StateWriteOp>(flagState, one, condition);
+    ++numFlagWritesAdded;
+  });
+
+  storageArg.setType(
+      StorageType::get(&getContext(), flagsOffset + flagsByOffset.size()));
+  modelOp->setAttr("dirtyFlagsOffset", builder.getI32IntegerAttr(flagsOffset));
+  numFlagsAdded += flagsByOffset.size();
+}
+
+std::unique_ptr<Pass> arc::createAddDirtyFlagsPass() {
+  return std::make_unique<AddDirtyFlagsPass>();
+}
@@ -37,6 +37,12 @@ struct AllocateStatePass
   void runOnOperation() override;
   void allocateBlock(Block *block);
   void allocateOps(Value storage, Block *block, ArrayRef<Operation *> ops);
+
+  using AllocateStateBase::batch;
+
+  /// The index of the copy being evaluated, if the model simulates a batch of
+  /// copies of the design.
+  Value copyArg;
 };
 } // namespace
 
@@ -45,6 +51,28 @@ void AllocateStatePass::runOnOperation() {
   LLVM_DEBUG(llvm::dbgs() << "Allocating state in `" << modelOp.getName()
                           << "`\n");
 
+  // If the model simulates a batch of copies of the design, every state is
+  // replicated for each copy. Only the allocations at the top level of the
+  // model can be indexed by the copy.
+  copyArg = {};
+  if (batch > 1) {
+    auto &bodyBlock = modelOp.getBodyBlock();
+    auto result = modelOp.walk([&](Operation *op) {
+      if (isa<AllocStorageOp>(op) ||
+          (op->getBlock() != &bodyBlock &&
+           isa<AllocStateOp, RootInputOp, RootOutputOp, AllocMemoryOp>(op))) {
+        op->emitOpError("cannot be allocated in a batched model");
+        return WalkResult::interrupt();
+      }
+      return WalkResult::advance();
+    });
+    if (result.wasInterrupted())
+      return signalPassFailure();
+    modelOp->setAttr("batch", Builder(&getContext()).getI32IntegerAttr(batch));
+    copyArg = bodyBlock.addArgument(IndexType::get(&getContext()),
+                                    modelOp.getLoc());
+  }
+
   // Walk the blocks from innermost to outermost and group all state allocations
   // in that block in one larger allocation.
   modelOp.walk([&](Block *block) { allocateBlock(block); });
@@ -70,7 +98,10 @@ void AllocateStatePass::allocateBlock(Block *block) {
 
 void AllocateStatePass::allocateOps(Value storage, Block *block,
                                     ArrayRef<Operation *> ops) {
-  SmallVector<std::tuple<Value, Value, IntegerAttr>> gettersToCreate;
+  SmallVector<std::tuple<Value, Value, IntegerAttr, IntegerAttr>>
+      gettersToCreate;
+
+  OpBuilder builder(block->getParentOp());
 
   // Helper function to allocate storage aligned to its own size, or 8 bytes at
   // most.
@@ -83,16 +114,56 @@ void AllocateStatePass::allocateOps(Value storage, Block *block,
     return offset;
   };
 
+  // In a batched model, each allocation is replicated for every copy, with the
+  // copies placed next to each other. The allocation as a whole is aligned to
+  // its total size, or 64 bytes at most, such that the copies of a small state
+  // do not straddle a cache line.
+  unsigned batchSize = copyArg ? unsigned(batch) : 1;
+  auto allocCopies = [&](unsigned numBytes) {
+    if (batchSize == 1)
+      return allocBytes(numBytes);
+    unsigned totalBytes = numBytes * batchSize;
+    currentByte = llvm::alignToPowerOf2(
+        currentByte, llvm::bit_ceil(std::min(totalBytes, 64U)));
+    unsigned offset = currentByte;
+    currentByte += totalBytes;
+    return offset;
+  };
+
+  // Group the operations that belong to a partition of the clock trees, such
+  // that each partition gets its own cache lines. The remaining operations are
+  // allocated first, in their original order.
+  auto getPartition = [](Operation *op) -> std::optional<uint64_t> {
+    if (auto attr = op->getAttrOfType<IntegerAttr>("partition"))
+      return attr.getValue().getZExtValue();
+    return std::nullopt;
+  };
+  SmallVector<Operation *> sortedOps(ops);
+  llvm::stable_sort(sortedOps, [&](auto *a, auto *b) {
+    return getPartition(a) < getPartition(b);
+  });
+  constexpr unsigned cacheLineSize = 64;
+  std::optional<uint64_t> currentPartition;
+
   // Allocate storage for the operations.
-  OpBuilder builder(block->getParentOp());
-  for (auto *op : ops) {
+  for (auto *op : sortedOps) {
+    if (auto partition = getPartition(op); partition != currentPartition) {
+      currentByte = llvm::alignTo(currentByte, cacheLineSize);
+      currentPartition = partition;
+    }
+
     if (isa<AllocStateOp, RootInputOp, RootOutputOp>(op)) {
       auto result = op->getResult(0);
       auto storage = op->getOperand(0);
       unsigned numBytes = result.getType().cast<StateType>().getByteWidth();
-      auto offset = builder.getI32IntegerAttr(allocBytes(numBytes));
+      auto offset = builder.getI32IntegerAttr(allocCopies(numBytes));
       op->setAttr("offset", offset);
-      gettersToCreate.emplace_back(result, storage, offset);
+      IntegerAttr copyStride;
+      if (batchSize > 1) {
+        copyStride = builder.getI32IntegerAttr(numBytes);
+        op->setAttr("copyStride", copyStride);
+      }
+      gettersToCreate.emplace_back(result, storage, offset, copyStride);
       continue;
     }
 
@@ -100,10 +171,16 @@ void AllocateStatePass::allocateOps(Value storage, Block *block,
       auto memType = memOp.getType();
       unsigned stride = memType.getStride();
       unsigned numBytes = memType.getNumWords() * stride;
-      auto offset = builder.getI32IntegerAttr(allocBytes(numBytes));
+      auto offset = builder.getI32IntegerAttr(allocCopies(numBytes));
       op->setAttr("offset", offset);
       op->setAttr("stride", builder.getI32IntegerAttr(stride));
-      gettersToCreate.emplace_back(memOp, memOp.getStorage(), offset);
+      IntegerAttr copyStride;
+      if (batchSize > 1) {
+        copyStride = builder.getI32IntegerAttr(numBytes);
+        op->setAttr("copyStride", copyStride);
+      }
+      gettersToCreate.emplace_back(memOp, memOp.getStorage(), offset,
+                                   copyStride);
       continue;
     }
 
@@ -112,21 +189,24 @@ void AllocateStatePass::allocateOps(Value storage, Block *block,
           allocBytes(allocStorageOp.getType().getSize()));
       allocStorageOp.setOffsetAttr(offset);
       gettersToCreate.emplace_back(allocStorageOp, allocStorageOp.getInput(),
-                                   offset);
+                                   offset, IntegerAttr{});
       continue;
     }
 
     assert("unsupported op for allocation" && false);
   }
+  if (currentPartition)
+    currentByte = llvm::alignTo(currentByte, cacheLineSize);
 
-  // For every user of the alloc op, create a local `StorageGetOp`.
+  // For every user of the alloc op, create a local `StorageGetOp`, or a
+  // `StorageGetCopyOp` for states replicated across a batch.
   // First, create an ordering of operations to avoid a very expensive
   // combination of isBeforeInBlock and moveBefore calls (which can be O(n²))
   DenseMap<Operation *, unsigned> opOrder;
   block->walk([&](Operation *op) { opOrder.insert({op, opOrder.size()}); });
-  SmallVector<StorageGetOp> getters;
-  for (auto [result, storage, offset] : gettersToCreate) {
-    SmallDenseMap<Block *, StorageGetOp> getterForBlock;
+  SmallVector<Operation *> getters;
+  for (auto [result, storage, offset, copyStride] : gettersToCreate) {
+    SmallDenseMap<Block *, Operation *> getterForBlock;
     for (auto *user : llvm::make_early_inc_range(result.getUsers())) {
       auto &getter = getterForBlock[user->getBlock()];
       // Create a local getter in front of each user, except for
@@ -134,15 +214,19 @@ void AllocateStatePass::allocateOps(Value storage, Block *block,
       auto userOrder = opOrder.lookup(user);
       if (!getter || !result.getDefiningOp<AllocStorageOp>()) {
         ImplicitLocOpBuilder builder(result.getLoc(), user);
-        getter =
-            builder.create<StorageGetOp>(result.getType(), storage, offset);
+        if (copyStride)
+          getter = builder.create<StorageGetCopyOp>(
+              result.getType(), storage, copyArg, offset, copyStride);
+        else
+          getter =
+              builder.create<StorageGetOp>(result.getType(), storage, offset);
         getters.push_back(getter);
         opOrder[getter] = userOrder;
       } else if (userOrder < opOrder.lookup(getter)) {
         getter->moveBefore(user);
         opOrder[getter] = userOrder;
       }
-      user->replaceUsesOfWith(result, getter);
+      user->replaceUsesOfWith(result, getter->getResult(0));
     }
   }
 
@@ -157,13 +241,17 @@ void AllocateStatePass::allocateOps(Value storage, Block *block,
         StorageType::get(&getContext(), currentByte), storage);
     for (auto *op : ops)
       op->replaceUsesOfWith(storage, substorage);
-    for (auto op : getters)
+    for (auto *op : getters)
       op->replaceUsesOfWith(storage, substorage);
   } else {
     storage.setType(StorageType::get(&getContext(), currentByte));
   }
 }
 
-std::unique_ptr<Pass> arc::createAllocateStatePass() {
-  return std::make_unique<AllocateStatePass>();
+std::unique_ptr<Pass>
+arc::createAllocateStatePass(std::optional<unsigned> batch) {
+  auto pass = std::make_unique<AllocateStatePass>();
+  if (batch)
+    pass->batch = *batch;
+  return pass;
 }
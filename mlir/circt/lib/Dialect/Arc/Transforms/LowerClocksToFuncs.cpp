@@ -8,9 +8,12 @@
 
 #include "circt/Dialect/Arc/ArcOps.h"
 #include "circt/Dialect/Arc/ArcPasses.h"
+#include "circt/Dialect/HW/HWOps.h"
+#include "mlir/Dialect/Arith/IR/Arith.h"
 #include "mlir/Dialect/Func/IR/FuncOps.h"
 #include "mlir/Dialect/SCF/IR/SCF.h"
 #include "mlir/Pass/Pass.h"
+#include "llvm/ADT/Sequence.h"
 #include "llvm/Support/Debug.h"
 
 #define DEBUG_TYPE "arc-lower-clocks-to-funcs"
@@ -41,10 +44,18 @@ struct LowerClocksToFuncsPass
 
   void runOnOperation() override;
   LogicalResult lowerModel(ModelOp modelOp);
-  LogicalResult lowerClock(Operation *clockOp, Value modelStorageArg,
-                           OpBuilder &funcBuilder);
-  LogicalResult isolateClock(Operation *clockOp, Value modelStorageArg,
-                             Value clockStorageArg);
+  FailureOr<func::FuncOp> lowerClock(Operation *clockOp, ValueRange modelArgs,
+                                     OpBuilder &funcBuilder,
+                                     bool createCall = true);
+  LogicalResult lowerPartitions(ArrayRef<Operation *> partitionOps,
+                                unsigned firstPartition, ValueRange modelArgs,
+                                OpBuilder &funcBuilder,
+                                SmallVectorImpl<func::FuncOp> &partitionFuncs);
+  LogicalResult createPartitionDispatch(ModelOp modelOp,
+                                        ArrayRef<func::FuncOp> partitionFuncs,
+                                        OpBuilder &funcBuilder);
+  LogicalResult isolateClock(Operation *clockOp, ValueRange modelArgs,
+                             ValueRange clockArgs);
 
   SymbolTable *symbolTable;
 
@@ -71,30 +82,59 @@ LogicalResult LowerClocksToFuncsPass::lowerModel(ModelOp modelOp) {
       clocks.push_back(op);
   });
 
-  // Perform the actual extraction.
+  // Perform the actual extraction. Consecutive clock trees that are partitions
+  // of the same clock tree are lowered together. The model's arguments, the
+  // storage and in batched models the copy index, are passed on to each clock
+  // function.
   OpBuilder funcBuilder(modelOp);
-  for (auto *op : clocks)
-    if (failed(lowerClock(op, modelOp.getBody().getArgument(0), funcBuilder)))
+  ValueRange modelArgs = modelOp.getBody().getArguments();
+  SmallVector<func::FuncOp> partitionFuncs;
+  for (unsigned i = 0; i < clocks.size();) {
+    if (!clocks[i]->hasAttr("partition")) {
+      if (failed(lowerClock(clocks[i], modelArgs, funcBuilder)))
+        return failure();
+      ++i;
+      continue;
+    }
+    auto treeOp = cast<ClockTreeOp>(clocks[i]);
+    unsigned numPartitions = 1;
+    for (; i + numPartitions < clocks.size(); ++numPartitions) {
+      auto nextOp = dyn_cast<ClockTreeOp>(clocks[i + numPartitions]);
+      if (!nextOp || nextOp->getPrevNode() != clocks[i + numPartitions - 1] ||
+          nextOp.getClock() != treeOp.getClock() ||
+          nextOp->getAttrOfType<IntegerAttr>("partition") !=
+              funcBuilder.getI32IntegerAttr(numPartitions))
+        break;
+    }
+    if (failed(lowerPartitions(ArrayRef(clocks).slice(i, numPartitions),
+                               partitionFuncs.size(), modelArgs, funcBuilder,
+                               partitionFuncs)))
       return failure();
+    i += numPartitions;
+  }
 
+  if (!partitionFuncs.empty())
+    return createPartitionDispatch(modelOp, partitionFuncs, funcBuilder);
   return success();
 }
 
-LogicalResult LowerClocksToFuncsPass::lowerClock(Operation *clockOp,
-                                                 Value modelStorageArg,
-                                                 OpBuilder &funcBuilder) {
+FailureOr<func::FuncOp>
+LowerClocksToFuncsPass::lowerClock(Operation *clockOp, ValueRange modelArgs,
+                                   OpBuilder &funcBuilder, bool createCall) {
   LLVM_DEBUG(llvm::dbgs() << "- Lowering clock " << clockOp->getName() << "\n");
   assert((isa<ClockTreeOp, PassThroughOp>(clockOp)));
 
-  // Add a `StorageType` block argument to the clock's body block which we are
-  // going to use to pass the storage pointer to the clock once it has been
-  // pulled out into a separate function.
+  // Add block arguments to the clock's body block which mirror the model's
+  // arguments. We are going to use them to pass the storage pointer (and copy
+  // index) to the clock once it has been pulled out into a separate function.
   Region &clockRegion = clockOp->getRegion(0);
-  Value clockStorageArg = clockRegion.addArgument(modelStorageArg.getType(),
-                                                  modelStorageArg.getLoc());
+  SmallVector<Value> clockArgs;
+  for (auto modelArg : modelArgs)
+    clockArgs.push_back(
+        clockRegion.addArgument(modelArg.getType(), modelArg.getLoc()));
 
   // Ensure the clock tree does not use any values defined outside of it.
-  if (failed(isolateClock(clockOp, modelStorageArg, clockStorageArg)))
+  if (failed(isolateClock(clockOp, modelArgs, clockArgs)))
     return failure();
 
   // Add a return op to the end of the body.
@@ -107,28 +147,125 @@ LogicalResult LowerClocksToFuncsPass::lowerClock(Operation *clockOp,
   funcName.append(isa<PassThroughOp>(clockOp) ? "_passthrough" : "_clock");
   auto funcOp = funcBuilder.create<func::FuncOp>(
       clockOp->getLoc(), funcName,
-      builder.getFunctionType({modelStorageArg.getType()}, {}));
+      builder.getFunctionType(modelArgs.getTypes(), {}));
   symbolTable->insert(funcOp); // uniquifies the name
   LLVM_DEBUG(llvm::dbgs() << "  - Created function `" << funcOp.getSymName()
                           << "`\n");
 
   // Create a call to the function within the model.
   builder.setInsertionPoint(clockOp);
-  if (auto treeOp = dyn_cast<ClockTreeOp>(clockOp)) {
+  if (!createCall) {
+    // The caller takes care of calling the function.
+  } else if (auto treeOp = dyn_cast<ClockTreeOp>(clockOp)) {
     auto ifOp =
         builder.create<scf::IfOp>(clockOp->getLoc(), treeOp.getClock(), false);
     auto builder = ifOp.getThenBodyBuilder();
-    builder.create<func::CallOp>(clockOp->getLoc(), funcOp,
-                                 ValueRange{modelStorageArg});
+    builder.create<func::CallOp>(clockOp->getLoc(), funcOp, modelArgs);
   } else {
-    builder.create<func::CallOp>(clockOp->getLoc(), funcOp,
-                                 ValueRange{modelStorageArg});
+    builder.create<func::CallOp>(clockOp->getLoc(), funcOp, modelArgs);
   }
 
   // Move the clock's body block to the function and remove the old clock op.
   funcOp.getBody().takeBody(clockRegion);
   clockOp->erase();
 
+  return funcOp;
+}
+
+/// Lower the partitions of a clock tree into separate functions, and call the
+/// `<model>_run_partitions` runtime function to run them in parallel. The
+/// runtime calls back into `<model>_partition` with the index of each
+/// partition, which dispatches to the partition's function.
+LogicalResult LowerClocksToFuncsPass::lowerPartitions(
+    ArrayRef<Operation *> partitionOps, unsigned firstPartition,
+    ValueRange modelArgs, OpBuilder &funcBuilder,
+    SmallVectorImpl<func::FuncOp> &partitionFuncs) {
+  auto treeOp = cast<ClockTreeOp>(partitionOps.front());
+  auto modelOp = treeOp->getParentOfType<ModelOp>();
+  LLVM_DEBUG(llvm::dbgs() << "- Lowering " << partitionOps.size()
+                          << " clock tree partitions\n");
+  if (modelArgs.size() != 1)
+    return treeOp.emitOpError(
+        "partitions are not supported in batched models");
+  auto modelStorageArg = modelArgs[0];
+
+  // Declare the runtime function that runs the partitions.
+  SmallString<32> runName(modelOp.getName());
+  runName.append("_run_partitions");
+  auto runFuncOp = symbolTable->lookup<func::FuncOp>(runName);
+  if (!runFuncOp) {
+    if (symbolTable->lookup(runName))
+      return modelOp.emitOpError("conflicting definition of `")
+             << runName << "`";
+    auto i32Type = funcBuilder.getI32Type();
+    runFuncOp = funcBuilder.create<func::FuncOp>(
+        modelOp.getLoc(), runName,
+        funcBuilder.getFunctionType(
+            {modelStorageArg.getType(), i32Type, i32Type}, {}));
+    runFuncOp.setPrivate();
+    symbolTable->insert(runFuncOp);
+  }
+
+  // Call the runtime function from within the model.
+  OpBuilder ifBuilder(treeOp);
+  auto loc = treeOp.getLoc();
+  auto ifOp = ifBuilder.create<scf::IfOp>(loc, treeOp.getClock(), false);
+  auto builder = ifOp.getThenBodyBuilder();
+  Value first = builder.create<hw::ConstantOp>(loc, builder.getI32Type(),
+                                               firstPartition);
+  Value count = builder.create<hw::ConstantOp>(loc, builder.getI32Type(),
+                                               partitionOps.size());
+  builder.create<func::CallOp>(loc, runFuncOp,
+                               ValueRange{modelStorageArg, first, count});
+
+  // Lower the partitions themselves.
+  for (auto *op : partitionOps) {
+    auto funcOp = lowerClock(op, modelArgs, funcBuilder,
+                             /*createCall=*/false);
+    if (failed(funcOp))
+      return failure();
+    partitionFuncs.push_back(*funcOp);
+  }
+  return success();
+}
+
+/// Create the `<model>_partition` function, which calls the function of the
+/// partition with the given index.
+LogicalResult LowerClocksToFuncsPass::createPartitionDispatch(
+    ModelOp modelOp, ArrayRef<func::FuncOp> partitionFuncs,
+    OpBuilder &funcBuilder) {
+  SmallString<32> funcName(modelOp.getName());
+  funcName.append("_partition");
+  if (symbolTable->lookup(funcName))
+    return modelOp.emitOpError("conflicting definition of `")
+           << funcName << "`";
+
+  auto loc = modelOp.getLoc();
+  auto storageType = modelOp.getBody().getArgument(0).getType();
+  auto funcOp = funcBuilder.create<func::FuncOp>(
+      loc, funcName,
+      funcBuilder.getFunctionType({storageType, funcBuilder.getI32Type()}, {}));
+  symbolTable->insert(funcOp);
+
+  auto *block = funcOp.addEntryBlock();
+  auto builder = OpBuilder::atBlockEnd(block);
+  auto index = builder.create<arith::IndexCastUIOp>(
+      loc, builder.getIndexType(), block->getArgument(1));
+  auto switchOp = builder.create<scf::IndexSwitchOp>(
+      loc, TypeRange{}, index,
+      llvm::to_vector(llvm::seq<int64_t>(0, partitionFuncs.size())),
+      partitionFuncs.size());
+  builder.create<func::ReturnOp>(loc);
+
+  builder.setInsertionPointToEnd(&switchOp.getDefaultRegion().emplaceBlock());
+  builder.create<scf::YieldOp>(loc);
+  for (auto [region, partitionFunc] :
+       llvm::zip(switchOp.getCaseRegions(), partitionFuncs)) {
+    builder.setInsertionPointToEnd(&region.emplaceBlock());
+    builder.create<func::CallOp>(loc, partitionFunc,
+                                 ValueRange{block->getArgument(0)});
+    builder.create<scf::YieldOp>(loc);
+  }
   return success();
 }
 
@@ -136,16 +273,17 @@ LogicalResult LowerClocksToFuncsPass::lowerClock(Operation *clockOp,
 /// body. Anything besides constants should no longer exist after a proper run
 /// of the pipeline.
 LogicalResult LowerClocksToFuncsPass::isolateClock(Operation *clockOp,
-                                                   Value modelStorageArg,
-                                                   Value clockStorageArg) {
+                                                   ValueRange modelArgs,
+                                                   ValueRange clockArgs) {
   auto *clockRegion = &clockOp->getRegion(0);
   auto builder = OpBuilder::atBlockBegin(&clockRegion->front());
   DenseMap<Value, Value> copiedValues;
   auto result = clockRegion->walk([&](Operation *op) {
     for (auto &operand : op->getOpOperands()) {
       // Block arguments are okay, since there's nothing we can move.
-      if (operand.get() == modelStorageArg) {
-        operand.set(clockStorageArg);
+      if (auto it = llvm::find(modelArgs, operand.get());
+          it != modelArgs.end()) {
+        operand.set(clockArgs[it - modelArgs.begin()]);
         continue;
       }
       if (operand.get().isa<BlockArgument>()) {
@@ -0,0 +1,209 @@
+//===- PartitionClockTrees.cpp --------------------------------------------===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+
+#include "circt/Dialect/Arc/ArcOps.h"
+#include "circt/Dialect/Arc/ArcPasses.h"
+#include "mlir/IR/IRMapping.h"
+#include "mlir/Interfaces/SideEffectInterfaces.h"
+#include "mlir/Pass/Pass.h"
+#include "llvm/ADT/IntEqClasses.h"
+#include "llvm/ADT/Sequence.h"
+#include "llvm/Support/Debug.h"
+
+#define DEBUG_TYPE "arc-partition-clock-trees"
+
+namespace circt {
+namespace arc {
+#define GEN_PASS_DEF_PARTITIONCLOCKTREES
+#include "circt/Dialect/Arc/ArcPasses.h.inc"
+} // namespace arc
+} // namespace circt
+
+using namespace mlir;
+using namespace circt;
+using namespace arc;
+
+//===----------------------------------------------------------------------===//
+// Pass Implementation
+//===----------------------------------------------------------------------===//
+
+namespace {
+struct PartitionClockTreesPass
+    : public arc::impl::PartitionClockTreesBase<PartitionClockTreesPass> {
+  void runOnOperation() override;
+  void partitionClockTree(ClockTreeOp treeOp);
+  void annotateStates();
+
+  using PartitionClockTreesBase::numPartitions;
+};
+} // namespace
+
+void PartitionClockTreesPass::runOnOperation() {
+  if (numPartitions < 2)
+    return markAllAnalysesPreserved();
+
+  LLVM_DEBUG(llvm::dbgs() << "Partitioning clock trees in `"
+                          << getOperation().getName() << "`\n");
+  for (auto treeOp : llvm::make_early_inc_range(
+           getOperation().getBodyBlock().getOps<ClockTreeOp>()))
+    partitionClockTree(treeOp);
+  annotateStates();
+}
+
+/// Check whether an operation has side effects which are not captured by the
+/// state or memory it operates on.
+static bool hasUntrackedSideEffects(Operation *op) {
+  if (isa<StateReadOp, StateWriteOp, MemoryReadOp, MemoryWriteOp>(op))
+    return false;
+  if (op->hasTrait<OpTrait::HasRecursiveMemoryEffects>())
+    return false;
+  return !isMemoryEffectFree(op);
+}
+
+void PartitionClockTreesPass::partitionClockTree(ClockTreeOp treeOp) {
+  auto &block = treeOp.getBodyBlock();
+
+  // Number the operations in the clock tree. Constants are not numbered, since
+  // they are replicated into every partition that uses them.
+  SmallVector<Operation *> ops;
+  DenseMap<Operation *, unsigned> opIndices;
+  for (auto &op : block) {
+    if (op.hasTrait<OpTrait::ConstantLike>())
+      continue;
+    opIndices.insert({&op, ops.size()});
+    ops.push_back(&op);
+  }
+  if (ops.size() < 2)
+    return;
+
+  // Group the operations into clusters that are connected through their
+  // operands, or through the states, memories, and other values defined
+  // outside the clock tree that they use. Operations with side effects that
+  // cannot be attributed to a state are all grouped into one cluster to keep
+  // their relative order.
+  llvm::IntEqClasses classes(ops.size() + 1);
+  unsigned effectsClass = ops.size();
+  DenseMap<Value, unsigned> externalValueClasses;
+  for (auto [index, op] : llvm::enumerate(ops)) {
+    op->walk([&](Operation *nestedOp) {
+      if (hasUntrackedSideEffects(nestedOp))
+        classes.join(index, effectsClass);
+      for (auto operand : nestedOp->getOperands()) {
+        auto *defOp = operand.getDefiningOp();
+        if (defOp && defOp->hasTrait<OpTrait::ConstantLike>())
+          continue;
+        if (defOp && defOp->getBlock() == &block) {
+          classes.join(index, opIndices.lookup(defOp));
+          continue;
+        }
+        if (treeOp->isAncestor(operand.getParentBlock()->getParentOp()))
+          continue;
+        auto [it, inserted] = externalValueClasses.try_emplace(operand, index);
+        if (!inserted)
+          classes.join(index, it->second);
+      }
+    });
+  }
+  classes.compress();
+
+  // Determine the number of operations in each cluster.
+  SmallVector<unsigned> opClasses;
+  opClasses.reserve(ops.size());
+  SmallVector<size_t> classSizes(classes.getNumClasses(), 0);
+  for (auto [index, op] : llvm::enumerate(ops)) {
+    auto opClass = classes[index];
+    opClasses.push_back(opClass);
+    op->walk([&](Operation *) { ++classSizes[opClass]; });
+  }
+  unsigned numClasses = llvm::count_if(classSizes, [](auto s) { return s; });
+  unsigned numTreePartitions = std::min<unsigned>(numPartitions, numClasses);
+  LLVM_DEBUG(llvm::dbgs() << "- Found " << numClasses
+                          << " independent clusters in clock tree\n");
+  if (numTreePartitions < 2)
+    return;
+
+  // Distribute the clusters across the partitions, handing out the largest
+  // clusters first, each to the partition with the fewest operations so far.
+  SmallVector<unsigned> classOrder(llvm::seq<unsigned>(0, classSizes.size()));
+  llvm::stable_sort(classOrder, [&](unsigned a, unsigned b) {
+    return classSizes[a] > classSizes[b];
+  });
+  SmallVector<size_t> partitionSizes(numTreePartitions, 0);
+  SmallVector<unsigned> classPartitions(classSizes.size(), 0);
+  for (auto opClass : classOrder) {
+    auto *partition = llvm::min_element(partitionSizes);
+    *partition += classSizes[opClass];
+    classPartitions[opClass] = partition - partitionSizes.begin();
+  }
+
+  // Create a clock tree for each partition and move the operations over,
+  // replicating the constants they use.
+  OpBuilder builder(treeOp);
+  SmallVector<ClockTreeOp> partitionOps;
+  SmallVector<IRMapping> constantMappings(numTreePartitions);
+  for (unsigned partition = 0; partition < numTreePartitions; ++partition) {
+    auto partitionOp =
+        builder.create<ClockTreeOp>(treeOp.getLoc(), treeOp.getClock());
+    partitionOp->setAttr("partition", builder.getI32IntegerAttr(partition));
+    partitionOp.getBody().emplaceBlock();
+    partitionOps.push_back(partitionOp);
+  }
+  for (auto [op, opClass] : llvm::zip(ops, opClasses)) {
+    auto partition = classPartitions[opClass];
+    auto &partitionBlock = partitionOps[partition].getBodyBlock();
+    op->moveBefore(&partitionBlock, partitionBlock.end());
+    auto &mapping = constantMappings[partition];
+    op->walk([&](Operation *nestedOp) {
+      for (auto &operand : nestedOp->getOpOperands()) {
+        auto *defOp = operand.get().getDefiningOp();
+        if (!defOp || defOp->getBlock() != &block)
+          continue;
+        if (!mapping.contains(defOp))
+          OpBuilder::atBlockBegin(&partitionBlock).clone(*defOp, mapping);
+        operand.set(mapping.lookup(operand.get()));
+      }
+    });
+  }
+  treeOp.erase();
+
+  ++numTreesPartitioned;
+  numPartitionsCreated += numTreePartitions;
+  LLVM_DEBUG(llvm::dbgs() << "- Split clock tree into " << numTreePartitions
+                          << " partitions\n");
+}
+
+/// Mark the states and memories that are only accessed from within a single
+/// partition with that partition's index.
+void PartitionClockTreesPass::annotateStates() {
+  for (auto &op : getOperation().getBodyBlock()) {
+    if (!isa<AllocStateOp, AllocMemoryOp>(&op))
+      continue;
+    IntegerAttr partition;
+    bool isShared = false;
+    for (auto *user : op.getUsers()) {
+      auto treeOp = user->getParentOfType<ClockTreeOp>();
+      auto userPartition =
+          treeOp ? treeOp->getAttrOfType<IntegerAttr>("partition") : nullptr;
+      if (!userPartition || (partition && partition != userPartition)) {
+        isShared = true;
+        break;
+      }
+      partition = userPartition;
+    }
+    if (partition && !isShared)
+      op.setAttr("partition", partition);
+  }
+}
+
+std::unique_ptr<Pass>
+arc::createPartitionClockTreesPass(std::optional<unsigned> numPartitions) {
+  auto pass = std::make_unique<PartitionClockTreesPass>();
+  if (numPartitions)
+    pass->numPartitions = *numPartitions;
+  return pass;
+}
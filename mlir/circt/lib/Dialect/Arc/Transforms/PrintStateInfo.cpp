@@ -39,6 +39,8 @@ struct StateInfo {
   unsigned numBits;
   unsigned memoryStride = 0; // byte separation between memory words
   unsigned memoryDepth = 0;  // number of words in a memory
+  unsigned copyStride = 0;   // byte separation between copies in a batch
+  unsigned dirtyFlag = 0;    // offset of the flag set when the state changes
 };
 
 struct ModelInfo {
@@ -95,9 +97,25 @@ PrintStateInfoPass::runOnOperation(llvm::raw_ostream &outputStream) {
       }
       llvm::sort(states, [](auto &a, auto &b) { return a.offset < b.offset; });
 
+      bool isPartitioned = false;
+      modelOp.walk([&](ClockTreeOp treeOp) {
+        if (treeOp->hasAttr("partition"))
+          isPartitioned = true;
+      });
+
       json.object([&] {
         json.attribute("name", modelOp.getName());
         json.attribute("numStateBytes", storageType.getSize());
+        if (isPartitioned)
+          json.attribute("partitioned", true);
+        if (auto batch = modelOp->getAttrOfType<IntegerAttr>("batch"))
+          json.attribute("batch", batch.getInt());
+        if (auto flagsOffset =
+                modelOp->getAttrOfType<IntegerAttr>("dirtyFlagsOffset")) {
+          json.attribute("dirtyFlagsOffset", flagsOffset.getInt());
+          json.attribute("numDirtyFlags",
+                         storageType.getSize() - flagsOffset.getInt());
+        }
         json.attributeArray("states", [&] {
           for (const auto &state : states) {
             json.object([&] {
@@ -124,6 +142,10 @@ PrintStateInfoPass::runOnOperation(llvm::raw_ostream &outputStream) {
                 json.attribute("stride", state.memoryStride);
                 json.attribute("depth", state.memoryDepth);
               }
+              if (state.copyStride)
+                json.attribute("copyStride", state.copyStride);
+              if (state.dirtyFlag)
+                json.attribute("dirtyFlag", state.dirtyFlag);
             });
           }
         });
@@ -158,6 +180,12 @@ PrintStateInfoPass::collectStates(Value storage, unsigned offset,
       op->emitOpError("without allocated offset; run state allocation first");
       return failure();
     }
+    unsigned copyStride = 0;
+    if (auto attr = op->getAttrOfType<IntegerAttr>("copyStride"))
+      copyStride = attr.getValue().getZExtValue();
+    unsigned dirtyFlag = 0;
+    if (auto attr = op->getAttrOfType<IntegerAttr>("dirtyFlag"))
+      dirtyFlag = attr.getValue().getZExtValue() + offset;
     if (isa<AllocStateOp, RootInputOp, RootOutputOp>(op)) {
       auto result = op->getResult(0);
       auto &stateInfo = stateInfos.emplace_back();
@@ -173,6 +201,8 @@ PrintStateInfoPass::collectStates(Value storage, unsigned offset,
       stateInfo.name = opName;
       stateInfo.offset = opOffset.getValue().getZExtValue() + offset;
       stateInfo.numBits = result.getType().cast<StateType>().getBitWidth();
+      stateInfo.copyStride = copyStride;
+      stateInfo.dirtyFlag = dirtyFlag;
       continue;
     }
     if (auto memOp = dyn_cast<AllocMemoryOp>(op)) {
@@ -190,6 +220,8 @@ PrintStateInfoPass::collectStates(Value storage, unsigned offset,
       stateInfo.numBits = intType.getWidth();
       stateInfo.memoryStride = stride.getValue().getZExtValue();
       stateInfo.memoryDepth = memType.getNumWords();
+      stateInfo.copyStride = copyStride;
+      stateInfo.dirtyFlag = dirtyFlag;
       continue;
     }
   }
@@ -44,7 +44,8 @@ import "DPI-C" sv2cCosimserverEpRegister =
 // --------------------- Endpoint Accessors ------------------------------------
 
 // Attempt to send data to a client.
-// - return 0 on success, negative on failure (unregistered EP).
+// - return 0 on success, negative on failure (unregistered EP, or the queue to
+//   the client is full).
 import "DPI-C" sv2cCosimserverEpTryPut =
   function int cosim_ep_tryput(
     // The ID of the endpoint to which the data should be sent.
@@ -55,6 +56,16 @@ import "DPI-C" sv2cCosimserverEpTryPut =
     input int data_size = -1
     );
 
+// Check whether there is room to send data to a client. Once this returns 1,
+// the next cosim_ep_tryput on the endpoint will not find the queue full.
+// - return 1 if there is room, 0 if the queue to the client is full, negative
+//   on failure (unregistered EP).
+import "DPI-C" sv2cCosimserverEpCanPut =
+  function int cosim_ep_canput(
+    // The ID of the endpoint to which the data would be sent.
+    input string endpoint_id
+    );
+
 // Attempt to recieve data from a client.
 //   - Returns negative when call failed (e.g. EP not registered).
 //   - If no message, return 0 with size_bytes == 0.
@@ -58,18 +58,23 @@ module Cosim_Endpoint_ToHost
   localparam int TO_HOST_SIZE_BYTES_FLOOR_IN_BITS
       = TO_HOST_SIZE_BYTES_FLOOR * 8;
 
-  assign DataInReady = 1'b1;
   byte unsigned DataInBuffer[TO_HOST_SIZE_BYTES-1:0];
 
+  // Only accept data when the queue to the host has room for it, so that a
+  // host which falls behind stalls the hardware instead of losing messages.
+  // Only the host can make room, so checking after each put is enough.
   always@(posedge clk) begin
     if (~rst) begin
-      if (DataInValid) begin
+      if (DataInValid && DataInReady) begin
         int rc;
         rc = cosim_ep_tryput(ENDPOINT_ID, DataInBuffer, TO_HOST_SIZE_BYTES);
         if (rc != 0)
           $error("cosim_ep_tryput(%d, *, %d) = %d Error! (Data lost)",
             ENDPOINT_ID, TO_HOST_SIZE_BYTES, rc);
       end
+      DataInReady <= cosim_ep_canput(ENDPOINT_ID) > 0;
+    end else begin
+      DataInReady <= 1'b0;
     end
   end
 
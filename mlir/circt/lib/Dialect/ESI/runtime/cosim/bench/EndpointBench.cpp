@@ -0,0 +1,95 @@
+//===- EndpointBench.cpp - Cosim endpoint throughput benchmark ------------===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+//
+// Measure how many messages per second an Endpoint can move between two
+// threads, standing in for the RPC server thread and the simulator's DPI
+// polling. Both directions are measured. The consumer polls like the
+// simulator does: it never blocks, it just tries again.
+//
+//===----------------------------------------------------------------------===//
+
+#include "cosim/Endpoint.h"
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <thread>
+
+using namespace esi::cosim;
+
+namespace {
+/// Which way the messages flow through the endpoint.
+enum class Direction { ToSim, ToClient };
+} // anonymous namespace
+
+/// Move `numMsgs` messages of `msgSize` bytes through a fresh endpoint and
+/// return the number of messages per second.
+static double run(Direction dir, size_t numMsgs, size_t msgSize) {
+  Endpoint ep("", msgSize, "", msgSize);
+  std::vector<uint8_t> payload(msgSize, 0x5a);
+
+  std::thread producer([&]() {
+    for (size_t i = 0; i < numMsgs; ++i) {
+      Endpoint::BlobPtr blob = dir == Direction::ToSim
+                                   ? ep.allocMessageToSim()
+                                   : ep.allocMessageToClient();
+      blob->assign(payload.begin(), payload.end());
+      while (!(dir == Direction::ToSim ? ep.pushMessageToSim(blob)
+                                       : ep.pushMessageToClient(blob)))
+        std::this_thread::yield();
+    }
+  });
+
+  auto start = std::chrono::steady_clock::now();
+  size_t received = 0;
+  size_t bytes = 0;
+  Endpoint::BlobPtr msg;
+  while (received < numMsgs) {
+    bool got = dir == Direction::ToSim ? ep.getMessageToSim(msg)
+                                       : ep.getMessageToClient(msg);
+    if (!got) {
+      // A real simulator would go on to simulate a clock cycle here.
+      std::this_thread::yield();
+      continue;
+    }
+    ++received;
+    bytes += msg->size();
+    if (dir == Direction::ToSim)
+      ep.recycleMessageToSim(std::move(msg));
+    else
+      ep.recycleMessageToClient(std::move(msg));
+  }
+  auto end = std::chrono::steady_clock::now();
+  producer.join();
+
+  if (bytes != numMsgs * msgSize) {
+    std::cerr << "Lost data: expected " << numMsgs * msgSize << " bytes, got "
+              << bytes << std::endl;
+    exit(1);
+  }
+  std::chrono::duration<double> secs = end - start;
+  return numMsgs / secs.count();
+}
+
+int main(int argc, const char *argv[]) {
+  if (argc > 3) {
+    std::cerr << "Expected usage: " << argv[0]
+              << " [number of messages] [message size in bytes]" << std::endl;
+    return -1;
+  }
+  size_t numMsgs = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 10000000;
+  size_t msgSize = argc > 2 ? std::strtoull(argv[2], nullptr, 10) : 64;
+
+  std::cout << "Sending " << numMsgs << " messages of " << msgSize
+            << " bytes in each direction" << std::endl;
+  std::cout << "  RPC -> sim: " << run(Direction::ToSim, numMsgs, msgSize)
+            << " msgs/sec" << std::endl;
+  std::cout << "  sim -> RPC: " << run(Direction::ToClient, numMsgs, msgSize)
+            << " msgs/sec" << std::endl;
+  return 0;
+}
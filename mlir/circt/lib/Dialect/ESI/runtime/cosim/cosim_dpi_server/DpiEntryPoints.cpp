@@ -22,6 +22,7 @@
 #include <algorithm>
 #include <cassert>
 #include <cstdlib>
+#include <deque>
 
 using namespace esi::cosim;
 
@@ -66,6 +67,17 @@ static int findPort() {
   return std::strtoull(portEnv, nullptr, 10);
 }
 
+/// If requested via an environment variable, open the shared memory region
+/// through which local clients can connect without RPC.
+static void openSharedMemory() {
+  const char *shmEnv = getenv("COSIM_SHM");
+  if (shmEnv == nullptr)
+    return;
+  if (server->shmBridge.open(shmEnv))
+    printf("[COSIM] Opened shared memory region %s\n",
+           server->shmBridge.getName().c_str());
+}
+
 /// Check that an array is an array of bytes and has some size.
 // NOLINTNEXTLINE(misc-misplaced-const)
 static int validateSvOpenArray(const svOpenArrayHandle data,
@@ -179,11 +191,13 @@ DPI int sv2cCosimserverEpTryGet(char *endpointId,
   }
   // Set the output data size.
   *dataSize = msg->size();
+  ep->recycleMessageToSim(std::move(msg));
   return 0;
 }
 
 // Attempt to send data to a client.
-// - return 0 on success, negative on failure (unregistered EP).
+// - return 0 on success, negative on failure (unregistered EP, or the queue to
+//   the client is full).
 // - if dataSize is negative, attempt to dynamically determine the size of
 //   'data'.
 DPI int sv2cCosimserverEpTryPut(char *endpointId,
@@ -207,20 +221,39 @@ DPI int sv2cCosimserverEpTryPut(char *endpointId,
     return -3;
   }
 
-  Endpoint::BlobPtr blob = std::make_unique<Endpoint::Blob>(dataSize);
+  Endpoint *ep = server->endpoints[endpointId];
+  if (!ep) {
+    fprintf(stderr, "Endpoint not found in registry!\n");
+    return -4;
+  }
+  Endpoint::BlobPtr blob = ep->allocMessageToClient();
+  blob->resize(dataSize);
   // Copy the message data into 'blob'.
   for (int i = 0; i < dataSize; ++i) {
     (*blob)[i] = *(char *)svGetArrElemPtr1(data, i);
   }
   // Queue the blob.
+  log(endpointId, true, blob);
+  if (!ep->pushMessageToClient(blob)) {
+    fprintf(stderr, "Endpoint queue to client is full!\n");
+    return -5;
+  }
+  return 0;
+}
+
+// Check whether a message to the client would fit in the endpoint's queue.
+// - return 1 if there is room, 0 if the queue is full, negative on failure
+//   (unregistered EP).
+DPI int sv2cCosimserverEpCanPut(char *endpointId) {
+  if (server == nullptr)
+    return -1;
+
   Endpoint *ep = server->endpoints[endpointId];
   if (!ep) {
     fprintf(stderr, "Endpoint not found in registry!\n");
     return -4;
   }
-  log(endpointId, true, blob);
-  ep->pushMessageToClient(std::move(blob));
-  return 0;
+  return ep->canPushMessageToClient() ? 1 : 0;
 }
 
 // Teardown cosimserver (disconnects from primary server port, stops connections
@@ -230,6 +263,7 @@ DPI void sv2cCosimserverFinish() {
   printf("[cosim] Tearing down RPC server.\n");
   if (server != nullptr) {
     server->stop();
+    server->shmBridge.close();
     server = nullptr;
 
     fclose(logFile);
@@ -252,6 +286,7 @@ DPI int sv2cCosimserverInit() {
     // Find the port and run.
     printf("[cosim] Starting RPC server.\n");
     server = new RpcServer();
+    openSharedMemory();
     server->run(findPort());
   }
   return 0;
@@ -285,6 +320,14 @@ sv2cCosimserverSetManifest(unsigned int esiVersion,
 // ---- Low-level cosim DPI entry points ----
 
 static bool mmioRegistered = false;
+
+/// MMIO requests can arrive over RPC or shared memory. The hardware responds in
+/// request order, so remember where each outstanding request came from (true
+/// for shared memory) to route the response back. Only accessed from the
+/// simulator thread.
+static std::deque<bool> mmioReadSources;
+static std::deque<bool> mmioWriteSources;
+
 DPI int sv2cCosimserverMMIORegister() {
   if (mmioRegistered) {
     printf("ERROR: DPI MMIO master already registered!");
@@ -298,28 +341,54 @@ DPI int sv2cCosimserverMMIORegister() {
 DPI int sv2cCosimserverMMIOReadTryGet(uint32_t *address) {
   assert(server);
   std::optional<int> reqAddress = server->lowLevelBridge.readReqs.pop();
-  if (!reqAddress.has_value())
-    return -1;
-  *address = reqAddress.value();
-  return 0;
+  if (reqAddress.has_value()) {
+    *address = reqAddress.value();
+    mmioReadSources.push_back(false);
+    return 0;
+  }
+  if (server->shmBridge.tryGetRead(*address)) {
+    mmioReadSources.push_back(true);
+    return 0;
+  }
+  return -1;
 }
 
 DPI void sv2cCosimserverMMIOReadRespond(uint32_t data, char error) {
   assert(server);
-  server->lowLevelBridge.readResps.push(data, error);
+  assert(!mmioReadSources.empty() && "MMIO read response without request");
+  bool fromShm = mmioReadSources.front();
+  mmioReadSources.pop_front();
+  if (fromShm)
+    server->shmBridge.respondRead(data, error);
+  else
+    server->lowLevelBridge.readResps.push(data, error);
 }
 
 DPI void sv2cCosimserverMMIOWriteRespond(char error) {
   assert(server);
-  server->lowLevelBridge.writeResps.push(error);
+  assert(!mmioWriteSources.empty() && "MMIO write response without request");
+  bool fromShm = mmioWriteSources.front();
+  mmioWriteSources.pop_front();
+  if (fromShm)
+    server->shmBridge.respondWrite(error);
+  else
+    server->lowLevelBridge.writeResps.push(error);
 }
 
 DPI int sv2cCosimserverMMIOWriteTryGet(uint32_t *address, uint32_t *data) {
   assert(server);
   auto req = server->lowLevelBridge.writeReqs.pop();
-  if (!req.has_value())
-    return -1;
-  *address = req.value().first;
-  *data = req.value().second;
-  return 0;
+  if (req.has_value()) {
+    *address = req.value().first;
+    *data = req.value().second;
+    mmioWriteSources.push_back(false);
+    return 0;
+  }
+  uint64_t shmData;
+  if (server->shmBridge.tryGetWrite(*address, shmData)) {
+    *data = shmData;
+    mmioWriteSources.push_back(true);
+    return 0;
+  }
+  return -1;
 }
@@ -16,8 +16,8 @@ using namespace esi::cosim;
 
 Endpoint::Endpoint(std::string fromHostTypeId, int fromHostTypeMaxSize,
                    std::string toHostTypeId, int toHostTypeMaxSize)
-    : fromHostTypeId(fromHostTypeId), toHostTypeId(toHostTypeId), inUse(false) {
-}
+    : fromHostTypeId(fromHostTypeId), toHostTypeId(toHostTypeId), inUse(false),
+      toCosim(fromHostTypeMaxSize), toClient(toHostTypeMaxSize) {}
 Endpoint::~Endpoint() {}
 
 bool Endpoint::setInUse() {
@@ -20,6 +20,7 @@
 #include "cosim/Server.h"
 #include "CosimDpi.capnp.h"
 #include <capnp/ez-rpc.h>
+#include <deque>
 #include <thread>
 #if WIN32
 #include <io.h>
@@ -50,6 +51,10 @@ public:
   /// Disallow copying as the 'open' variable needs to track the endpoint.
   EndpointServer(const EndpointServer &) = delete;
 
+  /// Queue a message to the simulation, retrying from the event loop while the
+  /// queue is full.
+  kj::Promise<void> pushToSim(Endpoint::BlobPtr blob);
+
   /// Implement the EsiDpiEndpoint RPC interface.
   kj::Promise<void> sendFromHost(SendFromHostContext) override;
   kj::Promise<void> recvToHost(RecvToHostContext) override;
@@ -61,13 +66,23 @@ class LowLevelServer final : public EsiLowLevel::Server {
   // Queues to and from the simulation.
   LowLevel &bridge;
 
-  // Functions which poll for responses without blocking the main loop. Polling
-  // ain't great, but it's the only way (AFAICT) to do inter-thread
-  // communication between a libkj concurrent thread and other threads. There is
-  // a non-polling way to do it by setting up a queue over a OS-level pipe
-  // (since the libkj event loop uses 'select').
-  kj::Promise<void> pollReadResp(ReadMMIOContext context);
-  kj::Promise<void> pollWriteResp(WriteMMIOContext context);
+  // The requests sent to the simulation whose responses haven't arrived yet,
+  // oldest first. The simulation answers requests in the order it receives
+  // them, so each response completes the oldest pending request.
+  std::deque<kj::Own<kj::PromiseFulfiller<uint64_t>>> pendingReads;
+  std::deque<kj::Own<kj::PromiseFulfiller<void>>> pendingWrites;
+
+  // Functions which poll for responses without blocking the main loop, as long
+  // as requests are pending. Polling ain't great, but it's the only way
+  // (AFAICT) to do inter-thread communication between a libkj concurrent
+  // thread and other threads. There is a non-polling way to do it by setting up
+  // a queue over a OS-level pipe (since the libkj event loop uses 'select').
+  kj::Promise<void> pollReadResps();
+  kj::Promise<void> pollWriteResps();
+  bool pollingReads = false;
+  bool pollingWrites = false;
+  kj::Promise<void> readPoller = kj::READY_NOW;
+  kj::Promise<void> writePoller = kj::READY_NOW;
 
 public:
   LowLevelServer(LowLevel &bridge);
@@ -127,6 +142,7 @@ kj::Promise<void> EndpointServer::recvToHost(RecvToHostContext context) {
   if (msgPresent) {
     Data::Builder data(blob->data(), blob->size());
     context.getResults().setResp(data.asReader());
+    endpoint.recycleMessageToClient(std::move(blob));
   }
   return kj::READY_NOW;
 }
@@ -139,10 +155,19 @@ kj::Promise<void> EndpointServer::sendFromHost(SendFromHostContext context) {
   KJ_REQUIRE(open, "EndPoint closed already");
   KJ_REQUIRE(context.getParams().hasMsg(), "Send request must have a message.");
   kj::ArrayPtr<const kj::byte> data = context.getParams().getMsg().asBytes();
-  Endpoint::BlobPtr blob =
-      std::make_unique<Endpoint::Blob>(data.begin(), data.end());
-  endpoint.pushMessageToSim(std::move(blob));
-  return kj::READY_NOW;
+  Endpoint::BlobPtr blob = endpoint.allocMessageToSim();
+  blob->assign(data.begin(), data.end());
+  return pushToSim(std::move(blob));
+}
+
+kj::Promise<void> EndpointServer::pushToSim(Endpoint::BlobPtr blob) {
+  if (endpoint.pushMessageToSim(blob))
+    return kj::READY_NOW;
+  // The simulation hasn't caught up yet, so let the event loop run and try
+  // again.
+  return kj::evalLast([this, blob = std::move(blob)]() mutable {
+    return pushToSim(std::move(blob));
+  });
 }
 
 kj::Promise<void> EndpointServer::close(CloseContext context) {
@@ -157,40 +182,74 @@ kj::Promise<void> EndpointServer::close(CloseContext context) {
 LowLevelServer::LowLevelServer(LowLevel &bridge) : bridge(bridge) {}
 LowLevelServer::~LowLevelServer() {}
 
-kj::Promise<void> LowLevelServer::pollReadResp(ReadMMIOContext context) {
-  auto respMaybe = bridge.readResps.pop();
-  if (!respMaybe.has_value()) {
-    return kj::evalLast(
-        [this, KJ_CPCAP(context)]() mutable { return pollReadResp(context); });
+kj::Promise<void> LowLevelServer::pollReadResps() {
+  while (!pendingReads.empty()) {
+    auto respMaybe = bridge.readResps.pop();
+    if (!respMaybe.has_value())
+      return kj::evalLast([this]() { return pollReadResps(); });
+    --bridge.readsInFlight;
+    auto resp = respMaybe.value();
+    auto fulfiller = kj::mv(pendingReads.front());
+    pendingReads.pop_front();
+    if (resp.second == 0)
+      fulfiller->fulfill(kj::cp(resp.first));
+    else
+      fulfiller->reject(
+          KJ_EXCEPTION(FAILED, "Read MMIO register encountered an error"));
   }
-  auto resp = respMaybe.value();
-  KJ_REQUIRE(resp.second == 0, "Read MMIO register encountered an error");
-  context.getResults().setData(resp.first);
+  pollingReads = false;
   return kj::READY_NOW;
 }
 
 kj::Promise<void> LowLevelServer::readMMIO(ReadMMIOContext context) {
+  if (bridge.readsInFlight >= bridge.readResps.capacity())
+    return kj::evalLast(
+        [this, KJ_CPCAP(context)]() mutable { return readMMIO(context); });
+  ++bridge.readsInFlight;
+  auto paf = kj::newPromiseAndFulfiller<uint64_t>();
+  pendingReads.push_back(kj::mv(paf.fulfiller));
   bridge.readReqs.push(context.getParams().getAddress());
-  return kj::evalLast(
-      [this, KJ_CPCAP(context)]() mutable { return pollReadResp(context); });
+  if (!pollingReads) {
+    pollingReads = true;
+    readPoller = pollReadResps().eagerlyEvaluate(nullptr);
+  }
+  return paf.promise.then([KJ_CPCAP(context)](uint64_t data) mutable {
+    context.getResults().setData(data);
+  });
 }
 
-kj::Promise<void> LowLevelServer::pollWriteResp(WriteMMIOContext context) {
-  auto respMaybe = bridge.writeResps.pop();
-  if (!respMaybe.has_value()) {
-    return kj::evalLast(
-        [this, KJ_CPCAP(context)]() mutable { return pollWriteResp(context); });
+kj::Promise<void> LowLevelServer::pollWriteResps() {
+  while (!pendingWrites.empty()) {
+    auto respMaybe = bridge.writeResps.pop();
+    if (!respMaybe.has_value())
+      return kj::evalLast([this]() { return pollWriteResps(); });
+    --bridge.writesInFlight;
+    auto fulfiller = kj::mv(pendingWrites.front());
+    pendingWrites.pop_front();
+    if (respMaybe.value() == 0)
+      fulfiller->fulfill();
+    else
+      fulfiller->reject(
+          KJ_EXCEPTION(FAILED, "write MMIO register encountered an error"));
   }
-  auto resp = respMaybe.value();
-  KJ_REQUIRE(resp == 0, "write MMIO register encountered an error");
+  pollingWrites = false;
   return kj::READY_NOW;
 }
 
 kj::Promise<void> LowLevelServer::writeMMIO(WriteMMIOContext context) {
+  if (bridge.writesInFlight >= bridge.writeResps.capacity())
+    return kj::evalLast(
+        [this, KJ_CPCAP(context)]() mutable { return writeMMIO(context); });
+  ++bridge.writesInFlight;
+  auto paf = kj::newPromiseAndFulfiller<void>();
+  pendingWrites.push_back(kj::mv(paf.fulfiller));
   bridge.writeReqs.push(context.getParams().getAddress(),
                         context.getParams().getData());
-  return kj::evalLast(
-      [this, KJ_CPCAP(context)]() mutable { return pollWriteResp(context); });
+  if (!pollingWrites) {
+    pollingWrites = true;
+    writePoller = pollWriteResps().eagerlyEvaluate(nullptr);
+  }
+  return kj::mv(paf.promise);
 }
 
 /// ----- CosimServer definitions.
@@ -248,10 +307,12 @@ RpcServer::~RpcServer() { stop(); }
 /// Write the port number to a file. Necessary when we allow 'EzRpcServer' to
 /// select its own port. We can't use stdout/stderr because the flushing
 /// semantics are undefined (as in `flush()` doesn't work on all simulators).
-static void writePort(uint16_t port) {
+static void writePort(uint16_t port, const SharedMemoryBridge &shm) {
   // "cosim.cfg" since we may want to include other info in the future.
   FILE *fd = fopen("cosim.cfg", "w");
   fprintf(fd, "port: %u\n", (unsigned int)port);
+  if (shm.isOpen())
+    fprintf(fd, "shm: %s\n", shm.getName().c_str());
   fclose(fd);
 }
 
@@ -266,7 +327,7 @@ void RpcServer::mainLoop(uint16_t port) {
     auto portPromise = rpcServer.getPort();
     port = portPromise.wait(waitScope);
   }
-  writePort(port);
+  writePort(port, shmBridge);
   printf("[COSIM] Listening on port: %u\n", (unsigned int)port);
 
   // OK, this is uber hacky, but it unblocks me and isn't _too_ inefficient. The
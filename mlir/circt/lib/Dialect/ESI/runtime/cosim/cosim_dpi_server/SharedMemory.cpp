@@ -0,0 +1,102 @@
+//===- SharedMemory.cpp - Cosim shared memory bridge ------------*- C++ -*-===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+//
+// Create and tear down the shared memory region. POSIX only for now.
+//
+//===----------------------------------------------------------------------===//
+
+#include "cosim/SharedMemory.h"
+
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <new>
+
+#if !defined(_WIN32)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+using namespace esi::cosim;
+using namespace esi::backends::shm;
+
+#if defined(_WIN32)
+
+bool SharedMemoryBridge::open(std::string name) {
+  fprintf(stderr, "Shared memory cosim is not supported on Windows.\n");
+  return false;
+}
+
+void SharedMemoryBridge::close() {}
+
+#else
+
+bool SharedMemoryBridge::open(std::string name) {
+  if (region != nullptr) {
+    fprintf(stderr, "Shared memory region already open!\n");
+    return false;
+  }
+  if (name.empty() || name[0] != '/')
+    name = "/" + name;
+
+  // Start from scratch in case a previous simulation didn't clean up.
+  shm_unlink(name.c_str());
+  int fd = shm_open(name.c_str(), O_RDWR | O_CREAT | O_EXCL, 0600);
+  if (fd < 0) {
+    fprintf(stderr, "Could not create shared memory object %s: %s\n",
+            name.c_str(), strerror(errno));
+    return false;
+  }
+  void *addr = MAP_FAILED;
+  if (ftruncate(fd, sizeof(Region)) == 0)
+    addr = mmap(nullptr, sizeof(Region), PROT_READ | PROT_WRITE, MAP_SHARED,
+                fd, 0);
+  ::close(fd);
+  if (addr == MAP_FAILED) {
+    fprintf(stderr, "Could not map shared memory object %s: %s\n",
+            name.c_str(), strerror(errno));
+    shm_unlink(name.c_str());
+    return false;
+  }
+
+  // The fresh object is zero filled, which is a valid empty region. Clients
+  // won't touch it until the magic number shows up.
+  region = new (addr) Region;
+  region->version = RegionVersion;
+  region->magic.store(RegionMagic, std::memory_order_release);
+  this->name = name;
+  return true;
+}
+
+void SharedMemoryBridge::close() {
+  if (region == nullptr)
+    return;
+  region->magic.store(0, std::memory_order_release);
+  munmap(region, sizeof(Region));
+  shm_unlink(name.c_str());
+  region = nullptr;
+}
+
+#endif
+
+void SharedMemoryBridge::setManifest(
+    unsigned int esiVersion, const std::vector<uint8_t> &compressedManifest) {
+  if (region == nullptr)
+    return;
+  if (compressedManifest.size() > MaxCompressedManifestSize) {
+    fprintf(stderr, "Manifest too large for the shared memory region!\n");
+    return;
+  }
+  region->compressedManifestSize.store(0, std::memory_order_relaxed);
+  region->esiVersion = esiVersion;
+  memcpy(region->compressedManifest, compressedManifest.data(),
+         compressedManifest.size());
+  region->compressedManifestSize.store(compressedManifest.size(),
+                                       std::memory_order_release);
+}
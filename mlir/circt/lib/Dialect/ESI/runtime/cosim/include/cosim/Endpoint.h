@@ -13,12 +13,14 @@
 #ifndef COSIM_ENDPOINT_H
 #define COSIM_ENDPOINT_H
 
+#include "cosim/Utils.h"
+
 #include <functional>
 #include <map>
 #include <memory>
 #include <mutex>
-#include <queue>
 #include <string>
+#include <vector>
 
 namespace esi {
 namespace cosim {
@@ -30,14 +32,23 @@ namespace cosim {
 /// candidates for inlining during compilation. This is particularly important
 /// on the simulation side since polling happens at each clock and we do not
 /// want to slow down the simulation any more than necessary.
+///
+/// Each direction is a pair of lock-free single-producer/single-consumer
+/// queues: one carries messages and the other returns consumed message blobs
+/// to the producer so their storage can be reused. As such, all of the
+/// to-simulator producer methods must be called from one thread (the RPC
+/// server) and all of the to-simulator consumer methods from another (the
+/// simulator), and vice versa for the to-client direction.
 class Endpoint {
 public:
-  /// Representing messages as shared pointers to vectors may be a performance
-  /// issue in the future but it is the easiest way to ensure memory
-  /// correctness.
+  /// Messages are vectors of bytes. The blobs are pooled per direction, so
+  /// after warm up sending a message does not allocate.
   using Blob = std::vector<uint8_t>;
   using BlobPtr = std::unique_ptr<Blob>;
 
+  /// The maximum number of messages in flight in each direction.
+  static constexpr size_t queueDepth = 1024;
+
   /// Construct an endpoint which knows and the type IDs in both directions.
   Endpoint(std::string fromHostTypeId, int sendTypeMaxSize,
            std::string toHostTypeId, int recvTypeMaxSize);
@@ -54,55 +65,91 @@ public:
   bool setInUse();
   void returnForUse();
 
-  /// Queue message to the simulation.
-  void pushMessageToSim(BlobPtr msg) {
-    Lock g(m);
-    toCosim.push(std::move(msg));
+  /// Get an empty blob in which to build a message to the simulation.
+  BlobPtr allocMessageToSim() { return toCosim.alloc(); }
+
+  /// Queue message to the simulation. Returns false and leaves `msg` untouched
+  /// if the queue is full.
+  bool pushMessageToSim(BlobPtr &msg) {
+    return toCosim.msgs.push(std::move(msg));
   }
 
   /// Pop from the to-simulator queue. Return true if there was a message in the
   /// queue.
-  bool getMessageToSim(BlobPtr &msg) {
-    Lock g(m);
-    if (toCosim.empty())
-      return false;
-    msg = std::move(toCosim.front());
-    toCosim.pop();
-    return true;
-  }
+  bool getMessageToSim(BlobPtr &msg) { return toCosim.msgs.pop(msg); }
 
-  /// Queue message to the RPC client.
-  void pushMessageToClient(BlobPtr msg) {
-    Lock g(m);
-    toClient.push(std::move(msg));
+  /// Hand a blob obtained from `getMessageToSim` back for reuse.
+  void recycleMessageToSim(BlobPtr msg) { toCosim.recycle(std::move(msg)); }
+
+  /// Get an empty blob in which to build a message to the RPC client.
+  BlobPtr allocMessageToClient() { return toClient.alloc(); }
+
+  /// Queue message to the RPC client. Returns false and leaves `msg` untouched
+  /// if the queue is full.
+  bool pushMessageToClient(BlobPtr &msg) {
+    return toClient.msgs.push(std::move(msg));
   }
 
+  /// Returns true if `pushMessageToClient` would succeed. Only the RPC client
+  /// side can make room, so a true result stays valid until the next push.
+  bool canPushMessageToClient() { return !toClient.msgs.full(); }
+
   /// Pop from the to-RPC-client queue. Return true if there was a message in
   /// the queue.
-  bool getMessageToClient(BlobPtr &msg) {
-    Lock g(m);
-    if (toClient.empty())
-      return false;
-    msg = std::move(toClient.front());
-    toClient.pop();
-    return true;
+  bool getMessageToClient(BlobPtr &msg) { return toClient.msgs.pop(msg); }
+
+  /// Hand a blob obtained from `getMessageToClient` back for reuse.
+  void recycleMessageToClient(BlobPtr msg) {
+    toClient.recycle(std::move(msg));
   }
 
 private:
+  /// One direction of the bridge.
+  struct Channel {
+    Channel(int maxMsgSize)
+        : maxMsgSize(maxMsgSize > 0 ? maxMsgSize : 0), msgs(queueDepth),
+          pool(queueDepth) {}
+
+    /// Producer side. Reuse a recycled blob if there is one.
+    BlobPtr alloc() {
+      BlobPtr blob;
+      if (pool.pop(blob)) {
+        blob->clear();
+        return blob;
+      }
+      blob = std::make_unique<Blob>();
+      blob->reserve(maxMsgSize);
+      return blob;
+    }
+
+    /// Consumer side. If the pool is full, just let the blob go.
+    void recycle(BlobPtr blob) {
+      if (blob)
+        pool.push(std::move(blob));
+    }
+
+    /// The largest message the hardware claims to send or receive. Used to
+    /// size new blobs so they never need to grow.
+    const size_t maxMsgSize;
+    /// Messages from the producer to the consumer.
+    SPSCQueue<BlobPtr> msgs;
+    /// Consumed blobs from the consumer back to the producer.
+    SPSCQueue<BlobPtr> pool;
+  };
+
   const std::string fromHostTypeId;
   const std::string toHostTypeId;
-  bool inUse;
 
   using Lock = std::lock_guard<std::mutex>;
 
-  /// This class needs to be thread-safe. All of the mutable member variables
-  /// are protected with this object-wide lock. This may be a performance issue
-  /// in the future.
+  /// Protects `inUse`. The message queues are lock-free and need no lock.
   std::mutex m;
-  /// Message queue from RPC client to the simulation.
-  std::queue<BlobPtr> toCosim;
-  /// Message queue to RPC client from the simulation.
-  std::queue<BlobPtr> toClient;
+  bool inUse;
+
+  /// Messages from RPC client to the simulation.
+  Channel toCosim;
+  /// Messages to RPC client from the simulation.
+  Channel toClient;
 };
 
 /// The Endpoint registry is where Endpoints report their existence (register)
@@ -24,10 +24,17 @@ public:
   /// copying is almost always a bug.
   LowLevel(const LowLevel &) = delete;
 
-  TSQueue<uint32_t> readReqs;
-  TSQueue<std::pair<uint64_t, uint8_t>> readResps;
-  TSQueue<std::pair<uint32_t, uint64_t>> writeReqs;
-  TSQueue<uint8_t> writeResps;
+  SPSCQueue<uint32_t> readReqs;
+  SPSCQueue<std::pair<uint64_t, uint8_t>> readResps;
+  SPSCQueue<std::pair<uint32_t, uint64_t>> writeReqs;
+  SPSCQueue<uint8_t> writeResps;
+
+  /// The number of requests which have been issued but whose responses haven't
+  /// been collected. The RPC server keeps these below the response queues'
+  /// capacities so the simulator never finds a response queue full. Only
+  /// accessed from the RPC server thread.
+  size_t readsInFlight = 0;
+  size_t writesInFlight = 0;
 };
 
 } // namespace cosim
@@ -18,6 +18,7 @@
 
 #include "cosim/Endpoint.h"
 #include "cosim/LowLevel.h"
+#include "cosim/SharedMemory.h"
 #include <thread>
 
 namespace esi {
@@ -31,6 +32,9 @@ class RpcServer {
 public:
   EndpointRegistry endpoints;
   LowLevel lowLevelBridge;
+  /// Only open if requested. Must be opened before `run` so that its name gets
+  /// written to the config file.
+  SharedMemoryBridge shmBridge;
 
   RpcServer();
   ~RpcServer();
@@ -43,6 +47,7 @@ public:
                    const std::vector<uint8_t> &manifest) {
     this->esiVersion = esiVersion;
     compressedManifest = manifest;
+    shmBridge.setManifest(esiVersion, manifest);
   }
 
 private:
@@ -0,0 +1,80 @@
+//===- SharedMemory.h - Cosim shared memory bridge --------------*- C++ -*-===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+//
+// The simulation side of the shared memory transport. The region layout is
+// defined by the ESI runtime's shared memory backend
+// (esi/backends/SharedMemory.h) so the two always agree.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef COSIM_SHAREDMEMORY_H
+#define COSIM_SHAREDMEMORY_H
+
+#include "esi/backends/SharedMemory.h"
+
+#include <string>
+#include <vector>
+
+namespace esi {
+namespace cosim {
+
+/// Creates and owns the shared memory region through which a host process on
+/// the same machine can talk to the simulation without going through RPC. All
+/// of the MMIO methods are called from the simulator thread (via DPI).
+class SharedMemoryBridge {
+public:
+  SharedMemoryBridge() : region(nullptr) {}
+  ~SharedMemoryBridge() { close(); }
+  /// Disallow copying. There is only ONE region per simulation.
+  SharedMemoryBridge(const SharedMemoryBridge &) = delete;
+
+  /// Create the shared memory object `name` and initialize the region in it.
+  /// Returns false on failure.
+  bool open(std::string name);
+  /// Tell any attached client that the simulation is gone and remove the
+  /// shared memory object.
+  void close();
+
+  bool isOpen() const { return region != nullptr; }
+  const std::string &getName() const { return name; }
+
+  /// Publish the manifest to clients.
+  void setManifest(unsigned int esiVersion,
+                   const std::vector<uint8_t> &compressedManifest);
+
+  /// Poll for MMIO requests from the client. These are defined inline since
+  /// they are called on every clock.
+  bool tryGetRead(uint32_t &address) {
+    return region && region->mmioReadReqs.pop(address);
+  }
+  bool tryGetWrite(uint32_t &address, uint64_t &data) {
+    backends::shm::MMIOWriteReq req;
+    if (!region || !region->mmioWriteReqs.pop(req))
+      return false;
+    address = req.address;
+    data = req.data;
+    return true;
+  }
+
+  /// Respond to the oldest outstanding MMIO request. The client keeps no more
+  /// requests outstanding than the response rings hold, so there is always
+  /// room.
+  void respondRead(uint64_t data, uint8_t error) {
+    region->mmioReadResps.push({data, error});
+  }
+  void respondWrite(uint8_t error) { region->mmioWriteResps.push(error); }
+
+private:
+  std::string name;
+  backends::shm::Region *region;
+};
+
+} // namespace cosim
+} // namespace esi
+
+#endif
@@ -9,39 +9,103 @@
 #ifndef COSIM_UTILS_H
 #define COSIM_UTILS_H
 
-#include <mutex>
+#include <atomic>
+#include <cstddef>
 #include <optional>
-#include <queue>
+#include <utility>
+#include <vector>
 
 namespace esi {
 namespace cosim {
 
-/// Thread safe queue. Just wraps std::queue protected with a lock.
+/// Bounded, lock-free, single-producer/single-consumer queue. Exactly one
+/// thread may push and exactly one (other) thread may pop. In cosim, one side
+/// is always the simulator thread (via DPI) and the other is the RPC server
+/// thread.
+///
+/// The producer owns `tail` and the consumer owns `head`. Each side keeps a
+/// private copy of the other side's index and only re-reads the shared atomic
+/// when that copy says the queue is full (or empty), so the common case of
+/// polling an empty queue touches a single cache line.
 template <typename T>
-class TSQueue {
-  using Lock = std::lock_guard<std::mutex>;
-
-  std::mutex m;
-  std::queue<T> q;
+class SPSCQueue {
+  /// Keep the indices on separate cache lines so the two threads don't
+  /// invalidate each other's caches on every operation.
+  static constexpr size_t cacheLineSize = 64;
 
 public:
-  /// Push onto the queue.
+  /// Construct a queue which holds at least `capacity` elements. The capacity
+  /// is rounded up to a power of two.
+  explicit SPSCQueue(size_t capacity = 1024) {
+    size_t size = 1;
+    while (size < capacity)
+      size <<= 1;
+    slots.resize(size);
+    mask = size - 1;
+  }
+  SPSCQueue(const SPSCQueue &) = delete;
+
+  /// The number of elements the queue can hold.
+  size_t capacity() const { return mask + 1; }
+
+  /// Push onto the queue. Returns false if the queue is full. Producer only.
   template <typename... E>
-  void push(E... t) {
-    Lock l(m);
-    q.emplace(t...);
+  bool push(E &&...t) {
+    size_t t0 = tail.load(std::memory_order_relaxed);
+    if (t0 - cachedHead > mask) {
+      cachedHead = head.load(std::memory_order_acquire);
+      if (t0 - cachedHead > mask)
+        return false;
+    }
+    slots[t0 & mask] = T(std::forward<E>(t)...);
+    tail.store(t0 + 1, std::memory_order_release);
+    return true;
+  }
+
+  /// Returns true if a push would fail. Producer only. Since only the consumer
+  /// can make room, a false result stays valid until the next push.
+  bool full() {
+    size_t t0 = tail.load(std::memory_order_relaxed);
+    if (t0 - cachedHead <= mask)
+      return false;
+    cachedHead = head.load(std::memory_order_acquire);
+    return t0 - cachedHead > mask;
   }
 
-  /// Pop something off the queue but return nullopt if the queue is empty. Why
-  /// doesn't std::queue have anything like this?
+  /// Pop something off the queue into `t`. Returns false if the queue is
+  /// empty. Consumer only.
+  bool pop(T &t) {
+    size_t h0 = head.load(std::memory_order_relaxed);
+    if (h0 == cachedTail) {
+      cachedTail = tail.load(std::memory_order_acquire);
+      if (h0 == cachedTail)
+        return false;
+    }
+    t = std::move(slots[h0 & mask]);
+    head.store(h0 + 1, std::memory_order_release);
+    return true;
+  }
+
+  /// Pop something off the queue but return nullopt if the queue is empty.
+  /// Consumer only.
   std::optional<T> pop() {
-    Lock l(m);
-    if (q.size() == 0)
+    T t;
+    if (!pop(t))
       return std::nullopt;
-    auto t = q.front();
-    q.pop();
     return t;
   }
+
+private:
+  std::vector<T> slots;
+  size_t mask;
+
+  /// Consumer side.
+  alignas(cacheLineSize) std::atomic<size_t> head{0};
+  size_t cachedTail = 0;
+
+  /// Producer side.
+  alignas(cacheLineSize) std::atomic<size_t> tail{0};
+  size_t cachedHead = 0;
 };
 
 } // namespace cosim
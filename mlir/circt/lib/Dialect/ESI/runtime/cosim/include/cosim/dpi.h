@@ -39,6 +39,8 @@ DPI int sv2cCosimserverEpTryGet(char *endpointId,
 DPI int sv2cCosimserverEpTryPut(char *endpointId,
                                 // NOLINTNEXTLINE(misc-misplaced-const)
                                 const svOpenArrayHandle data, int dataLimit);
+/// Check whether there is room to send a message to a client.
+DPI int sv2cCosimserverEpCanPut(char *endpointId);
 
 /// Start the server. Not required as the first endpoint registration will do
 /// this. Provided if one wants to start the server early.
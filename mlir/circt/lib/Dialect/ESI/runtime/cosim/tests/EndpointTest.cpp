@@ -0,0 +1,167 @@
+//===- EndpointTest.cpp - Cosim endpoint queue tests ----------------------===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+//
+// Check the ordering, capacity, and backpressure behavior of SPSCQueue and the
+// Endpoint built on it. Exits non-zero on the first failure.
+//
+//===----------------------------------------------------------------------===//
+
+#include "cosim/Endpoint.h"
+
+#include <cstdlib>
+#include <iostream>
+#include <thread>
+
+using namespace esi::cosim;
+
+#define CHECK(cond)                                                            \
+  do {                                                                         \
+    if (!(cond)) {                                                             \
+      std::cerr << __FILE__ << ":" << __LINE__ << ": check failed: " #cond     \
+                << std::endl;                                                  \
+      exit(1);                                                                 \
+    }                                                                          \
+  } while (0)
+
+/// A queue holds exactly its (rounded up) capacity, refuses more, and hands
+/// elements back in order, including after the indices wrap around.
+static void testQueueCapacity() {
+  SPSCQueue<int> queue(5);
+  CHECK(queue.capacity() == 8);
+
+  int next = 0, expected = 0;
+  for (int round = 0; round < 3; ++round) {
+    CHECK(!queue.full());
+    for (size_t i = 0; i < queue.capacity(); ++i)
+      CHECK(queue.push(next++));
+    CHECK(queue.full());
+    CHECK(!queue.push(-1));
+
+    // Popping one element makes room for exactly one more.
+    int value;
+    CHECK(queue.pop(value) && value == expected++);
+    CHECK(!queue.full());
+    CHECK(queue.push(next++));
+    CHECK(queue.full());
+
+    while (queue.pop(value))
+      CHECK(value == expected++);
+    CHECK(!queue.pop());
+  }
+  CHECK(expected == next);
+}
+
+/// A producer and a consumer on separate threads see every element exactly
+/// once and in order.
+static void testQueueThreads() {
+  constexpr size_t numElements = 1000000;
+  SPSCQueue<size_t> queue(64);
+
+  std::thread producer([&]() {
+    for (size_t i = 0; i < numElements; ++i)
+      while (!queue.push(i))
+        std::this_thread::yield();
+  });
+
+  size_t expected = 0;
+  while (expected < numElements) {
+    size_t value;
+    if (!queue.pop(value)) {
+      std::this_thread::yield();
+      continue;
+    }
+    CHECK(value == expected);
+    ++expected;
+  }
+  producer.join();
+  CHECK(!queue.pop());
+}
+
+/// The to-client direction reports when it is full, as the simulator relies on
+/// this to deassert DataInReady, and recycles the blobs it hands out.
+static void testEndpointToClient() {
+  Endpoint ep("", 4, "", 4);
+  CHECK(ep.canPushMessageToClient());
+
+  for (size_t i = 0; i < Endpoint::queueDepth; ++i) {
+    CHECK(ep.canPushMessageToClient());
+    Endpoint::BlobPtr blob = ep.allocMessageToClient();
+    blob->push_back(i & 0xff);
+    CHECK(ep.pushMessageToClient(blob));
+    CHECK(!blob);
+  }
+  CHECK(!ep.canPushMessageToClient());
+
+  // A push into a full queue must leave the message with the caller.
+  Endpoint::BlobPtr extra = ep.allocMessageToClient();
+  extra->push_back(0x5a);
+  CHECK(!ep.pushMessageToClient(extra));
+  CHECK(extra && extra->size() == 1);
+
+  Endpoint::BlobPtr msg;
+  CHECK(ep.getMessageToClient(msg));
+  CHECK(msg->size() == 1 && (*msg)[0] == 0);
+  Endpoint::Blob *recycled = msg.get();
+  ep.recycleMessageToClient(std::move(msg));
+  CHECK(ep.canPushMessageToClient());
+  CHECK(ep.pushMessageToClient(extra));
+  CHECK(!ep.canPushMessageToClient());
+
+  // The consumed blob comes back empty from the pool.
+  for (size_t i = 1; i < Endpoint::queueDepth; ++i) {
+    CHECK(ep.getMessageToClient(msg));
+    CHECK((*msg)[0] == (i & 0xff));
+  }
+  CHECK(ep.getMessageToClient(msg));
+  CHECK((*msg)[0] == 0x5a);
+  CHECK(!ep.getMessageToClient(msg));
+  Endpoint::BlobPtr reused = ep.allocMessageToClient();
+  CHECK(reused.get() == recycled && reused->empty());
+}
+
+/// Messages to the simulator arrive in order and intact across threads.
+static void testEndpointToSim() {
+  constexpr size_t numMsgs = 100000;
+  Endpoint ep("", 8, "", 8);
+
+  std::thread producer([&]() {
+    for (size_t i = 0; i < numMsgs; ++i) {
+      Endpoint::BlobPtr blob = ep.allocMessageToSim();
+      for (size_t b = 0; b < 8; ++b)
+        blob->push_back((i >> (b * 8)) & 0xff);
+      while (!ep.pushMessageToSim(blob))
+        std::this_thread::yield();
+    }
+  });
+
+  size_t expected = 0;
+  Endpoint::BlobPtr msg;
+  while (expected < numMsgs) {
+    if (!ep.getMessageToSim(msg)) {
+      std::this_thread::yield();
+      continue;
+    }
+    CHECK(msg->size() == 8);
+    size_t value = 0;
+    for (size_t b = 0; b < 8; ++b)
+      value |= static_cast<size_t>((*msg)[b]) << (b * 8);
+    CHECK(value == expected);
+    ++expected;
+    ep.recycleMessageToSim(std::move(msg));
+  }
+  producer.join();
+}
+
+int main() {
+  testQueueCapacity();
+  testQueueThreads();
+  testEndpointToClient();
+  testEndpointToSim();
+  std::cout << "PASS" << std::endl;
+  return 0;
+}
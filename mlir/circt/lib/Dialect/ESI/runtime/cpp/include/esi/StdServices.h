@@ -23,6 +23,9 @@
 #include "esi/Accelerator.h"
 
 #include <cstdint>
+#include <future>
+#include <utility>
+#include <vector>
 
 namespace esi {
 namespace services {
@@ -47,6 +50,23 @@ public:
   virtual ~MMIO() = default;
   virtual uint64_t read(uint32_t addr) const = 0;
   virtual void write(uint32_t addr, uint64_t data) = 0;
+
+  /// Read a number of registers, returning the values in the same order.
+  /// Backends which can have multiple requests outstanding should override this
+  /// to pay for one round trip rather than one per address. The default issues
+  /// all of the async reads then waits for them.
+  virtual std::vector<uint64_t>
+  readBatch(const std::vector<uint32_t> &addrs) const;
+  /// Write a number of registers in order. Returns once all of them are done.
+  virtual void
+  writeBatch(const std::vector<std::pair<uint32_t, uint64_t>> &writes);
+
+  /// Start a read and return without waiting for it. Requests are issued in
+  /// order. The futures must be waited on from the thread which issued them.
+  /// The default performs the access immediately.
+  virtual std::future<uint64_t> readAsync(uint32_t addr) const;
+  /// Start a write and return without waiting for it.
+  virtual std::future<void> writeAsync(uint32_t addr, uint64_t data);
 };
 
 /// Implement the SysInfo API for a standard MMIO protocol.
@@ -0,0 +1,143 @@
+//===- SharedMemory.h - ESI C++ shared memory cosim backend -----*- C++ -*-===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+//
+// This is a specialization of the ESI C++ API (backend) for connection into a
+// simulation of an ESI system running on the same machine. Rather than going
+// through Cap'nProto RPC over a socket, the cosim DPI server and this backend
+// map the same shared memory region and exchange requests through lock-free
+// ring buffers within it. No serialization or syscalls are necessary per
+// request.
+//
+// The region layout is defined here and shared with the cosim DPI server.
+// Everything in it must be address-free since the two processes map it at
+// different addresses.
+//
+// DO NOT EDIT!
+// This file is distributed as part of an ESI package. The source for this file
+// should always be modified within CIRCT
+// (lib/dialect/ESI/runtime/cpp/include/esi/backends/SharedMemory.h).
+//
+//===----------------------------------------------------------------------===//
+
+// NOLINTNEXTLINE(llvm-header-guard)
+#ifndef ESI_BACKENDS_SHAREDMEMORY_H
+#define ESI_BACKENDS_SHAREDMEMORY_H
+
+#include "esi/Accelerator.h"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+namespace esi {
+namespace backends {
+namespace shm {
+
+/// Identifies an initialized region. Written last by the server when the region
+/// is ready and cleared when the simulation exits.
+constexpr uint64_t RegionMagic = 0x4d48534d49534f43; // "COSIMSHM"
+/// Bump whenever the layout below changes.
+constexpr uint32_t RegionVersion = 2;
+/// The maximum size of the compressed manifest the region can carry.
+constexpr uint32_t MaxCompressedManifestSize = 4 << 20;
+/// The number of MMIO requests which can be queued in each direction.
+constexpr size_t MMIOQueueDepth = 64;
+
+static_assert(std::atomic<uint64_t>::is_always_lock_free,
+              "shared memory rings require lock-free 64-bit atomics");
+
+/// A bounded single-producer/single-consumer ring buffer which lives in shared
+/// memory. The indices increase monotonically and are masked to get the slot.
+/// All zeros is a valid, empty ring.
+template <typename T, size_t Depth>
+struct Ring {
+  static_assert((Depth & (Depth - 1)) == 0, "Depth must be a power of two");
+
+  /// Producer side. Returns false if the ring is full.
+  bool push(const T &t) {
+    uint64_t t0 = tail.load(std::memory_order_relaxed);
+    if (t0 - head.load(std::memory_order_acquire) >= Depth)
+      return false;
+    slots[t0 % Depth] = t;
+    tail.store(t0 + 1, std::memory_order_release);
+    return true;
+  }
+
+  /// Consumer side. Returns false if the ring is empty.
+  bool pop(T &t) {
+    uint64_t h0 = head.load(std::memory_order_relaxed);
+    if (h0 == tail.load(std::memory_order_acquire))
+      return false;
+    t = slots[h0 % Depth];
+    head.store(h0 + 1, std::memory_order_release);
+    return true;
+  }
+
+  alignas(64) std::atomic<uint64_t> head;
+  alignas(64) std::atomic<uint64_t> tail;
+  alignas(64) T slots[Depth];
+};
+
+struct MMIOReadResp {
+  uint64_t data;
+  uint8_t error;
+};
+struct MMIOWriteReq {
+  uint32_t address;
+  uint64_t data;
+};
+
+/// The contents of the shared memory region. The server creates and owns it;
+/// exactly one client may attach at a time.
+struct Region {
+  std::atomic<uint64_t> magic;
+  uint32_t version;
+  /// The process ID of the attached client, or zero if there is none. A client
+  /// which finds a process ID here that no longer exists takes over.
+  std::atomic<uint32_t> clientPid;
+
+  /// The manifest is published once by the simulation at startup. Zero size
+  /// means it hasn't been set yet.
+  uint32_t esiVersion;
+  std::atomic<uint32_t> compressedManifestSize;
+
+  /// MMIO requests flow from the client (producer) to the simulation
+  /// (consumer) and the responses the other way around. Responses come back in
+  /// request order.
+  Ring<uint32_t, MMIOQueueDepth> mmioReadReqs;
+  Ring<MMIOReadResp, MMIOQueueDepth> mmioReadResps;
+  Ring<MMIOWriteReq, MMIOQueueDepth> mmioWriteReqs;
+  Ring<uint8_t, MMIOQueueDepth> mmioWriteResps;
+
+  uint8_t compressedManifest[MaxCompressedManifestSize];
+};
+
+/// Connect to an ESI simulation through shared memory.
+class SharedMemoryAccelerator : public esi::Accelerator {
+public:
+  /// Map the shared memory object `name` and attach to it. Throws if the
+  /// simulation isn't running or another live client is attached. If the
+  /// previous client died while attached, the responses to its outstanding
+  /// requests are waited for and discarded.
+  SharedMemoryAccelerator(std::string name);
+  ~SharedMemoryAccelerator();
+  static std::unique_ptr<Accelerator> connect(std::string connectionString);
+
+protected:
+  virtual Service *createService(Service::Type service) override;
+
+private:
+  Region *region;
+};
+
+} // namespace shm
+} // namespace backends
+} // namespace esi
+
+#endif // ESI_BACKENDS_SHAREDMEMORY_H
@@ -28,18 +28,25 @@ services::Service *Accelerator::getServiceImpl(Service::Type svcType) {
 namespace registry {
 namespace internal {
 
-static std::map<std::string, BackendCreate> backendRegistry;
+/// Backends register themselves from static initializers in other translation
+/// units, so construct the registry on first use.
+static std::map<std::string, BackendCreate> &backendRegistry() {
+  static std::map<std::string, BackendCreate> registry;
+  return registry;
+}
 void registerBackend(std::string name, BackendCreate create) {
-  if (backendRegistry.count(name))
+  auto &registry = backendRegistry();
+  if (registry.count(name))
     throw std::runtime_error("Backend already exists in registry");
-  backendRegistry[name] = create;
+  registry[name] = create;
 }
 } // namespace internal
 
 std::unique_ptr<Accelerator> connect(std::string backend,
                                      std::string connection) {
-  auto f = internal::backendRegistry.find(backend);
-  if (f == internal::backendRegistry.end())
+  auto &registry = internal::backendRegistry();
+  auto f = registry.find(backend);
+  if (f == registry.end())
     throw std::runtime_error("Backend not found");
   return f->second(connection);
 }
@@ -38,6 +38,50 @@ std::string SysInfo::jsonManifest() const {
   return std::string(reinterpret_cast<char *>(dst.data()), dstSize);
 }
 
+std::vector<uint64_t>
+MMIO::readBatch(const std::vector<uint32_t> &addrs) const {
+  std::vector<std::future<uint64_t>> futures;
+  futures.reserve(addrs.size());
+  for (uint32_t addr : addrs)
+    futures.push_back(readAsync(addr));
+  std::vector<uint64_t> results;
+  results.reserve(addrs.size());
+  for (auto &f : futures)
+    results.push_back(f.get());
+  return results;
+}
+
+void MMIO::writeBatch(
+    const std::vector<std::pair<uint32_t, uint64_t>> &writes) {
+  std::vector<std::future<void>> futures;
+  futures.reserve(writes.size());
+  for (auto [addr, data] : writes)
+    futures.push_back(writeAsync(addr, data));
+  for (auto &f : futures)
+    f.get();
+}
+
+std::future<uint64_t> MMIO::readAsync(uint32_t addr) const {
+  std::promise<uint64_t> p;
+  try {
+    p.set_value(read(addr));
+  } catch (...) {
+    p.set_exception(std::current_exception());
+  }
+  return p.get_future();
+}
+
+std::future<void> MMIO::writeAsync(uint32_t addr, uint64_t data) {
+  std::promise<void> p;
+  try {
+    write(addr, data);
+    p.set_value();
+  } catch (...) {
+    p.set_exception(std::current_exception());
+  }
+  return p.get_future();
+}
+
 MMIOSysInfo::MMIOSysInfo(const MMIO *mmio) : mmio(mmio) {}
 
 uint32_t MMIOSysInfo::esiVersion() const {
@@ -20,6 +20,7 @@
 #include <capnp/ez-rpc.h>
 
 #include <fstream>
+#include <future>
 #include <iostream>
 
 using namespace esi;
@@ -99,6 +100,27 @@ public:
     req.send().wait(waitScope);
   }
 
+  /// Send the request right away so that many can be in flight at once, but
+  /// only drive the event loop when the result is asked for. kj is single
+  /// threaded, so the wait must happen on the thread which sent the request.
+  std::future<uint64_t> readAsync(uint32_t addr) const override {
+    auto req = llClient.readMMIORequest();
+    req.setAddress(addr);
+    return std::async(std::launch::deferred,
+                      [promise = req.send(), &waitScope = waitScope]() mutable {
+                        return promise.wait(waitScope).getData();
+                      });
+  }
+  std::future<void> writeAsync(uint32_t addr, uint64_t data) override {
+    auto req = llClient.writeMMIORequest();
+    req.setAddress(addr);
+    req.setData(data);
+    return std::async(std::launch::deferred,
+                      [promise = req.send(), &waitScope = waitScope]() mutable {
+                        promise.wait(waitScope);
+                      });
+  }
+
 private:
   EsiLowLevel::Client &llClient;
   kj::WaitScope &waitScope;
@@ -0,0 +1,273 @@
+//===- SharedMemory.cpp - Connection to ESI simulation via shared memory --===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+//
+// DO NOT EDIT!
+// This file is distributed as part of an ESI package. The source for this file
+// should always be modified within CIRCT
+// (lib/dialect/ESI/runtime/cpp/lib/backends/SharedMemory.cpp).
+//
+//===----------------------------------------------------------------------===//
+
+#include "esi/backends/SharedMemory.h"
+#include "esi/StdServices.h"
+
+#include <cerrno>
+#include <fstream>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+
+#if !defined(_WIN32)
+#include <fcntl.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+using namespace esi;
+using namespace esi::services;
+using namespace esi::backends::shm;
+
+namespace {
+/// Spin until `ready` returns true. Throws if the simulation goes away in the
+/// meantime.
+template <typename Fn>
+void waitFor(const Region *region, Fn ready) {
+  while (!ready()) {
+    if (region->magic.load(std::memory_order_relaxed) != RegionMagic)
+      throw std::runtime_error("simulation exited");
+    std::this_thread::yield();
+  }
+}
+} // namespace
+
+/// Parse the connection string and instantiate the accelerator. Accept either
+/// the name of the shared memory object or a path to the 'cosim.cfg' which is
+/// output by the cosimulation when it starts.
+std::unique_ptr<Accelerator>
+SharedMemoryAccelerator::connect(std::string connectionString) {
+  std::string name = connectionString;
+  std::ifstream cfg(connectionString);
+  if (cfg.good()) {
+    name.clear();
+    std::string line;
+    size_t colon;
+    while (std::getline(cfg, line))
+      if ((colon = line.find(":")) != std::string::npos &&
+          line.substr(0, colon) == "shm")
+        name = line.substr(line.find_first_not_of(' ', colon + 1));
+    if (name.size() == 0)
+      throw std::runtime_error("shm line not found in file");
+  }
+  return std::make_unique<SharedMemoryAccelerator>(name);
+}
+
+#if defined(_WIN32)
+
+SharedMemoryAccelerator::SharedMemoryAccelerator(std::string name)
+    : region(nullptr) {
+  throw std::runtime_error("shared memory cosim is not supported on Windows");
+}
+SharedMemoryAccelerator::~SharedMemoryAccelerator() {}
+
+#else
+
+/// Claim the region for this process. A previous client which exited without
+/// detaching, e.g. because it crashed, leaves its process ID behind; take over
+/// from it.
+static bool claimRegion(Region *region) {
+  uint32_t self = getpid();
+  uint32_t owner = 0;
+  while (!region->clientPid.compare_exchange_strong(owner, self)) {
+    if (owner == self || kill(owner, 0) == 0 || errno != ESRCH)
+      return false;
+    // `owner` now holds the dead client's PID, so the exchange only succeeds if
+    // nobody else took over in the meantime.
+  }
+  return true;
+}
+
+/// Wait for the simulation to answer every request a previous client left in
+/// flight, and throw away the responses, such that the next response popped
+/// belongs to our first request. This client is the only producer of requests
+/// and the only consumer of responses once it holds the region.
+static void drainResponses(Region *region) {
+  MMIOReadResp readResp;
+  while (region->mmioReadResps.head.load(std::memory_order_relaxed) !=
+         region->mmioReadReqs.tail.load(std::memory_order_relaxed))
+    waitFor(region, [&]() { return region->mmioReadResps.pop(readResp); });
+  uint8_t writeResp;
+  while (region->mmioWriteResps.head.load(std::memory_order_relaxed) !=
+         region->mmioWriteReqs.tail.load(std::memory_order_relaxed))
+    waitFor(region, [&]() { return region->mmioWriteResps.pop(writeResp); });
+}
+
+SharedMemoryAccelerator::SharedMemoryAccelerator(std::string name) {
+  if (name.empty() || name[0] != '/')
+    name = "/" + name;
+  int fd = shm_open(name.c_str(), O_RDWR, 0);
+  if (fd < 0)
+    throw std::runtime_error("could not open shared memory object " + name);
+  struct stat st;
+  if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(Region)) {
+    close(fd);
+    throw std::runtime_error("shared memory object " + name +
+                             " is too small to be a cosim region");
+  }
+  void *addr =
+      mmap(nullptr, sizeof(Region), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  close(fd);
+  if (addr == MAP_FAILED)
+    throw std::runtime_error("could not map shared memory object " + name);
+  region = static_cast<Region *>(addr);
+
+  const char *err = nullptr;
+  if (region->magic.load(std::memory_order_acquire) != RegionMagic)
+    err = "simulation is not running";
+  else if (region->version != RegionVersion)
+    err = "shared memory region version mismatch";
+  else if (!claimRegion(region))
+    err = "another client is already attached";
+  if (err) {
+    munmap(region, sizeof(Region));
+    throw std::runtime_error(std::string("cannot connect to ") + name + ": " +
+                             err);
+  }
+
+  try {
+    drainResponses(region);
+  } catch (...) {
+    region->clientPid.store(0, std::memory_order_release);
+    munmap(region, sizeof(Region));
+    throw;
+  }
+}
+
+SharedMemoryAccelerator::~SharedMemoryAccelerator() {
+  region->clientPid.store(0, std::memory_order_release);
+  munmap(region, sizeof(Region));
+}
+
+#endif
+
+namespace {
+class SharedMemoryMMIO : public MMIO {
+public:
+  SharedMemoryMMIO(Region *region) : region(region) {}
+
+  uint64_t read(uint32_t addr) const override {
+    std::lock_guard<std::mutex> g(m);
+    waitFor(region, [&]() { return region->mmioReadReqs.push(addr); });
+    MMIOReadResp resp;
+    waitFor(region, [&]() { return region->mmioReadResps.pop(resp); });
+    if (resp.error)
+      throw std::runtime_error("Read MMIO register encountered an error");
+    return resp.data;
+  }
+  void write(uint32_t addr, uint64_t data) override {
+    std::lock_guard<std::mutex> g(m);
+    waitFor(region,
+            [&]() { return region->mmioWriteReqs.push({addr, data}); });
+    uint8_t error;
+    waitFor(region, [&]() { return region->mmioWriteResps.pop(error); });
+    if (error)
+      throw std::runtime_error("write MMIO register encountered an error");
+  }
+
+  /// Keep the request ring topped up while collecting responses. At most
+  /// `MMIOQueueDepth` requests are outstanding so the simulation always has
+  /// room for its responses.
+  std::vector<uint64_t>
+  readBatch(const std::vector<uint32_t> &addrs) const override {
+    std::lock_guard<std::mutex> g(m);
+    std::vector<uint64_t> results;
+    results.reserve(addrs.size());
+    bool error = false;
+    size_t sent = 0;
+    while (results.size() < addrs.size()) {
+      while (sent < addrs.size() && sent - results.size() < MMIOQueueDepth &&
+             region->mmioReadReqs.push(addrs[sent]))
+        ++sent;
+      MMIOReadResp resp;
+      waitFor(region, [&]() { return region->mmioReadResps.pop(resp); });
+      error |= resp.error != 0;
+      results.push_back(resp.data);
+    }
+    if (error)
+      throw std::runtime_error("Read MMIO register encountered an error");
+    return results;
+  }
+  void writeBatch(
+      const std::vector<std::pair<uint32_t, uint64_t>> &writes) override {
+    std::lock_guard<std::mutex> g(m);
+    bool error = false;
+    size_t sent = 0;
+    for (size_t done = 0; done < writes.size(); ++done) {
+      while (sent < writes.size() && sent - done < MMIOQueueDepth &&
+             region->mmioWriteReqs.push({writes[sent].first,
+                                         writes[sent].second}))
+        ++sent;
+      uint8_t resp;
+      waitFor(region, [&]() { return region->mmioWriteResps.pop(resp); });
+      error |= resp != 0;
+    }
+    if (error)
+      throw std::runtime_error("write MMIO register encountered an error");
+  }
+
+private:
+  Region *region;
+  /// The rings are single-producer/single-consumer, so only one thread in this
+  /// process may be issuing requests at a time. This also keeps each response
+  /// paired with its request.
+  mutable std::mutex m;
+};
+} // namespace
+
+namespace {
+class SharedMemorySysInfo : public SysInfo {
+public:
+  SharedMemorySysInfo(const Region *region) : region(region) {}
+
+  uint32_t esiVersion() const override {
+    waitForManifest();
+    return region->esiVersion;
+  }
+
+  std::vector<uint8_t> compressedManifest() const override {
+    uint32_t size = waitForManifest();
+    return std::vector<uint8_t>(region->compressedManifest,
+                                region->compressedManifest + size);
+  }
+
+private:
+  /// The simulation publishes the manifest shortly after it starts, possibly
+  /// after we have connected.
+  uint32_t waitForManifest() const {
+    uint32_t size;
+    waitFor(region, [&]() {
+      size = region->compressedManifestSize.load(std::memory_order_acquire);
+      return size != 0;
+    });
+    return size;
+  }
+
+  const Region *region;
+};
+} // namespace
+
+Service *SharedMemoryAccelerator::createService(Service::Type svcType) {
+  if (svcType == typeid(MMIO))
+    return new SharedMemoryMMIO(region);
+  else if (svcType == typeid(SysInfo))
+    return new SharedMemorySysInfo(region);
+  return nullptr;
+}
+
+REGISTER_ACCELERATOR("cosim-shm", backends::shm::SharedMemoryAccelerator);
@@ -0,0 +1,75 @@
+//===- esimmiobench.cpp - ESI MMIO throughput benchmark -------------------===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+//
+// Compare one-at-a-time MMIO reads against batched and asynchronous ones to
+// show how much of the per-access round trip is amortized.
+//
+// DO NOT EDIT!
+// This file is distributed as part of an ESI package. The source for this file
+// should always be modified within CIRCT
+// (lib/dialect/ESI/runtime/cpp/tools/esimmiobench.cpp).
+//
+//===----------------------------------------------------------------------===//
+
+#include "esi/Accelerator.h"
+#include "esi/StdServices.h"
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <stdexcept>
+
+using namespace esi;
+using namespace esi::services;
+
+/// Run `f` and print how long each of the `num` reads it does took on average.
+template <typename Fn>
+static void time(const char *name, size_t num, Fn f) {
+  auto start = std::chrono::steady_clock::now();
+  f();
+  std::chrono::duration<double, std::micro> us =
+      std::chrono::steady_clock::now() - start;
+  std::cout << "  " << name << ": " << us.count() / num << " us/read"
+            << std::endl;
+}
+
+int main(int argc, const char *argv[]) {
+  if (argc < 3) {
+    std::cerr << "Expected usage: " << argv[0]
+              << " <backend> <connection specifier> [number of reads]"
+              << std::endl;
+    return -1;
+  }
+
+  std::unique_ptr<Accelerator> acc = registry::connect(argv[1], argv[2]);
+  MMIO *mmio = acc->getService<MMIO>();
+  if (!mmio)
+    throw std::runtime_error("Backend does not support MMIO");
+  size_t num = argc > 3 ? std::strtoull(argv[3], nullptr, 10) : 10000;
+
+  // Read the ESI magic number and version registers over and over.
+  std::vector<uint32_t> addrs(num);
+  for (size_t i = 0; i < num; ++i)
+    addrs[i] = MagicNumOffset + 4 * (i % 3);
+
+  std::cout << "Reading " << num << " MMIO registers" << std::endl;
+  time("blocking", num, [&]() {
+    for (uint32_t addr : addrs)
+      mmio->read(addr);
+  });
+  time("batched ", num, [&]() { mmio->readBatch(addrs); });
+  time("async   ", num, [&]() {
+    std::vector<std::future<uint64_t>> futures;
+    futures.reserve(num);
+    for (uint32_t addr : addrs)
+      futures.push_back(mmio->readAsync(addr));
+    for (auto &f : futures)
+      f.get();
+  });
+  return 0;
+}
@@ -15,6 +15,7 @@
 
 // pybind11 includes
 #include "pybind11/pybind11.h"
+#include "pybind11/stl.h"
 namespace py = pybind11;
 
 using namespace esi;
@@ -35,5 +36,7 @@ PYBIND11_MODULE(esiCppAccel, m) {
 
   py::class_<services::MMIO>(m, "MMIO")
       .def("read", &services::MMIO::read)
-      .def("write", &services::MMIO::write);
+      .def("write", &services::MMIO::write)
+      .def("read_batch", &services::MMIO::readBatch)
+      .def("write_batch", &services::MMIO::writeBatch);
 }
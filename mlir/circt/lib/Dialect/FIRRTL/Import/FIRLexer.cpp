@@ -162,6 +162,13 @@ FIRLexer::FIRLexer(const llvm::SourceMgr &sourceMgr, MLIRContext *context)
       curBuffer(
           sourceMgr.getMemoryBuffer(sourceMgr.getMainFileID())->getBuffer()),
       curPtr(curBuffer.begin()),
+      // Old Mac-style files terminate lines with a lone '\r'. Checking the
+      // first line terminator is enough to tell them apart.
+      hasNewlineTerminatedLines([&] {
+        auto pos = curBuffer.find_first_of("\r\n");
+        return pos == StringRef::npos || curBuffer[pos] == '\n' ||
+               curBuffer.substr(pos).startswith("\r\n");
+      }()),
       // Prime the first token.
       curToken(lexTokenImpl()) {}
 
@@ -205,6 +212,42 @@ std::optional<unsigned> FIRLexer::getIndentation(const FIRToken &tok) const {
   return indent;
 }
 
+void FIRLexer::skipToLineWithIndentation(unsigned indent) {
+  assert(curToken.isNot(FIRToken::eof, FIRToken::error) &&
+         "shouldn't advance past EOF or errors");
+
+  // Fall back to lexing token by token if we can't find line starts quickly.
+  if (!hasNewlineTerminatedLines) {
+    do
+      lexToken();
+    while (getIndentation(curToken) != indent &&
+           curToken.isNot(FIRToken::eof, FIRToken::error));
+    return;
+  }
+
+  // Find each line start with memchr, which is vectorized by the C library,
+  // and only look at the indentation of the line.
+  const char *end = curBuffer.end();
+  const char *ptr = curPtr;
+  while (true) {
+    const auto *newline =
+        static_cast<const char *>(memchr(ptr, '\n', end - ptr));
+    if (!newline) {
+      curPtr = end;
+      break;
+    }
+    const char *lineStart = ptr = newline + 1;
+    while (ptr != end && (*ptr == ' ' || *ptr == '\t' || *ptr == ','))
+      ++ptr;
+    if (ptr != end && unsigned(ptr - lineStart) == indent &&
+        (llvm::isAlpha(*ptr) || *ptr == '_' || *ptr == '`')) {
+      curPtr = ptr;
+      break;
+    }
+  }
+  lexToken();
+}
+
 //===----------------------------------------------------------------------===//
 // Lexer Implementation Methods
 //===----------------------------------------------------------------------===//
@@ -117,6 +117,12 @@ public:
   /// Get an opaque pointer into the lexer state that can be restored later.
   FIRLexerCursor getCursor() const;
 
+  /// Skip to the next line whose first character is an identifier character
+  /// at the specified indentation, and lex the token there.  This does not
+  /// form tokens for the skipped lines, and is used to quickly find the end of
+  /// a declaration whose body is lexed later.
+  void skipToLineWithIndentation(unsigned indent);
+
 private:
   FIRToken lexTokenImpl();
 
@@ -141,6 +147,10 @@ private:
   StringRef curBuffer;
   const char *curPtr;
 
+  /// Whether lines in the buffer are terminated by '\n', which allows
+  /// skipToLineWithIndentation to scan for line starts with memchr.
+  bool hasNewlineTerminatedLines;
+
   /// This is the next token that hasn't been consumed yet.
   FIRToken curToken;
 
@@ -4416,8 +4416,10 @@ ParseResult FIRCircuitParser::parseRefList(ArrayRef<PortInfo> portList,
   return success();
 }
 
-/// We're going to defer parsing this module, so just skip tokens until we
-/// get to the next module or the end of the file.
+/// We're going to defer parsing this module, so just skip lines until we
+/// get to the next module or the end of the file.  Only the first token of
+/// lines at the module's indentation is lexed, which keeps this serial part of
+/// the parser cheap.
 ParseResult FIRCircuitParser::skipToModuleEnd(unsigned indent) {
   while (true) {
     switch (getToken().getKind()) {
@@ -4442,7 +4444,7 @@ ParseResult FIRCircuitParser::skipToModuleEnd(unsigned indent) {
         return success();
       [[fallthrough]];
     default:
-      consumeToken();
+      getLexer().skipToLineWithIndentation(indent);
       break;
     }
   }
@@ -8,12 +8,15 @@
 //
 // This file implements the FIRRTL combinational cycles detection pass. The
 // algorithm handles aggregates and sub-index/field/access ops.
-// 1. Traverse each module in the Instance Graph bottom up.
-// 2. Preprocess step: Gather all the Value which serve as the root for the
-//    DFS traversal. The input arguments and wire ops and Instance results
-//    are the roots.
-//    Then populate the map for Value to all the FieldRefs it can refer to,
-//    and another map of FieldRef to all the Values that refer to it.
+// 1. Group the modules in the Instance Graph into levels, such that every
+//    module only instantiates modules of earlier levels. Process the levels
+//    bottom up, and the modules within a level in parallel.
+// 2. Preprocess step: Number all the Values in the module, such that the side
+//    tables below are flat vectors indexed by Value number. Gather all the
+//    Values which serve as the root for the DFS traversal. The input
+//    arguments and wire ops and Instance results are the roots.
+//    Then populate the table of Value to all the FieldRefs it can refer to,
+//    and a map of FieldRef to all the Values that refer to it.
 //    (A single Value can refer to multiple FieldRefs, if the Value is the
 //    result of a SubAccess op. Multiple values can refer to the same
 //    FieldRef, since multiple SubIndex/Field ops with the same fieldIndex
@@ -25,6 +28,9 @@
 //    alias set to the DFS stack.
 // 5. If any child is already present in the Visiting set, then a cycle is
 //    found.
+// 6. Summarize the combinational paths between the module's ports for the
+//    modules that instantiate it, as a bitset of reachable output port fields
+//    for every input port field.
 //
 //===----------------------------------------------------------------------===//
 
@@ -33,61 +39,119 @@
 #include "circt/Dialect/FIRRTL/FIRRTLUtils.h"
 #include "circt/Dialect/FIRRTL/FIRRTLVisitors.h"
 #include "circt/Dialect/FIRRTL/Passes.h"
+#include "mlir/IR/Threading.h"
+#include "llvm/ADT/BitVector.h"
 #include "llvm/ADT/DenseMap.h"
-#include "llvm/ADT/DepthFirstIterator.h"
-#include "llvm/ADT/PostOrderIterator.h"
-#include "llvm/ADT/SCCIterator.h"
-#include "llvm/ADT/SmallSet.h"
-#include <variant>
+#include "llvm/ADT/DenseSet.h"
+#include "llvm/ADT/SparseBitVector.h"
 
 #define DEBUG_TYPE "check-comb-loops"
 
 using namespace circt;
 using namespace firrtl;
 
-using SetOfFieldRefs = DenseSet<FieldRef>;
+/// The combinational paths between the ports of a module. The fields of all
+/// ports are numbered consecutively, and the output port fields reachable from
+/// an input port field are recorded as a sparse bitset over these numbers.
+/// This summary is all that modules instantiating the module need to know.
+struct PortPaths {
+  PortPaths(FModuleOp module) {
+    portOffsets.reserve(module.getNumPorts() + 1);
+    unsigned offset = 0;
+    for (auto arg : module.getArguments()) {
+      portOffsets.push_back(offset);
+      offset += hw::FieldIdImpl::getMaxFieldID(arg.getType()) + 1;
+    }
+    portOffsets.push_back(offset);
+  }
+
+  /// Record a path from an input port field to an output port field.
+  void addPath(FieldRef from, FieldRef to) {
+    paths[getIndex(from)].set(getIndex(to));
+  }
+
+  /// Get the output port fields reachable from an input port field, or null if
+  /// there are none.
+  const llvm::SparseBitVector<> *getPathsFrom(unsigned port,
+                                              unsigned fieldID) const {
+    auto it = paths.find(portOffsets[port] + fieldID);
+    if (it == paths.end())
+      return nullptr;
+    return &it->second;
+  }
+
+  /// Map a field number back to its port number and field ID.
+  std::pair<unsigned, unsigned> getPortField(unsigned index) const {
+    unsigned port = llvm::upper_bound(portOffsets, index) - 1 -
+                    portOffsets.begin();
+    return {port, index - portOffsets[port]};
+  }
+
+  void dump() const {
+    for (const auto &[from, reachable] : paths) {
+      auto [fromPort, fromField] = getPortField(from);
+      llvm::dbgs() << "\n Input port " << fromPort << " field " << fromField
+                   << " has comb path to :";
+      for (auto to : reachable) {
+        auto [toPort, toField] = getPortField(to);
+        llvm::dbgs() << "\n Output port " << toPort << " field " << toField;
+      }
+    }
+  }
+
+private:
+  unsigned getIndex(FieldRef ref) const {
+    auto arg = cast<BlockArgument>(ref.getValue());
+    return portOffsets[arg.getArgNumber()] + ref.getFieldID();
+  }
+
+  /// The number of the first field of each port, followed by the total number
+  /// of fields.
+  SmallVector<unsigned> portOffsets;
+  /// The output port fields reachable from each input port field.
+  DenseMap<unsigned, llvm::SparseBitVector<>> paths;
+};
 
 /// A value is in VisitingSet if its subtree is still being traversed. That is,
 /// all its children have not yet been visited. If any Value is visited while
 /// its still in the `VisitingSet`, that implies a back edge and a cycle.
+/// Values are identified by their number within the module.
 struct VisitingSet {
 private:
   /// The stack is maintained to keep track of the cycle, if one is found. This
   /// is required for an iterative DFS traversal, its implicitly recorded for a
   /// recursive version of this algorithm. Each entry in the stack is a list of
   /// aliasing Values, which were visited at the same time.
-  SmallVector<SmallVector<Value, 2>> visitingStack;
-  /// This map of the Visiting values, is for faster query, to check if a Value
-  /// is in VisitingSet. It also records the corresponding index into the
-  /// visitingStack, for faster pop until the Value.
-  DenseMap<Value, unsigned> valToStackMap;
+  SmallVector<SmallVector<unsigned, 2>> visitingStack;
+  /// The index into the visitingStack of each Value, or `notVisiting`. This
+  /// is for faster query, to check if a Value is in VisitingSet, and for faster
+  /// pop until the Value.
+  SmallVector<unsigned> stackPositions;
+  static constexpr unsigned notVisiting = ~0U;
 
 public:
+  VisitingSet(unsigned numValues) : stackPositions(numValues, notVisiting) {}
+
   void appendEmpty() { visitingStack.push_back({}); }
-  void appendToEnd(SmallVector<Value> &values) {
+  void appendToEnd(ArrayRef<unsigned> values) {
     auto stackSize = visitingStack.size() - 1;
     visitingStack.back().append(values.begin(), values.end());
     // Record the stack location where this Value is pushed.
-    llvm::for_each(values, [&](Value v) { valToStackMap[v] = stackSize; });
-  }
-  bool contains(Value v) {
-    return valToStackMap.find(v) != valToStackMap.end();
+    for (auto v : values)
+      stackPositions[v] = stackSize;
   }
+  bool contains(unsigned v) const { return stackPositions[v] != notVisiting; }
   // Pop all the Values which were visited after v. Then invoke f (if present)
   // on a popped value for each index.
-  void popUntilVal(Value v,
-                   const llvm::function_ref<void(Value poppedVal)> f = {}) {
-    auto valPos = valToStackMap[v];
+  void popUntilVal(unsigned v,
+                   const llvm::function_ref<void(unsigned poppedVal)> f = {}) {
+    auto valPos = contains(v) ? stackPositions[v] : 0;
     while (visitingStack.size() != valPos) {
       auto poppedVals = visitingStack.pop_back_val();
-      Value poppedVal;
-      llvm::for_each(poppedVals, [&](Value pv) {
-        if (!poppedVal)
-          poppedVal = pv;
-        valToStackMap.erase(pv);
-      });
-      if (f && poppedVal)
-        f(poppedVal);
+      for (auto pv : poppedVals)
+        stackPositions[pv] = notVisiting;
+      if (f && !poppedVals.empty())
+        f(poppedVals.front());
     }
   }
 };
@@ -96,51 +160,56 @@ class DiscoverLoops {
 
 public:
   DiscoverLoops(FModuleOp module, InstanceGraph &instanceGraph,
-                DenseMap<FieldRef, SetOfFieldRefs> &portPaths)
-      : module(module), instanceGraph(instanceGraph), portPaths(portPaths) {}
+                DenseMap<Operation *, PortPaths> &allPortPaths,
+                bool reportErrors)
+      : module(module), instanceGraph(instanceGraph),
+        allPortPaths(allPortPaths),
+        portPaths(allPortPaths.find(module)->second),
+        reportErrors(reportErrors) {}
 
   LogicalResult processModule() {
     LLVM_DEBUG(llvm::dbgs() << "\n processing module :" << module.getName());
-    SmallVector<Value> worklist;
+    SmallVector<unsigned> worklist;
     // Traverse over ports and ops, to populate the worklist and get the
     // FieldRef corresponding to every Value. Also process the InstanceOps and
     // get the paths that exist between the ports of the referenced module.
     preprocess(worklist);
 
-    llvm::DenseSet<Value> visited;
-    VisitingSet visiting;
-    SmallVector<Value> dfsStack;
+    BitVector visited(values.size());
+    VisitingSet visiting(values.size());
+    SmallVector<unsigned> dfsStack;
     SmallVector<FieldRef> inputArgFields;
     // Record all the children of Value being visited.
-    SmallVector<Value, 8> children;
+    SmallVector<unsigned, 8> children;
     // If this is an input port field, then record it. This is used to
     // discover paths from input to output ports. Only the last input port
     // that is visited on the DFS traversal is recorded.
     SmallVector<FieldRef, 2> inputArgFieldsTemp;
-    SmallVector<Value> aliasingValues;
+    SmallVector<unsigned> aliasingValues;
 
     // worklist is the list of roots, to begin the traversal from.
     for (auto root : worklist) {
       dfsStack = {root};
       inputArgFields.clear();
       LLVM_DEBUG(llvm::dbgs() << "\n Starting traversal from root :"
-                              << getFieldName(FieldRef(root, 0)).first);
-      if (auto inArg = dyn_cast<BlockArgument>(root)) {
+                              << getFieldName(FieldRef(values[root], 0)).first);
+      if (auto inArg = dyn_cast<BlockArgument>(values[root])) {
         if (module.getPortDirection(inArg.getArgNumber()) == Direction::In)
           // This is required, such that paths to output port can be discovered.
           // If there is an overlapping path from two input ports to an output
           // port, then the already visited nodes must be re-visited to discover
           // the comb paths to the output port.
-          visited.clear();
+          visited.reset();
       }
       while (!dfsStack.empty()) {
         auto dfsVal = dfsStack.back();
         if (!visiting.contains(dfsVal)) {
           unsigned dfsSize = dfsStack.size();
 
-          LLVM_DEBUG(llvm::dbgs() << "\n Stack pop :"
-                                  << getFieldName(FieldRef(dfsVal, 0)).first
-                                  << "," << dfsVal;);
+          LLVM_DEBUG(llvm::dbgs()
+                         << "\n Stack pop :"
+                         << getFieldName(FieldRef(values[dfsVal], 0)).first
+                         << "," << values[dfsVal];);
 
           // Visiting set will contain all the values which alias with the
           // dfsVal, this is required to detect back edges to aliasing Values.
@@ -151,11 +220,7 @@ public:
           // All the Values that refer to the same FieldRef are added to the
           // aliasingValues.
           aliasingValues = {dfsVal};
-          auto aToVIter = aliasingValuesMap.find(dfsVal);
-          if (aToVIter != aliasingValuesMap.end()) {
-            aliasingValues.append(aToVIter->getSecond().begin(),
-                                  aToVIter->getSecond().end());
-          }
+          llvm::append_range(aliasingValues, aliasingValuesMap[dfsVal]);
           // If `dfsVal` is a subfield, then get all the FieldRefs that it
           // refers to and then get all the values that alias with it.
           forallRefersTo(dfsVal, [&](FieldRef ref) {
@@ -175,11 +240,12 @@ public:
             inputArgFields = std::move(inputArgFieldsTemp);
 
           visiting.appendToEnd(aliasingValues);
-          visited.insert(aliasingValues.begin(), aliasingValues.end());
+          for (auto v : aliasingValues)
+            visited.set(v);
           // Add the Value to `children`, to which a path exists from `dfsVal`.
           for (auto dfsFromVal : aliasingValues) {
 
-            for (auto &use : dfsFromVal.getUses()) {
+            for (auto &use : values[dfsFromVal].getUses()) {
               auto childVal =
                   TypeSwitch<Operation *, Value>(use.getOwner())
                       // Registers stop walk for comb loops.
@@ -203,19 +269,20 @@ public:
                         return {};
                       });
               if (childVal && type_isa<FIRRTLType>(childVal.getType()))
-                children.push_back(childVal);
+                children.push_back(getIndex(childVal));
             }
           }
           for (auto childVal : children) {
             // This childVal can be ignored, if
             // It is a Register or a subfield of a register.
-            if (!visited.contains(childVal))
+            if (!visited.test(childVal))
               dfsStack.push_back(childVal);
             // If the childVal is a sub, then check if it aliases with any of
             // the predecessors (the visiting set).
             if (visiting.contains(childVal)) {
               // Comb Cycle Detected !!
-              reportLoopFound(childVal, visiting);
+              if (reportErrors)
+                reportLoopFound(childVal, visiting);
               return failure();
             }
           }
@@ -233,7 +300,7 @@ public:
         (void)popped;
         LLVM_DEBUG({
           llvm::dbgs() << "\n dfs popped :"
-                       << getFieldName(FieldRef(popped, 0)).first;
+                       << getFieldName(FieldRef(values[popped], 0)).first;
           dump();
         });
       }
@@ -243,36 +310,49 @@ public:
   }
 
   // Preprocess the module ops to get the
-  // 1. roots for DFS traversal,
-  // 2. FieldRef corresponding to each Value.
-  void preprocess(SmallVector<Value> &worklist) {
+  // 1. number of each Value,
+  // 2. roots for DFS traversal,
+  // 3. FieldRef corresponding to each Value.
+  void preprocess(SmallVector<unsigned> &worklist) {
+    module->walk([&](Block *block) {
+      for (auto arg : block->getArguments())
+        addValue(arg);
+      for (auto &op : *block)
+        for (auto result : op.getResults())
+          addValue(result);
+    });
+    valRefersTo.resize(values.size());
+    aliasingValuesMap.resize(values.size());
+
     // All the input ports are added to the worklist.
     for (BlockArgument arg : module.getArguments()) {
       auto argType = type_cast<FIRRTLType>(arg.getType());
       if (type_isa<RefType>(argType))
         continue;
       if (module.getPortDirection(arg.getArgNumber()) == Direction::In)
-        worklist.push_back(arg);
+        worklist.push_back(getIndex(arg));
       if (!argType.isGround())
-        setValRefsTo(arg, FieldRef(arg, 0));
+        setValRefsTo(getIndex(arg), FieldRef(arg, 0));
     }
-    DenseSet<Value> memPorts;
+    BitVector memPorts(values.size());
 
     for (auto &op : module.getOps()) {
       TypeSwitch<Operation *>(&op)
           // Wire is added to the worklist
           .Case<WireOp>([&](WireOp wire) {
-            worklist.push_back(wire.getResult());
+            auto res = getIndex(wire.getResult());
+            worklist.push_back(res);
             auto ty = type_dyn_cast<FIRRTLBaseType>(wire.getResult().getType());
             if (ty && !ty.isGround())
-              setValRefsTo(wire.getResult(), FieldRef(wire.getResult(), 0));
+              setValRefsTo(res, FieldRef(wire.getResult(), 0));
           })
           // All sub elements are added to the worklist.
           .Case<SubfieldOp>([&](SubfieldOp sub) {
-            auto res = sub.getResult();
+            auto res = getIndex(sub.getResult());
+            auto input = getIndex(sub.getInput());
             bool isValid = false;
             auto fieldIndex = sub.getAccessedField().getFieldID();
-            if (memPorts.contains(sub.getInput())) {
+            if (memPorts.test(input)) {
               auto memPort = sub.getInput();
               BundleType type = memPort.getType();
               auto enableFieldId =
@@ -283,13 +363,13 @@ public:
                   type.getFieldID((unsigned)ReadPortSubfield::addr);
               if (fieldIndex == enableFieldId || fieldIndex == dataFieldId ||
                   fieldIndex == addressFieldId) {
-                setValRefsTo(memPort, FieldRef(memPort, 0));
+                setValRefsTo(input, FieldRef(memPort, 0));
               } else
                 return;
             }
             SmallVector<FieldRef, 4> fields;
             forallRefersTo(
-                sub.getInput(),
+                input,
                 [&](FieldRef subBase) {
                   isValid = true;
                   fields.push_back(subBase.getSubField(fieldIndex));
@@ -302,12 +382,12 @@ public:
             }
           })
           .Case<SubindexOp>([&](SubindexOp sub) {
-            auto res = sub.getResult();
+            auto res = getIndex(sub.getResult());
             bool isValid = false;
             auto index = sub.getAccessedField().getFieldID();
             SmallVector<FieldRef, 4> fields;
             forallRefersTo(
-                sub.getInput(),
+                getIndex(sub.getInput()),
                 [&](FieldRef subBase) {
                   isValid = true;
                   fields.push_back(subBase.getSubField(index));
@@ -321,11 +401,11 @@ public:
           })
           .Case<SubaccessOp>([&](SubaccessOp sub) {
             FVectorType vecType = sub.getInput().getType();
-            auto res = sub.getResult();
+            auto res = getIndex(sub.getResult());
             bool isValid = false;
             SmallVector<FieldRef, 4> fields;
             forallRefersTo(
-                sub.getInput(),
+                getIndex(sub.getInput()),
                 [&](FieldRef subBase) {
                   isValid = true;
                   // The result of a subaccess can refer to multiple storage
@@ -353,26 +433,40 @@ public:
             for (auto memPort : mem.getResults()) {
               if (!type_isa<FIRRTLBaseType>(memPort.getType()))
                 continue;
-              memPorts.insert(memPort);
+              memPorts.set(getIndex(memPort));
             }
           })
           .Default([&](auto) {});
     }
+
+    // Drop the duplicates recorded for Values that alias through multiple
+    // FieldRefs, keeping the first occurrence of each.
+    BitVector seen(values.size());
+    for (auto &aliases : aliasingValuesMap) {
+      llvm::erase_if(aliases, [&](unsigned v) {
+        if (seen.test(v))
+          return true;
+        seen.set(v);
+        return false;
+      });
+      for (auto v : aliases)
+        seen.reset(v);
+    }
   }
 
-  void handleInstanceOp(InstanceOp ins, SmallVector<Value> &worklist) {
+  void handleInstanceOp(InstanceOp ins, SmallVector<unsigned> &worklist) {
     for (auto port : ins.getResults()) {
       if (auto type = type_dyn_cast<FIRRTLBaseType>(port.getType())) {
-        worklist.push_back(port);
+        worklist.push_back(getIndex(port));
         if (!type.isGround())
-          setValRefsTo(port, FieldRef(port, 0));
+          setValRefsTo(getIndex(port), FieldRef(port, 0));
       } else if (auto type = type_dyn_cast<PropertyType>(port.getType())) {
-        worklist.push_back(port);
+        worklist.push_back(getIndex(port));
       }
     }
   }
 
-  void handlePorts(FieldRef ref, SmallVectorImpl<Value> &children) {
+  void handlePorts(FieldRef ref, SmallVectorImpl<unsigned> &children) {
     if (auto inst = dyn_cast_or_null<InstanceOp>(ref.getDefiningOp())) {
       auto res = cast<OpResult>(ref.getValue());
       auto portNum = res.getResultNumber();
@@ -380,20 +474,24 @@ public:
           dyn_cast_or_null<FModuleOp>(*instanceGraph.getReferencedModule(inst));
       if (!refMod)
         return;
-      FieldRef modArg(refMod.getArgument(portNum), ref.getFieldID());
-      auto pathIter = portPaths.find(modArg);
-      if (pathIter == portPaths.end())
+      // The referenced module is in an earlier level, and its summary is no
+      // longer modified.
+      auto refModPaths = allPortPaths.find(refMod);
+      if (refModPaths == allPortPaths.end())
+        return;
+      auto *reachable =
+          refModPaths->second.getPathsFrom(portNum, ref.getFieldID());
+      if (!reachable)
         return;
-      for (auto modOutPort : pathIter->second) {
-        auto outPortNum =
-            cast<BlockArgument>(modOutPort.getValue()).getArgNumber();
-        if (modOutPort.getFieldID() == 0) {
-          children.push_back(inst.getResult(outPortNum));
+      for (auto modOutPort : *reachable) {
+        auto [outPortNum, fieldID] =
+            refModPaths->second.getPortField(modOutPort);
+        if (fieldID == 0) {
+          children.push_back(getIndex(inst.getResult(outPortNum)));
           continue;
         }
-        FieldRef instanceOutPort(inst.getResult(outPortNum),
-                                 modOutPort.getFieldID());
-        llvm::append_range(children, fieldToVals[instanceOutPort]);
+        FieldRef instanceOutPort(inst.getResult(outPortNum), fieldID);
+        llvm::append_range(children, getValuesReferringTo(instanceOutPort));
       }
     } else if (auto mem = dyn_cast<MemOp>(ref.getDefiningOp())) {
       if (mem.getReadLatency() > 0)
@@ -405,50 +503,50 @@ public:
       auto addressFieldId = type.getFieldID((unsigned)ReadPortSubfield::addr);
       if (ref.getFieldID() == enableFieldId ||
           ref.getFieldID() == addressFieldId) {
-        for (auto dataField : fieldToVals[FieldRef(memPort, dataFieldId)])
-          children.push_back(dataField);
+        llvm::append_range(
+            children, getValuesReferringTo(FieldRef(memPort, dataFieldId)));
       }
     }
   }
 
-  void reportLoopFound(Value childVal, VisitingSet visiting) {
+  void reportLoopFound(unsigned childVal, VisitingSet visiting) {
     // TODO: Work harder to provide best information possible to user,
     // especially across instances or when we trace through aliasing values.
     // We're about to exit, and can afford to do some slower work here.
-    auto getName = [&](Value v) {
+    auto getName = [&](unsigned v) {
       if (isa_and_nonnull<SubfieldOp, SubindexOp, SubaccessOp>(
-              v.getDefiningOp())) {
+              values[v].getDefiningOp())) {
         assert(!valRefersTo[v].empty());
-        // Pick representative of the "alias set", not deterministic.
-        return getFieldName(*valRefersTo[v].begin()).first;
+        // Pick representative of the "alias set".
+        return getFieldName(valRefersTo[v].front()).first;
       }
-      return getFieldName(FieldRef(v, 0)).first;
+      return getFieldName(FieldRef(values[v], 0)).first;
     };
     auto errorDiag = mlir::emitError(
         module.getLoc(), "detected combinational cycle in a FIRRTL module");
 
-    SmallVector<Value, 16> path;
+    SmallVector<unsigned, 16> path;
     path.push_back(childVal);
     visiting.popUntilVal(
-        childVal, [&](Value visitingVal) { path.push_back(visitingVal); });
+        childVal, [&](unsigned visitingVal) { path.push_back(visitingVal); });
     assert(path.back() == childVal);
     path.pop_back();
 
     // Find a value we can name
     auto *it =
-        llvm::find_if(path, [&](Value v) { return !getName(v).empty(); });
+        llvm::find_if(path, [&](unsigned v) { return !getName(v).empty(); });
     if (it == path.end()) {
       errorDiag.append(", but unable to find names for any involved values.");
-      errorDiag.attachNote(childVal.getLoc()) << "cycle detected here";
+      errorDiag.attachNote(values[childVal].getLoc()) << "cycle detected here";
       return;
     }
     errorDiag.append(", sample path: ");
 
     bool lastWasDots = false;
     errorDiag << module.getName() << ".{" << getName(*it);
-    for (auto v :
-         llvm::concat<Value>(llvm::make_range(std::next(it), path.end()),
-                             llvm::make_range(path.begin(), std::next(it)))) {
+    for (auto v : llvm::concat<unsigned>(
+             llvm::make_range(std::next(it), path.end()),
+             llvm::make_range(path.begin(), std::next(it)))) {
       auto name = getName(v);
       if (!name.empty()) {
         errorDiag << " <- " << name;
@@ -474,11 +572,11 @@ public:
       }
       onlyFieldZero = false;
       for (auto inArg : inputArgFields) {
-        portPaths[inArg].insert(dstFieldRef);
+        portPaths.addPath(inArg, dstFieldRef);
       }
       return success();
     };
-    forallRefersTo(dst, pathsToOutPort);
+    forallRefersTo(getIndex(dst), pathsToOutPort);
 
     if (onlyFieldZero) {
       if (isa<RegOp, RegResetOp, SubfieldOp, SubaccessOp, SubindexOp>(
@@ -488,88 +586,137 @@ public:
     return success();
   }
 
-  void setValRefsTo(Value val, FieldRef ref) {
-    assert(val && ref && " Value and Ref cannot be null");
-    valRefersTo[val].insert(ref);
-    auto fToVIter = fieldToVals.find(ref);
-    if (fToVIter != fieldToVals.end()) {
-      for (auto aliasingVal : fToVIter->second) {
-        aliasingValuesMap[val].insert(aliasingVal);
-        aliasingValuesMap[aliasingVal].insert(val);
-      }
-      fToVIter->getSecond().insert(val);
-    } else
-      fieldToVals[ref].insert(val);
+  void addValue(Value val) {
+    valueIndices.try_emplace(val, values.size());
+    values.push_back(val);
+  }
+
+  unsigned getIndex(Value val) const {
+    auto it = valueIndices.find(val);
+    assert(it != valueIndices.end() && "value not defined in this module");
+    return it->second;
+  }
+
+  ArrayRef<unsigned> getValuesReferringTo(FieldRef ref) const {
+    auto it = fieldToVals.find(ref);
+    if (it == fieldToVals.end())
+      return {};
+    return it->second;
+  }
+
+  void setValRefsTo(unsigned val, FieldRef ref) {
+    assert(ref && " Ref cannot be null");
+    auto &refVals = fieldToVals[ref];
+    if (llvm::is_contained(refVals, val))
+      return;
+    valRefersTo[val].push_back(ref);
+    for (auto aliasingVal : refVals) {
+      aliasingValuesMap[val].push_back(aliasingVal);
+      aliasingValuesMap[aliasingVal].push_back(val);
+    }
+    refVals.push_back(val);
   }
 
   void
-  forallRefersTo(Value val,
+  forallRefersTo(unsigned val,
                  const llvm::function_ref<LogicalResult(FieldRef &refNode)> f,
                  bool baseCase = true) {
-    auto refersToIter = valRefersTo.find(val);
-    if (refersToIter != valRefersTo.end()) {
-      for (auto ref : refersToIter->second)
+    if (!valRefersTo[val].empty()) {
+      for (auto ref : valRefersTo[val])
         if (f(ref).failed())
           return;
     } else if (baseCase) {
-      FieldRef base(val, 0);
+      FieldRef base(values[val], 0);
       if (f(base).failed())
         return;
     }
   }
 
   void dump() {
-    for (const auto &valRef : valRefersTo) {
-      llvm::dbgs() << "\n val :" << valRef.first;
-      for (auto node : valRef.second)
+    for (auto [val, refs] : llvm::enumerate(valRefersTo)) {
+      if (refs.empty())
+        continue;
+      llvm::dbgs() << "\n val :" << values[val];
+      for (auto node : refs)
         llvm::dbgs() << "\n Refers to :" << getFieldName(node).first;
     }
     for (const auto &dtv : fieldToVals) {
       llvm::dbgs() << "\n Field :" << getFieldName(dtv.first).first
                    << " ::" << dtv.first.getValue();
       for (auto val : dtv.second)
-        llvm::dbgs() << "\n val :" << val;
-    }
-    for (const auto &p : portPaths) {
-      llvm::dbgs() << "\n Output port : " << getFieldName(p.first).first
-                   << " has comb path from :";
-      for (const auto &src : p.second)
-        llvm::dbgs() << "\n Input port : " << getFieldName(src).first;
+        llvm::dbgs() << "\n val :" << values[val];
     }
+    portPaths.dump();
   }
 
   FModuleOp module;
   InstanceGraph &instanceGraph;
-  /// Map of a Value to all the FieldRefs that it refers to.
-  DenseMap<Value, SetOfFieldRefs> valRefersTo;
-
-  DenseMap<Value, DenseSet<Value>> aliasingValuesMap;
-
-  DenseMap<FieldRef, DenseSet<Value>> fieldToVals;
-  /// Comb paths that exist between module ports. This is maintained across
-  /// modules.
-  DenseMap<FieldRef, SetOfFieldRefs> &portPaths;
+  /// All the Values in the module, and the number of each Value.
+  SmallVector<Value> values;
+  DenseMap<Value, unsigned> valueIndices;
+  /// The FieldRefs that each Value refers to, by Value number.
+  SmallVector<SmallVector<FieldRef, 1>> valRefersTo;
+  /// The Values that can refer to the same FieldRef as each Value, by Value
+  /// number.
+  SmallVector<SmallVector<unsigned, 2>> aliasingValuesMap;
+
+  DenseMap<FieldRef, SmallVector<unsigned, 2>> fieldToVals;
+  /// Comb paths that exist between module ports, for all modules. Only the
+  /// entry of this module is modified.
+  const DenseMap<Operation *, PortPaths> &allPortPaths;
+  /// Comb paths that exist between the ports of this module.
+  PortPaths &portPaths;
+  /// Whether to emit a diagnostic for a detected loop.
+  bool reportErrors;
 };
 
 /// This pass constructs a local graph for each module to detect combinational
 /// cycles. To capture the cross-module combinational cycles, this pass inlines
 /// the combinational paths between IOs of its subinstances into a subgraph and
-/// encodes them in a `combPathsMap`.
+/// encodes them in a `PortPaths` summary per module.
 class CheckCombLoopsPass : public CheckCombLoopsBase<CheckCombLoopsPass> {
 public:
   void runOnOperation() override {
     auto &instanceGraph = getAnalysis<InstanceGraph>();
-    DenseMap<FieldRef, SetOfFieldRefs> portPaths;
-    // Traverse modules in a post order to make sure the combinational paths
-    // between IOs of a module have been detected and recorded in `portPaths`
-    // before we handle its parent modules.
-    for (auto *igNode : llvm::post_order<InstanceGraph *>(&instanceGraph)) {
-      if (auto module = dyn_cast<FModuleOp>(*igNode->getModule())) {
-        DiscoverLoops rdf(module, instanceGraph, portPaths);
-        if (rdf.processModule().failed()) {
-          return signalPassFailure();
-        }
-      }
+
+    // Create the port path summaries of all modules up front, such that the map
+    // is not modified while the modules are processed in parallel.
+    DenseMap<Operation *, PortPaths> portPaths;
+    for (auto *igNode : instanceGraph.getPostOrder())
+      if (auto module = dyn_cast<FModuleOp>(*igNode->getModule()))
+        portPaths.try_emplace(module, module);
+
+    // Process the levels of the instance graph bottom up, such that the
+    // combinational paths between IOs of a module have been detected and
+    // recorded in `portPaths` before we handle its parent modules. The modules
+    // within a level are independent.
+    DenseSet<Operation *> failedModules;
+    for (auto level : instanceGraph.getLevels()) {
+      SmallVector<bool> levelFailed(level.size(), false);
+      mlir::parallelFor(&getContext(), 0, level.size(), [&](size_t i) {
+        auto module = dyn_cast<FModuleOp>(*level[i]->getModule());
+        if (!module)
+          return;
+        DiscoverLoops rdf(module, instanceGraph, portPaths,
+                          /*reportErrors=*/false);
+        levelFailed[i] = rdf.processModule().failed();
+      });
+      for (auto [igNode, moduleFailed] : llvm::zip(level, levelFailed))
+        if (moduleFailed)
+          failedModules.insert(igNode->getModule().getOperation());
+    }
+
+    // Report the loop in the first failing module in post order. All modules
+    // it instantiates succeeded, so it sees the same port paths a serial
+    // traversal would have, and this matches the error a serial traversal
+    // would have stopped at.
+    for (auto *igNode : instanceGraph.getPostOrder()) {
+      if (!failedModules.contains(igNode->getModule().getOperation()))
+        continue;
+      DiscoverLoops rdf(cast<FModuleOp>(*igNode->getModule()), instanceGraph,
+                        portPaths, /*reportErrors=*/true);
+      (void)rdf.processModule();
+      return signalPassFailure();
     }
     markAllAnalysesPreserved();
   }
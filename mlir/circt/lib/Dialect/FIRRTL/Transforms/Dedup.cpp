@@ -29,10 +29,11 @@
 #include "llvm/ADT/DenseMap.h"
 #include "llvm/ADT/DenseMapInfo.h"
 #include "llvm/ADT/DepthFirstIterator.h"
-#include "llvm/ADT/PostOrderIterator.h"
 #include "llvm/ADT/SmallPtrSet.h"
 #include "llvm/ADT/TypeSwitch.h"
+#include "llvm/ADT/bit.h"
 #include "llvm/Support/Format.h"
+#include "llvm/Support/RWMutex.h"
 #include "llvm/Support/SHA256.h"
 
 using namespace circt;
@@ -65,7 +66,7 @@ llvm::raw_ostream &printHash(llvm::raw_ostream &stream, std::string data) {
 // names could be replaced during dedup, it's necessary to keep names up-to-date
 // before actually combining them into structural hashes.
 struct ModuleInfo {
-  // SHA256 hash.
+  // SHA256 hash, or a FastHash in the first 16 bytes and zeros in the rest.
   std::array<uint8_t, 32> structuralHash;
   // Module names referred by instance op in the module.
   mlir::ArrayAttr referredModuleNames;
@@ -108,26 +109,116 @@ struct StructuralHasherSharedConstants {
   DenseSet<Attribute> nonessentialAttributes;
 };
 
+/// A fast, non-cryptographic 128-bit hash of a sequence of 64-bit words. The
+/// structural hasher only ever hashes interned pointers and small integers, so
+/// there is no need to handle arbitrary byte strings. The two halves of the
+/// state are updated independently so that the multiplies of one word can
+/// execute in parallel. This is not collision resistant against an adversary;
+/// any match must be confirmed with a full structural comparison.
+struct FastHash {
+  using Digest = std::array<uint64_t, 2>;
+
+  void update(uint64_t word) {
+    lo = llvm::rotl(lo + word * prime2, 31) * prime1;
+    hi = llvm::rotl(hi ^ (word * prime4), 27) * prime3 + prime5;
+    ++length;
+  }
+
+  void update(const Digest &digest) {
+    update(digest[0]);
+    update(digest[1]);
+  }
+
+  Digest final() const {
+    auto a = avalanche(lo ^ length);
+    auto b = avalanche(hi + length * prime5);
+    return {avalanche(a + b), avalanche(b + a * prime1)};
+  }
+
+private:
+  static constexpr uint64_t prime1 = 0x9E3779B185EBCA87ULL;
+  static constexpr uint64_t prime2 = 0xC2B2AE3D27D4EB4FULL;
+  static constexpr uint64_t prime3 = 0x165667B19E3779F9ULL;
+  static constexpr uint64_t prime4 = 0x85EBCA77C2B2AE63ULL;
+  static constexpr uint64_t prime5 = 0x27D4EB2F165667C5ULL;
+
+  static uint64_t avalanche(uint64_t x) {
+    x ^= x >> 33;
+    x *= prime2;
+    x ^= x >> 29;
+    x *= prime3;
+    x ^= x >> 32;
+    return x;
+  }
+
+  uint64_t lo = prime1 + prime2;
+  uint64_t hi = prime5;
+  uint64_t length = 0;
+};
+
+/// A cache of the hashes of bundle types and port type lists, which are
+/// otherwise rehashed element by element every time they appear. These are
+/// shared by many modules, so the cache is shared between all the threads
+/// hashing modules. Only used with the fast hash.
+struct StructuralHashCache {
+  /// Look up the cached hash for `key`, or compute it with `compute` and
+  /// cache it.
+  template <typename Fn>
+  FastHash::Digest getOrCompute(const void *key, Fn compute) {
+    {
+      llvm::sys::SmartScopedReader<true> lock(mutex);
+      auto it = digests.find(key);
+      if (it != digests.end())
+        return it->second;
+    }
+    // Compute the hash outside of the lock, since it may recursively hash
+    // other cached types. Racing threads will compute the same value.
+    auto digest = compute();
+    llvm::sys::SmartScopedWriter<true> lock(mutex);
+    digests.try_emplace(key, digest);
+    return digest;
+  }
+
+private:
+  llvm::sys::SmartRWMutex<true> mutex;
+  DenseMap<const void *, FastHash::Digest> digests;
+};
+
 struct StructuralHasher {
-  explicit StructuralHasher(const StructuralHasherSharedConstants &constants)
-      : constants(constants){};
+  /// Create a hasher. If `cache` is provided, modules are hashed with the fast
+  /// hash, otherwise with SHA256.
+  explicit StructuralHasher(const StructuralHasherSharedConstants &constants,
+                            StructuralHashCache *cache = nullptr)
+      : constants(constants), cache(cache){};
 
   std::pair<std::array<uint8_t, 32>, SmallVector<StringAttr>>
   getHashAndModuleNames(FModuleLike module, StringAttr group) {
     update(&(*module));
-    if (group)
-      sha.update(group.str());
-    auto hash = sha.final();
+    std::array<uint8_t, 32> hash = {};
+    if (cache) {
+      if (group)
+        update(group.getAsOpaquePointer());
+      auto digest = fastHash.final();
+      std::memcpy(hash.data(), digest.data(), sizeof(digest));
+    } else {
+      if (group)
+        sha.update(group.str());
+      hash = sha.final();
+    }
     return {hash, referredModuleNames};
   }
 
 private:
   void update(const void *pointer) {
+    if (cache)
+      return fastHash.update(reinterpret_cast<uintptr_t>(pointer));
     auto *addr = reinterpret_cast<const uint8_t *>(&pointer);
     sha.update(ArrayRef<uint8_t>(addr, sizeof pointer));
   }
 
   void update(size_t value) {
+    if (cache)
+      return fastHash.update(value);
     auto *addr = reinterpret_cast<const uint8_t *>(&value);
     sha.update(ArrayRef<uint8_t>(addr, sizeof value));
   }
@@ -136,6 +227,20 @@ private:
 
   // NOLINTNEXTLINE(misc-no-recursion)
   void update(BundleType type) {
+    if (cache) {
+      // Hash the bundle once with a separate hasher and reuse the result.
+      auto digest = cache->getOrCompute(type.getAsOpaquePointer(), [&]() {
+        StructuralHasher hasher(constants, cache);
+        hasher.updateElements(type);
+        return hasher.fastHash.final();
+      });
+      return fastHash.update(digest);
+    }
+    updateElements(type);
+  }
+
+  // NOLINTNEXTLINE(misc-no-recursion)
+  void updateElements(BundleType type) {
     update(type.getTypeID());
     for (auto &element : type.getElements()) {
       update(element.isFlip);
@@ -205,11 +310,24 @@ private:
       if (constants.nonessentialAttributes.contains(name))
         continue;
 
-      // Hash the port types.
+      // Hash the port types. Many modules share the same port types, so the
+      // fast hash caches the hash of the whole list.
       if (name == constants.portTypesAttr) {
-        auto portTypes = cast<ArrayAttr>(value).getAsValueRange<TypeAttr>();
-        for (auto type : portTypes)
-          update(type);
+        auto updatePortTypes = [&](StructuralHasher &hasher) {
+          auto portTypes = cast<ArrayAttr>(value).getAsValueRange<TypeAttr>();
+          for (auto type : portTypes)
+            hasher.update(type);
+        };
+        if (!cache) {
+          updatePortTypes(*this);
+          continue;
+        }
+        fastHash.update(
+            cache->getOrCompute(value.getAsOpaquePointer(), [&]() {
+              StructuralHasher hasher(constants, cache);
+              updatePortTypes(hasher);
+              return hasher.fastHash.final();
+            }));
         continue;
       }
 
@@ -301,9 +419,15 @@ private:
   // String constants.
   const StructuralHasherSharedConstants &constants;
 
+  // Hashes of types and attributes shared between modules. Null when hashing
+  // with SHA256.
+  StructuralHashCache *cache;
+
   // This is the actual running hash calculation. This is a stateful element
-  // that should be reinitialized after each hash is produced.
+  // that should be reinitialized after each hash is produced. Only one of
+  // these is used, depending on whether we have a cache.
   llvm::SHA256 sha;
+  FastHash fastHash;
 };
 
 //===----------------------------------------------------------------------===//
@@ -577,7 +701,7 @@ struct Equivalence {
         } else {
           // Otherwise make sure that they are targeting the same operation.
           if (!bTarget.isOpOnly() ||
-              aTarget.getOp() != data.map.lookup(bTarget.getOp()))
+              data.map.lookupOrNull(aTarget.getOp()) != bTarget.getOp())
             return error();
         }
         if (aTarget.getField() != bTarget.getField())
@@ -767,6 +891,31 @@ struct Equivalence {
     diag.attachNote(b->getLoc()) << "second module here";
   }
 
+  /// Check that two modules which hashed the same are really equivalent,
+  /// without reporting why not. This rules out hash collisions when using a
+  /// non-cryptographic hash.
+  bool isEquivalent(FModuleLike a, FModuleLike b) {
+    hw::InnerSymbolTable aTable(a);
+    hw::InnerSymbolTable bTable(b);
+    ModuleData data(aTable, bTable);
+    auto diag = emitError(a->getLoc());
+    // Port types are otherwise only compared through the block arguments,
+    // which external modules don't have.
+    auto aPorts = a.getPortTypes();
+    auto bPorts = b.getPortTypes();
+    auto result = success(aPorts.size() == bPorts.size());
+    for (auto [aType, bType] : llvm::zip(aPorts, bPorts)) {
+      if (failed(result))
+        break;
+      result = check(diag, "module port", a, cast<TypeAttr>(aType).getValue(),
+                     b, cast<TypeAttr>(bType).getValue());
+    }
+    if (succeeded(result))
+      result = check(diag, data, a, b);
+    diag.abandon();
+    return succeeded(result);
+  }
+
   // This is a cached "portDirections" string attr.
   StringAttr portDirectionsAttr;
   // This is a cached "NoDedup" annotation class string attr.
@@ -1423,7 +1572,7 @@ void fixupAllModules(InstanceGraph &instanceGraph) {
 
 namespace llvm {
 /// A DenseMapInfo implementation for `ModuleInfo` that is a pair of
-/// llvm::SHA256 hashes, which are represented as std::array<uint8_t, 32>, and
+/// structural hashes, which are represented as std::array<uint8_t, 32>, and
 /// an array of string attributes. This allows us to create a DenseMap with
 /// `ModuleInfo` as keys.
 template <>
@@ -1441,8 +1590,8 @@ struct DenseMapInfo<ModuleInfo> {
   }
 
   static unsigned getHashValue(const ModuleInfo &val) {
-    // We assume SHA256 is already a good hash and just truncate down to the
-    // number of bytes we need for DenseMap.
+    // We assume the structural hash is already good and just truncate down to
+    // the number of bytes we need for DenseMap.
     unsigned hash;
     std::memcpy(&hash, val.structuralHash.data(), sizeof(unsigned));
 
@@ -1479,8 +1628,10 @@ class DedupPass : public DedupBase<DedupPass> {
     // Only modules within the same group may be deduplicated.
     auto dedupGroupClass = StringAttr::get(context, dedupGroupAnnoClass);
 
-    // A map of all the module moduleInfo that we have calculated so far.
-    llvm::DenseMap<ModuleInfo, Operation *> moduleInfoToModule;
+    // A map of all the module moduleInfo that we have calculated so far. With
+    // the fast hash, different modules may share a moduleInfo, so each entry
+    // holds every module which was not deduplicated into an earlier one.
+    llvm::DenseMap<ModuleInfo, SmallVector<Operation *, 1>> moduleInfoToModule;
 
     // We track the name of the module that each module is deduped into, so that
     // we can make sure all modules which are marked "must dedup" with each
@@ -1489,9 +1640,9 @@ class DedupPass : public DedupBase<DedupPass> {
 
     // We must iterate the modules from the bottom up so that we can properly
     // deduplicate the modules. We copy the list of modules into a vector first
-    // to avoid iterator invalidation while we mutate the instance graph.
+    // since deduping erases nodes from the instance graph.
     SmallVector<FModuleLike, 0> modules(
-        llvm::map_range(llvm::post_order(&instanceGraph), [](auto *node) {
+        llvm::map_range(instanceGraph.getPostOrder(), [](auto *node) {
           return cast<FModuleLike>(*node->getModule());
         }));
 
@@ -1499,6 +1650,7 @@ class DedupPass : public DedupBase<DedupPass> {
         std::pair<std::array<uint8_t, 32>, SmallVector<StringAttr>>>>
         hashesAndModuleNames(modules.size());
     StructuralHasherSharedConstants hasherConstants(&getContext());
+    StructuralHashCache hashCache;
 
     // Calculate module information parallelly.
     auto result = mlir::failableParallelForEach(
@@ -1546,7 +1698,8 @@ class DedupPass : public DedupBase<DedupPass> {
           }
           auto dedupGroup = groups.empty() ? StringAttr() : groups.front();
 
-          StructuralHasher hasher(hasherConstants);
+          StructuralHasher hasher(hasherConstants,
+                                  fastHash ? &hashCache : nullptr);
           // Calculate the hash of the module and referred module names.
           hashesAndModuleNames[idx] =
               hasher.getHashAndModuleNames(module, dedupGroup);
@@ -1580,10 +1733,21 @@ class DedupPass : public DedupBase<DedupPass> {
       ModuleInfo moduleInfo{hashAndModuleNamesOpt->first,
                             mlir::ArrayAttr::get(module.getContext(), names)};
 
-      // Check if there a module with the same hash.
-      auto it = moduleInfoToModule.find(moduleInfo);
-      if (it != moduleInfoToModule.end()) {
-        auto original = cast<FModuleLike>(it->second);
+      // Check if there a module with the same hash. The fast hash is not
+      // collision resistant, so double check that the modules really are the
+      // same, and try every module which shares the hash.
+      auto &candidates = moduleInfoToModule[moduleInfo];
+      FModuleLike original;
+      for (auto *candidate : candidates) {
+        auto candidateModule = cast<FModuleLike>(candidate);
+        if (!fastHash || equiv.isEquivalent(candidateModule, module)) {
+          original = candidateModule;
+          break;
+        }
+      }
+      if (!original && !candidates.empty())
+        ++hashCollisions;
+      if (original) {
         // Record the group ID of the other module.
         dedupMap[moduleName] = original.getModuleNameAttr();
         deduper.dedup(original, module);
@@ -1596,7 +1760,7 @@ class DedupPass : public DedupBase<DedupPass> {
       // Add the module to a new dedup group.
       dedupMap[moduleName] = moduleName;
       // Record the module info.
-      moduleInfoToModule[moduleInfo] = module;
+      candidates.push_back(module);
     }
 
     // This part verifies that all modules marked by "MustDedup" have been
@@ -1684,6 +1848,8 @@ class DedupPass : public DedupBase<DedupPass> {
 };
 } // end anonymous namespace
 
-std::unique_ptr<mlir::Pass> circt::firrtl::createDedupPass() {
-  return std::make_unique<DedupPass>();
+std::unique_ptr<mlir::Pass> circt::firrtl::createDedupPass(bool fastHash) {
+  auto pass = std::make_unique<DedupPass>();
+  pass->fastHash = fastHash;
+  return pass;
 }
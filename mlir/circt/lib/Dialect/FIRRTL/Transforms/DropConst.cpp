@@ -15,6 +15,7 @@
 #include "circt/Dialect/FIRRTL/FIRRTLOps.h"
 #include "circt/Dialect/FIRRTL/FIRRTLTypes.h"
 #include "circt/Dialect/FIRRTL/FIRRTLUtils.h"
+#include "circt/Dialect/FIRRTL/NLATable.h"
 #include "circt/Dialect/FIRRTL/Passes.h"
 #include "mlir/IR/Threading.h"
 
@@ -87,7 +88,9 @@ class DropConstPass : public DropConstBase<DropConstPass> {
                             ArrayAttr::get(module.getContext(), portTypes));
         });
 
-    markAnalysesPreserved<InstanceGraph>();
+    // Only types change, so anything tracking operations is still valid.
+    markAnalysesPreserved<InstanceGraph, SymbolTable,
+                          hw::InnerSymbolTableCollection, NLATable>();
   }
 };
 } // namespace
@@ -21,7 +21,6 @@
 #include "circt/Dialect/HW/HWTypeInterfaces.h"
 #include "mlir/IR/BuiltinAttributes.h"
 #include "mlir/IR/ImplicitLocOpBuilder.h"
-#include "llvm/ADT/PostOrderIterator.h"
 #include "llvm/Support/Debug.h"
 #include "llvm/Support/FormatVariadic.h"
 
@@ -471,7 +470,7 @@ void HoistPassthroughPass::runOnOperation() {
 
   SmallVector<FModuleOp, 0> modules(llvm::make_filter_range(
       llvm::map_range(
-          llvm::post_order(&instanceGraph),
+          instanceGraph.getPostOrder(),
           [](auto *node) { return dyn_cast<FModuleOp>(*node->getModule()); }),
       [](auto module) { return module; }));
 
@@ -17,6 +17,7 @@
 #include "circt/Dialect/FIRRTL/FIRRTLFieldSource.h"
 #include "circt/Dialect/FIRRTL/FIRRTLInstanceGraph.h"
 #include "circt/Dialect/FIRRTL/FIRRTLUtils.h"
+#include "circt/Dialect/FIRRTL/NLATable.h"
 #include "circt/Dialect/FIRRTL/Passes.h"
 #include "circt/Support/APInt.h"
 #include "mlir/IR/Threading.h"
@@ -391,6 +392,10 @@ void IMConstPropPass::runOnOperation() {
   fieldRefToUsers.clear();
   valueToFieldRef.clear();
   resultPortToInstanceResultMapping.clear();
+
+  // Instances and operations with symbols are never erased, and modules and
+  // hierarchical paths are left alone.
+  markAnalysesPreserved<InstanceGraph, SymbolTable, NLATable>();
 }
 
 /// Return the lattice value for the specified SSA value, extended to the width
@@ -17,7 +17,6 @@
 #include "mlir/Interfaces/SideEffectInterfaces.h"
 #include "llvm/ADT/BitVector.h"
 #include "llvm/ADT/DenseMapInfoVariant.h"
-#include "llvm/ADT/PostOrderIterator.h"
 #include "llvm/ADT/TinyPtrVector.h"
 #include "llvm/Support/Debug.h"
 
@@ -360,12 +359,12 @@ void IMDeadCodeElimPass::runOnOperation() {
     }
   });
 
-  // Create a vector of modules in the post order of instance graph.
-  // FIXME: We copy the list of modules into a vector first to avoid iterator
-  // invalidation while we mutate the instance graph. See issue 3387.
+  // Create a vector of modules in the post order of instance graph. We copy
+  // the list of modules into a vector first since we mutate the instance
+  // graph below.
   SmallVector<FModuleOp, 0> modules(llvm::make_filter_range(
       llvm::map_range(
-          llvm::post_order(instanceGraph),
+          instanceGraph->getPostOrder(),
           [](auto *node) { return dyn_cast<FModuleOp>(*node->getModule()); }),
       [](auto module) { return module; }));
 
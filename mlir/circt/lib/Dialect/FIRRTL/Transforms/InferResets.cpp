@@ -517,7 +517,8 @@ void InferResetsPass::runOnOperation() {
   resetDrives.clear();
   annotatedResets.clear();
   domains.clear();
-  markAnalysesPreserved<InstanceGraph>();
+  // Ports and wires may be added, but no modules.
+  markAnalysesPreserved<InstanceGraph, SymbolTable>();
 }
 
 void InferResetsPass::runOnOperationInner() {
@@ -11,16 +11,19 @@
 //===----------------------------------------------------------------------===//
 
 #include "PassDetails.h"
+#include "circt/Dialect/FIRRTL/FIRRTLInstanceGraph.h"
 #include "circt/Dialect/FIRRTL/FIRRTLOps.h"
 #include "circt/Dialect/FIRRTL/FIRRTLTypes.h"
 #include "circt/Dialect/FIRRTL/FIRRTLUtils.h"
 #include "circt/Dialect/FIRRTL/FIRRTLVisitors.h"
+#include "circt/Dialect/FIRRTL/NLATable.h"
 #include "circt/Dialect/FIRRTL/Passes.h"
 #include "circt/Support/FieldRef.h"
 #include "mlir/IR/ImplicitLocOpBuilder.h"
 #include "mlir/IR/Threading.h"
 #include "llvm/ADT/APSInt.h"
 #include "llvm/ADT/DenseSet.h"
+#include "llvm/ADT/EquivalenceClasses.h"
 #include "llvm/ADT/GraphTraits.h"
 #include "llvm/ADT/Hashing.h"
 #include "llvm/ADT/MapVector.h"
@@ -28,6 +31,8 @@
 #include "llvm/ADT/SetVector.h"
 #include "llvm/Support/Debug.h"
 #include "llvm/Support/ErrorHandling.h"
+#include <atomic>
+#include <chrono>
 
 #define DEBUG_TYPE "infer-widths"
 
@@ -658,6 +663,9 @@ public:
   }
 
   void dumpConstraints(llvm::raw_ostream &os);
+  /// Check that no variable is constrained to be wider than itself. This must
+  /// succeed before calling `solve`.
+  LogicalResult checkForUnbreakableCycles();
   LogicalResult solve();
 
   using ContextInfo = DenseMap<Expr *, llvm::SmallSetVector<FieldRef, 1>>;
@@ -1003,10 +1011,9 @@ static ExprSolution solveExpr(Expr *expr, SmallPtrSetImpl<Expr *> &seenVars,
   return solvedExprs[expr];
 }
 
-/// Solve the constraint problem. This is a very simple implementation that
-/// does not fully solve the problem if there are weird dependency cycles
-/// present.
-LogicalResult ConstraintSolver::solve() {
+/// Check the constraint problem for cycles which cannot be satisfied, and
+/// report each of them.
+LogicalResult ConstraintSolver::checkForUnbreakableCycles() {
   LLVM_DEBUG({
     llvm::dbgs() << "\n===----- Constraints -----===\n\n";
     dumpConstraints(llvm::dbgs());
@@ -1067,13 +1074,17 @@ LogicalResult ConstraintSolver::solve() {
     }
   }
 
-  // If there were cycles, return now to avoid complaining to the user about
-  // dependent widths not being inferred.
-  if (anyFailed)
-    return failure();
+  return failure(anyFailed);
+}
 
+/// Solve the constraint problem. This is a very simple implementation that
+/// does not fully solve the problem if there are weird dependency cycles
+/// present.
+LogicalResult ConstraintSolver::solve() {
   // Iterate over the constraint variables and solve each.
   LLVM_DEBUG(llvm::dbgs() << "\n===----- Solving constraints -----===\n\n");
+  SmallPtrSet<Expr *, 16> seenVars;
+  bool anyFailed = false;
   unsigned defaultWorklistSize = exprs.size() / 2;
   for (auto *expr : exprs) {
     // Only work on variables.
@@ -1211,9 +1222,15 @@ public:
                    hw::InnerSymbolTableCollection &istc)
       : solver(solver), symtbl(symtbl), irn{symtbl, istc} {}
 
-  LogicalResult map(CircuitOp op);
+  /// Map the given modules. Any module they instantiate with uninferred port
+  /// widths must be among them.
+  LogicalResult map(ArrayRef<FModuleOp> modules);
   LogicalResult mapOperation(Operation *op);
 
+  /// Declare the variables for the ports of a module, unless that has already
+  /// been done.
+  void declarePorts(FModuleOp module);
+
   /// Declare all the variables in the value. If the value is a ground type,
   /// there is a single variable declared.  If the value is an aggregate type,
   /// it sets up variables for each unknown width.
@@ -1278,6 +1295,9 @@ private:
   /// The constraint exprs for each result type of an operation.
   DenseMap<FieldRef, Expr *> opExprs;
 
+  /// The modules whose ports have been declared.
+  SmallPtrSet<Operation *, 16> declaredModules;
+
   /// The fully inferred modules that were skipped entirely.
   SmallPtrSet<Operation *, 16> skippedModules;
   bool allModulesSkipped = true;
@@ -1300,18 +1320,24 @@ static bool hasUninferredWidth(Type type) {
       .Default([](auto) { return false; });
 }
 
-LogicalResult InferenceMapping::map(CircuitOp op) {
+void InferenceMapping::declarePorts(FModuleOp module) {
+  if (!declaredModules.insert(module).second)
+    return;
+  for (auto arg : module.getArguments()) {
+    solver.setCurrentContextInfo(FieldRef(arg, 0));
+    declareVars(arg, module.getLoc());
+  }
+}
+
+LogicalResult InferenceMapping::map(ArrayRef<FModuleOp> modules) {
   LLVM_DEBUG(llvm::dbgs()
              << "\n===----- Mapping ops to constraint exprs -----===\n\n");
 
   // Ensure we have constraint variables established for all module ports.
-  for (auto module : op.getOps<FModuleOp>())
-    for (auto arg : module.getArguments()) {
-      solver.setCurrentContextInfo(FieldRef(arg, 0));
-      declareVars(arg, module.getLoc());
-    }
+  for (auto module : modules)
+    declarePorts(module);
 
-  for (auto module : op.getOps<FModuleOp>()) {
+  for (auto module : modules) {
     // Check if the module contains *any* uninferred widths. This allows us to
     // do an early skip if the module is already fully inferred.
     bool anyUninferred = false;
@@ -1664,7 +1690,10 @@ LogicalResult InferenceMapping::mapOperation(Operation *op) {
         // Simply look up the free variables created for the instantiated
         // module's ports, and use them for instance port wires. This way,
         // constraints imposed onto the ports of the instance will transparently
-        // apply to the ports of the instantiated module.
+        // apply to the ports of the instantiated module. If the module is
+        // mapped separately, its port widths are all known and we just need
+        // our own copy of them.
+        declarePorts(module);
         for (auto it : llvm::zip(op->getResults(), module.getArguments())) {
           unifyTypes(FieldRef(std::get<0>(it), 0), FieldRef(std::get<1>(it), 0),
                      type_cast<FIRRTLType>(std::get<0>(it).getType()));
@@ -2064,9 +2093,9 @@ namespace {
 /// of variables and constraints to be solved later.
 class InferenceTypeUpdate {
 public:
-  InferenceTypeUpdate(InferenceMapping &mapping) : mapping(mapping) {}
+  InferenceTypeUpdate(const InferenceMapping &mapping) : mapping(mapping) {}
 
-  LogicalResult update(CircuitOp op);
+  LogicalResult update(FModuleOp module);
   FailureOr<bool> updateOperation(Operation *op);
   FailureOr<bool> updateValue(Value value);
   FIRRTLBaseType updateType(FieldRef fieldRef, FIRRTLBaseType type);
@@ -2077,22 +2106,17 @@ private:
 
 } // namespace
 
-/// Update the types throughout a circuit.
-LogicalResult InferenceTypeUpdate::update(CircuitOp op) {
-  LLVM_DEBUG(llvm::dbgs() << "\n===----- Update types -----===\n\n");
-  return mlir::failableParallelForEach(
-      op.getContext(), op.getOps<FModuleOp>(), [&](FModuleOp op) {
-        // Skip this module if it had no widths to be
-        // inferred at all.
-        if (mapping.isModuleSkipped(op))
-          return success();
-        auto isFailed = op.walk<WalkOrder::PreOrder>([&](Operation *op) {
-                            if (failed(updateOperation(op)))
-                              return WalkResult::interrupt();
-                            return WalkResult::advance();
-                          }).wasInterrupted();
-        return failure(isFailed);
-      });
+/// Update the types throughout a module.
+LogicalResult InferenceTypeUpdate::update(FModuleOp module) {
+  // Skip this module if it had no widths to be inferred at all.
+  if (mapping.isModuleSkipped(module))
+    return success();
+  auto isFailed = module.walk<WalkOrder::PreOrder>([&](Operation *op) {
+                    if (failed(updateOperation(op)))
+                      return WalkResult::interrupt();
+                    return WalkResult::advance();
+                  }).wasInterrupted();
+  return failure(isFailed);
 }
 
 /// Update the result types of an operation.
@@ -2340,34 +2364,150 @@ struct DenseMapInfo<InternedSlot<T>> {
 //===----------------------------------------------------------------------===//
 
 namespace {
+/// A group of modules whose widths are inferred together, independently of
+/// all other modules. Each has its own solver, and thereby its own arena for
+/// the constraint expressions.
+struct Partition {
+  Partition(SymbolTable &symtbl, hw::InnerSymbolTableCollection &istc)
+      : mapping(solver, symtbl, istc) {}
+  SmallVector<FModuleOp, 1> modules;
+  ConstraintSolver solver;
+  InferenceMapping mapping;
+};
+
 class InferWidthsPass : public InferWidthsBase<InferWidthsPass> {
   void runOnOperation() override;
 };
 } // namespace
 
+/// Group the modules of a circuit into sets whose width constraints cannot
+/// influence each other. Constraints only cross module boundaries through
+/// instances of modules with uninferred port widths and through rwprobes of
+/// another module's internals. An instance of a module whose port widths are
+/// all known only contributes known widths, so it doesn't tie the two modules
+/// together. The partitions and their modules are in circuit order.
+static SmallVector<SmallVector<FModuleOp, 1>>
+partitionModules(CircuitOp circuit, SymbolTable &symtbl) {
+  SmallVector<FModuleOp> modules(circuit.getOps<FModuleOp>());
+
+  // Find the modules each module is tied to.
+  SmallVector<SmallVector<Operation *, 0>> ties(modules.size());
+  mlir::parallelFor(circuit.getContext(), 0, modules.size(), [&](size_t i) {
+    auto tie = [&](Operation *other) {
+      if (other && other != modules[i])
+        ties[i].push_back(other);
+    };
+    modules[i].walk([&](Operation *op) {
+      if (auto inst = dyn_cast<InstanceOp>(op)) {
+        auto module = dyn_cast_or_null<FModuleOp>(
+            inst.getReferencedModule(symtbl).getOperation());
+        if (module && llvm::any_of(module.getArguments(), [](auto arg) {
+              return hasUninferredWidth(arg.getType());
+            }))
+          tie(module);
+      } else if (auto probe = dyn_cast<RWProbeOp>(op)) {
+        tie(symtbl.lookup<FModuleOp>(probe.getTarget().getModule()));
+      }
+    });
+  });
+
+  llvm::EquivalenceClasses<Operation *> classes;
+  for (auto module : modules)
+    classes.insert(module);
+  for (auto [module, moduleTies] : llvm::zip(modules, ties))
+    for (auto *other : moduleTies)
+      classes.unionSets(module, other);
+
+  SmallVector<SmallVector<FModuleOp, 1>> partitions;
+  DenseMap<Operation *, unsigned> partitionIndex;
+  for (auto module : modules) {
+    auto [it, inserted] = partitionIndex.try_emplace(
+        classes.getLeaderValue(module), partitions.size());
+    if (inserted)
+      partitions.emplace_back();
+    partitions[it->second].push_back(module);
+  }
+  return partitions;
+}
+
 void InferWidthsPass::runOnOperation() {
+  auto circuit = getOperation();
+  auto *context = &getContext();
+  auto &symtbl = getAnalysis<SymbolTable>();
+  auto &istc = getAnalysis<hw::InnerSymbolTableCollection>();
+
+  // Time each phase into a statistic.
+  auto start = std::chrono::steady_clock::now();
+  auto lap = [&](Statistic &stat) {
+    auto now = std::chrono::steady_clock::now();
+    stat += std::chrono::duration_cast<std::chrono::microseconds>(now - start)
+                .count();
+    start = now;
+  };
+
+  // Split the circuit into independent constraint problems.
+  std::vector<std::unique_ptr<Partition>> partitions;
+  for (auto &modules : partitionModules(circuit, symtbl)) {
+    partitions.push_back(std::make_unique<Partition>(symtbl, istc));
+    partitions.back()->modules = std::move(modules);
+  }
+  numPartitions += partitions.size();
+  for (auto &partition : partitions)
+    maxPartitionSize.updateMax(partition->modules.size());
+  lap(partitionTimeUs);
+
   // Collect variables and constraints
-  ConstraintSolver solver;
-  InferenceMapping mapping(solver, getAnalysis<SymbolTable>(),
-                           getAnalysis<hw::InnerSymbolTableCollection>());
-  if (failed(mapping.map(getOperation()))) {
+  if (failed(mlir::failableParallelForEach(
+          context, partitions, [&](auto &partition) {
+            return partition->mapping.map(partition->modules);
+          }))) {
     signalPassFailure();
     return;
   }
-  if (mapping.areAllModulesSkipped()) {
+  lap(mapTimeUs);
+  if (llvm::all_of(partitions, [](auto &partition) {
+        return partition->mapping.areAllModulesSkipped();
+      })) {
     markAllAnalysesPreserved();
     return; // fast path if no inferrable widths are around
   }
 
-  // Solve the constraints.
-  if (failed(solver.solve())) {
+  // Solve the constraints. Report all unbreakable cycles before trying to
+  // solve anything, to avoid complaining to the user about dependent widths
+  // not being inferred.
+  std::atomic<bool> anyFailed = false;
+  mlir::parallelForEach(context, partitions, [&](auto &partition) {
+    if (failed(partition->solver.checkForUnbreakableCycles()))
+      anyFailed = true;
+  });
+  if (!anyFailed)
+    mlir::parallelForEach(context, partitions, [&](auto &partition) {
+      if (failed(partition->solver.solve()))
+        anyFailed = true;
+    });
+  lap(solveTimeUs);
+  if (anyFailed) {
     signalPassFailure();
     return;
   }
 
   // Update the types with the inferred widths.
-  if (failed(InferenceTypeUpdate(mapping).update(getOperation())))
+  LLVM_DEBUG(llvm::dbgs() << "\n===----- Update types -----===\n\n");
+  SmallVector<std::pair<FModuleOp, const InferenceMapping *>> modules;
+  for (auto &partition : partitions)
+    for (auto module : partition->modules)
+      modules.emplace_back(module, &partition->mapping);
+  if (failed(mlir::failableParallelForEach(
+          context, modules, [&](auto &moduleAndMapping) {
+            auto [module, mapping] = moduleAndMapping;
+            return InferenceTypeUpdate(*mapping).update(module);
+          })))
     signalPassFailure();
+  lap(updateTimeUs);
+
+  // Only the types of values changed. No operations were created or erased.
+  markAnalysesPreserved<InstanceGraph, SymbolTable,
+                        hw::InnerSymbolTableCollection, NLATable>();
 }
 
 std::unique_ptr<mlir::Pass> circt::firrtl::createInferWidthsPass() {
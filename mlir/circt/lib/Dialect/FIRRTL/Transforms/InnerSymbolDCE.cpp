@@ -10,6 +10,7 @@
 //===----------------------------------------------------------------------===//
 
 #include "PassDetails.h"
+#include "circt/Dialect/FIRRTL/FIRRTLInstanceGraph.h"
 #include "circt/Dialect/FIRRTL/FIRRTLOps.h"
 #include "circt/Dialect/HW/HWAttributes.h"
 #include "mlir/IR/BuiltinOps.h"
@@ -124,6 +125,9 @@ void InnerSymbolDCEPass::runOnOperation() {
   // dead code.
   parallelForEach(&getContext(), modules,
                   [&](FModuleLike mod) { removeInnerSyms(mod); });
+
+  // Only inner symbols were removed.
+  markAnalysesPreserved<firrtl::InstanceGraph>();
 }
 
 std::unique_ptr<mlir::Pass> circt::firrtl::createInnerSymbolDCEPass() {
@@ -680,6 +680,12 @@ void LowerIntrinsicsPass::runOnOperation() {
         found = true;
         if (intrinsic.second(ig, cast<FModuleLike>(op))) {
           ++numConverted;
+          // The instances have been replaced, drop them and the module from
+          // the instance graph.
+          auto *node = ig.lookup(cast<FModuleLike>(op));
+          for (auto *use : llvm::make_early_inc_range(node->uses()))
+            use->erase();
+          ig.erase(node);
           op.erase();
         } else {
           ++numFailures;
@@ -696,6 +702,8 @@ void LowerIntrinsicsPass::runOnOperation() {
     signalPassFailure();
   if (!numConverted)
     markAllAnalysesPreserved();
+  else
+    markAnalysesPreserved<InstanceGraph>();
 }
 
 /// This is the pass constructor.
@@ -22,7 +22,6 @@
 #include "llvm/ADT/BitVector.h"
 #include "llvm/ADT/DenseMap.h"
 #include "llvm/ADT/EquivalenceClasses.h"
-#include "llvm/ADT/PostOrderIterator.h"
 #include "llvm/Support/Debug.h"
 
 #define DEBUG_TYPE "firrtl-lower-xmr"
@@ -248,7 +247,7 @@ class LowerXMRPass : public LowerXMRBase<LowerXMRPass> {
     SmallVector<FModuleOp> publicModules;
 
     // Traverse the modules in post order.
-    for (auto node : llvm::post_order(&instanceGraph)) {
+    for (auto *node : instanceGraph.getPostOrder()) {
       auto module = dyn_cast<FModuleOp>(*node->getModule());
       if (!module)
         continue;
@@ -332,7 +331,7 @@ class LowerXMRPass : public LowerXMRBase<LowerXMRPass> {
       if (failed(handlePublicModuleRefPorts(module)))
         return signalPassFailure();
     }
-    garbageCollect();
+    garbageCollect(instanceGraph);
 
     // Clean up
     moduleNamespaces.clear();
@@ -346,6 +345,10 @@ class LowerXMRPass : public LowerXMRBase<LowerXMRPass> {
     circuitNamespace = nullptr;
     pathCache.clear();
     pathInsertPoint = {};
+
+    // Instances with probe ports were replaced in the instance graph, and no
+    // module was added or removed.
+    markAnalysesPreserved<InstanceGraph>();
   }
 
   /// Generate the ABI ref_<circuit>_<module> prefix string into `prefix`.
@@ -706,7 +709,7 @@ class LowerXMRPass : public LowerXMRBase<LowerXMRPass> {
     return indx;
   }
 
-  void garbageCollect() {
+  void garbageCollect(InstanceGraph &instanceGraph) {
     // Now erase all the Ops and ports of RefType.
     // This needs to be done as the last step to ensure uses are erased before
     // the def is erased.
@@ -719,7 +722,8 @@ class LowerXMRPass : public LowerXMRBase<LowerXMRPass> {
         mod.erasePorts(iter.getSecond());
       else if (auto inst = dyn_cast<InstanceOp>(iter.getFirst())) {
         ImplicitLocOpBuilder b(inst.getLoc(), inst);
-        inst.erasePorts(b, iter.getSecond());
+        auto newInst = inst.erasePorts(b, iter.getSecond());
+        instanceGraph.replaceInstance(inst, newInst);
         inst.erase();
       } else if (auto mem = dyn_cast<MemOp>(iter.getFirst())) {
         // Remove all debug ports of the memory.
@@ -16,6 +16,7 @@
 #include "circt/Dialect/FIRRTL/FIRRTLInstanceGraph.h"
 #include "circt/Dialect/FIRRTL/FIRRTLOps.h"
 #include "circt/Dialect/FIRRTL/FIRRTLTypes.h"
+#include "circt/Dialect/FIRRTL/NLATable.h"
 #include "circt/Dialect/FIRRTL/Namespace.h"
 #include "circt/Dialect/FIRRTL/Passes.h"
 #include "mlir/IR/ImplicitLocOpBuilder.h"
@@ -63,6 +64,10 @@ struct MemToRegOfVecPass : public MemToRegOfVecBase<MemToRegOfVecPass> {
                             if (auto mod = dyn_cast<FModuleOp>(op))
                               runOnModule(mod);
                           });
+
+    // Memories are replaced with registers; no modules or instances change.
+    // The memories may have had inner symbols, though.
+    markAnalysesPreserved<InstanceGraph, SymbolTable, NLATable>();
   }
 
   void runOnModule(FModuleOp mod) {
@@ -14,7 +14,6 @@
 #include "mlir/IR/ImplicitLocOpBuilder.h"
 #include "llvm/ADT/APSInt.h"
 #include "llvm/ADT/BitVector.h"
-#include "llvm/ADT/PostOrderIterator.h"
 #include "llvm/Support/Debug.h"
 
 #define DEBUG_TYPE "firrtl-remove-unused-ports"
@@ -27,7 +26,8 @@ struct RemoveUnusedPortsPass
     : public RemoveUnusedPortsBase<RemoveUnusedPortsPass> {
   void runOnOperation() override;
   void removeUnusedModulePorts(FModuleOp module,
-                               InstanceGraphNode *instanceGraphNode);
+                               InstanceGraphNode *instanceGraphNode,
+                               InstanceGraph &instanceGraph);
 
   /// If true, the pass will remove unused ports even if they have carry a
   /// symbol or annotations. This is likely to break the IR, but may be useful
@@ -43,15 +43,19 @@ void RemoveUnusedPortsPass::runOnOperation() {
                           << "\n");
   // Iterate in the reverse order of instance graph iterator, i.e. from leaves
   // to top.
-  for (auto *node : llvm::post_order(&instanceGraph))
+  for (auto *node : instanceGraph.getPostOrder())
     if (auto module = dyn_cast<FModuleOp>(*node->getModule()))
       // Don't prune the main module.
       if (!module.isPublic())
-        removeUnusedModulePorts(module, node);
+        removeUnusedModulePorts(module, node, instanceGraph);
+
+  // Instances are replaced in the instance graph as their ports are removed.
+  markAnalysesPreserved<InstanceGraph>();
 }
 
 void RemoveUnusedPortsPass::removeUnusedModulePorts(
-    FModuleOp module, InstanceGraphNode *instanceGraphNode) {
+    FModuleOp module, InstanceGraphNode *instanceGraphNode,
+    InstanceGraph &instanceGraph) {
   LLVM_DEBUG(llvm::dbgs() << "Prune ports of module: " << module.getName()
                           << "\n");
   // This tracks constant values of output ports. None indicates an invalid
@@ -192,7 +196,8 @@ void RemoveUnusedPortsPass::removeUnusedModulePorts(
     }
 
     // Create a new instance op without unused ports.
-    instance.erasePorts(builder, removalPortIndexes);
+    auto newInstance = instance.erasePorts(builder, removalPortIndexes);
+    instanceGraph.replaceInstance(instance, newInstance);
     // Remove old one.
     instance.erase();
   }
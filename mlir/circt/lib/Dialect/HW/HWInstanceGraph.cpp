@@ -12,7 +12,7 @@ using namespace circt;
 using namespace hw;
 
 InstanceGraph::InstanceGraph(Operation *operation)
-    : igraph::InstanceGraph(operation) {
+    : igraph::InstanceGraph(operation), entry(this) {
   for (auto &node : nodes) {
     // Note: we dyn_cast here because we cannot assume that _all_ nodes are
     // HWModuleLike - there may be cases where hw.module's are mixed with
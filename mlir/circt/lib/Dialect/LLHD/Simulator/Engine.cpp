@@ -18,8 +18,37 @@
 
 #include "llvm/Support/TargetSelect.h"
 
+#include <cstring>
+
 using namespace circt::llhd::sim;
 
+/// Overwrite `width` bits of `dst`, starting at bit `offset`, with the low
+/// bits of `src`.
+static void insertBits(uint8_t *dst, unsigned offset, const uint8_t *src,
+                       unsigned width) {
+  // Copy whole bytes if the bits are byte-aligned.
+  if (offset % 8 == 0) {
+    dst += offset / 8;
+    std::memcpy(dst, src, width / 8);
+    dst += width / 8;
+    src += width / 8;
+    offset = 0;
+    width %= 8;
+  }
+  for (unsigned i = 0; i < width;) {
+    unsigned dstBit = offset + i;
+    unsigned dstShift = dstBit % 8;
+    unsigned n = std::min(8 - dstShift, width - i);
+    unsigned srcShift = i % 8;
+    unsigned bits = src[i / 8] >> srcShift;
+    if (srcShift + n > 8)
+      bits |= src[i / 8 + 1] << (8 - srcShift);
+    uint8_t mask = ((1u << n) - 1) << dstShift;
+    dst[dstBit / 8] = (dst[dstBit / 8] & ~mask) | ((bits << dstShift) & mask);
+    i += n;
+  }
+}
+
 Engine::Engine(
     llvm::raw_ostream &out, ModuleOp module,
     llvm::function_ref<mlir::LogicalResult(mlir::ModuleOp)> mlirTransformer,
@@ -79,6 +108,9 @@ int Engine::simulate(int n, uint64_t maxTime) {
     return -1;
   }
 
+  // Move the signal values allocated during initialization into one arena.
+  state->packSignals();
+
   if (traceMode != TraceMode::None) {
     // Add changes for all the signals' initial values.
     for (size_t i = 0, e = state->signals.size(); i < e; ++i) {
@@ -87,8 +119,7 @@ int Engine::simulate(int n, uint64_t maxTime) {
   }
 
   // Add a dummy event to get the simulation started.
-  state->queue.push_back(Slot(Time()));
-  ++state->queue.events;
+  state->queue.getOrCreateSlot(Time());
 
   // Keep track of the instances that need to wakeup.
   llvm::SmallVector<unsigned, 8> wakeupQueue;
@@ -106,9 +137,13 @@ int Engine::simulate(int n, uint64_t maxTime) {
     inst.unitFPtr = *expectedFPtr;
   }
 
+  // Scratch space to apply the changes to a signal in, reused across signals
+  // to avoid allocating for every change.
+  llvm::SmallVector<uint64_t, 8> buffer;
+
   int cycle = 0;
-  while (state->queue.events > 0) {
-    const auto &pop = state->queue.top();
+  while (!state->queue.empty()) {
+    auto &pop = state->queue.top();
 
     // Interrupt the simulation if a stop condition is met.
     if ((n > 0 && cycle >= n) ||
@@ -123,27 +158,29 @@ int Engine::simulate(int n, uint64_t maxTime) {
       trace.flush();
 
     // Process signal changes.
-    size_t i = 0, e = pop.changesSize;
+    pop.sortChanges();
+    size_t i = 0, e = pop.changes.size();
     while (i < e) {
-      const auto sigIndex = pop.changes[i].first;
+      const auto sigIndex = pop.changes[i].signal;
       auto &curr = state->signals[sigIndex];
-      APInt buff(curr.getSize() * 8, 0);
-      llvm::LoadIntFromMemory(buff, curr.getValue(), curr.getSize());
+      auto size = curr.getSize();
+      buffer.assign(llvm::divideCeil(size, 8), 0);
+      auto *bytes = reinterpret_cast<uint8_t *>(buffer.data());
+      std::memcpy(bytes, curr.getValue(), size);
 
       // Apply the changes to the buffer until we reach the next signal.
-      while (i < e && pop.changes[i].first == sigIndex) {
-        const auto &change = pop.buffers[pop.changes[i].second];
-        const auto offset = change.first;
-        const auto &drive = change.second;
-        if (drive.getBitWidth() < buff.getBitWidth())
-          buff.insertBits(drive, offset);
+      while (i < e && pop.changes[i].signal == sigIndex) {
+        const auto &change = pop.changes[i];
+        const auto *drive = pop.getChangeData(change);
+        if (change.width < size * 8)
+          insertBits(bytes, change.bitOffset, drive, change.width);
         else
-          buff = drive;
+          std::memcpy(bytes, drive, size);
 
         ++i;
       }
 
-      if (!curr.updateWhenChanged(buff.getRawData()))
+      if (!curr.updateWhenChanged(buffer.data()))
         continue;
 
       // Add sensitive instances.
@@ -232,6 +269,7 @@ void Engine::buildLayout(ModuleOp module) {
   rootInst.isEntity = true;
   // Store the root instance.
   state->instances.push_back(std::move(rootInst));
+  state->indexInstances();
 
   // Add triggers to signals.
   for (size_t i = 0, e = state->instances.size(); i < e; ++i) {
@@ -248,7 +286,7 @@ void Engine::walkEntity(EntityOp entity, Instance &child) {
 
     // Add a signal to the signal table.
     if (auto sig = dyn_cast<SigOp>(op)) {
-      uint64_t index = state->addSignal(sig.getName().str(), child.name);
+      uint64_t index = state->addSignal(sig.getName(), child.name);
       child.sensitivityList.push_back(
           SignalDetail({nullptr, 0, child.sensitivityList.size(), index}));
     }
@@ -282,13 +320,13 @@ void Engine::walkEntity(EntityOp entity, Instance &child) {
             newChild.sensitivityList.push_back(detail);
           } else if (auto sigOp = dyn_cast<SigOp>(args[i].getDefiningOp())) {
             // The signal comes from one of the instance's owned signals.
+            auto sigName = state->internName(sigOp.getName());
+            auto owner = state->internName(child.name);
             auto it = std::find_if(
                 child.sensitivityList.begin(), child.sensitivityList.end(),
                 [&](SignalDetail &detail) {
-                  return state->signals[detail.globalIndex].getName() ==
-                             sigOp.getName() &&
-                         state->signals[detail.globalIndex].getOwner() ==
-                             child.name;
+                  auto &sig = state->signals[detail.globalIndex];
+                  return sig.getNameID() == sigName && sig.isOwner(owner);
                 });
             if (it != child.sensitivityList.end()) {
               auto detail = *it;
@@ -13,7 +13,10 @@
 
 #include "circt/Dialect/LLHD/Simulator/State.h"
 
+#include "llvm/ADT/STLExtras.h"
+#include "llvm/ADT/StringExtras.h"
 #include "llvm/Support/Format.h"
+#include "llvm/Support/MathExtras.h"
 #include "llvm/Support/raw_ostream.h"
 
 #include <string>
@@ -57,50 +60,36 @@ std::string Signal::toHexString(unsigned elemIndex) const {
   return ret;
 }
 
-Signal::~Signal() {
-  std::free(value);
-  value = nullptr;
-}
-
 //===----------------------------------------------------------------------===//
 // Slot
 //===----------------------------------------------------------------------===//
 
-bool Slot::operator<(const Slot &rhs) const { return time < rhs.time; }
-
-bool Slot::operator>(const Slot &rhs) const { return rhs.time < time; }
-
-void Slot::insertChange(int index, int bitOffset, uint8_t *bytes,
-                        unsigned width) {
-  // Get the amount of 64 bit words required to store the value in an APInt.
-  auto size = llvm::divideCeil(width, 8);
+void Slot::insertChange(unsigned index, unsigned bitOffset,
+                        const uint8_t *bytes, unsigned width) {
+  // Copy the driven value into the change buffer, which retains its capacity
+  // across reuses of the slot.
+  unsigned data = buffer.size();
+  buffer.append(bytes, bytes + llvm::divideCeil(width, 8));
+  changes.push_back({index, bitOffset, width, data});
+}
 
-  APInt buffer(width, 0);
-  llvm::LoadIntFromMemory(buffer, bytes, size);
-  auto offsetBufferPair = std::make_pair(bitOffset, buffer);
+void Slot::insertChange(unsigned inst) { scheduled.push_back(inst); }
 
-  if (changesSize >= buffers.size()) {
-    // Create a new change buffer if we don't have any unused one available for
-    // reuse.
-    buffers.push_back(offsetBufferPair);
-  } else {
-    // Reuse the first available buffer.
-    buffers[changesSize] = offsetBufferPair;
-  }
+void Slot::sortChanges() { llvm::sort(changes); }
 
-  // Map the signal index to the change buffer so we can retrieve
-  // it after sorting.
-  changes.push_back(std::make_pair(index, changesSize));
-  ++changesSize;
+void Slot::clear() {
+  changes.clear();
+  buffer.clear();
+  scheduled.clear();
+  time = Time();
 }
 
-void Slot::insertChange(unsigned inst) { scheduled.push_back(inst); }
-
 //===----------------------------------------------------------------------===//
 // UpdateQueue
 //===----------------------------------------------------------------------===//
-void UpdateQueue::insertOrUpdate(Time time, int index, int bitOffset,
-                                 uint8_t *bytes, unsigned width) {
+
+void UpdateQueue::insertOrUpdate(Time time, unsigned index, unsigned bitOffset,
+                                 const uint8_t *bytes, unsigned width) {
   auto &slot = getOrCreateSlot(time);
   slot.insertChange(index, bitOffset, bytes, width);
 }
@@ -111,84 +100,97 @@ void UpdateQueue::insertOrUpdate(Time time, unsigned inst) {
 }
 
 Slot &UpdateQueue::getOrCreateSlot(Time time) {
-  auto &top = begin()[topSlot];
-
-  // Directly add to top slot.
-  if (!top.unused && time == top.time) {
-    return top;
+  assert(time.getTime() >= windowStart && "cannot schedule in the past");
+
+  // Slots beyond the window go into the overflow map.
+  if (time.getTime() - windowStart >= wheelSize) {
+    auto [it, inserted] = overflow.try_emplace(time, noSlot);
+    if (inserted)
+      it->second = allocSlot(time);
+    return slots[it->second];
   }
 
-  // We need to search through the queue for an existing slot only if we're
-  // spawning an event later than the top slot. Adding to an existing slot
-  // scheduled earlier than the top slot should never happens, as then it should
-  // be the top.
-  if (events > 0 && top.time < time) {
-    for (size_t i = 0, e = size(); i < e; ++i) {
-      if (time == begin()[i].time) {
-        return begin()[i];
-      }
-    }
-  }
+  auto &bucket = wheel[time.getTime() % wheelSize];
+  auto it = llvm::lower_bound(bucket, time, [&](unsigned slot, Time time) {
+    return slots[slot].time < time;
+  });
+  if (it != bucket.end() && slots[*it].time == time)
+    return slots[*it];
+
+  auto slot = allocSlot(time);
+  bucket.insert(it, slot);
+  ++wheelEvents;
+
+  // Update the top of the queue if the new slot is earlier than it.
+  if (topSlot != noSlot && time < slots[topSlot].time)
+    topSlot = slot;
+  return slots[slot];
+}
 
-  // Spawn new event using an existing slot.
+unsigned UpdateQueue::allocSlot(Time time) {
+  ++events;
   if (!unused.empty()) {
-    auto firstUnused = unused.pop_back_val();
-    auto &newSlot = begin()[firstUnused];
-    newSlot.unused = false;
-    newSlot.time = time;
-
-    // Update the top of the queue either if it is currently unused or the new
-    // timestamp is earlier than it.
-    if (top.unused || time < top.time)
-      topSlot = firstUnused;
-
-    ++events;
-    return newSlot;
+    auto slot = unused.pop_back_val();
+    slots[slot].time = time;
+    return slot;
   }
+  slots.emplace_back(time);
+  return slots.size() - 1;
+}
 
-  // We do not have pre-allocated slots available, generate a new one.
-  push_back(Slot(time));
+void UpdateQueue::insertIntoWheel(unsigned slot) {
+  auto time = slots[slot].time;
+  auto &bucket = wheel[time.getTime() % wheelSize];
+  auto it = llvm::lower_bound(bucket, time, [&](unsigned slot, Time time) {
+    return slots[slot].time < time;
+  });
+  bucket.insert(it, slot);
+  ++wheelEvents;
+}
 
-  // Update the top of the queue either if it is currently unused or the new
-  // timestamp is earlier than it.
-  if (top.unused || time < top.time)
-    topSlot = size() - 1;
+void UpdateQueue::findTop() {
+  assert(events > 0 && "the event queue is empty");
+
+  // Advance the window to the earliest bucket with a slot in it. If the wheel
+  // is empty, restart it at the earliest slot in the overflow map.
+  if (wheelEvents == 0)
+    windowStart = overflow.begin()->first.getTime();
+  else
+    while (wheel[windowStart % wheelSize].empty())
+      ++windowStart;
+
+  // Move the overflow slots that are now within the window into the wheel.
+  // These are all later than the slots already in the wheel.
+  while (!overflow.empty() &&
+         overflow.begin()->first.getTime() - windowStart < wheelSize) {
+    insertIntoWheel(overflow.begin()->second);
+    overflow.erase(overflow.begin());
+  }
 
-  ++events;
-  return back();
+  topSlot = wheel[windowStart % wheelSize].front();
 }
 
-const Slot &UpdateQueue::top() {
-  assert(topSlot < size() && "top is pointing out of bounds!");
-
-  // Sort the changes of the top slot such that all changes to the same signal
-  // are in succession.
-  auto &top = begin()[topSlot];
-  llvm::sort(top.changes.begin(), top.changes.begin() + top.changesSize);
-  return top;
+Slot &UpdateQueue::top() {
+  if (topSlot == noSlot)
+    findTop();
+  return slots[topSlot];
 }
 
 void UpdateQueue::pop() {
-  // Reset internal structures and decrease the event counter.
-  auto &curr = begin()[topSlot];
-  curr.unused = true;
-  curr.changesSize = 0;
-  curr.scheduled.clear();
-  curr.changes.clear();
-  curr.time = Time();
+  if (topSlot == noSlot)
+    findTop();
+  auto slot = topSlot;
+
+  // The top is always the first slot of the window's first bucket.
+  auto &bucket = wheel[windowStart % wheelSize];
+  assert(!bucket.empty() && bucket.front() == slot && "top is not in wheel");
+  bucket.erase(bucket.begin());
+  --wheelEvents;
   --events;
 
-  // Add to unused slots list for easy retrieval.
-  unused.push_back(topSlot);
-
-  // Update the current top of the queue.
-  topSlot = std::distance(
-      begin(),
-      std::min_element(begin(), end(), [](const auto &a, const auto &b) {
-        // a is "smaller" than b if either a's timestamp is earlier than b's, or
-        // b is unused (i.e. b has no actual meaning).
-        return !a.unused && (a < b || b.unused);
-      }));
+  slots[slot].clear();
+  unused.push_back(slot);
+  topSlot = noSlot;
 }
 
 //===----------------------------------------------------------------------===//
@@ -212,13 +214,11 @@ State::~State() {
       std::free(inst.procState->senses);
     }
   }
-}
-
-Slot State::popQueue() {
-  assert(!queue.empty() && "the event queue is empty");
-  Slot pop = queue.top();
-  queue.pop();
-  return pop;
+  // Free the values allocated by the generated code if they have not been
+  // moved into the arena.
+  if (!signalArena)
+    for (auto &sig : signals)
+      std::free(sig.getValue());
 }
 
 void State::pushQueue(Time t, unsigned inst) {
@@ -228,22 +228,39 @@ void State::pushQueue(Time t, unsigned inst) {
 }
 
 llvm::SmallVectorTemplateCommon<Instance>::iterator
-State::getInstanceIterator(std::string instName) {
-  auto it =
-      std::find_if(instances.begin(), instances.end(),
-                   [&](const auto &inst) { return instName == inst.name; });
+State::getInstanceIterator(StringRef instName) {
+  auto it = instanceIndices.find(instName);
+  assert(it != instanceIndices.end() && "instance does not exist!");
+  return instances.begin() + it->second;
+}
+
+void State::indexInstances() {
+  instanceIndices.clear();
+  for (auto [index, inst] : llvm::enumerate(instances))
+    instanceIndices.try_emplace(inst.name, index);
+}
 
-  assert(it != instances.end() && "instance does not exist!");
+NameID State::internName(StringRef name) {
+  auto [it, inserted] = nameIDs.try_emplace(name, names.size());
+  if (inserted)
+    names.push_back(it->getKey());
+  return it->second;
+}
 
-  return it;
+/// Check whether a signal name is of the form `(sig)?[0-9]*`, as assigned to
+/// signals without a name given by the user.
+static bool isAnonymousSigName(StringRef name) {
+  name.consume_front("sig");
+  return llvm::all_of(name, llvm::isDigit);
 }
 
-int State::addSignal(std::string name, std::string owner) {
-  signals.push_back(Signal(name, owner));
+int State::addSignal(StringRef name, StringRef owner) {
+  signals.push_back(
+      Signal(internName(name), internName(owner), isAnonymousSigName(name)));
   return signals.size() - 1;
 }
 
-void State::addProcPtr(std::string name, ProcState *procStatePtr) {
+void State::addProcPtr(StringRef name, ProcState *procStatePtr) {
   auto it = getInstanceIterator(name);
 
   // Store instance index in process state.
@@ -251,7 +268,7 @@ void State::addProcPtr(std::string name, ProcState *procStatePtr) {
   (*it).procState = procStatePtr;
 }
 
-int State::addSignalData(int index, std::string owner, uint8_t *value,
+int State::addSignalData(int index, StringRef owner, uint8_t *value,
                          uint64_t size) {
   auto it = getInstanceIterator(owner);
 
@@ -273,6 +290,44 @@ int State::addSignalData(int index, std::string owner, uint8_t *value,
   return globalIdx;
 }
 
+void State::packSignals() {
+  assert(!signalArena && "signals have already been packed");
+
+  // Give every signal twice its size, as the generated code does, such that
+  // shifted accesses stay within the signal, and keep them 8-byte aligned.
+  auto getSlotSize = [](const Signal &sig) {
+    return llvm::alignTo(2 * llvm::PowerOf2Ceil(sig.getSize()), 8);
+  };
+  uint64_t numBytes = 0;
+  for (auto &sig : signals)
+    numBytes += getSlotSize(sig);
+  signalArena = std::make_unique<uint64_t[]>(numBytes / 8 + 1);
+
+  std::vector<uint8_t *> oldValues;
+  oldValues.reserve(signals.size());
+  auto *next = reinterpret_cast<uint8_t *>(signalArena.get());
+  for (auto &sig : signals) {
+    oldValues.push_back(sig.getValue());
+    if (sig.getValue()) {
+      std::memcpy(next, sig.getValue(), sig.getSize());
+      std::free(sig.getValue());
+    }
+    sig.store(next, sig.getSize());
+    next += getSlotSize(sig);
+  }
+
+  // Point the signal tables of the instances into the arena.
+  for (auto &inst : instances) {
+    for (auto &detail : inst.sensitivityList) {
+      if (!detail.value)
+        continue;
+      auto *oldValue = oldValues[detail.globalIndex];
+      detail.value =
+          signals[detail.globalIndex].getValue() + (detail.value - oldValue);
+    }
+  }
+}
+
 void State::addSignalElement(unsigned index, unsigned offset, unsigned size) {
   signals[index].pushElement(std::make_pair(offset, size));
 }
@@ -281,7 +336,7 @@ void State::dumpSignal(llvm::raw_ostream &out, int index) {
   auto &sig = signals[index];
   for (auto inst : sig.getTriggeredInstanceIndices()) {
     out << time.toString() << "  " << instances[inst].path << "/"
-        << sig.getName() << "  " << sig.toHexString() << "\n";
+        << getName(sig.getNameID()) << "  " << sig.toHexString() << "\n";
   }
 }
 
@@ -303,8 +358,8 @@ void State::dumpLayout() {
 void State::dumpSignalTriggers() {
   llvm::errs() << "::------------- Signal information -------------::\n";
   for (size_t i = 0, e = signals.size(); i < e; ++i) {
-    llvm::errs() << signals[i].getOwner() << "/" << signals[i].getName()
-                 << " triggers: ";
+    llvm::errs() << getName(signals[i].getOwnerID()) << "/"
+                 << getName(signals[i].getNameID()) << " triggers: ";
     for (auto trig : signals[i].getTriggeredInstanceIndices()) {
       llvm::errs() << trig << " ";
     }
@@ -20,7 +20,7 @@ using namespace circt::llhd::sim;
 Trace::Trace(std::unique_ptr<State> const &state, llvm::raw_ostream &out,
              TraceMode mode)
     : out(out), state(state), mode(mode) {
-  auto root = state->root;
+  auto root = state->internName(state->root);
   for (auto &sig : state->signals) {
     bool done = (mode != TraceMode::Full && mode != TraceMode::Merged &&
                  !sig.isOwner(root)) ||
@@ -39,7 +39,7 @@ void Trace::pushChange(unsigned inst, unsigned sigIndex, int elem = -1) {
   std::string path;
   llvm::raw_string_ostream ss(path);
 
-  ss << state->instances[inst].path << '/' << sig.getName();
+  ss << state->instances[inst].path << '/' << state->getName(sig.getNameID());
 
   if (elem >= 0) {
     // Add element index to the hierarchical path.
@@ -25,9 +25,7 @@ using namespace circt::llhd::sim;
 int allocSignal(State *state, int index, char *owner, uint8_t *value,
                 int64_t size) {
   assert(state && "alloc_signal: state not found");
-  std::string sOwner(owner);
-
-  return state->addSignalData(index, sOwner, value, size);
+  return state->addSignalData(index, owner, value, size);
 }
 
 void addSigArrayElements(State *state, unsigned index, unsigned size,
@@ -43,8 +41,7 @@ void addSigStructElement(State *state, unsigned index, unsigned offset,
 
 void allocProc(State *state, char *owner, ProcState *procState) {
   assert(state && "alloc_proc: state not found");
-  std::string sOwner(owner);
-  state->addProcPtr(sOwner, procState);
+  state->addProcPtr(owner, procState);
 }
 
 void allocEntity(State *state, char *owner, uint8_t *entityState) {
@@ -60,7 +57,7 @@ void driveSignal(State *state, SignalDetail *detail, uint8_t *value,
   auto globalIndex = detail->globalIndex;
   auto offset = detail->offset;
 
-  int bitOffset =
+  unsigned bitOffset =
       (detail->value - state->signals[globalIndex].getValue()) * 8 + offset;
 
   // Spawn a new event.
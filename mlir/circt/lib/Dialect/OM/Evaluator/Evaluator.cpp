@@ -23,7 +23,25 @@ using namespace mlir;
 using namespace circt::om;
 
 /// Construct an Evaluator with an IR module.
-circt::om::Evaluator::Evaluator(ModuleOp mod) : symbolTable(mod) {}
+circt::om::Evaluator::Evaluator(ModuleOp mod, bool memoizeInstances)
+    : symbolTable(mod), memoizeInstances(memoizeInstances) {}
+
+circt::om::Evaluator::~Evaluator() {
+  // Values refer to each other through shared pointers, and placeholders and
+  // graph regions make those references cyclic. Drop them all, so that every
+  // value is destroyed before the arena holding it is freed.
+  for (auto &weakValue : allocatedValues)
+    if (auto value = weakValue.lock())
+      value->dropReferences();
+  objects.clear();
+  worklist = {};
+  instances.clear();
+  evaluatedInstances.clear();
+  actualParametersAllocator.DestroyAll();
+  assert(llvm::all_of(allocatedValues,
+                      [](auto &value) { return value.expired(); }) &&
+         "evaluator values must not outlive the Evaluator");
+}
 
 /// Get the Module this Evaluator is built from.
 ModuleOp circt::om::Evaluator::getModule() {
@@ -54,6 +72,14 @@ LogicalResult circt::om::evaluator::EvaluatorValue::finalize() {
           [](auto v) { return v->finalizeImpl(); });
 }
 
+void circt::om::evaluator::EvaluatorValue::dropReferences() {
+  using namespace evaluator;
+  llvm::TypeSwitch<EvaluatorValue *>(this)
+      .Case<AttributeValue, ObjectValue, ListValue, MapValue, ReferenceValue,
+            TupleValue, BasePathValue, PathValue>(
+          [](auto v) { v->dropReferencesImpl(); });
+}
+
 Type circt::om::evaluator::EvaluatorValue::getType() const {
   return llvm::TypeSwitch<const EvaluatorValue *, Type>(this)
       .Case<AttributeValue>([](auto *attr) -> Type {
@@ -77,17 +103,17 @@ circt::om::Evaluator::getPartiallyEvaluatedValue(Type type, Location loc) {
   return TypeSwitch<mlir::Type, FailureOr<evaluator::EvaluatorValuePtr>>(type)
       .Case([&](circt::om::MapType type) {
         evaluator::EvaluatorValuePtr result =
-            std::make_shared<evaluator::MapValue>(type, loc);
+            allocateValue<evaluator::MapValue>(type, loc);
         return success(result);
       })
       .Case([&](circt::om::ListType type) {
         evaluator::EvaluatorValuePtr result =
-            std::make_shared<evaluator::ListValue>(type, loc);
+            allocateValue<evaluator::ListValue>(type, loc);
         return success(result);
       })
       .Case([&](mlir::TupleType type) {
         evaluator::EvaluatorValuePtr result =
-            std::make_shared<evaluator::TupleValue>(type, loc);
+            allocateValue<evaluator::TupleValue>(type, loc);
         return success(result);
       })
 
@@ -100,7 +126,7 @@ circt::om::Evaluator::getPartiallyEvaluatedValue(Type type, Location loc) {
                  << type.getClassName();
 
         evaluator::EvaluatorValuePtr result =
-            std::make_shared<evaluator::ObjectValue>(cls, loc);
+            allocateValue<evaluator::ObjectValue>(cls, loc);
 
         return success(result);
       })
@@ -134,7 +160,7 @@ FailureOr<evaluator::EvaluatorValuePtr> circt::om::Evaluator::getOrCreateValue(
                   // Create a reference value since the value pointed by object
                   // field op is not created yet.
                   evaluator::EvaluatorValuePtr result =
-                      std::make_shared<evaluator::ReferenceValue>(
+                      allocateValue<evaluator::ReferenceValue>(
                           value.getType(), loc);
                   return success(result);
                 })
@@ -143,13 +169,13 @@ FailureOr<evaluator::EvaluatorValuePtr> circt::om::Evaluator::getOrCreateValue(
                 })
                 .Case<FrozenBasePathCreateOp>([&](FrozenBasePathCreateOp op) {
                   evaluator::EvaluatorValuePtr result =
-                      std::make_shared<evaluator::BasePathValue>(
+                      allocateValue<evaluator::BasePathValue>(
                           op.getPathAttr(), loc);
                   return success(result);
                 })
                 .Case<FrozenPathCreateOp>([&](FrozenPathCreateOp op) {
                   evaluator::EvaluatorValuePtr result =
-                      std::make_shared<evaluator::PathValue>(
+                      allocateValue<evaluator::PathValue>(
                           op.getTargetKindAttr(), op.getPathAttr(),
                           op.getModuleAttr(), op.getRefAttr(),
                           op.getFieldAttr(), loc);
@@ -157,7 +183,7 @@ FailureOr<evaluator::EvaluatorValuePtr> circt::om::Evaluator::getOrCreateValue(
                 })
                 .Case<FrozenEmptyPathOp>([&](FrozenEmptyPathOp op) {
                   evaluator::EvaluatorValuePtr result =
-                      std::make_shared<evaluator::PathValue>(
+                      allocateValue<evaluator::PathValue>(
                           evaluator::PathValue::getEmptyPath(loc));
                   return success(result);
                 })
@@ -236,17 +262,20 @@ circt::om::Evaluator::evaluateObjectInstance(StringAttr className,
   // Instantiate the fields.
   evaluator::ObjectFields fields;
 
+  // Allocate the values of the class body, unless an earlier instance with the
+  // same parameters already did.
   auto *context = cls.getContext();
-  for (auto &op : cls.getOps())
-    for (auto result : op.getResults()) {
-      // Allocate the value, with unknown loc. It will be later set when
-      // evaluating the fields.
-      if (failed(
-              getOrCreateValue(result, actualParams, UnknownLoc::get(context))))
-        return failure();
-      // Add to the worklist.
-      worklist.push({result, actualParams});
-    }
+  if (evaluatedInstances.insert(actualParams).second)
+    for (auto &op : cls.getOps())
+      for (auto result : op.getResults()) {
+        // Allocate the value, with unknown loc. It will be later set when
+        // evaluating the fields.
+        if (failed(getOrCreateValue(result, actualParams,
+                                    UnknownLoc::get(context))))
+          return failure();
+        // Add to the worklist.
+        worklist.push({result, actualParams});
+      }
 
   for (auto field : cls.getOps<ClassFieldOp>()) {
     StringAttr name = field.getSymNameAttr();
@@ -270,7 +299,7 @@ circt::om::Evaluator::evaluateObjectInstance(StringAttr className,
 
   // If it's external call, just allocate new ObjectValue.
   evaluator::EvaluatorValuePtr result =
-      std::make_shared<evaluator::ObjectValue>(cls, fields, loc);
+      allocateValue<evaluator::ObjectValue>(cls, fields, loc);
   return result;
 }
 
@@ -283,14 +312,10 @@ circt::om::Evaluator::instantiate(
     return symbolTable.getOp()->emitError("unknown class name ") << className;
 
   auto parameters =
-      std::make_unique<SmallVector<std::shared_ptr<evaluator::EvaluatorValue>>>(
-          actualParams);
-
-  actualParametersBuffers.push_back(std::move(parameters));
+      getActualParameters(className, llvm::to_vector(actualParams));
 
   auto loc = cls.getLoc();
-  auto result = evaluateObjectInstance(
-      className, actualParametersBuffers.back().get(), loc);
+  auto result = evaluateObjectInstance(className, parameters, loc);
 
   if (failed(result))
     return failure();
@@ -390,28 +415,193 @@ FailureOr<circt::om::evaluator::EvaluatorValuePtr>
 circt::om::Evaluator::evaluateConstant(ConstantOp op,
                                        ActualParameters actualParams,
                                        Location loc) {
-  return success(std::make_shared<circt::om::evaluator::AttributeValue>(
-      op.getValue(), loc));
+  return success(
+      allocateValue<circt::om::evaluator::AttributeValue>(op.getValue(), loc));
+}
+
+/// Return the value an actual parameter stands for, looking through evaluated
+/// references.
+static const evaluator::EvaluatorValue *
+getParameterValue(const evaluator::EvaluatorValue *value) {
+  if (auto *ref = dyn_cast<evaluator::ReferenceValue>(value)) {
+    if (!ref->isFullyEvaluated())
+      return value;
+    auto stripped = ref->getStrippedValue();
+    if (succeeded(stripped) && stripped.value())
+      return stripped.value().get();
+  }
+  return value;
+}
+
+/// Return true if an actual parameter can be compared by value. Objects have
+/// an identity, and values that are still being evaluated may change, so those
+/// are compared by pointer.
+static bool isComparedByValue(const evaluator::EvaluatorValue *value) {
+  using namespace evaluator;
+  value = getParameterValue(value);
+  if (!value->isFullyEvaluated())
+    return false;
+  auto elementsByValue = [](const auto &elements) {
+    return llvm::all_of(elements, [](const EvaluatorValuePtr &element) {
+      return element && isComparedByValue(element.get());
+    });
+  };
+  return TypeSwitch<const EvaluatorValue *, bool>(value)
+      .Case<AttributeValue, BasePathValue, PathValue>([](auto) { return true; })
+      .Case<ListValue, TupleValue>(
+          [&](auto *value) { return elementsByValue(value->getElements()); })
+      .Case([&](const MapValue *map) {
+        return elementsByValue(llvm::make_second_range(map->getElements()));
+      })
+      .Default([](auto) { return false; });
+}
+
+static llvm::hash_code hashParameter(const evaluator::EvaluatorValue *value) {
+  using namespace evaluator;
+  value = getParameterValue(value);
+  if (!isComparedByValue(value))
+    return llvm::hash_value(value);
+  auto hashElements = [](const auto &elements) {
+    SmallVector<llvm::hash_code> hashes;
+    for (auto &element : elements)
+      hashes.push_back(hashParameter(element.get()));
+    return llvm::hash_combine_range(hashes.begin(), hashes.end());
+  };
+  return TypeSwitch<const EvaluatorValue *, llvm::hash_code>(value)
+      .Case([](const AttributeValue *attr) {
+        return llvm::hash_value(attr->getAttr());
+      })
+      .Case([](const BasePathValue *path) {
+        return llvm::hash_value(path->getPath());
+      })
+      .Case([](const PathValue *path) {
+        return llvm::hash_combine(path->getTargetKind(), path->getPath(),
+                                  path->getModule(), path->getRef(),
+                                  path->getField());
+      })
+      .Case<ListValue, TupleValue>([&](auto *value) {
+        return llvm::hash_combine(value->getType(),
+                                  hashElements(value->getElements()));
+      })
+      .Case([](const MapValue *map) {
+        // The elements are unordered, so combine their hashes commutatively.
+        size_t hash = 0;
+        for (auto &[key, element] : map->getElements())
+          hash += llvm::hash_combine(key, hashParameter(element.get()));
+        return llvm::hash_combine(map->getType(), hash);
+      });
+}
+
+static bool isEqualParameter(const evaluator::EvaluatorValue *lhs,
+                             const evaluator::EvaluatorValue *rhs) {
+  using namespace evaluator;
+  lhs = getParameterValue(lhs);
+  rhs = getParameterValue(rhs);
+  if (lhs == rhs)
+    return true;
+  if (lhs->getKind() != rhs->getKind() || !isComparedByValue(lhs) ||
+      !isComparedByValue(rhs) || lhs->getType() != rhs->getType())
+    return false;
+  auto isEqualElements = [](const auto &elements, const auto &otherElements) {
+    return elements.size() == otherElements.size() &&
+           llvm::all_of(llvm::zip(elements, otherElements), [](auto pair) {
+             return isEqualParameter(std::get<0>(pair).get(),
+                                     std::get<1>(pair).get());
+           });
+  };
+  return TypeSwitch<const EvaluatorValue *, bool>(lhs)
+      .Case([&](const AttributeValue *attr) {
+        return attr->getAttr() == cast<AttributeValue>(rhs)->getAttr();
+      })
+      .Case([&](const BasePathValue *path) {
+        return path->getPath() == cast<BasePathValue>(rhs)->getPath();
+      })
+      .Case([&](const PathValue *path) {
+        auto *other = cast<PathValue>(rhs);
+        return path->getTargetKind() == other->getTargetKind() &&
+               path->getPath() == other->getPath() &&
+               path->getModule() == other->getModule() &&
+               path->getRef() == other->getRef() &&
+               path->getField() == other->getField();
+      })
+      .Case([&](const ListValue *list) {
+        return isEqualElements(list->getElements(),
+                               cast<ListValue>(rhs)->getElements());
+      })
+      .Case([&](const TupleValue *tuple) {
+        return isEqualElements(tuple->getElements(),
+                               cast<TupleValue>(rhs)->getElements());
+      })
+      .Case([&](const MapValue *map) {
+        auto &elements = map->getElements();
+        auto &otherElements = cast<MapValue>(rhs)->getElements();
+        return elements.size() == otherElements.size() &&
+               llvm::all_of(elements, [&](auto &element) {
+                 auto it = otherElements.find(element.first);
+                 return it != otherElements.end() &&
+                        isEqualParameter(element.second.get(),
+                                         it->second.get());
+               });
+      });
+}
+
+bool circt::om::Evaluator::InstanceKeyInfo::isEqual(const InstanceKey &lhs,
+                                                    const InstanceKey &rhs) {
+  if (lhs.className != rhs.className || lhs.hash != rhs.hash)
+    return false;
+  auto empty = DenseMapInfo<StringAttr>::getEmptyKey();
+  auto tombstone = DenseMapInfo<StringAttr>::getTombstoneKey();
+  if (lhs.className == empty || lhs.className == tombstone)
+    return true;
+  return lhs.params.size() == rhs.params.size() &&
+         llvm::all_of(llvm::zip(lhs.params, rhs.params), [](auto pair) {
+           return isEqualParameter(std::get<0>(pair).get(),
+                                   std::get<1>(pair).get());
+         });
+}
+
+circt::om::Evaluator::ActualParameters
+circt::om::Evaluator::getActualParameters(
+    StringAttr className, SmallVector<evaluator::EvaluatorValuePtr> params) {
+  auto allocate = [&]() -> ActualParameters {
+    return new (actualParametersAllocator.Allocate())
+        SmallVector<evaluator::EvaluatorValuePtr>(std::move(params));
+  };
+  if (!memoizeInstances || llvm::is_contained(params, nullptr))
+    return allocate();
+
+  // Key the parameters by value. Constants, lists and paths are created anew
+  // in each instantiation context, so equal ones must hit the same entry.
+  SmallVector<llvm::hash_code> hashes;
+  for (auto &param : params)
+    hashes.push_back(hashParameter(param.get()));
+  unsigned hash = llvm::hash_combine(
+      className, llvm::hash_combine_range(hashes.begin(), hashes.end()));
+
+  auto it = instances.find({className, params, hash});
+  if (it != instances.end())
+    return it->second;
+
+  auto *parameters = allocate();
+  instances.insert({{className, *parameters, hash}, parameters});
+  return parameters;
 }
 
 /// Evaluator dispatch function for Object instances.
 FailureOr<circt::om::Evaluator::ActualParameters>
 circt::om::Evaluator::createParametersFromOperands(
-    ValueRange range, ActualParameters actualParams, Location loc) {
-  // Create an unique storage to store parameters.
-  auto parameters = std::make_unique<
-      SmallVector<std::shared_ptr<evaluator::EvaluatorValue>>>();
-
+    StringAttr className, ValueRange range, ActualParameters actualParams,
+    Location loc) {
   // Collect operands' evaluator values in the current instantiation context.
+  SmallVector<evaluator::EvaluatorValuePtr> parameters;
   for (auto input : range) {
     auto inputResult = getOrCreateValue(input, actualParams, loc);
     if (failed(inputResult))
       return failure();
-    parameters->push_back(inputResult.value());
+    parameters.push_back(inputResult.value());
   }
 
-  actualParametersBuffers.push_back(std::move(parameters));
-  return actualParametersBuffers.back().get();
+  return getActualParameters(className, std::move(parameters));
 }
 
 /// Evaluator dispatch function for Object instances.
@@ -422,8 +612,8 @@ circt::om::Evaluator::evaluateObjectInstance(ObjectOp op,
   if (isFullyEvaluated({op, actualParams}))
     return getOrCreateValue(op, actualParams, loc);
 
-  auto params =
-      createParametersFromOperands(op.getOperands(), actualParams, loc);
+  auto params = createParametersFromOperands(
+      op.getClassNameAttr(), op.getOperands(), actualParams, loc);
   if (failed(params))
     return failure();
   return evaluateObjectInstance(op.getClassNameAttr(), params.value(), loc,
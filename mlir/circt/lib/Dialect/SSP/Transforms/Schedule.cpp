@@ -50,6 +50,20 @@ static std::optional<float> getCycleTime(StringRef options) {
   return std::nullopt;
 }
 
+// Determine the tableau storage for the simplex schedulers.
+static std::optional<SimplexTableauKind> getSimplexTableau(StringRef options) {
+  for (StringRef option : llvm::split(options, ',')) {
+    if (option.consume_front("tableau=")) {
+      if (option == "sparse")
+        return SimplexTableauKind::Sparse;
+      if (option == "dense")
+        return SimplexTableauKind::Dense;
+      return std::nullopt;
+    }
+  }
+  return SimplexTableauKind::Sparse;
+}
+
 //===----------------------------------------------------------------------===//
 // ASAP scheduler
 //===----------------------------------------------------------------------===//
@@ -76,10 +90,11 @@ static InstanceOp scheduleWithASAP(InstanceOp instOp, OpBuilder &builder) {
 template <typename ProblemT>
 static InstanceOp scheduleProblemTWithSimplex(InstanceOp instOp,
                                               Operation *lastOp,
+                                              SimplexTableauKind tableau,
                                               OpBuilder &builder) {
   auto prob = loadProblem<ProblemT>(instOp);
   if (failed(prob.check()) ||
-      failed(scheduling::scheduleSimplex(prob, lastOp)) ||
+      failed(scheduling::scheduleSimplex(prob, lastOp, tableau)) ||
       failed(prob.verify()))
     return {};
   return saveProblem(prob, builder);
@@ -88,10 +103,11 @@ static InstanceOp scheduleProblemTWithSimplex(InstanceOp instOp,
 static InstanceOp scheduleChainingProblemWithSimplex(InstanceOp instOp,
                                                      Operation *lastOp,
                                                      float cycleTime,
+                                                     SimplexTableauKind tableau,
                                                      OpBuilder &builder) {
   auto prob = loadProblem<scheduling::ChainingProblem>(instOp);
   if (failed(prob.check()) ||
-      failed(scheduling::scheduleSimplex(prob, lastOp, cycleTime)) ||
+      failed(scheduling::scheduleSimplex(prob, lastOp, cycleTime, tableau)) ||
       failed(prob.verify()))
     return {};
   return saveProblem(prob, builder);
@@ -108,20 +124,30 @@ static InstanceOp scheduleWithSimplex(InstanceOp instOp, StringRef options,
     return {};
   }
 
+  auto tableau = getSimplexTableau(options);
+  if (!tableau) {
+    llvm::errs() << "ssp-schedule: Unsupported value for option 'tableau' of "
+                    "simplex scheduler\n";
+    return {};
+  }
+
   auto problemName = instOp.getProblemName();
   if (problemName.equals("Problem"))
-    return scheduleProblemTWithSimplex<Problem>(instOp, lastOp, builder);
+    return scheduleProblemTWithSimplex<Problem>(instOp, lastOp, *tableau,
+                                                builder);
   if (problemName.equals("CyclicProblem"))
-    return scheduleProblemTWithSimplex<CyclicProblem>(instOp, lastOp, builder);
+    return scheduleProblemTWithSimplex<CyclicProblem>(instOp, lastOp, *tableau,
+                                                      builder);
   if (problemName.equals("SharedOperatorsProblem"))
-    return scheduleProblemTWithSimplex<SharedOperatorsProblem>(instOp, lastOp,
-                                                               builder);
+    return scheduleProblemTWithSimplex<SharedOperatorsProblem>(
+        instOp, lastOp, *tableau, builder);
   if (problemName.equals("ModuloProblem"))
-    return scheduleProblemTWithSimplex<ModuloProblem>(instOp, lastOp, builder);
+    return scheduleProblemTWithSimplex<ModuloProblem>(instOp, lastOp, *tableau,
+                                                      builder);
   if (problemName.equals("ChainingProblem")) {
     if (auto cycleTime = getCycleTime(options))
-      return scheduleChainingProblemWithSimplex(instOp, lastOp,
-                                                cycleTime.value(), builder);
+      return scheduleChainingProblemWithSimplex(
+          instOp, lastOp, cycleTime.value(), *tableau, builder);
     llvm::errs() << "ssp-schedule: Missing option 'cycle-time' for "
                     "ChainingProblem simplex scheduler\n";
     return {};
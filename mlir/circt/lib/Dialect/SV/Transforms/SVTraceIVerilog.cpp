@@ -68,6 +68,9 @@ void SVTraceIVerilogPass::runOnOperation() {
        << ");\n  #1;\nend\n";
     builder.create<sv::VerbatimOp>(hwmod.getLoc(), ss.str());
   }
+
+  // Only verbatim ops are added, so the instance graph is unchanged.
+  markAnalysesPreserved<InstanceGraph>();
 }
 
 std::unique_ptr<Pass> circt::sv::createSVTraceIVerilogPass() {
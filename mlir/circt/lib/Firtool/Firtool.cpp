@@ -94,7 +94,8 @@ LogicalResult firtool::populateCHIRRTLToLowFIRRTL(mlir::PassManager &pm,
                 "in firtool 1.58.0");
 
   if (!opt.noDedup)
-    pm.nest<firrtl::CircuitOp>().addPass(firrtl::createDedupPass());
+    pm.nest<firrtl::CircuitOp>().addPass(
+        firrtl::createDedupPass(opt.dedupFastHash));
 
   pm.nest<firrtl::CircuitOp>().addPass(firrtl::createWireDFTPass());
 
@@ -351,7 +352,9 @@ LogicalResult firtool::populateExportSplitVerilog(mlir::PassManager &pm,
   if (failed(::detail::populatePrepareForExportVerilog(pm, opt)))
     return failure();
 
-  pm.addPass(createExportSplitVerilogPass(directory));
+  pm.addPass(createExportSplitVerilogPass(
+      directory, opt.emissionCacheDirectory, opt.splitVerilogShardIndex,
+      opt.splitVerilogNumShards));
   return success();
 }
 
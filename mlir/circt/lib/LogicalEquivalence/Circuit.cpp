@@ -27,7 +27,9 @@ using namespace circt;
 void Solver::Circuit::addInput(Value value) {
   LLVM_DEBUG(lec::dbgs() << name << " addInput\n");
   lec::Scope indent;
+  bindCutPoint(value);
   z3::expr input = fetchOrAllocateExpr(value);
+  recordCutPoint(value, input);
   inputs.insert(inputs.end(), input);
 }
 
@@ -62,6 +64,36 @@ void Solver::Circuit::addInstance(llvm::StringRef instanceName,
   lec::Scope indent;
   LLVM_DEBUG(lec::dbgs() << "instance name: " << instanceName << "\n");
   LLVM_DEBUG(lec::dbgs() << "module name: " << op->getName() << "\n");
+
+  // An identical instance in the other circuit already computed the results.
+  if (useCutPoints && !results.empty() &&
+      llvm::all_of(results, [&](Value result) { return bindCutPoint(result); }))
+    return;
+
+  // Model the results of an abstracted module as uninterpreted functions of
+  // the arguments.
+  auto abstracted = solver.abstractedModules.find(op);
+  if (abstracted != solver.abstractedModules.end()) {
+    z3::expr_vector argExprs(solver.context);
+    z3::sort_vector domain(solver.context);
+    for (Value argument : arguments) {
+      z3::expr argExpr = fetchOrAllocateExpr(argument);
+      argExprs.push_back(argExpr);
+      domain.push_back(argExpr.get_sort());
+    }
+    for (auto [i, result] : llvm::enumerate(results)) {
+      std::string fnName = "abstract" + std::to_string(abstracted->second) +
+                           "_" + std::to_string(i);
+      z3::sort range =
+          solver.context.bv_sort(result.getType().getIntOrFloatBitWidth());
+      z3::expr output =
+          solver.context.function(fnName.c_str(), domain, range)(argExprs);
+      Value resultValue = result;
+      constrainResult(resultValue, output);
+    }
+    return;
+  }
+
   // There is no preventing multiple instances holding the same name.
   // As an hack, a suffix is used to differentiate them.
   std::string suffix = "_" + std::to_string(assignments);
@@ -91,6 +123,7 @@ void Solver::Circuit::addInstance(llvm::StringRef instanceName,
     for (circt::OpResult result : results) {
       z3::expr resultExpr = fetchOrAllocateExpr(result);
       solver.solver.add(resultExpr == *output++);
+      recordCutPoint(result, resultExpr);
     }
   }
 }
@@ -454,7 +487,10 @@ void Solver::Circuit::constrainResult(Value &result, z3::expr &expr) {
     lec::Scope indent;
     LLVM_DEBUG(lec::printExpr(expr));
   }
+  if (bindCutPoint(result))
+    return;
   z3::expr resExpr = fetchOrAllocateExpr(result);
+  recordCutPoint(result, resExpr);
   z3::expr constraint = resExpr == expr;
   {
     LLVM_DEBUG(lec::dbgs() << "adding constraint:\n");
@@ -464,6 +500,87 @@ void Solver::Circuit::constrainResult(Value &result, z3::expr &expr) {
   solver.solver.add(constraint);
 }
 
+/// Returns the cut point class of a value of the circuit's module, if it has
+/// one. Values are in the same class if they are computed by the same
+/// operations from the same inputs, so they are equivalent by construction.
+std::optional<unsigned> Solver::Circuit::getCutPointClass(Value value) {
+  if (!useCutPoints)
+    return std::nullopt;
+
+  // Classify all the values of the module in one go. Values used before they
+  // are defined, and everything computed from them, are left unclassified.
+  if (!cutPointClasses) {
+    cutPointClasses.emplace();
+    Block *body = value.getParentBlock();
+    for (auto arg : body->getArguments()) {
+      uintptr_t key[] = {0, arg.getArgNumber(),
+                         (uintptr_t)arg.getType().getAsOpaquePointer()};
+      (*cutPointClasses)[arg] = solver.getCutPointClass(key);
+    }
+    SmallVector<uintptr_t> key;
+    for (auto &op : *body) {
+      key.assign({1, (uintptr_t)op.getName().getAsOpaquePointer()});
+      // The names of an instance don't matter, but the instanced module does.
+      if (auto instance = dyn_cast<hw::InstanceOp>(op)) {
+        Operation *module = instance.getReferencedModuleSlow();
+        auto abstracted = solver.abstractedModules.find(module);
+        if (abstracted != solver.abstractedModules.end())
+          key.append({2, abstracted->second});
+        else
+          key.append({3, (uintptr_t)module});
+      } else {
+        key.push_back((uintptr_t)op.getAttrDictionary().getAsOpaquePointer());
+      }
+      bool complete = llvm::all_of(op.getOperands(), [&](Value operand) {
+        auto it = cutPointClasses->find(operand);
+        if (it == cutPointClasses->end())
+          return false;
+        key.push_back(it->second);
+        return true;
+      });
+      if (!complete)
+        continue;
+      for (auto result : op.getResults()) {
+        key.append({result.getResultNumber(),
+                    (uintptr_t)result.getType().getAsOpaquePointer()});
+        (*cutPointClasses)[result] = solver.getCutPointClass(key);
+        key.pop_back_n(2);
+      }
+    }
+  }
+
+  auto it = cutPointClasses->find(value);
+  if (it == cutPointClasses->end())
+    return std::nullopt;
+  return it->second;
+}
+
+/// Reuses the expression of an equivalent value allocated by either circuit.
+/// Returns true on success.
+bool Solver::Circuit::bindCutPoint(Value value) {
+  auto id = getCutPointClass(value);
+  if (!id)
+    return false;
+  auto cutPoint = solver.cutPointExprs.find(*id);
+  if (cutPoint == solver.cutPointExprs.end())
+    return false;
+  LLVM_DEBUG(lec::dbgs() << "reusing equivalent value:\n");
+  lec::Scope indent;
+  LLVM_DEBUG(lec::printExpr(cutPoint->second));
+  LLVM_DEBUG(lec::printValue(value));
+  auto [entry, inserted] = exprTable.insert({value, cutPoint->second});
+  // The value was used before its definition.
+  if (!inserted)
+    solver.solver.add(entry->second == cutPoint->second);
+  return true;
+}
+
+/// Records the expression of a value for equivalent values to reuse.
+void Solver::Circuit::recordCutPoint(Value value, const z3::expr &expr) {
+  if (auto id = getCutPointClass(value))
+    solver.cutPointExprs.insert({*id, expr});
+}
+
 /// Convert from bitvector to bool sort.
 z3::expr Solver::Circuit::bvToBool(const z3::expr &condition) {
   // bitvector is true if it's different from 0
@@ -0,0 +1,423 @@
+//===-- IncrementalChecker.cpp - Hierarchical equivalence checking --------===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+///
+/// This file defines a driver for the `circt-lec` tool which checks two module
+/// hierarchies for equivalence one pair of modules at a time.
+///
+//===----------------------------------------------------------------------===//
+
+#include "circt/LogicalEquivalence/IncrementalChecker.h"
+#include "circt/LogicalEquivalence/Circuit.h"
+#include "circt/LogicalEquivalence/LogicExporter.h"
+#include "circt/LogicalEquivalence/Solver.h"
+#include "circt/LogicalEquivalence/Utility.h"
+#include "mlir/IR/Threading.h"
+#include "llvm/ADT/StringExtras.h"
+#include "llvm/ADT/StringMap.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/SHA256.h"
+#include <optional>
+
+#define DEBUG_TYPE "lec-incremental"
+
+using namespace circt;
+using namespace mlir;
+
+using Abstractions = llvm::MapVector<Operation *, unsigned>;
+
+/// Returns whether two modules have the same input and output types.
+static bool haveSamePorts(hw::HWModuleOp m1, hw::HWModuleOp m2) {
+  Block *body1 = m1.getBodyBlock();
+  Block *body2 = m2.getBodyBlock();
+  return llvm::equal(body1->getArgumentTypes(), body2->getArgumentTypes()) &&
+         llvm::equal(body1->getTerminator()->getOperandTypes(),
+                     body2->getTerminator()->getOperandTypes());
+}
+
+static std::string hashString(StringRef str) {
+  llvm::SHA256 hasher;
+  hasher.update(str);
+  return llvm::toHex(hasher.final(), /*LowerCase=*/true);
+}
+
+/// Solve the equivalence problem between two modules, then present the results
+/// to the user.
+LogicalResult IncrementalChecker::solve(hw::HWModuleOp c1, hw::HWModuleOp c2) {
+  pairs.clear();
+  pairIndices.clear();
+
+  // Mismatching ports are reported by the solver.
+  if (haveSamePorts(c1, c2))
+    addPair(c1, c2);
+  else
+    pairs.push_back({{c1, c2}});
+
+  // The top-level pair is the only one at the highest level.
+  unsigned topLevel = pairs.front().level;
+  SmallVector<SmallVector<unsigned>> levels(topLevel + 1);
+  for (auto [i, pair] : llvm::enumerate(pairs))
+    levels[pair.level].push_back(i);
+
+  // The pairs which need a proof, along with the cache keys to record the
+  // proof under.
+  struct Task {
+    unsigned pair;
+    Abstractions abstractions;
+    std::string key;
+    std::string inlinedKey;
+    bool proven = false;
+    bool fellBack = false;
+  };
+
+  // Settle what can be settled without a solver, and return the remaining
+  // task.
+  auto prepare = [&](unsigned i) -> std::optional<Task> {
+    auto &pair = pairs[i];
+    if (getModuleHash(pair.modules[0]) == getModuleHash(pair.modules[1])) {
+      LLVM_DEBUG(lec::dbgs() << pair.modules[0].getModuleName() << " and "
+                             << pair.modules[1].getModuleName()
+                             << " are identical\n");
+      ++numIdentical;
+      addProof(pair.modules[0], pair.modules[1]);
+      return std::nullopt;
+    }
+    Task task{i, getAbstractions(pair)};
+    task.key = getPairKey(pair, task.abstractions);
+    task.inlinedKey =
+        task.abstractions.empty() ? task.key : getPairKey(pair, {});
+    if (cache.contains(task.key) || cache.contains(task.inlinedKey)) {
+      LLVM_DEBUG(lec::dbgs() << pair.modules[0].getModuleName() << " and "
+                             << pair.modules[1].getModuleName()
+                             << " were proven equivalent before\n");
+      ++numCached;
+      addProof(pair.modules[0], pair.modules[1]);
+      return std::nullopt;
+    }
+    return task;
+  };
+
+  auto record = [&](const Task &task) {
+    auto &pair = pairs[task.pair];
+    numFallbacks += task.fellBack;
+    if (!task.proven) {
+      ++numDifferent;
+      return;
+    }
+    ++numProven;
+    addProof(pair.modules[0], pair.modules[1]);
+    cache.insert(task.fellBack ? task.inlinedKey : task.key);
+  };
+
+  // Check the instanced modules bottom-up, so that the modules proven
+  // equivalent can be abstracted in the modules instantiating them.
+  for (unsigned level = 0; level < topLevel; ++level) {
+    SmallVector<Task> tasks;
+    for (unsigned i : levels[level])
+      if (auto task = prepare(i))
+        tasks.push_back(std::move(*task));
+
+    auto result = failableParallelForEach(context, tasks, [&](Task &task) {
+      lec::BufferedOutput output;
+      auto &pair = pairs[task.pair];
+      auto proven = checkPair(pair, task.abstractions);
+      // The abstraction may be too coarse.
+      if (succeeded(proven) && !*proven && !task.abstractions.empty()) {
+        task.fellBack = true;
+        proven = checkPair(pair, {});
+      }
+      if (failed(proven))
+        return failure();
+      task.proven = *proven;
+      return success();
+    });
+    if (failed(result))
+      return failure();
+
+    for (auto &task : tasks)
+      record(task);
+  }
+
+  // Check the top-level modules.
+  auto task = prepare(0);
+  if (task && !task->abstractions.empty()) {
+    auto proven = checkPair(pairs.front(), task->abstractions);
+    if (failed(proven))
+      return failure();
+    if (*proven) {
+      task->proven = true;
+      record(*task);
+      task.reset();
+    }
+  }
+
+  LogicalResult outcome = success();
+  if (!task) {
+    lec::outs() << "c1 == c2\n";
+  } else {
+    // Check the modules with all instances inlined, which also reports a
+    // counterexample if they are not equivalent.
+    hw::HWModuleOp m1 = pairs.front().modules[0];
+    hw::HWModuleOp m2 = pairs.front().modules[1];
+    Solver s(context, statisticsOpt);
+    s.enableCutPoints();
+    Solver::Circuit *circuit1 = s.addCircuit(m1.getModuleName());
+    Solver::Circuit *circuit2 = s.addCircuit(m2.getModuleName());
+    if (failed(LogicExporter(m1.getModuleName(), circuit1).run(m1)) ||
+        failed(LogicExporter(m2.getModuleName(), circuit2).run(m2)))
+      return failure();
+    outcome = s.solve();
+    task->proven = succeeded(outcome);
+    task->fellBack = !task->abstractions.empty();
+    record(*task);
+  }
+
+  if (statisticsOpt)
+    printStatistics();
+  return outcome;
+}
+
+/// Pair up two modules and, recursively, the modules they instantiate.
+/// Returns the index of the pair.
+unsigned IncrementalChecker::addPair(hw::HWModuleOp m1, hw::HWModuleOp m2) {
+  auto [it, inserted] = pairIndices.insert({{m1, m2}, pairs.size()});
+  unsigned index = it->second;
+  if (!inserted)
+    return index;
+  pairs.push_back({{m1, m2}});
+
+  // Pair up the instances with the same name and port types.
+  llvm::StringMap<hw::InstanceOp> instances;
+  for (auto instance : m2.getOps<hw::InstanceOp>())
+    instances[instance.getInstanceName()] = instance;
+  for (auto instance1 : m1.getOps<hw::InstanceOp>()) {
+    auto instance2 = instances.lookup(instance1.getInstanceName());
+    if (!instance2 ||
+        !llvm::equal(instance1->getOperandTypes(),
+                     instance2->getOperandTypes()) ||
+        !llvm::equal(instance1->getResultTypes(), instance2->getResultTypes()))
+      continue;
+    auto callee1 =
+        dyn_cast_or_null<hw::HWModuleOp>(instance1.getReferencedModuleSlow());
+    auto callee2 =
+        dyn_cast_or_null<hw::HWModuleOp>(instance2.getReferencedModuleSlow());
+    if (!callee1 || !callee2)
+      continue;
+    unsigned child = addPair(callee1, callee2);
+    pairs[index].children.push_back(child);
+    pairs[index].level = std::max(pairs[index].level, pairs[child].level + 1);
+  }
+  return index;
+}
+
+/// Pick the instanced modules to abstract when checking a pair, mapped to the
+/// identifier of their uninterpreted functions. A module is abstracted if it
+/// is known to be equivalent to a module instantiated on the other side.
+Abstractions IncrementalChecker::getAbstractions(const ModulePair &pair) {
+  SmallPtrSet<Operation *, 8> leaders[2];
+  for (unsigned side = 0; side < 2; ++side)
+    for (auto instance : pair.modules[side].getOps<hw::InstanceOp>()) {
+      auto leader =
+          equivalentModules.findLeader(instance.getReferencedModuleSlow());
+      if (leader != equivalentModules.member_end())
+        leaders[side].insert(*leader);
+    }
+
+  // Number the functions in order of appearance, for stable cache keys.
+  Abstractions abstractions;
+  DenseMap<Operation *, unsigned> ids;
+  for (unsigned side = 0; side < 2; ++side)
+    for (auto instance : pair.modules[side].getOps<hw::InstanceOp>()) {
+      Operation *callee = instance.getReferencedModuleSlow();
+      auto leader = equivalentModules.findLeader(callee);
+      if (leader == equivalentModules.member_end() ||
+          !leaders[0].contains(*leader) || !leaders[1].contains(*leader))
+        continue;
+      unsigned id = ids.insert({*leader, ids.size()}).first->second;
+      abstractions.insert({callee, id});
+    }
+  return abstractions;
+}
+
+/// Check a pair with a fresh solver. Returns true if the modules are
+/// equivalent.
+FailureOr<bool>
+IncrementalChecker::checkPair(const ModulePair &pair,
+                              const Abstractions &abstractions) {
+  hw::HWModuleOp m1 = pair.modules[0];
+  hw::HWModuleOp m2 = pair.modules[1];
+  LLVM_DEBUG(lec::dbgs() << "Checking " << m1.getModuleName() << " and "
+                         << m2.getModuleName() << " with "
+                         << abstractions.size() << " abstracted modules\n");
+  Solver s(context, /*statisticsOpt=*/false);
+  s.enableCutPoints();
+  for (auto [module, id] : abstractions)
+    s.abstractModule(module, id);
+  Solver::Circuit *circuit1 = s.addCircuit(m1.getModuleName());
+  Solver::Circuit *circuit2 = s.addCircuit(m2.getModuleName());
+  if (failed(LogicExporter(m1.getModuleName(), circuit1).run(m1)) ||
+      failed(LogicExporter(m2.getModuleName(), circuit2).run(m2)))
+    return failure();
+  // A solver timeout only means the pair isn't proven.
+  auto result = s.checkEquivalence();
+  return succeeded(result) && *result;
+}
+
+/// Return the structural hash of a module, including the modules it
+/// instantiates. Names don't contribute to the hash.
+StringRef IncrementalChecker::getModuleHash(hw::HWModuleOp module) {
+  auto it = moduleHashes.find(module);
+  if (it != moduleHashes.end())
+    return it->second;
+
+  std::string str;
+  llvm::raw_string_ostream os(str);
+  printModule(module, os, [&](hw::InstanceOp instance) {
+    auto callee =
+        dyn_cast_or_null<hw::HWModuleOp>(instance.getReferencedModuleSlow());
+    if (callee)
+      os << getModuleHash(callee);
+    else
+      os << "extern " << instance.getModuleName();
+  });
+  StringRef hash = saver.save(hashString(os.str()));
+  moduleHashes.insert({module, hash});
+  return hash;
+}
+
+/// Return the cache key of a pair checked with the given abstractions.
+std::string IncrementalChecker::getPairKey(const ModulePair &pair,
+                                           const Abstractions &abstractions) {
+  std::string str;
+  llvm::raw_string_ostream os(str);
+  for (auto module : pair.modules) {
+    printModule(module, os, [&](hw::InstanceOp instance) {
+      Operation *callee = instance.getReferencedModuleSlow();
+      auto it = abstractions.find(callee);
+      if (it != abstractions.end())
+        os << "abstract " << it->second;
+      else if (auto hwModule = dyn_cast_or_null<hw::HWModuleOp>(callee))
+        os << getModuleHash(hwModule);
+      else
+        os << "extern " << instance.getModuleName();
+    });
+    os << '\n';
+  }
+  return hashString(os.str());
+}
+
+/// Print the structure of a module for hashing. Values are numbered in order
+/// of definition. `printInstance` prints what an instance refers to.
+void IncrementalChecker::printModule(
+    hw::HWModuleOp module, llvm::raw_ostream &os,
+    llvm::function_ref<void(hw::InstanceOp)> printInstance) {
+  Block *body = module.getBodyBlock();
+  DenseMap<Value, unsigned> ids;
+  for (auto arg : body->getArguments())
+    ids.insert({arg, ids.size()});
+  for (auto &op : *body)
+    for (auto result : op.getResults())
+      ids.insert({result, ids.size()});
+
+  auto printType = [&](Type type) {
+    os << print(type.getAsOpaquePointer(),
+                [&](raw_ostream &typeOS) { type.print(typeOS); });
+  };
+
+  os << "(";
+  llvm::interleaveComma(body->getArgumentTypes(), os, printType);
+  os << ")\n";
+  for (auto &op : *body) {
+    os << op.getName() << ' ';
+    if (auto instance = dyn_cast<hw::InstanceOp>(op)) {
+      printInstance(instance);
+      auto params = instance.getParameters();
+      os << ' '
+         << print(params.getAsOpaquePointer(),
+                  [&](raw_ostream &attrOS) { params.print(attrOS); });
+    } else {
+      auto attrs = op.getAttrDictionary();
+      os << print(attrs.getAsOpaquePointer(),
+                  [&](raw_ostream &attrOS) { attrs.print(attrOS); });
+    }
+    os << " (";
+    llvm::interleaveComma(op.getOperands(), os,
+                          [&](Value operand) { os << ids.lookup(operand); });
+    os << ") : ";
+    llvm::interleaveComma(op.getResultTypes(), os, printType);
+    os << '\n';
+  }
+}
+
+/// Return the textual form of an attribute or type, for stable hashing.
+StringRef
+IncrementalChecker::print(const void *opaque,
+                          llvm::function_ref<void(raw_ostream &)> printFn) {
+  auto it = printed.find(opaque);
+  if (it != printed.end())
+    return it->second;
+  std::string str;
+  llvm::raw_string_ostream os(str);
+  printFn(os);
+  StringRef saved = saver.save(os.str());
+  printed.insert({opaque, saved});
+  return saved;
+}
+
+/// Record that two modules are equivalent.
+void IncrementalChecker::addProof(hw::HWModuleOp m1, hw::HWModuleOp m2) {
+  equivalentModules.unionSets(m1, m2);
+}
+
+/// Add the proofs stored in a cache file. A missing file is an empty cache.
+LogicalResult IncrementalChecker::loadCache(StringRef path) {
+  auto buffer = llvm::MemoryBuffer::getFile(path);
+  if (!buffer) {
+    if (buffer.getError() == std::errc::no_such_file_or_directory)
+      return success();
+    lec::errs() << "circt-lec error: cannot read cache " << path << ": "
+                << buffer.getError().message() << "\n";
+    return failure();
+  }
+  SmallVector<StringRef> keys;
+  (*buffer)->getBuffer().split(keys, '\n', /*MaxSplit=*/-1,
+                               /*KeepEmpty=*/false);
+  for (auto key : keys)
+    cache.insert(key.trim());
+  return success();
+}
+
+/// Store the loaded proofs and those made since in a cache file.
+LogicalResult IncrementalChecker::saveCache(StringRef path) {
+  SmallVector<StringRef> keys;
+  for (auto &entry : cache)
+    keys.push_back(entry.getKey());
+  llvm::sort(keys);
+  auto error = llvm::writeToOutput(path, [&](raw_ostream &os) {
+    for (auto key : keys)
+      os << key << '\n';
+    return llvm::Error::success();
+  });
+  if (error) {
+    lec::errs() << "circt-lec error: cannot write cache " << path << ": "
+                << llvm::toString(std::move(error)) << "\n";
+    return failure();
+  }
+  return success();
+}
+
+/// Print the statistics about the decomposition.
+void IncrementalChecker::printStatistics() {
+  lec::outs() << "Decomposition statistics:\n";
+  lec::Scope indent;
+  lec::outs() << "module pairs : " << pairs.size() << "\n";
+  lec::outs() << "identical : " << numIdentical << "\n";
+  lec::outs() << "cached : " << numCached << "\n";
+  lec::outs() << "proven : " << numProven << "\n";
+  lec::outs() << "inlined rechecks : " << numFallbacks << "\n";
+  lec::outs() << "not equivalent : " << numDifferent << "\n";
+}
@@ -27,6 +27,11 @@ Solver::Solver(MLIRContext *mlirCtx, bool statisticsOpt)
     : circuits{}, mlirCtx(mlirCtx), context(), solver(context),
       statisticsOpt(statisticsOpt) {}
 
+Solver::~Solver() {
+  delete circuits[0];
+  delete circuits[1];
+}
+
 /// Solve the equivalence problem between the two circuits, then present the
 /// results to the user.
 LogicalResult Solver::solve() {
@@ -61,6 +66,24 @@ LogicalResult Solver::solve() {
   return outcome;
 }
 
+/// Solve the equivalence problem between the two circuits without reporting
+/// anything. Returns true if they are equivalent and false if there is a
+/// counterexample.
+FailureOr<bool> Solver::checkEquivalence() {
+  if (constrainCircuits().failed())
+    return failure();
+
+  switch (solver.check()) {
+  case z3::unsat:
+    return true;
+  case z3::sat:
+    return false;
+  case z3::unknown:
+    break;
+  }
+  return failure();
+}
+
 /// Create a new circuit to be compared and return it.
 Solver::Circuit *Solver::addCircuit(llvm::StringRef name) {
   // NOLINTNEXTLINE
@@ -71,10 +94,20 @@ Solver::Circuit *Solver::addCircuit(llvm::StringRef name) {
   // To avoid that, they're differentiated by a prefix.
   unsigned n = circuits[0] ? 1 : 0;
   std::string prefix = n == 0 ? "c1@" : "c2@";
-  circuits[n] = new Solver::Circuit(prefix + name, *this);
+  circuits[n] = new Solver::Circuit(prefix + name, *this, cutPointsEnabled);
   return circuits[n];
 }
 
+/// Return the cut point class identified by `key`, creating it if needed.
+unsigned Solver::getCutPointClass(ArrayRef<uintptr_t> key) {
+  auto it = cutPointClasses.find(key);
+  if (it != cutPointClasses.end())
+    return it->second;
+  unsigned id = cutPointClasses.size();
+  cutPointClasses.insert({key.copy(cutPointKeyAllocator), id});
+  return id;
+}
+
 /// Prints a model satisfying the solved constraints.
 void Solver::printModel() {
   lec::outs() << "Model:\n";
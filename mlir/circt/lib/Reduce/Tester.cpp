@@ -12,12 +12,41 @@
 
 #include "circt/Reduce/Tester.h"
 #include "mlir/IR/Verifier.h"
+#include "llvm/Support/MD5.h"
 #include "llvm/Support/ToolOutputFile.h"
 
 using namespace llvm;
 using namespace mlir;
 using namespace circt;
 
+namespace {
+/// An output stream that forwards everything written to it to another stream,
+/// and computes a hash of it along the way.
+class HashingOStream : public raw_ostream {
+public:
+  HashingOStream(raw_ostream &os) : os(os) {}
+  ~HashingOStream() override { flush(); }
+
+  /// Return the hash of everything written to the stream.
+  std::pair<uint64_t, uint64_t> getHash() {
+    flush();
+    return hasher.result().words();
+  }
+
+private:
+  void write_impl(const char *ptr, size_t size) override {
+    hasher.update(StringRef(ptr, size));
+    os.write(ptr, size);
+    pos += size;
+  }
+  uint64_t current_pos() const override { return pos; }
+
+  raw_ostream &os;
+  MD5 hasher;
+  uint64_t pos = 0;
+};
+} // namespace
+
 //===----------------------------------------------------------------------===//
 // Tester
 //===----------------------------------------------------------------------===//
@@ -36,6 +65,28 @@ std::pair<bool, size_t> Tester::isInteresting(ModuleOp module) const {
 /// true if the interesting behavior is present in the test case or false
 /// otherwise.
 bool Tester::isInteresting(StringRef testCase) const {
+  return finishTest(startTest(testCase));
+}
+
+/// Run the tester on multiple test cases concurrently. All tests are started
+/// before waiting for any of them, such that writing the later test cases to
+/// disk overlaps with the earlier tests running.
+void Tester::runConcurrently(ArrayRef<TestCase *> testCases) const {
+  SmallVector<std::pair<TestCase *, sys::ProcessInfo>> runningTests;
+  for (auto *test : testCases) {
+    if (test->interesting || !test->isValid())
+      continue;
+    test->ensureFileOnDisk();
+    if (test->interesting)
+      continue;
+    runningTests.push_back({test, startTest(test->filepath)});
+  }
+  for (auto &[test, process] : runningTests)
+    test->setInteresting(finishTest(process));
+}
+
+/// Start the testing script on a test case file in a separate process.
+sys::ProcessInfo Tester::startTest(StringRef testCase) const {
   // Assemble the arguments to the tester. Note that the first one has to be the
   // name of the program.
   SmallVector<StringRef> testerArgs;
@@ -45,9 +96,22 @@ bool Tester::isInteresting(StringRef testCase) const {
 
   // Run the tester.
   std::string errMsg;
-  int result = llvm::sys::ExecuteAndWait(
-      testScript, testerArgs, /*Env=*/std::nullopt, /*Redirects=*/std::nullopt,
-      /*SecondsToWait=*/0, /*MemoryLimit=*/0, &errMsg);
+  bool executionFailed = false;
+  auto process = llvm::sys::ExecuteNoWait(
+      testScript, testerArgs, /*Env=*/std::nullopt, /*Redirects=*/{},
+      /*MemoryLimit=*/0, &errMsg, &executionFailed);
+  if (executionFailed)
+    llvm::report_fatal_error(
+        Twine("Error running interestingness test: ") + errMsg, false);
+  return process;
+}
+
+/// Wait for a test started with `startTest` to finish and return whether the
+/// test case is interesting.
+bool Tester::finishTest(const sys::ProcessInfo &process) const {
+  std::string errMsg;
+  int result = llvm::sys::Wait(process, /*SecondsToWait=*/std::nullopt, &errMsg)
+                   .ReturnCode;
   if (result < 0)
     llvm::report_fatal_error(
         Twine("Error running interestingness test: ") + errMsg, false);
@@ -109,10 +173,18 @@ bool TestCase::isInteresting() {
     return false;
   ensureFileOnDisk();
   if (!interesting)
-    interesting = tester.isInteresting(filepath);
+    setInteresting(tester.isInteresting(filepath));
   return *interesting;
 }
 
+/// Record the result of the tester, and remember it for any other test case
+/// with the same contents.
+void TestCase::setInteresting(bool result) {
+  interesting = result;
+  if (hash)
+    tester.testedHashes.try_emplace(*hash, result);
+}
+
 /// Ensure `filepath` and `size` are populated, and that the test case is in a
 /// file on disk.
 void TestCase::ensureFileOnDisk() {
@@ -129,9 +201,13 @@ void TestCase::ensureFileOnDisk() {
       llvm::report_fatal_error(
           Twine("Error making unique filename: ") + ec.message(), false);
 
-    // Write to the output.
+    // Write to the output, hashing the contents along the way.
     file = std::make_unique<llvm::ToolOutputFile>(filepath, fd);
-    module.print(file->os());
+    {
+      HashingOStream os(file->os());
+      module.print(os);
+      hash = os.getHash();
+    }
     file->os().close();
     if (file->os().has_error())
       llvm::report_fatal_error(llvm::Twine("Error emitting the IR to file `") +
@@ -140,6 +216,11 @@ void TestCase::ensureFileOnDisk() {
 
     // Update the file size.
     size = file->os().tell();
+
+    // Reuse the result of an earlier test case with the same contents.
+    auto it = tester.testedHashes.find(*hash);
+    if (it != tester.testedHashes.end())
+      interesting = it->second;
     return;
   }
 
@@ -16,12 +16,14 @@
 
 #include "mlir/IR/Operation.h"
 
+#include "llvm/ADT/BitVector.h"
 #include "llvm/ADT/DenseMap.h"
 #include "llvm/Support/Debug.h"
 #include "llvm/Support/Format.h"
 
 #include <algorithm>
 #include <limits>
+#include <memory>
 
 #define DEBUG_TYPE "simplex-schedulers"
 
@@ -33,6 +35,196 @@ using llvm::format;
 
 namespace {
 
+/// A row of the simplex tableau under construction. It is indexed like a dense
+/// vector, but remembers which columns were written, so that appending it to a
+/// sparse tableau doesn't need to look at every column.
+class TableauRow {
+public:
+  explicit TableauRow(unsigned nColumns)
+      : values(nColumns, 0), written(nColumns) {}
+
+  int &operator[](unsigned column) {
+    if (!written.test(column)) {
+      written.set(column);
+      columns.push_back(column);
+    }
+    return values[column];
+  }
+
+  /// Call `fn` with the non-zero entries in ascending column order, and clear
+  /// the row for reuse.
+  template <typename Fn>
+  void consume(Fn fn) {
+    llvm::sort(columns);
+    for (unsigned column : columns) {
+      if (values[column] != 0)
+        fn(column, values[column]);
+      values[column] = 0;
+      written.reset(column);
+    }
+    columns.clear();
+  }
+
+private:
+  SmallVector<int> values;
+  llvm::BitVector written;
+  SmallVector<unsigned> columns;
+};
+
+/// The storage for the explicitly stored part of the simplex tableau (see
+/// `SimplexSchedulerBase::tableau`).
+class SimplexTableau {
+public:
+  explicit SimplexTableau(unsigned nColumns) : nColumns(nColumns) {}
+  virtual ~SimplexTableau() = default;
+
+  unsigned getNumRows() const { return nRows; }
+  unsigned getNumColumns() const { return nColumns; }
+
+  /// Append a copy of \p row to the tableau, and clear \p row.
+  virtual void appendRow(TableauRow &row) = 0;
+
+  virtual int get(unsigned row, unsigned column) const = 0;
+  /// Add \p value to the entry at \p row and \p column.
+  virtual void add(unsigned row, unsigned column, int value) = 0;
+
+  /// Call \p fn with the column and value of every non-zero entry in \p row, in
+  /// ascending column order. \p fn must not modify the tableau.
+  virtual void
+  forEachInRow(unsigned row,
+               llvm::function_ref<void(unsigned column, int value)> fn) = 0;
+  /// Call \p fn with the row and value of every non-zero entry in \p column, in
+  /// no particular order. \p fn may modify the tableau.
+  virtual void
+  forEachInColumn(unsigned column,
+                  llvm::function_ref<void(unsigned row, int value)> fn) = 0;
+
+  virtual void multiplyRow(unsigned row, int factor) = 0;
+
+  /// Apply elementary row operations to make \p pivotColumn the unit vector
+  /// with a 1 in \p pivotRow, and then replace it with the column of the basic
+  /// variable associated with \p pivotRow, which is not stored explicitly.
+  virtual void pivot(unsigned pivotRow, unsigned pivotColumn) = 0;
+
+protected:
+  unsigned nRows = 0;
+  unsigned nColumns;
+};
+
+/// Stores every entry of the tableau. The memory and the time per pivot step
+/// grow with |deps| * |ops|.
+class DenseSimplexTableau : public SimplexTableau {
+public:
+  using SimplexTableau::SimplexTableau;
+
+  void appendRow(TableauRow &row) override;
+  int get(unsigned row, unsigned column) const override {
+    return tableau[row][column];
+  }
+  void add(unsigned row, unsigned column, int value) override {
+    tableau[row][column] += value;
+  }
+  void forEachInRow(
+      unsigned row,
+      llvm::function_ref<void(unsigned column, int value)> fn) override;
+  void forEachInColumn(
+      unsigned column,
+      llvm::function_ref<void(unsigned row, int value)> fn) override;
+  void multiplyRow(unsigned row, int factor) override;
+  void pivot(unsigned pivotRow, unsigned pivotColumn) override;
+
+private:
+  void addMultipleOfRow(unsigned sourceRow, int factor, unsigned targetRow);
+
+  SmallVector<SmallVector<int>> tableau;
+
+  /// During the pivot operation, one column in the elided part of the tableau
+  /// is modified; this vector temporarily catches the changes.
+  SmallVector<int> implicitBasicVariableColumnVector;
+};
+
+/// Stores only the non-zero entries of the tableau. The rows are kept sorted by
+/// column in one contiguous buffer, and each column knows which rows may have a
+/// non-zero entry in it. The constraint rows start out with at most four
+/// non-zero entries and stay sparse while pivoting, so a pivot step only
+/// touches the rows with a non-zero entry in the pivot column.
+class SparseSimplexTableau : public SimplexTableau {
+public:
+  explicit SparseSimplexTableau(unsigned nColumns)
+      : SimplexTableau(nColumns), columnRows(nColumns) {}
+
+  void appendRow(TableauRow &row) override;
+  int get(unsigned row, unsigned column) const override;
+  void add(unsigned row, unsigned column, int value) override;
+  void forEachInRow(
+      unsigned row,
+      llvm::function_ref<void(unsigned column, int value)> fn) override;
+  void forEachInColumn(
+      unsigned column,
+      llvm::function_ref<void(unsigned row, int value)> fn) override;
+  void multiplyRow(unsigned row, int factor) override;
+  void pivot(unsigned pivotRow, unsigned pivotColumn) override;
+
+private:
+  struct Entry {
+    unsigned column;
+    int value;
+  };
+
+  /// The entries of a row are `entries[begin, begin + size)`. The following
+  /// `capacity - size` entries are reserved for the row to grow into.
+  struct RowSlice {
+    unsigned begin;
+    unsigned size;
+    unsigned capacity;
+  };
+
+  ArrayRef<Entry> getRow(unsigned row) const {
+    auto &slice = rowSlices[row];
+    return ArrayRef<Entry>(entries.data() + slice.begin, slice.size);
+  }
+  MutableArrayRef<Entry> getRow(unsigned row) {
+    auto &slice = rowSlices[row];
+    return MutableArrayRef<Entry>(entries.data() + slice.begin, slice.size);
+  }
+
+  /// Replace the entries of \p row. \p newEntries must not point into
+  /// `entries`, as the row may have to be moved to the end of the buffer.
+  void setRow(unsigned row, ArrayRef<Entry> newEntries);
+
+  /// Fill `columnEntries` with the non-zero entries in \p column. Rows which
+  /// no longer have a non-zero entry in the column, and duplicates, are
+  /// dropped from `columnRows` along the way.
+  void collectColumn(unsigned column);
+
+  /// Move all rows to the front of the buffer, dropping the space left behind
+  /// by rows which had to be moved.
+  void compact();
+
+  /// The non-zero entries of all rows.
+  SmallVector<Entry> entries;
+  SmallVector<RowSlice> rowSlices;
+  /// The number of entries in `entries` which belong to no row.
+  size_t numDeadEntries = 0;
+
+  /// For each column, the rows which may have a non-zero entry in it. A row is
+  /// added when an entry becomes non-zero. Rows whose entry became zero again
+  /// are only removed in `collectColumn`.
+  SmallVector<SmallVector<unsigned, 4>> columnRows;
+
+  /// Scratch space for the pivot operation and column traversal.
+  SmallVector<Entry> newRowEntries;
+  SmallVector<Entry> pivotRowEntries;
+  SmallVector<std::pair<unsigned, int>> columnEntries;
+  /// Used to detect duplicates in `columnRows`.
+  SmallVector<unsigned> rowMarks;
+  unsigned currentMark = 0;
+};
+
+} // anonymous namespace
+
+namespace {
+
 /// This class provides a framework to model certain scheduling problems as
 /// lexico-parametric linear programs (LP), which are then solved with an
 /// extended version of the dual simplex algorithm.
@@ -85,11 +277,11 @@ protected:
   ///  firstNonBasicVariableColumn ^
   ///                              ─────────── ──────────
   ///                       nonBasicVariables   basicVariables
-  SmallVector<SmallVector<int>> tableau;
-
-  /// During the pivot operation, one column in the elided part of the tableau
-  /// is modified; this vector temporarily catches the changes.
-  SmallVector<int> implicitBasicVariableColumnVector;
+  ///
+  /// It is stored sparsely by default, which is what allows large problems to
+  /// be scheduled.
+  std::unique_ptr<SimplexTableau> tableau;
+  SimplexTableauKind tableauKind;
 
   /// The linear program models the operations' start times as variables, which
   /// we identify here as 0, ..., |ops|-1.
@@ -149,10 +341,9 @@ protected:
 
   virtual Problem &getProblem() = 0;
   virtual LogicalResult checkLastOp();
-  virtual bool fillObjectiveRow(SmallVector<int> &row, unsigned obj);
-  virtual void fillConstraintRow(SmallVector<int> &row,
-                                 Problem::Dependence dep);
-  virtual void fillAdditionalConstraintRow(SmallVector<int> &row,
+  virtual bool fillObjectiveRow(TableauRow &row, unsigned obj);
+  virtual void fillConstraintRow(TableauRow &row, Problem::Dependence dep);
+  virtual void fillAdditionalConstraintRow(TableauRow &row,
                                            Problem::Dependence dep);
   void buildTableau();
 
@@ -163,8 +354,6 @@ protected:
                                               bool allowPositive = false);
   std::optional<unsigned> findPrimalPivotColumn();
   std::optional<unsigned> findPrimalPivotRow(unsigned pivotColumn);
-  void multiplyRow(unsigned row, int factor);
-  void addMultipleOfRow(unsigned sourceRow, int factor, unsigned targetRow);
   void pivot(unsigned pivotRow, unsigned pivotColumn);
   LogicalResult solveTableau();
   LogicalResult restoreDualFeasibility();
@@ -178,7 +367,8 @@ protected:
   void dumpTableau();
 
 public:
-  explicit SimplexSchedulerBase(Operation *lastOp) : lastOp(lastOp) {}
+  SimplexSchedulerBase(Operation *lastOp, SimplexTableauKind tableauKind)
+      : lastOp(lastOp), tableauKind(tableauKind) {}
   virtual ~SimplexSchedulerBase() = default;
   virtual LogicalResult schedule() = 0;
 };
@@ -192,8 +382,9 @@ protected:
   Problem &getProblem() override { return prob; }
 
 public:
-  SimplexScheduler(Problem &prob, Operation *lastOp)
-      : SimplexSchedulerBase(lastOp), prob(prob) {}
+  SimplexScheduler(Problem &prob, Operation *lastOp,
+                   SimplexTableauKind tableauKind)
+      : SimplexSchedulerBase(lastOp, tableauKind), prob(prob) {}
 
   LogicalResult schedule() override;
 };
@@ -209,12 +400,12 @@ private:
 
 protected:
   Problem &getProblem() override { return prob; }
-  void fillConstraintRow(SmallVector<int> &row,
-                         Problem::Dependence dep) override;
+  void fillConstraintRow(TableauRow &row, Problem::Dependence dep) override;
 
 public:
-  CyclicSimplexScheduler(CyclicProblem &prob, Operation *lastOp)
-      : SimplexSchedulerBase(lastOp), prob(prob) {}
+  CyclicSimplexScheduler(CyclicProblem &prob, Operation *lastOp,
+                         SimplexTableauKind tableauKind)
+      : SimplexSchedulerBase(lastOp, tableauKind), prob(prob) {}
   LogicalResult schedule() override;
 };
 
@@ -229,8 +420,9 @@ protected:
 
 public:
   SharedOperatorsSimplexScheduler(SharedOperatorsProblem &prob,
-                                  Operation *lastOp)
-      : SimplexSchedulerBase(lastOp), prob(prob) {}
+                                  Operation *lastOp,
+                                  SimplexTableauKind tableauKind)
+      : SimplexSchedulerBase(lastOp, tableauKind), prob(prob) {}
   LogicalResult schedule() override;
 };
 
@@ -260,14 +452,16 @@ protected:
   Problem &getProblem() override { return prob; }
   LogicalResult checkLastOp() override;
   enum { OBJ_LATENCY = 0, OBJ_AXAP /* i.e. either ASAP or ALAP */ };
-  bool fillObjectiveRow(SmallVector<int> &row, unsigned obj) override;
+  bool fillObjectiveRow(TableauRow &row, unsigned obj) override;
   void updateMargins();
   void scheduleOperation(Operation *n);
   unsigned computeResMinII();
 
 public:
-  ModuloSimplexScheduler(ModuloProblem &prob, Operation *lastOp)
-      : CyclicSimplexScheduler(prob, lastOp), prob(prob), mrt(*this) {}
+  ModuloSimplexScheduler(ModuloProblem &prob, Operation *lastOp,
+                         SimplexTableauKind tableauKind)
+      : CyclicSimplexScheduler(prob, lastOp, tableauKind), prob(prob),
+        mrt(*this) {}
   LogicalResult schedule() override;
 };
 
@@ -280,18 +474,273 @@ private:
 
 protected:
   Problem &getProblem() override { return prob; }
-  void fillAdditionalConstraintRow(SmallVector<int> &row,
+  void fillAdditionalConstraintRow(TableauRow &row,
                                    Problem::Dependence dep) override;
 
 public:
   ChainingSimplexScheduler(ChainingProblem &prob, Operation *lastOp,
-                           float cycleTime)
-      : SimplexSchedulerBase(lastOp), prob(prob), cycleTime(cycleTime) {}
+                           float cycleTime, SimplexTableauKind tableauKind)
+      : SimplexSchedulerBase(lastOp, tableauKind), prob(prob),
+        cycleTime(cycleTime) {}
   LogicalResult schedule() override;
 };
 
 } // anonymous namespace
 
+//===----------------------------------------------------------------------===//
+// DenseSimplexTableau
+//===----------------------------------------------------------------------===//
+
+void DenseSimplexTableau::appendRow(TableauRow &row) {
+  auto &rowVec = tableau.emplace_back(nColumns, 0);
+  row.consume([&](unsigned column, int value) { rowVec[column] = value; });
+  implicitBasicVariableColumnVector.push_back(0);
+  ++nRows;
+}
+
+void DenseSimplexTableau::forEachInRow(
+    unsigned row, llvm::function_ref<void(unsigned column, int value)> fn) {
+  auto &rowVec = tableau[row];
+  for (unsigned col = 0; col < nColumns; ++col)
+    if (rowVec[col] != 0)
+      fn(col, rowVec[col]);
+}
+
+void DenseSimplexTableau::forEachInColumn(
+    unsigned column, llvm::function_ref<void(unsigned row, int value)> fn) {
+  for (unsigned row = 0; row < nRows; ++row)
+    if (int elem = tableau[row][column])
+      fn(row, elem);
+}
+
+void DenseSimplexTableau::multiplyRow(unsigned row, int factor) {
+  assert(factor != 0);
+  for (unsigned col = 0; col < nColumns; ++col)
+    tableau[row][col] *= factor;
+  // Also multiply the corresponding entry in the temporary column vector.
+  implicitBasicVariableColumnVector[row] *= factor;
+}
+
+void DenseSimplexTableau::addMultipleOfRow(unsigned sourceRow, int factor,
+                                           unsigned targetRow) {
+  assert(factor != 0 && sourceRow != targetRow);
+  for (unsigned col = 0; col < nColumns; ++col)
+    tableau[targetRow][col] += tableau[sourceRow][col] * factor;
+  // Again, perform row operation on the temporary column vector as well.
+  implicitBasicVariableColumnVector[targetRow] +=
+      implicitBasicVariableColumnVector[sourceRow] * factor;
+}
+
+void DenseSimplexTableau::pivot(unsigned pivotRow, unsigned pivotColumn) {
+  // The implicit columns are part of an identity matrix.
+  implicitBasicVariableColumnVector[pivotRow] = 1;
+
+  int pivotElem = tableau[pivotRow][pivotColumn];
+  // The constraint matrix has only {-1, 0, 1} entries by construction.
+  assert(pivotElem * pivotElem == 1);
+  // Make `tableau[pivotRow][pivotColumn]` := 1
+  multiplyRow(pivotRow, 1 / pivotElem);
+
+  for (unsigned row = 0; row < nRows; ++row) {
+    if (row == pivotRow)
+      continue;
+
+    int elem = tableau[row][pivotColumn];
+    if (elem == 0)
+      continue; // nothing to do
+
+    // Make `tableau[row][pivotColumn]` := 0.
+    addMultipleOfRow(pivotRow, -elem, row);
+  }
+
+  // Swap the pivot column with the implicitly constructed column vector.
+  // We really only need to copy in one direction here, as the former pivot
+  // column is a unit vector, which is not stored explicitly.
+  for (unsigned row = 0; row < nRows; ++row) {
+    tableau[row][pivotColumn] = implicitBasicVariableColumnVector[row];
+    implicitBasicVariableColumnVector[row] = 0; // Reset for next pivot step.
+  }
+}
+
+//===----------------------------------------------------------------------===//
+// SparseSimplexTableau
+//===----------------------------------------------------------------------===//
+
+void SparseSimplexTableau::appendRow(TableauRow &row) {
+  unsigned begin = entries.size();
+  row.consume([&](unsigned column, int value) {
+    entries.push_back({column, value});
+    columnRows[column].push_back(nRows);
+  });
+  unsigned size = entries.size() - begin;
+  rowSlices.push_back({begin, size, size});
+  rowMarks.push_back(0);
+  ++nRows;
+}
+
+int SparseSimplexTableau::get(unsigned row, unsigned column) const {
+  auto rowEntries = getRow(row);
+  auto *it = llvm::partition_point(
+      rowEntries, [&](const Entry &entry) { return entry.column < column; });
+  if (it != rowEntries.end() && it->column == column)
+    return it->value;
+  return 0;
+}
+
+void SparseSimplexTableau::add(unsigned row, unsigned column, int value) {
+  if (value == 0)
+    return;
+
+  auto rowEntries = getRow(row);
+  auto *it = llvm::partition_point(
+      rowEntries, [&](const Entry &entry) { return entry.column < column; });
+  if (it != rowEntries.end() && it->column == column) {
+    it->value += value;
+    if (it->value != 0)
+      return;
+    // The entry became zero; drop it.
+    newRowEntries.assign(rowEntries.begin(), it);
+    newRowEntries.append(it + 1, rowEntries.end());
+  } else {
+    newRowEntries.assign(rowEntries.begin(), it);
+    newRowEntries.push_back({column, value});
+    newRowEntries.append(it, rowEntries.end());
+    columnRows[column].push_back(row);
+  }
+  setRow(row, newRowEntries);
+}
+
+void SparseSimplexTableau::forEachInRow(
+    unsigned row, llvm::function_ref<void(unsigned column, int value)> fn) {
+  for (auto &entry : getRow(row))
+    fn(entry.column, entry.value);
+}
+
+void SparseSimplexTableau::forEachInColumn(
+    unsigned column, llvm::function_ref<void(unsigned row, int value)> fn) {
+  collectColumn(column);
+  // `fn` may modify the tableau, and thereby `columnEntries`.
+  SmallVector<std::pair<unsigned, int>> snapshot(columnEntries.begin(),
+                                                 columnEntries.end());
+  for (auto [row, value] : snapshot)
+    fn(row, value);
+}
+
+void SparseSimplexTableau::multiplyRow(unsigned row, int factor) {
+  assert(factor != 0);
+  for (auto &entry : getRow(row))
+    entry.value *= factor;
+}
+
+void SparseSimplexTableau::pivot(unsigned pivotRow, unsigned pivotColumn) {
+  int pivotElem = get(pivotRow, pivotColumn);
+  // The constraint matrix has only {-1, 0, 1} entries by construction.
+  assert(pivotElem * pivotElem == 1);
+  // Make the pivot element 1.
+  multiplyRow(pivotRow, 1 / pivotElem);
+
+  // Take a copy of the pivot row, as the buffer may be reallocated when other
+  // rows grow.
+  auto pivotRowRef = getRow(pivotRow);
+  pivotRowEntries.assign(pivotRowRef.begin(), pivotRowRef.end());
+
+  // Eliminate the pivot column from all other rows that have a non-zero entry
+  // in it. This also computes the column of the basic variable leaving the
+  // basis (the identity matrix column for the pivot row, multiplied by the same
+  // factors), which replaces the pivot column. Its entry is `factor *
+  // (1 / pivotElem)` in the rows we touch, and zero everywhere else.
+  collectColumn(pivotColumn);
+  for (auto [row, elem] : columnEntries) {
+    if (row == pivotRow)
+      continue;
+
+    int factor = -elem;
+    auto rowEntries = getRow(row);
+    newRowEntries.clear();
+    auto *target = rowEntries.begin(), *targetEnd = rowEntries.end();
+    auto *source = pivotRowEntries.begin(), *sourceEnd = pivotRowEntries.end();
+    while (target != targetEnd || source != sourceEnd) {
+      if (source == sourceEnd ||
+          (target != targetEnd && target->column < source->column)) {
+        newRowEntries.push_back(*target++);
+        continue;
+      }
+      if (target == targetEnd || source->column < target->column) {
+        // A new non-zero entry.
+        newRowEntries.push_back({source->column, source->value * factor});
+        columnRows[source->column].push_back(row);
+        ++source;
+        continue;
+      }
+      int value = source->column == pivotColumn
+                      ? factor * pivotElem
+                      : target->value + source->value * factor;
+      if (value != 0)
+        newRowEntries.push_back({source->column, value});
+      ++target;
+      ++source;
+    }
+    setRow(row, newRowEntries);
+  }
+
+  // Finally, the pivot row's entry of the new column.
+  for (auto &entry : getRow(pivotRow))
+    if (entry.column == pivotColumn)
+      entry.value = pivotElem;
+
+  if (numDeadEntries > entries.size() / 2)
+    compact();
+}
+
+void SparseSimplexTableau::setRow(unsigned row, ArrayRef<Entry> newEntries) {
+  auto &slice = rowSlices[row];
+  if (newEntries.size() > slice.capacity) {
+    // Move the row to the end of the buffer, leaving some room to grow.
+    numDeadEntries += slice.capacity;
+    slice.begin = entries.size();
+    slice.capacity = std::max<unsigned>(2 * newEntries.size(), 4);
+    entries.resize(entries.size() + slice.capacity);
+  }
+  slice.size = newEntries.size();
+  llvm::copy(newEntries, entries.begin() + slice.begin);
+}
+
+void SparseSimplexTableau::collectColumn(unsigned column) {
+  if (++currentMark == 0) {
+    // Start over once the marks wrap around.
+    std::fill(rowMarks.begin(), rowMarks.end(), 0);
+    currentMark = 1;
+  }
+
+  columnEntries.clear();
+  auto &rows = columnRows[column];
+  unsigned numLive = 0;
+  for (unsigned row : rows) {
+    if (rowMarks[row] == currentMark)
+      continue;
+    int value = get(row, column);
+    if (value == 0)
+      continue;
+    rowMarks[row] = currentMark;
+    rows[numLive++] = row;
+    columnEntries.push_back({row, value});
+  }
+  rows.truncate(numLive);
+}
+
+void SparseSimplexTableau::compact() {
+  SmallVector<Entry> compacted;
+  compacted.reserve(entries.size() - numDeadEntries);
+  for (auto &slice : rowSlices) {
+    unsigned begin = compacted.size();
+    compacted.append(entries.begin() + slice.begin,
+                     entries.begin() + slice.begin + slice.capacity);
+    slice.begin = begin;
+  }
+  entries = std::move(compacted);
+  numDeadEntries = 0;
+}
+
 //===----------------------------------------------------------------------===//
 // SimplexSchedulerBase
 //===----------------------------------------------------------------------===//
@@ -304,15 +753,14 @@ LogicalResult SimplexSchedulerBase::checkLastOp() {
   return success();
 }
 
-bool SimplexSchedulerBase::fillObjectiveRow(SmallVector<int> &row,
-                                            unsigned obj) {
+bool SimplexSchedulerBase::fillObjectiveRow(TableauRow &row, unsigned obj) {
   assert(obj == 0);
   // Minimize start time of user-specified last operation.
   row[startTimeLocations[startTimeVariables[lastOp]]] = 1;
   return false;
 }
 
-void SimplexSchedulerBase::fillConstraintRow(SmallVector<int> &row,
+void SimplexSchedulerBase::fillConstraintRow(TableauRow &row,
                                              Problem::Dependence dep) {
   auto &prob = getProblem();
   Operation *src = dep.getSource();
@@ -326,7 +774,7 @@ void SimplexSchedulerBase::fillConstraintRow(SmallVector<int> &row,
 }
 
 void SimplexSchedulerBase::fillAdditionalConstraintRow(
-    SmallVector<int> &row, Problem::Dependence dep) {
+    TableauRow &row, Problem::Dependence dep) {
   // Handling is subclass-specific, so do nothing by default.
   (void)row;
   (void)dep;
@@ -351,54 +799,56 @@ void SimplexSchedulerBase::buildTableau() {
   // one column for each parameter (1,S,T), and for all operations
   nColumns = nParameters + nonBasicVariables.size();
 
-  // Helper to grow both the tableau and the implicit column vector.
-  auto addRow = [&]() -> SmallVector<int> & {
-    implicitBasicVariableColumnVector.push_back(0);
-    return tableau.emplace_back(nColumns, 0);
-  };
+  if (tableauKind == SimplexTableauKind::Dense)
+    tableau = std::make_unique<DenseSimplexTableau>(nColumns);
+  else
+    tableau = std::make_unique<SparseSimplexTableau>(nColumns);
+
+  // The rows are filled in one at a time and then copied into the tableau.
+  TableauRow rowVec(nColumns);
 
   // Set up the objective rows.
   nObjectives = 0;
   bool hasMoreObjectives;
   do {
-    auto &objRowVec = addRow();
-    hasMoreObjectives = fillObjectiveRow(objRowVec, nObjectives);
+    hasMoreObjectives = fillObjectiveRow(rowVec, nObjectives);
+    tableau->appendRow(rowVec);
     ++nObjectives;
   } while (hasMoreObjectives);
 
   // Now set up rows/constraints for the dependences.
   for (auto *op : prob.getOperations()) {
     for (auto &dep : prob.getDependences(op)) {
-      auto &consRowVec = addRow();
-      fillConstraintRow(consRowVec, dep);
+      fillConstraintRow(rowVec, dep);
+      tableau->appendRow(rowVec);
       basicVariables.push_back(var);
       ++var;
     }
   }
   for (auto &dep : additionalConstraints) {
-    auto &consRowVec = addRow();
-    fillAdditionalConstraintRow(consRowVec, dep);
+    fillAdditionalConstraintRow(rowVec, dep);
+    tableau->appendRow(rowVec);
     basicVariables.push_back(var);
     ++var;
   }
 
   // one row per objective + one row per dependence
-  nRows = tableau.size();
+  nRows = tableau->getNumRows();
 }
 
 int SimplexSchedulerBase::getParametricConstant(unsigned row) {
-  auto &rowVec = tableau[row];
   // Compute the dot-product ~B[row] * u between the constant matrix and the
   // parameter vector.
-  return rowVec[parameter1Column] + rowVec[parameterSColumn] * parameterS +
-         rowVec[parameterTColumn] * parameterT;
+  return tableau->get(row, parameter1Column) +
+         tableau->get(row, parameterSColumn) * parameterS +
+         tableau->get(row, parameterTColumn) * parameterT;
 }
 
 SmallVector<int> SimplexSchedulerBase::getObjectiveVector(unsigned column) {
   SmallVector<int> objVec;
   // Extract the column vector C^T[column] from the cost matrix.
   for (unsigned obj = 0; obj < nObjectives; ++obj)
-    objVec.push_back(tableau[obj][column]);
+    objVec.push_back(tableau->get(obj, column));
   return objVec;
 }
 
@@ -415,18 +865,19 @@ std::optional<unsigned>
 SimplexSchedulerBase::findDualPivotColumn(unsigned pivotRow,
                                           bool allowPositive) {
   SmallVector<int> maxQuot(nObjectives, std::numeric_limits<int>::min());
+  SmallVector<int> quot;
   std::optional<unsigned> pivotCol;
 
   // Look for non-zero entries in the constraint matrix (~A part of the
   // tableau). If multiple candidates exist, take the one corresponding to the
   // lexicographical maximum (over the objective rows) of the quotients:
   //   tableau[<objective row>][col] / pivotCand
-  for (unsigned col = firstNonBasicVariableColumn; col < nColumns; ++col) {
-    if (frozenVariables.count(
+  tableau->forEachInRow(pivotRow, [&](unsigned col, int pivotCand) {
+    if (col < firstNonBasicVariableColumn ||
+        frozenVariables.count(
             nonBasicVariables[col - firstNonBasicVariableColumn]))
-      continue;
+      return;
 
-    int pivotCand = tableau[pivotRow][col];
     // Only negative candidates bring us closer to the optimal solution.
     // However, when freezing variables to a certain value, we accept that the
     // value of the objective function degrades.
@@ -434,9 +885,9 @@ SimplexSchedulerBase::findDualPivotColumn(unsigned pivotRow,
       // The constraint matrix has only {-1, 0, 1} entries by construction.
       assert(pivotCand * pivotCand == 1);
 
-      SmallVector<int> quot;
+      quot.clear();
       for (unsigned obj = 0; obj < nObjectives; ++obj)
-        quot.push_back(tableau[obj][col] / pivotCand);
+        quot.push_back(tableau->get(obj, col) / pivotCand);
 
       if (std::lexicographical_compare(maxQuot.begin(), maxQuot.end(),
                                        quot.begin(), quot.end())) {
@@ -444,15 +895,27 @@ SimplexSchedulerBase::findDualPivotColumn(unsigned pivotRow,
         pivotCol = col;
       }
     }
-  }
+  });
 
   return pivotCol;
 }
 
 std::optional<unsigned> SimplexSchedulerBase::findPrimalPivotColumn() {
+  // Only columns with a non-zero entry in the cost matrix can be
+  // lexico-negative.
+  SmallVector<unsigned> candidates;
+  for (unsigned obj = 0; obj < nObjectives; ++obj)
+    tableau->forEachInRow(obj, [&](unsigned col, int) {
+      if (col >= firstNonBasicVariableColumn)
+        candidates.push_back(col);
+    });
+  llvm::sort(candidates);
+  candidates.erase(std::unique(candidates.begin(), candidates.end()),
+                   candidates.end());
+
   // Find the first lexico-negative column in the cost matrix.
   SmallVector<int> zeroVec(nObjectives, 0);
-  for (unsigned col = firstNonBasicVariableColumn; col < nColumns; ++col) {
+  for (unsigned col : candidates) {
     if (frozenVariables.count(
             nonBasicVariables[col - firstNonBasicVariableColumn]))
       continue;
@@ -475,74 +938,30 @@ SimplexSchedulerBase::findPrimalPivotRow(unsigned pivotColumn) {
   // tableau). If multiple candidates exist, take the one corresponding to the
   // minimum of the quotient:
   //   parametricConstant(row) / pivotCand
-  for (unsigned row = firstConstraintRow; row < nRows; ++row) {
-    int pivotCand = tableau[row][pivotColumn];
-    if (pivotCand > 0) {
-      // The constraint matrix has only {-1, 0, 1} entries by construction.
-      assert(pivotCand == 1);
-      int quot = getParametricConstant(row) / pivotCand;
-      if (quot < minQuot) {
-        minQuot = quot;
-        pivotRow = row;
-      }
+  // The entries are visited in no particular order, so break ties in favor of
+  // the first row.
+  tableau->forEachInColumn(pivotColumn, [&](unsigned row, int pivotCand) {
+    if (row < firstConstraintRow || pivotCand <= 0)
+      return;
+    // The constraint matrix has only {-1, 0, 1} entries by construction.
+    assert(pivotCand == 1);
+    int quot = getParametricConstant(row) / pivotCand;
+    if (quot < minQuot || (pivotRow && quot == minQuot && row < *pivotRow)) {
+      minQuot = quot;
+      pivotRow = row;
     }
-  }
+  });
 
   return pivotRow;
 }
 
-void SimplexSchedulerBase::multiplyRow(unsigned row, int factor) {
-  assert(factor != 0);
-  for (unsigned col = 0; col < nColumns; ++col)
-    tableau[row][col] *= factor;
-  // Also multiply the corresponding entry in the temporary column vector.
-  implicitBasicVariableColumnVector[row] *= factor;
-}
-
-void SimplexSchedulerBase::addMultipleOfRow(unsigned sourceRow, int factor,
-                                            unsigned targetRow) {
-  assert(factor != 0 && sourceRow != targetRow);
-  for (unsigned col = 0; col < nColumns; ++col)
-    tableau[targetRow][col] += tableau[sourceRow][col] * factor;
-  // Again, perform row operation on the temporary column vector as well.
-  implicitBasicVariableColumnVector[targetRow] +=
-      implicitBasicVariableColumnVector[sourceRow] * factor;
-}
-
 /// The pivot operation applies elementary row operations to the tableau in
 /// order to make the \p pivotColumn (corresponding to a non-basic variable) a
 /// unit vector (only the \p pivotRow'th entry is 1). Then, a basis exchange is
 /// performed: the non-basic variable is swapped with the basic variable
 /// associated with the pivot row.
 void SimplexSchedulerBase::pivot(unsigned pivotRow, unsigned pivotColumn) {
-  // The implicit columns are part of an identity matrix.
-  implicitBasicVariableColumnVector[pivotRow] = 1;
-
-  int pivotElem = tableau[pivotRow][pivotColumn];
-  // The constraint matrix has only {-1, 0, 1} entries by construction.
-  assert(pivotElem * pivotElem == 1);
-  // Make `tableau[pivotRow][pivotColumn]` := 1
-  multiplyRow(pivotRow, 1 / pivotElem);
-
-  for (unsigned row = 0; row < nRows; ++row) {
-    if (row == pivotRow)
-      continue;
-
-    int elem = tableau[row][pivotColumn];
-    if (elem == 0)
-      continue; // nothing to do
-
-    // Make `tableau[row][pivotColumn]` := 0.
-    addMultipleOfRow(pivotRow, -elem, row);
-  }
-
-  // Swap the pivot column with the implicitly constructed column vector.
-  // We really only need to copy in one direction here, as the former pivot
-  // column is a unit vector, which is not stored explicitly.
-  for (unsigned row = 0; row < nRows; ++row) {
-    tableau[row][pivotColumn] = implicitBasicVariableColumnVector[row];
-    implicitBasicVariableColumnVector[row] = 0; // Reset for next pivot step.
-  }
+  tableau->pivot(pivotRow, pivotColumn);
 
   // Look up numeric IDs of variables involved in this pivot operation.
   unsigned &nonBasicVar =
@@ -574,8 +993,8 @@ LogicalResult SimplexSchedulerBase::solveTableau() {
     // positive entries, and the problem is in principle infeasible. However, if
     // the entry in the `parameterTColumn` is positive, we can try to make the
     // LP feasible again by increasing the II.
-    int entry1Col = tableau[*pivotRow][parameter1Column];
-    int entryTCol = tableau[*pivotRow][parameterTColumn];
+    int entry1Col = tableau->get(*pivotRow, parameter1Column);
+    int entryTCol = tableau->get(*pivotRow, parameterTColumn);
     if (entryTCol > 0) {
       // The negation of `entry1Col` is not in the paper. I think this is an
       // oversight, because `entry1Col` certainly is negative (otherwise the row
@@ -657,16 +1076,11 @@ unsigned SimplexSchedulerBase::freeze(unsigned startTimeVariable,
 
 void SimplexSchedulerBase::translate(unsigned column, int factor1, int factorS,
                                      int factorT) {
-  for (unsigned row = 0; row < nRows; ++row) {
-    auto &rowVec = tableau[row];
-    int elem = rowVec[column];
-    if (elem == 0)
-      continue;
-
-    rowVec[parameter1Column] += -elem * factor1;
-    rowVec[parameterSColumn] += -elem * factorS;
-    rowVec[parameterTColumn] += -elem * factorT;
-  }
+  tableau->forEachInColumn(column, [&](unsigned row, int elem) {
+    tableau->add(row, parameter1Column, -elem * factor1);
+    tableau->add(row, parameterSColumn, -elem * factorS);
+    tableau->add(row, parameterTColumn, -elem * factorT);
+  });
 }
 
 LogicalResult SimplexSchedulerBase::scheduleAt(unsigned startTimeVariable,
@@ -764,7 +1178,7 @@ void SimplexSchedulerBase::dumpTableau() {
     for (unsigned j = 0; j < nColumns; ++j) {
       if (j == firstNonBasicVariableColumn)
         dbgs() << " |";
-      dbgs() << format(" %3d", tableau[i][j]);
+      dbgs() << format(" %3d", tableau->get(i, j));
     }
     if (i >= firstConstraintRow)
       dbgs() << format(" |< %2d", basicVariables[i - firstConstraintRow]);
@@ -813,7 +1227,7 @@ LogicalResult SimplexScheduler::schedule() {
 // CyclicSimplexScheduler
 //===----------------------------------------------------------------------===//
 
-void CyclicSimplexScheduler::fillConstraintRow(SmallVector<int> &row,
+void CyclicSimplexScheduler::fillConstraintRow(TableauRow &row,
                                                Problem::Dependence dep) {
   SimplexSchedulerBase::fillConstraintRow(row, dep);
   if (auto dist = prob.getDistance(dep))
@@ -995,8 +1409,7 @@ void ModuloSimplexScheduler::MRT::release(Operation *op) {
   revTab.erase(it);
 }
 
-bool ModuloSimplexScheduler::fillObjectiveRow(SmallVector<int> &row,
-                                              unsigned obj) {
+bool ModuloSimplexScheduler::fillObjectiveRow(TableauRow &row, unsigned obj) {
   switch (obj) {
   case OBJ_LATENCY:
     // Minimize start time of user-specified last operation.
@@ -1020,7 +1433,7 @@ void ModuloSimplexScheduler::updateMargins() {
   // negate it again to restore the "ASAP" objective, and store these times as
   // well.
   for (auto *axapTimes : {&alapTimes, &asapTimes}) {
-    multiplyRow(OBJ_AXAP, -1);
+    tableau->multiplyRow(OBJ_AXAP, -1);
     // This should not fail for a feasible tableau.
     auto dualFeasRestored = restoreDualFeasibility();
     auto solved = solveTableau();
@@ -1217,7 +1630,7 @@ LogicalResult ModuloSimplexScheduler::schedule() {
 //===----------------------------------------------------------------------===//
 
 void ChainingSimplexScheduler::fillAdditionalConstraintRow(
-    SmallVector<int> &row, Problem::Dependence dep) {
+    TableauRow &row, Problem::Dependence dep) {
   fillConstraintRow(row, dep);
   // One _extra_ time step breaks the chain (note that the latency is negative
   // in the tableau).
@@ -1258,31 +1671,36 @@ LogicalResult ChainingSimplexScheduler::schedule() {
 // Public API
 //===----------------------------------------------------------------------===//
 
-LogicalResult scheduling::scheduleSimplex(Problem &prob, Operation *lastOp) {
-  SimplexScheduler simplex(prob, lastOp);
+LogicalResult scheduling::scheduleSimplex(Problem &prob, Operation *lastOp,
+                                          SimplexTableauKind tableau) {
+  SimplexScheduler simplex(prob, lastOp, tableau);
   return simplex.schedule();
 }
 
 LogicalResult scheduling::scheduleSimplex(CyclicProblem &prob,
-                                          Operation *lastOp) {
-  CyclicSimplexScheduler simplex(prob, lastOp);
+                                          Operation *lastOp,
+                                          SimplexTableauKind tableau) {
+  CyclicSimplexScheduler simplex(prob, lastOp, tableau);
   return simplex.schedule();
 }
 
 LogicalResult scheduling::scheduleSimplex(SharedOperatorsProblem &prob,
-                                          Operation *lastOp) {
-  SharedOperatorsSimplexScheduler simplex(prob, lastOp);
+                                          Operation *lastOp,
+                                          SimplexTableauKind tableau) {
+  SharedOperatorsSimplexScheduler simplex(prob, lastOp, tableau);
   return simplex.schedule();
 }
 
 LogicalResult scheduling::scheduleSimplex(ModuloProblem &prob,
-                                          Operation *lastOp) {
-  ModuloSimplexScheduler simplex(prob, lastOp);
+                                          Operation *lastOp,
+                                          SimplexTableauKind tableau) {
+  ModuloSimplexScheduler simplex(prob, lastOp, tableau);
   return simplex.schedule();
 }
 
 LogicalResult scheduling::scheduleSimplex(ChainingProblem &prob,
-                                          Operation *lastOp, float cycleTime) {
-  ChainingSimplexScheduler simplex(prob, lastOp, cycleTime);
+                                          Operation *lastOp, float cycleTime,
+                                          SimplexTableauKind tableau) {
+  ChainingSimplexScheduler simplex(prob, lastOp, cycleTime, tableau);
   return simplex.schedule();
 }
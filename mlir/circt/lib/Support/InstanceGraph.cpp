@@ -9,6 +9,7 @@
 #include "circt/Support/InstanceGraph.h"
 #include "mlir/IR/BuiltinOps.h"
 #include "mlir/IR/Threading.h"
+#include "llvm/ADT/PostOrderIterator.h"
 
 using namespace circt;
 using namespace igraph;
@@ -22,12 +23,19 @@ void InstanceRecord::erase() {
   // Update the next node to point to the prev node.
   if (nextUse)
     nextUse->prevUse = prevUse;
-  getParent()->instances.erase(this);
+  auto *graph = getParent()->graph;
+  graph->invalidateOrders();
+  getParent()->instances.remove(this);
+  this->~InstanceRecord();
+  graph->freeRecords.push_back(this);
 }
 
 InstanceRecord *InstanceGraphNode::addInstance(InstanceOpInterface instance,
                                                InstanceGraphNode *target) {
-  auto *instanceRecord = new InstanceRecord(this, instance, target);
+  auto *instanceRecord =
+      new (graph->allocate<InstanceRecord>(graph->freeRecords))
+          InstanceRecord(this, instance, target);
+  graph->invalidateOrders();
   target->recordUse(instanceRecord);
   instances.push_back(instanceRecord);
   return instanceRecord;
@@ -45,12 +53,17 @@ InstanceGraphNode *InstanceGraph::getOrAddNode(StringAttr name) {
   // an iterator pointing to the node.
   auto *&node = nodeMap[name];
   if (!node) {
-    node = new InstanceGraphNode();
+    node = createNode();
     nodes.push_back(node);
   }
   return node;
 }
 
+InstanceGraphNode *InstanceGraph::createNode() {
+  invalidateOrders();
+  return new (allocate<InstanceGraphNode>(freeNodes)) InstanceGraphNode(this);
+}
+
 InstanceGraph::InstanceGraph(Operation *parent) : parent(parent) {
   assert(parent->hasTrait<mlir::OpTrait::SingleBlock>() &&
          "top-level operation must have a single block");
@@ -60,6 +73,7 @@ InstanceGraph::InstanceGraph(Operation *parent) : parent(parent) {
   for (auto module :
        parent->getRegion(0).front().getOps<igraph::ModuleOpInterface>())
     moduleToInstances.push_back({module, {}});
+  nodeMap.reserve(moduleToInstances.size());
 
   // Populate instances in the module parallelly.
   mlir::parallelFor(parent->getContext(), 0, moduleToInstances.size(),
@@ -72,7 +86,8 @@ InstanceGraph::InstanceGraph(Operation *parent) : parent(parent) {
                       });
                     });
 
-  // Construct an instance graph sequentially.
+  // Construct an instance graph sequentially. Nodes are created in order of
+  // first appearance, which determines the iteration order of the graph.
   for (auto &[module, instances] : moduleToInstances) {
     auto name = module.getModuleNameAttr();
     auto *currentNode = getOrAddNode(name);
@@ -87,7 +102,7 @@ InstanceGraph::InstanceGraph(Operation *parent) : parent(parent) {
 
 InstanceGraphNode *InstanceGraph::addModule(ModuleOpInterface module) {
   assert(!nodeMap.count(module.getModuleNameAttr()) && "module already added");
-  auto *node = new InstanceGraphNode();
+  auto *node = createNode();
   node->module = module;
   nodeMap[module.getModuleNameAttr()] = node;
   nodes.push_back(node);
@@ -101,7 +116,10 @@ void InstanceGraph::erase(InstanceGraphNode *node) {
   for (auto *instance : llvm::make_early_inc_range(*node))
     instance->erase();
   nodeMap.erase(node->getModule().getModuleNameAttr());
-  nodes.erase(node);
+  invalidateOrders();
+  nodes.remove(node);
+  node->~InstanceGraphNode();
+  freeNodes.push_back(node);
 }
 
 InstanceGraphNode *InstanceGraph::lookup(StringAttr name) {
@@ -159,6 +177,65 @@ bool InstanceGraph::isAncestor(ModuleOpInterface child,
   return false;
 }
 
+ArrayRef<InstanceGraphNode *> InstanceGraph::getPostOrder() {
+  if (!ordersValid)
+    computeOrders();
+  return postOrder;
+}
+
+ArrayRef<ArrayRef<InstanceGraphNode *>> InstanceGraph::getLevels() {
+  if (!ordersValid)
+    computeOrders();
+  return levels;
+}
+
+void InstanceGraph::computeOrders() {
+  postOrder.clear();
+  if (auto *top = getTopLevelNode()) {
+    postOrder.assign(llvm::po_begin(top), llvm::po_end(top));
+  } else {
+    // Start a traversal from every node not yet visited, sharing the visited
+    // set so that each node is only added once.
+    llvm::SmallPtrSet<InstanceGraphNode *, 16> visited;
+    for (auto *node : *this)
+      for (auto *child : llvm::post_order_ext(node, visited))
+        postOrder.push_back(child);
+  }
+
+  // The level of a node is one more than the highest level of its children,
+  // which precede it in post-order. Children only reached through a cycle
+  // have not been assigned a level yet and are ignored.
+  DenseMap<InstanceGraphNode *, unsigned> levelOf;
+  levelOf.reserve(postOrder.size());
+  SmallVector<unsigned> levelSizes;
+  for (auto *node : postOrder) {
+    unsigned level = 0;
+    for (auto *record : *node) {
+      auto it = levelOf.find(record->getTarget());
+      if (it != levelOf.end())
+        level = std::max(level, it->second + 1);
+    }
+    levelOf[node] = level;
+    if (level >= levelSizes.size())
+      levelSizes.resize(level + 1);
+    ++levelSizes[level];
+  }
+
+  // Bucket the nodes by level, keeping them in post-order within a level.
+  SmallVector<size_t> offsets(levelSizes.size() + 1, 0);
+  for (size_t i = 0, e = levelSizes.size(); i < e; ++i)
+    offsets[i + 1] = offsets[i] + levelSizes[i];
+  levelOrder.assign(postOrder.size(), nullptr);
+  auto next = offsets;
+  for (auto *node : postOrder)
+    levelOrder[next[levelOf[node]]++] = node;
+  levels.clear();
+  for (size_t i = 0, e = levelSizes.size(); i < e; ++i)
+    levels.push_back(ArrayRef(levelOrder).slice(offsets[i], levelSizes[i]));
+
+  ordersValid = true;
+}
+
 FailureOr<llvm::ArrayRef<InstanceGraphNode *>>
 InstanceGraph::getInferredTopLevelNodes() {
   if (!inferredTopLevelNodes.empty())
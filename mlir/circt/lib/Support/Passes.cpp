@@ -9,9 +9,181 @@
 #include "circt/Support/Passes.h"
 #include "mlir/Transforms/GreedyPatternRewriteDriver.h"
 #include "mlir/Transforms/Passes.h"
+#include "llvm/Config/llvm-config.h"
+#include "llvm/Support/JSON.h"
+#include "llvm/Support/Process.h"
+#include "llvm/Support/Threading.h"
+#include <cstdio>
+#include <functional>
+
+#if defined(__APPLE__)
+#include <mach/mach.h>
+#endif
+#ifdef LLVM_ON_UNIX
+#include <sys/resource.h>
+#endif
 
 using namespace circt;
 
+AnalysisStatisticsInstrumentation::~AnalysisStatisticsInstrumentation() {
+  print(out);
+}
+
+void AnalysisStatisticsInstrumentation::runBeforeAnalysis(StringRef name,
+                                                          TypeID id,
+                                                          Operation *op) {
+  std::lock_guard<std::mutex> lock(mutex);
+  startTimes[llvm::get_threadid()].push_back(TimePoint::clock::now());
+}
+
+void AnalysisStatisticsInstrumentation::runAfterAnalysis(StringRef name,
+                                                         TypeID id,
+                                                         Operation *op) {
+  auto now = TimePoint::clock::now();
+  std::lock_guard<std::mutex> lock(mutex);
+  auto &stats = statistics[name];
+  ++stats.count;
+  stats.time += now - startTimes[llvm::get_threadid()].pop_back_val();
+}
+
+void AnalysisStatisticsInstrumentation::print(llvm::raw_ostream &os) {
+  std::lock_guard<std::mutex> lock(mutex);
+  os << "===" << std::string(73, '-') << "===\n"
+     << "                       ... Analysis statistics report ...\n"
+     << "===" << std::string(73, '-') << "===\n";
+
+  // Sort by name so that the report is deterministic.
+  SmallVector<StringRef> names;
+  for (auto &entry : statistics)
+    names.push_back(entry.getKey());
+  llvm::sort(names);
+  for (auto name : names) {
+    auto &stats = statistics[name];
+    auto seconds = std::chrono::duration<double>(stats.time).count();
+    os << name << "\n"
+       << "  computed: " << stats.count << "\n"
+       << "  time: " << llvm::format("%.4f", seconds) << " sec\n";
+  }
+}
+
+/// Return the resident set size of the process in bytes, or zero if it is not
+/// available on this platform.
+static uint64_t getCurrentRSS() {
+#if defined(__linux__)
+  unsigned long long size = 0, resident = 0;
+  if (FILE *file = fopen("/proc/self/statm", "r")) {
+    if (fscanf(file, "%llu %llu", &size, &resident) != 2)
+      resident = 0;
+    fclose(file);
+  }
+  return resident * llvm::sys::Process::getPageSizeEstimate();
+#elif defined(__APPLE__)
+  mach_task_basic_info_data_t info;
+  mach_msg_type_number_t count = MACH_TASK_BASIC_INFO_COUNT;
+  if (task_info(mach_task_self(), MACH_TASK_BASIC_INFO,
+                reinterpret_cast<task_info_t>(&info), &count) != KERN_SUCCESS)
+    return 0;
+  return info.resident_size;
+#else
+  return 0;
+#endif
+}
+
+/// Return the peak resident set size of the process in bytes, or zero if it is
+/// not available on this platform.
+static uint64_t getPeakRSS() {
+#ifdef LLVM_ON_UNIX
+  struct rusage usage;
+  if (getrusage(RUSAGE_SELF, &usage) != 0)
+    return 0;
+#if defined(__APPLE__)
+  return usage.ru_maxrss;
+#else
+  // Linux and the BSDs report kilobytes.
+  return uint64_t(usage.ru_maxrss) * 1024;
+#endif
+#else
+  return 0;
+#endif
+}
+
+using detail::MemoryStatisticsInstrumentationImpl;
+
+MemoryStatisticsInstrumentationImpl::~MemoryStatisticsInstrumentationImpl() {
+  print(out);
+}
+
+size_t MemoryStatisticsInstrumentationImpl::countOperations(Operation *op) {
+  if (op != countedOp) {
+    countedOp = op;
+    countedOps = 0;
+    op->walk([&](Operation *) { ++countedOps; });
+  }
+  return countedOps;
+}
+
+void MemoryStatisticsInstrumentationImpl::beginPass(Pass *pass,
+                                                    Operation *op) {
+  PassRecord record;
+  llvm::raw_string_ostream name(record.name);
+  pass->printAsTextualPipeline(name);
+  record.opName = op->getName().getStringRef().str();
+  record.opsBefore = countOperations(op);
+  record.startHeap = llvm::sys::Process::GetMallocUsage();
+  record.startRSS = getCurrentRSS();
+  record.startTime = TimePoint::clock::now();
+  activePasses.push_back(std::move(record));
+}
+
+void MemoryStatisticsInstrumentationImpl::endPass(Operation *op, bool failed) {
+  auto now = TimePoint::clock::now();
+  auto record = std::move(activePasses.back());
+  activePasses.pop_back();
+  record.wall = std::chrono::duration<double>(now - record.startTime).count();
+  record.rssDelta = int64_t(getCurrentRSS()) - int64_t(record.startRSS);
+  record.heapDelta = int64_t(llvm::sys::Process::GetMallocUsage()) -
+                     int64_t(record.startHeap);
+  record.peakRSS = getPeakRSS();
+  record.failed = failed;
+  // The pass may have changed the operation.
+  countedOp = nullptr;
+  record.opsAfter = countOperations(op);
+  auto &parent = activePasses.empty() ? passes : activePasses.back().passes;
+  parent.push_back(std::move(record));
+}
+
+void MemoryStatisticsInstrumentationImpl::print(llvm::raw_ostream &os) {
+  llvm::json::OStream json(os, /*IndentSize=*/2);
+  std::function<void(const PassRecord &)> printPass =
+      [&](const PassRecord &record) {
+        json.object([&] {
+          json.attribute("name", record.name);
+          json.attribute("op", record.opName);
+          if (record.failed)
+            json.attribute("failed", true);
+          json.attribute("wall", record.wall);
+          json.attribute("opsBefore", int64_t(record.opsBefore));
+          json.attribute("opsAfter", int64_t(record.opsAfter));
+          json.attribute("rssDelta", record.rssDelta);
+          json.attribute("heapDelta", record.heapDelta);
+          json.attribute("peakRSS", record.peakRSS);
+          if (!record.passes.empty())
+            json.attributeArray("passes", [&] {
+              for (auto &nested : record.passes)
+                printPass(nested);
+            });
+        });
+      };
+  json.object([&] {
+    json.attributeArray("passes", [&] {
+      for (auto &record : passes)
+        printPass(record);
+    });
+    json.attribute("peakRSS", getPeakRSS());
+  });
+  os << "\n";
+}
+
 std::unique_ptr<Pass> circt::createSimpleCanonicalizerPass() {
   mlir::GreedyRewriteConfig config;
   config.useTopDownTraversal = true;
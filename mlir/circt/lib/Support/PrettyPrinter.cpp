@@ -11,15 +11,20 @@
 // https://dx.doi.org/10.1145/357114.357115
 //
 // This was selected as it is linear in number of tokens O(n) and requires
-// memory O(linewidth).
+// memory O(linewidth), or O(lookahead limit) when one is set.
 //
 // This has been adjusted from the paper:
-// * Deque for tokens instead of ringbuffer + left/right cursors.
-//   This is simpler to reason about and allows us to easily grow the buffer
-//   to accommodate longer widths when needed (and not reserve 3*linewidth).
+// * Growable ring buffer for tokens instead of a fixed one + left/right
+//   cursors. This allows us to grow the buffer to accommodate longer widths
+//   when needed (and not reserve 3*linewidth), and the storage is kept when
+//   the buffer is reset so the printer stops allocating once warmed up.
 //   Since scanStack references buffered tokens by index, we track an offset
 //   that we increase when dropping off the front.
 //   When the scan stack is cleared the buffer is reset, including this offset.
+// * Zero-width tokens (begin/end/callback/zero breaks) don't count towards the
+//   width, so a long run of them is buffered however wide the line. An
+//   optional lookahead limit bounds the buffer like the paper's fixed ring
+//   buffer does: when it is full, the oldest pending token is deemed too wide.
 // * Indentation tracked from left not relative to margin (linewidth).
 // * Indentation emitted lazily, avoid trailing whitespace.
 // * Group indentation styles: Visual and Block, set on 'begin' tokens.
@@ -77,6 +82,10 @@ PrettyPrinter::Listener::~Listener() = default;
 
 /// Add token for printing.  In Oppen, this is "scan".
 void PrettyPrinter::add(Token t) {
+  ++numTokens;
+  if (lookaheadLimit && tokens.size() >= lookaheadLimit)
+    enforceLookaheadLimit();
+
   // Add token to tokens, and add its index to scanStack.
   auto addScanToken = [&](auto offset) {
     auto right = tokenOffset + tokens.size();
@@ -124,6 +133,7 @@ void PrettyPrinter::add(Token t) {
         tokens.push_back({t, 0});
       });
   rebaseIfNeeded();
+  peakLookahead = std::max(peakLookahead, tokens.size());
 }
 
 void PrettyPrinter::rebaseIfNeeded() {
@@ -137,7 +147,8 @@ void PrettyPrinter::rebaseIfNeeded() {
   if (uint32_t(leftTotal) > rebaseThreshold) {
     // Plan: reset leftTotal to '1', adjust all accordingly.
     auto adjust = leftTotal - 1;
-    for (auto &scanIndex : scanStack) {
+    for (size_t i = 0, e = scanStack.size(); i != e; ++i) {
+      auto &scanIndex = scanStack[i];
       assert(scanIndex >= tokenOffset);
       auto &t = tokens[scanIndex - tokenOffset];
       if (isa<BreakToken, BeginToken>(&t.token)) {
@@ -220,6 +231,19 @@ void PrettyPrinter::checkStream() {
   }
 }
 
+/// Print tokens until the buffer is below the lookahead limit.
+/// Like running out of space in checkStream, the oldest pending token is
+/// assumed not to fit.
+void PrettyPrinter::enforceLookaheadLimit() {
+  while (tokens.size() >= lookaheadLimit) {
+    if (!scanStack.empty() && tokenOffset == scanStack.front()) {
+      tokens.front().size = kInfinity;
+      scanStack.pop_front();
+    }
+    advanceLeft();
+  }
+}
+
 /// Print out tokens we know sizes for, and drop from token buffer.
 void PrettyPrinter::advanceLeft() {
   assert(!tokens.empty());
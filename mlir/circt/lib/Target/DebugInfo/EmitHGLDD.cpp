@@ -16,6 +16,8 @@
 #include "llvm/Support/JSON.h"
 #include "llvm/Support/Path.h"
 #include "llvm/Support/ToolOutputFile.h"
+#include <chrono>
+#include <mutex>
 
 #define DEBUG_TYPE "di"
 
@@ -92,10 +94,19 @@ struct FileEmitter {
   SmallString<64> outputFileName;
   StringAttr hdlFile;
   SmallMapVector<StringAttr, unsigned, 8> sourceFiles;
+  /// The best source (0) and emitted (1) location found for each location,
+  /// along with the index of its file.
+  DenseMap<Location, std::pair<FileLineColLoc, unsigned>> bestLocations[2];
+  /// The number of objects described in the file, its size, and the time it
+  /// took to emit.
+  size_t numObjects = 0;
+  uint64_t numBytes = 0;
+  std::chrono::duration<double> emissionTime{};
 
   void emit(llvm::raw_ostream &os);
   void emit(llvm::json::OStream &json);
-  void emitLoc(llvm::json::OStream &json, FileLineColLoc loc, bool emitted);
+  void collectSourceFiles();
+  void emitLoc(llvm::json::OStream &json, FileLineColLoc loc, unsigned file);
   void emitModule(llvm::json::OStream &json, DIModule *module);
   void emitInstance(llvm::json::OStream &json, DIInstance *instance);
   void emitVariable(llvm::json::OStream &json, DIVariable *variable);
@@ -127,12 +138,23 @@ struct FileEmitter {
     return slot;
   }
 
+  /// Find the best location for `loc` and the index of its file. The result
+  /// is cached, such that the files are only numbered once.
+  std::pair<FileLineColLoc, unsigned> findLoc(Location loc, bool emitted) {
+    auto [it, inserted] = bestLocations[emitted].try_emplace(loc);
+    if (inserted)
+      if (auto fileLoc = findBestLocation(loc, emitted))
+        it->second = {fileLoc, getSourceFile(fileLoc.getFilename(), emitted)};
+    return it->second;
+  }
+
   /// Find the best location and, if one is found, emit it under the given
   /// `fieldName`.
   void findAndEmitLoc(llvm::json::OStream &json, StringRef fieldName,
                       Location loc, bool emitted) {
-    if (auto fileLoc = findBestLocation(loc, emitted))
-      json.attributeObject(fieldName, [&] { emitLoc(json, fileLoc, emitted); });
+    auto [fileLoc, file] = findLoc(loc, emitted);
+    if (fileLoc)
+      json.attributeObject(fieldName, [&] { emitLoc(json, fileLoc, file); });
   }
 };
 
@@ -146,19 +168,10 @@ void FileEmitter::emit(llvm::raw_ostream &os) {
 
 void FileEmitter::emit(llvm::json::OStream &json) {
   // The "HGLDD" header field needs to be the first in the JSON file (which
-  // violates the JSON spec, but what can you do). But we only know after module
-  // emission what the contents of the header will be.
-  std::string rawObjects;
-  {
-    llvm::raw_string_ostream objectsOS(rawObjects);
-    llvm::json::OStream objectsJson(objectsOS, 2);
-    objectsJson.arrayBegin(); // dummy for indentation
-    objectsJson.arrayBegin();
-    for (auto *module : modules)
-      emitModule(objectsJson, module);
-    objectsJson.arrayEnd();
-    objectsJson.arrayEnd(); // dummy for indentation
-  }
+  // violates the JSON spec, but what can you do). It lists the files referenced
+  // by the objects, so number those upfront; the objects can then be streamed
+  // out after the header.
+  collectSourceFiles();
 
   std::optional<unsigned> hdlFileIndex;
   if (hdlFile)
@@ -176,16 +189,34 @@ void FileEmitter::emit(llvm::json::OStream &json) {
       json.attribute("hdl_file_index", *hdlFileIndex);
   });
 
-  json.attributeBegin("objects");
-  json.rawValue(StringRef(rawObjects).drop_front().drop_back().trim());
-  json.attributeEnd();
+  json.attributeArray("objects", [&] {
+    for (auto *module : modules)
+      emitModule(json, module);
+  });
 
   json.objectEnd();
 }
 
+/// Find the locations to be emitted, in emission order, and number their files.
+void FileEmitter::collectSourceFiles() {
+  auto collect = [&](Location loc) {
+    findLoc(loc, false);
+    findLoc(loc, true);
+  };
+  for (auto *module : modules) {
+    if (auto *op = module->op)
+      collect(op->getLoc());
+    for (auto *var : module->variables)
+      collect(var->loc);
+    for (auto *instance : module->instances)
+      if (auto *op = instance->op)
+        collect(op->getLoc());
+  }
+}
+
 void FileEmitter::emitLoc(llvm::json::OStream &json, FileLineColLoc loc,
-                          bool emitted) {
-  json.attribute("file", getSourceFile(loc.getFilename(), emitted));
+                          unsigned file) {
+  json.attribute("file", file);
   if (auto line = loc.getLine()) {
     json.attribute("begin_line", line);
     json.attribute("end_line", line);
@@ -212,6 +243,7 @@ StringAttr getVerilogInstanceName(DIInstance &inst) {
 
 /// Emit the debug info for a `DIModule`.
 void FileEmitter::emitModule(llvm::json::OStream &json, DIModule *module) {
+  ++numObjects;
   json.objectBegin();
   json.attribute("kind", "module");
   json.attribute("obj_name", module->name.getValue()); // HGL
@@ -237,6 +269,7 @@ void FileEmitter::emitModule(llvm::json::OStream &json, DIModule *module) {
 /// Emit the debug info for a `DIInstance`.
 void FileEmitter::emitInstance(llvm::json::OStream &json,
                                DIInstance *instance) {
+  ++numObjects;
   json.objectBegin();
   json.attribute("name", instance->name.getValue());
   auto verilogName = getVerilogInstanceName(*instance);
@@ -255,6 +288,7 @@ void FileEmitter::emitInstance(llvm::json::OStream &json,
 /// Emit the debug info for a `DIVariable`.
 void FileEmitter::emitVariable(llvm::json::OStream &json,
                                DIVariable *variable) {
+  ++numObjects;
   json.objectBegin();
   json.attribute("var_name", variable->name.getValue());
   findAndEmitLoc(json, "hgl_loc", variable->loc, false);
@@ -365,19 +399,70 @@ Emitter::Emitter(Operation *module, const EmitHGLDDOptions &options)
 // Emission Entry Points
 //===----------------------------------------------------------------------===//
 
-LogicalResult debug::emitHGLDD(Operation *module, llvm::raw_ostream &os,
-                               const EmitHGLDDOptions &options) {
-  Emitter emitter(module, options);
+/// Emit a file, measuring its size and the time it took.
+static void emitFile(FileEmitter &fileEmitter, llvm::raw_ostream &os) {
+  auto start = std::chrono::steady_clock::now();
+  uint64_t startPos = os.tell();
+  fileEmitter.emit(os);
+  fileEmitter.numBytes = os.tell() - startPos;
+  fileEmitter.emissionTime = std::chrono::steady_clock::now() - start;
+}
+
+/// Report the sizes and emission times of the files.
+static void recordStatistics(const Emitter &emitter,
+                             EmitHGLDDStatistics *statistics) {
+  LLVM_DEBUG({
+    llvm::dbgs() << "HGLDD emission:\n";
+    for (auto &fileEmitter : emitter.files)
+      llvm::dbgs() << "- " << fileEmitter.outputFileName << ": "
+                   << fileEmitter.numObjects << " objects, "
+                   << fileEmitter.numBytes << " bytes, "
+                   << fileEmitter.emissionTime.count() << " s\n";
+  });
+  if (!statistics)
+    return;
+  statistics->numFiles += emitter.files.size();
   for (auto &fileEmitter : emitter.files) {
-    os << "\n// ----- 8< ----- FILE \"" + fileEmitter.outputFileName +
-              "\" ----- 8< -----\n\n";
-    fileEmitter.emit(os);
+    statistics->numObjects += fileEmitter.numObjects;
+    statistics->numBytes += fileEmitter.numBytes;
   }
+}
+
+LogicalResult debug::emitHGLDD(Operation *module, llvm::raw_ostream &os,
+                               const EmitHGLDDOptions &options,
+                               EmitHGLDDStatistics *statistics) {
+  Emitter emitter(module, options);
+
+  // Emit the files in parallel. Each file is written out and its buffer freed
+  // as soon as it and all files before it are done, such that only the files
+  // which finished ahead of an earlier one are held in memory.
+  auto numFiles = emitter.files.size();
+  SmallVector<std::string, 0> buffers(numFiles);
+  SmallVector<bool, 0> finished(numFiles, false);
+  size_t numWritten = 0;
+  std::mutex writeMutex;
+  mlir::parallelFor(module->getContext(), 0, numFiles, [&](size_t i) {
+    {
+      llvm::raw_string_ostream bufferOS(buffers[i]);
+      emitFile(emitter.files[i], bufferOS);
+    }
+    std::lock_guard<std::mutex> lock(writeMutex);
+    finished[i] = true;
+    for (; numWritten < numFiles && finished[numWritten]; ++numWritten) {
+      os << "\n// ----- 8< ----- FILE \"" +
+                emitter.files[numWritten].outputFileName +
+                "\" ----- 8< -----\n\n";
+      os << buffers[numWritten];
+      std::string().swap(buffers[numWritten]);
+    }
+  });
+  recordStatistics(emitter, statistics);
   return success();
 }
 
 LogicalResult debug::emitSplitHGLDD(Operation *module,
-                                    const EmitHGLDDOptions &options) {
+                                    const EmitHGLDDOptions &options,
+                                    EmitHGLDDStatistics *statistics) {
   Emitter emitter(module, options);
 
   auto emit = [&](auto &fileEmitter) {
@@ -391,11 +476,14 @@ LogicalResult debug::emitSplitHGLDD(Operation *module,
     }
 
     // Emit the debug information and keep the file around.
-    fileEmitter.emit(output->os());
+    emitFile(fileEmitter, output->os());
     output->keep();
     return success();
   };
 
-  return mlir::failableParallelForEach(module->getContext(), emitter.files,
-                                       emit);
+  if (failed(mlir::failableParallelForEach(module->getContext(),
+                                           emitter.files, emit)))
+    return failure();
+  recordStatistics(emitter, statistics);
+  return success();
 }
@@ -7,6 +7,7 @@
 //===----------------------------------------------------------------------===//
 
 #include "PassDetail.h"
+#include "circt/Dialect/HW/HWInstanceGraph.h"
 #include "circt/Transforms/Passes.h"
 #include "mlir/IR/BuiltinOps.h"
 #include "mlir/IR/Operation.h"
@@ -97,6 +98,9 @@ void StripDebugInfoWithPred::runOnOperation() {
                 updateLocIfChanged(&arg, getStrippedLoc(arg.getLoc()));
         });
       });
+
+  // Only locations changed.
+  markAnalysesPreserved<circt::hw::InstanceGraph>();
 }
 
 namespace circt {
@@ -40,6 +40,20 @@ func.func @StorageTypes(%arg0: !arc.storage) -> (!arc.state<i1>, !arc.memory<4 x
 }
 // CHECK-NEXT: }
 
+// CHECK-LABEL: llvm.func @StorageCopyTypes(%arg0: !llvm.ptr<i8>, %arg1: i64) -> !llvm.ptr<i32> {
+func.func @StorageCopyTypes(%arg0: !arc.storage, %arg1: index) -> !arc.state<i32> {
+  %0 = arc.storage.get_copy %arg0[16] copy %arg1 stride 4 : !arc.storage -> !arc.state<i32>
+  // CHECK-NEXT: [[STRIDE:%.+]] = llvm.mlir.constant(4 : i64)
+  // CHECK-NEXT: [[OFFSET:%.+]] = llvm.mlir.constant(16 : i64)
+  // CHECK-NEXT: [[COPYOFFSET:%.+]] = llvm.mul %arg1, [[STRIDE]]
+  // CHECK-NEXT: [[TOTAL:%.+]] = llvm.add [[OFFSET]], [[COPYOFFSET]]
+  // CHECK-NEXT: [[PTR:%.+]] = llvm.getelementptr %arg0[[[TOTAL]]]
+  // CHECK-NEXT: llvm.bitcast [[PTR]] : !llvm.ptr<i8> to !llvm.ptr<i32>
+  return %0 : !arc.state<i32>
+  // CHECK: llvm.return
+}
+// CHECK-NEXT: }
+
 // CHECK-LABEL: llvm.func @StateAllocation(%arg0: !llvm.ptr<i8>) {
 func.func @StateAllocation(%arg0: !arc.storage<10>) {
   arc.root_input "a", %arg0 {offset = 0} : (!arc.storage<10>) -> !arc.state<i1>
@@ -182,3 +196,17 @@ func.func @seqClocks(%clk1: !seq.clock, %clk2: !seq.clock) -> !seq.clock {
 //  CHECK-SAME: ([[CLK1:%.+]]: i1, [[CLK2:%.+]]: i1)
 //       CHECK: [[RES:%.+]] = llvm.xor [[CLK1]], [[CLK2]]
 //       CHECK: llvm.return [[RES]] : i1
+
+// CHECK-LABEL: llvm.func @Batch_eval(%arg0: !llvm.ptr<i8>) {
+// CHECK:         llvm.br ^bb1(
+// CHECK:       ^bb1([[COPY:%.+]]: i64):
+// CHECK:         llvm.icmp "slt" [[COPY]]
+// CHECK:         llvm.call @BatchClock(%arg0, [[COPY]]) : (!llvm.ptr<i8>, i64) -> ()
+// CHECK:         llvm.return
+arc.model "Batch" attributes {batch = 4 : i32} {
+^bb0(%arg0: !arc.storage<8>, %arg1: index):
+  func.call @BatchClock(%arg0, %arg1) : (!arc.storage<8>, index) -> ()
+}
+func.func @BatchClock(%arg0: !arc.storage<8>, %arg1: index) {
+  return
+}
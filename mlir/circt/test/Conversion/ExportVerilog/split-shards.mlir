@@ -0,0 +1,30 @@
+// RUN: rm -rf %t.unsharded %t.sharded
+// RUN: circt-opt %s --export-split-verilog='dir-name=%t.unsharded'
+// RUN: circt-opt %s --export-split-verilog='dir-name=%t.sharded num-shards=2 shard-index=0'
+// RUN: ls %t.sharded | FileCheck %s --check-prefix=SHARD0 --implicit-check-not=Small.sv
+// RUN: circt-opt %s --export-split-verilog='dir-name=%t.sharded num-shards=2 shard-index=1'
+// RUN: diff -r %t.unsharded %t.sharded
+// RUN: rm -rf %t.shard1
+// RUN: circt-opt %s --export-split-verilog='dir-name=%t.shard1 num-shards=2 shard-index=1'
+// RUN: ls %t.shard1 | FileCheck %s --check-prefix=SHARD1 --implicit-check-not=Big.sv --implicit-check-not=filelist.f
+// RUN: not circt-opt %s --export-split-verilog='dir-name=%t.invalid num-shards=2 shard-index=2' 2>&1 | FileCheck %s --check-prefix=INVALID
+
+// The largest file is assigned to the first shard, the next one to the least
+// loaded shard.
+
+// SHARD0: Big.sv
+// SHARD0: filelist.f
+// SHARD1: Small.sv
+
+// INVALID: error: invalid shard 2 of 2 shards
+
+hw.module @Big(in %a: i8, in %b: i8, out c: i8) {
+  %0 = comb.add %a, %b : i8
+  %1 = comb.mul %0, %a : i8
+  %2 = comb.xor %1, %b : i8
+  hw.output %2 : i8
+}
+
+hw.module @Small(in %a: i8, out b: i8) {
+  hw.output %a : i8
+}
@@ -0,0 +1,58 @@
+// RUN: circt-opt %s --arc-add-dirty-flags --split-input-file --verify-diagnostics | FileCheck %s
+
+// CHECK-LABEL: arc.model "Foo" attributes {dirtyFlagsOffset = 32 : i32} {
+arc.model "Foo" {
+^bb0(%arg0: !arc.storage<32>):
+  // CHECK-NEXT: ^bb0([[PTR:%.+]]: !arc.storage<35>):
+  // CHECK-NEXT: arc.root_input "a", [[PTR]] {offset = 0 : i32}
+  // CHECK-NEXT: arc.root_output "b", [[PTR]] {dirtyFlag = 32 : i32, offset = 1 : i32}
+  // CHECK-NEXT: arc.alloc_state [[PTR]] {dirtyFlag = 33 : i32, name = "x", offset = 4 : i32}
+  // CHECK-NEXT: arc.alloc_state [[PTR]] {offset = 8 : i32}
+  // CHECK-NEXT: arc.alloc_memory [[PTR]] {dirtyFlag = 34 : i32, name = "m", offset = 16 : i32, stride = 1 : i32}
+  arc.root_input "a", %arg0 {offset = 0 : i32} : (!arc.storage<32>) -> !arc.state<i1>
+  arc.root_output "b", %arg0 {offset = 1 : i32} : (!arc.storage<32>) -> !arc.state<i8>
+  arc.alloc_state %arg0 {name = "x", offset = 4 : i32} : (!arc.storage<32>) -> !arc.state<i32>
+  arc.alloc_state %arg0 {offset = 8 : i32} : (!arc.storage<32>) -> !arc.state<i32>
+  arc.alloc_memory %arg0 {name = "m", offset = 16 : i32, stride = 1 : i32} : (!arc.storage<32>) -> !arc.memory<4 x i8, i2>
+
+  // CHECK-NEXT: arc.passthrough {
+  arc.passthrough {
+    %c1_i8 = hw.constant 1 : i8
+    %c42_i32 = hw.constant 42 : i32
+    %c0_i2 = hw.constant 0 : i2
+    %true = hw.constant true
+    // CHECK: [[STATE:%.+]] = arc.storage.get [[PTR]][1]
+    // CHECK-NEXT: [[FLAG:%.+]] = arc.storage.get [[PTR]][32] : !arc.storage<35> -> !arc.state<i8>
+    // CHECK-NEXT: [[ONE:%.+]] = hw.constant 1 : i8
+    // CHECK-NEXT: arc.state_write [[FLAG]] = [[ONE]] : <i8>
+    // CHECK-NEXT: arc.state_write [[STATE]]
+    %0 = arc.storage.get %arg0[1] : !arc.storage<32> -> !arc.state<i8>
+    arc.state_write %0 = %c1_i8 : <i8>
+    // CHECK-NEXT: [[STATE:%.+]] = arc.storage.get [[PTR]][4]
+    // CHECK-NEXT: [[FLAG:%.+]] = arc.storage.get [[PTR]][33] : !arc.storage<35> -> !arc.state<i8>
+    // CHECK-NEXT: [[ONE:%.+]] = hw.constant 1 : i8
+    // CHECK-NEXT: arc.state_write [[FLAG]] = [[ONE]] if [[COND:%.+]] : <i8>
+    // CHECK-NEXT: arc.state_write [[STATE]] = {{%.+}} if [[COND]] : <i32>
+    %1 = arc.storage.get %arg0[4] : !arc.storage<32> -> !arc.state<i32>
+    arc.state_write %1 = %c42_i32 if %true : <i32>
+    // CHECK-NEXT: [[STATE:%.+]] = arc.storage.get [[PTR]][8]
+    // CHECK-NEXT: arc.state_write [[STATE]]
+    %2 = arc.storage.get %arg0[8] : !arc.storage<32> -> !arc.state<i32>
+    arc.state_write %2 = %c42_i32 : <i32>
+    // CHECK-NEXT: [[MEM:%.+]] = arc.storage.get [[PTR]][16]
+    // CHECK-NEXT: [[FLAG:%.+]] = arc.storage.get [[PTR]][34] : !arc.storage<35> -> !arc.state<i8>
+    // CHECK-NEXT: [[ONE:%.+]] = hw.constant 1 : i8
+    // CHECK-NEXT: arc.state_write [[FLAG]] = [[ONE]] if [[COND]] : <i8>
+    // CHECK-NEXT: arc.memory_write [[MEM]]
+    %3 = arc.storage.get %arg0[16] : !arc.storage<32> -> !arc.memory<4 x i8, i2>
+    arc.memory_write %3[%c0_i2], %c1_i8 if %true : <4 x i8, i2>
+  }
+  // CHECK-NEXT: }
+}
+
+// -----
+
+// expected-error @below {{'arc.model' op dirty flags are not supported in batched models}}
+arc.model "Batch" attributes {batch = 4 : i32} {
+^bb0(%arg0: !arc.storage<32>, %arg1: index):
+}
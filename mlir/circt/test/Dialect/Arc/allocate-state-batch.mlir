@@ -0,0 +1,46 @@
+// RUN: circt-opt %s --arc-allocate-state=batch=4 --split-input-file --verify-diagnostics | FileCheck %s
+
+// CHECK-LABEL: arc.model "Batch" attributes {batch = 4 : i32} {
+arc.model "Batch" {
+^bb0(%arg0: !arc.storage):
+  // CHECK-NEXT: ^bb0([[PTR:%.+]]: !arc.storage<96>, [[COPY:%.+]]: index):
+  %0 = arc.alloc_state %arg0 : (!arc.storage) -> !arc.state<i1>
+  %1 = arc.alloc_state %arg0 : (!arc.storage) -> !arc.state<i32>
+  %2 = arc.alloc_memory %arg0 : (!arc.storage) -> !arc.memory<4 x i8, i2>
+  %3 = arc.alloc_state %arg0 : (!arc.storage) -> !arc.state<i64>
+  // CHECK-NEXT: arc.alloc_state [[PTR]] {copyStride = 1 : i32, offset = 0 : i32}
+  // CHECK-NEXT: arc.alloc_state [[PTR]] {copyStride = 4 : i32, offset = 16 : i32}
+  // CHECK-NEXT: arc.alloc_memory [[PTR]] {copyStride = 4 : i32, offset = 32 : i32, stride = 1 : i32}
+  // CHECK-NEXT: arc.alloc_state [[PTR]] {copyStride = 8 : i32, offset = 64 : i32}
+
+  // CHECK-NEXT: arc.passthrough {
+  arc.passthrough {
+    // CHECK-NEXT: [[STATE:%.+]] = arc.storage.get_copy [[PTR]][0] copy [[COPY]] stride 1 : !arc.storage<96> -> !arc.state<i1>
+    // CHECK-NEXT: arc.state_read [[STATE]] : <i1>
+    arc.state_read %0 : <i1>
+    // CHECK-NEXT: [[STATE:%.+]] = arc.storage.get_copy [[PTR]][64] copy [[COPY]] stride 8 : !arc.storage<96> -> !arc.state<i64>
+    // CHECK-NEXT: arc.state_read [[STATE]] : <i64>
+    arc.state_read %3 : <i64>
+    // CHECK-NEXT: [[ADDR:%.+]] = hw.constant
+    // CHECK-NEXT: [[MEM:%.+]] = arc.storage.get_copy [[PTR]][32] copy [[COPY]] stride 4 : !arc.storage<96> -> !arc.memory<4 x i8, i2>
+    // CHECK-NEXT: arc.memory_read [[MEM]]{{\[}}[[ADDR]]{{\]}} : <4 x i8, i2>
+    %c0_i2 = hw.constant 0 : i2
+    arc.memory_read %2[%c0_i2] : <4 x i8, i2>
+    // CHECK-NEXT: [[VALUE:%.+]] = hw.constant
+    // CHECK-NEXT: [[STATE:%.+]] = arc.storage.get_copy [[PTR]][16] copy [[COPY]] stride 4 : !arc.storage<96> -> !arc.state<i32>
+    // CHECK-NEXT: arc.state_write [[STATE]] = [[VALUE]] : <i32>
+    %c42_i32 = hw.constant 42 : i32
+    arc.state_write %1 = %c42_i32 : <i32>
+  }
+  // CHECK-NEXT: }
+}
+
+// -----
+
+arc.model "NestedAllocation" {
+^bb0(%arg0: !arc.storage):
+  arc.passthrough {
+    // expected-error @below {{'arc.alloc_state' op cannot be allocated in a batched model}}
+    arc.alloc_state %arg0 : (!arc.storage) -> !arc.state<i1>
+  }
+}
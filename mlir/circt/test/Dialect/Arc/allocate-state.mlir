@@ -79,3 +79,18 @@ arc.model "test" {
   }
   // CHECK-NEXT: }
 }
+
+// States of different partitions are placed in separate cache lines.
+// CHECK-LABEL: arc.model "partitioned"
+arc.model "partitioned" {
+^bb0(%arg0: !arc.storage):
+  // CHECK-NEXT: ([[PTR:%.+]]: !arc.storage<192>):
+  arc.alloc_state %arg0 {partition = 1 : i32} : (!arc.storage) -> !arc.state<i8>
+  arc.alloc_state %arg0 {partition = 0 : i32} : (!arc.storage) -> !arc.state<i8>
+  arc.alloc_state %arg0 : (!arc.storage) -> !arc.state<i8>
+  arc.alloc_state %arg0 {partition = 0 : i32} : (!arc.storage) -> !arc.state<i8>
+  // CHECK-NEXT: arc.alloc_state [[PTR]] {offset = 128 : i32, partition = 1 : i32}
+  // CHECK-NEXT: arc.alloc_state [[PTR]] {offset = 64 : i32, partition = 0 : i32}
+  // CHECK-NEXT: arc.alloc_state [[PTR]] {offset = 0 : i32}
+  // CHECK-NEXT: arc.alloc_state [[PTR]] {offset = 65 : i32, partition = 0 : i32}
+}
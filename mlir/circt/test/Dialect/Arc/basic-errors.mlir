@@ -87,6 +87,20 @@ arc.model "WrongArgType" {
 
 // -----
 
+// expected-error @below {{op with batch must have exactly two arguments}}
+arc.model "MissingCopyArg" attributes {batch = 4 : i32} {
+^bb0(%arg0: !arc.storage):
+}
+
+// -----
+
+// expected-error @below {{op copy argument must be of index type}}
+arc.model "WrongCopyArgType" attributes {batch = 4 : i32} {
+^bb0(%arg0: !arc.storage, %arg1: i32):
+}
+
+// -----
+
 arc.define @Foo() {
   // expected-error @+1 {{`Bar` does not reference a valid `arc.define`}}
   arc.call @Bar() : () -> ()
@@ -65,6 +65,15 @@ func.func @StorageAccess(%arg0: !arc.storage<10000>) {
   return
 }
 
+// CHECK-LABEL: func.func @StorageCopyAccess
+func.func @StorageCopyAccess(%arg0: !arc.storage<10000>, %arg1: index) {
+  // CHECK-NEXT: arc.storage.get_copy %arg0[42] copy %arg1 stride 2 : !arc.storage<10000> -> !arc.state<i9>
+  // CHECK-NEXT: arc.storage.get_copy %arg0[1337] copy %arg1 stride 16 : !arc.storage<10000> -> !arc.memory<4 x i19, i32>
+  %0 = arc.storage.get_copy %arg0[42] copy %arg1 stride 2 : !arc.storage<10000> -> !arc.state<i9>
+  %1 = arc.storage.get_copy %arg0[1337] copy %arg1 stride 16 : !arc.storage<10000> -> !arc.memory<4 x i19, i32>
+  return
+}
+
 // CHECK-LABEL: func.func @zeroCount
 func.func @zeroCount(%arg0 : i32) {
   // CHECK-NEXT: {{%.+}} = arc.zero_count leading %arg0  : i32
@@ -89,3 +89,77 @@ arc.model "InsertionOrderProblem" {
     }
   }
 }
+
+//===----------------------------------------------------------------------===//
+
+// Partitions of a clock tree are run through the runtime, which calls back
+// into the partition dispatch function.
+
+// CHECK-LABEL: func.func private @Partitioned_run_partitions(!arc.storage<42>, i32, i32)
+
+// CHECK-LABEL: func.func @Partitioned_clock(%arg0: !arc.storage<42>) {
+// CHECK-NEXT:    hw.constant 0 : i9
+// CHECK-NEXT:    return
+// CHECK-NEXT:  }
+
+// CHECK-LABEL: func.func @Partitioned_clock_0(%arg0: !arc.storage<42>) {
+// CHECK-NEXT:    hw.constant 1 : i9
+// CHECK-NEXT:    return
+// CHECK-NEXT:  }
+
+// CHECK-LABEL: func.func @Partitioned_partition(%arg0: !arc.storage<42>, %arg1: i32) {
+// CHECK-NEXT:    [[IDX:%.+]] = arith.index_castui %arg1 : i32 to index
+// CHECK-NEXT:    scf.index_switch [[IDX]]
+// CHECK-NEXT:    case 0 {
+// CHECK-NEXT:      func.call @Partitioned_clock(%arg0) : (!arc.storage<42>) -> ()
+// CHECK-NEXT:      scf.yield
+// CHECK-NEXT:    }
+// CHECK-NEXT:    case 1 {
+// CHECK-NEXT:      func.call @Partitioned_clock_0(%arg0) : (!arc.storage<42>) -> ()
+// CHECK-NEXT:      scf.yield
+// CHECK-NEXT:    }
+// CHECK-NEXT:    default {
+// CHECK-NEXT:      scf.yield
+// CHECK-NEXT:    }
+// CHECK-NEXT:    return
+// CHECK-NEXT:  }
+
+// CHECK-LABEL: arc.model "Partitioned" {
+// CHECK-NEXT:  ^bb0(%arg0: !arc.storage<42>):
+// CHECK-NEXT:    %true = hw.constant true
+// CHECK-NEXT:    scf.if %true {
+// CHECK-NEXT:      [[FIRST:%.+]] = hw.constant 0 : i32
+// CHECK-NEXT:      [[COUNT:%.+]] = hw.constant 2 : i32
+// CHECK-NEXT:      func.call @Partitioned_run_partitions(%arg0, [[FIRST]], [[COUNT]]) : (!arc.storage<42>, i32, i32) -> ()
+// CHECK-NEXT:    }
+// CHECK-NEXT:  }
+
+arc.model "Partitioned" {
+^bb0(%arg0: !arc.storage<42>):
+  %true = hw.constant true
+  arc.clock_tree %true attributes {partition = 0 : i32} {
+    hw.constant 0 : i9
+  }
+  arc.clock_tree %true attributes {partition = 1 : i32} {
+    hw.constant 1 : i9
+  }
+}
+
+// CHECK-LABEL: func.func @Batch_passthrough(%arg0: !arc.storage<4>, %arg1: index) {
+// CHECK-NEXT:    [[STATE:%.+]] = arc.storage.get_copy %arg0[0] copy %arg1 stride 1 : !arc.storage<4> -> !arc.state<i1>
+// CHECK-NEXT:    arc.state_read [[STATE]] : <i1>
+// CHECK-NEXT:    return
+// CHECK-NEXT:  }
+
+// CHECK-LABEL: arc.model "Batch" attributes {batch = 4 : i32} {
+// CHECK-NEXT:  ^bb0(%arg0: !arc.storage<4>, %arg1: index):
+// CHECK-NEXT:    func.call @Batch_passthrough(%arg0, %arg1) : (!arc.storage<4>, index) -> ()
+// CHECK-NEXT:  }
+
+arc.model "Batch" attributes {batch = 4 : i32} {
+^bb0(%arg0: !arc.storage<4>, %arg1: index):
+  arc.passthrough {
+    %0 = arc.storage.get_copy %arg0[0] copy %arg1 stride 1 : !arc.storage<4> -> !arc.state<i1>
+    arc.state_read %0 : <i1>
+  }
+}
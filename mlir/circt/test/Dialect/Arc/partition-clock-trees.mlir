@@ -0,0 +1,64 @@
+// RUN: circt-opt %s --pass-pipeline='builtin.module(arc.model(arc-partition-clock-trees{num-partitions=2}))' | FileCheck %s
+
+// CHECK-LABEL: arc.model "Independent"
+arc.model "Independent" {
+^bb0(%arg0: !arc.storage):
+  %true = hw.constant true
+  // CHECK-DAG: [[A:%.+]] = arc.alloc_state %arg0 {partition = 0 : i32}
+  // CHECK-DAG: [[B:%.+]] = arc.alloc_state %arg0 {partition = 1 : i32}
+  // CHECK-DAG: [[C:%.+]] = arc.alloc_state %arg0 {partition = 0 : i32}
+  // CHECK-DAG: [[D:%.+]] = arc.alloc_state %arg0 : (
+  %a = arc.alloc_state %arg0 : (!arc.storage) -> !arc.state<i8>
+  %b = arc.alloc_state %arg0 : (!arc.storage) -> !arc.state<i8>
+  %c = arc.alloc_state %arg0 : (!arc.storage) -> !arc.state<i8>
+  %d = arc.alloc_state %arg0 : (!arc.storage) -> !arc.state<i8>
+
+  // The first cluster, accessing `a` and `c`, is the largest and ends up in
+  // the first partition. The other two clusters go to the second one.
+  // CHECK:      arc.clock_tree %true attributes {partition = 0 : i32} {
+  // CHECK-NEXT:   [[K:%.+]] = hw.constant 1 : i8
+  // CHECK-NEXT:   [[X:%.+]] = arc.state_read [[A]]
+  // CHECK-NEXT:   [[Y:%.+]] = comb.add [[X]], [[K]]
+  // CHECK-NEXT:   arc.state_write [[A]] = [[Y]]
+  // CHECK-NEXT:   arc.state_write [[C]] = [[X]]
+  // CHECK-NEXT: }
+  // CHECK-NEXT: arc.clock_tree %true attributes {partition = 1 : i32} {
+  // CHECK-NEXT:   [[K:%.+]] = hw.constant 1 : i8
+  // CHECK-NEXT:   [[X:%.+]] = arc.state_read [[B]]
+  // CHECK-NEXT:   [[Y:%.+]] = comb.add [[X]], [[K]]
+  // CHECK-NEXT:   arc.state_write [[B]] = [[Y]]
+  // CHECK-NEXT:   [[X:%.+]] = arc.state_read [[D]]
+  // CHECK-NEXT: }
+  // CHECK-NOT:  arc.clock_tree
+  arc.clock_tree %true {
+    %k = hw.constant 1 : i8
+    %0 = arc.state_read %a : <i8>
+    %1 = arc.state_read %b : <i8>
+    %2 = comb.add %0, %k : i8
+    %3 = comb.add %1, %k : i8
+    arc.state_write %a = %2 : <i8>
+    arc.state_write %b = %3 : <i8>
+    arc.state_write %c = %0 : <i8>
+    %4 = arc.state_read %d : <i8>
+  }
+  // `d` is also accessed outside the clock tree.
+  arc.passthrough {
+    %0 = arc.state_read %d : <i8>
+  }
+}
+
+// CHECK-LABEL: arc.model "Connected"
+arc.model "Connected" {
+^bb0(%arg0: !arc.storage):
+  %true = hw.constant true
+  %a = arc.alloc_state %arg0 : (!arc.storage) -> !arc.state<i8>
+  %b = arc.alloc_state %arg0 : (!arc.storage) -> !arc.state<i8>
+  // CHECK-NOT: partition
+  // CHECK: arc.clock_tree %true {
+  arc.clock_tree %true {
+    %0 = arc.state_read %a : <i8>
+    %1 = arc.state_read %b : <i8>
+    arc.state_write %a = %1 : <i8>
+    arc.state_write %b = %0 : <i8>
+  }
+}
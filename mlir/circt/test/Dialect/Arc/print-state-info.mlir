@@ -45,3 +45,39 @@ arc.model "Bar" {
   // CHECK-NEXT: "type": "wire"
   arc.alloc_state %arg0 tap {name = "z", offset = 92} : (!arc.storage<9001>) -> !arc.state<i1337>
 }
+
+// CHECK-LABEL: "name": "Batch"
+// CHECK-DAG: "numStateBytes": 64
+// CHECK-DAG: "batch": 4
+arc.model "Batch" attributes {batch = 4 : i32} {
+^bb0(%arg0: !arc.storage<64>, %arg1: index):
+  // CHECK:      "name": "a"
+  // CHECK-NEXT: "offset": 0
+  // CHECK-NEXT: "numBits": 19
+  // CHECK-NEXT: "type": "input"
+  // CHECK-NEXT: "copyStride": 3
+  arc.root_input "a", %arg0 {copyStride = 3 : i32, offset = 0 : i32} : (!arc.storage<64>) -> !arc.state<i19>
+
+  // CHECK:      "name": "y"
+  // CHECK-NEXT: "offset": 16
+  // CHECK-NEXT: "numBits": 8
+  // CHECK-NEXT: "type": "memory"
+  // CHECK-NEXT: "stride": 1
+  // CHECK-NEXT: "depth": 4
+  // CHECK-NEXT: "copyStride": 4
+  arc.alloc_memory %arg0 {name = "y", copyStride = 4 : i32, offset = 16 : i32, stride = 1 : i32} : (!arc.storage<64>) -> !arc.memory<4 x i8, i2>
+}
+
+// CHECK-LABEL: "name": "Dirty"
+// CHECK-DAG: "numStateBytes": 10
+// CHECK-DAG: "dirtyFlagsOffset": 8
+// CHECK-DAG: "numDirtyFlags": 2
+arc.model "Dirty" attributes {dirtyFlagsOffset = 8 : i32} {
+^bb0(%arg0: !arc.storage<10>):
+  // CHECK:      "name": "x"
+  // CHECK-NEXT: "offset": 0
+  // CHECK-NEXT: "numBits": 32
+  // CHECK-NEXT: "type": "register"
+  // CHECK-NEXT: "dirtyFlag": 8
+  arc.alloc_state %arg0 {dirtyFlag = 8 : i32, name = "x", offset = 0 : i32} : (!arc.storage<10>) -> !arc.state<i32>
+}
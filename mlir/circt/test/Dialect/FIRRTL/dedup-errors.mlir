@@ -563,6 +563,32 @@ firrtl.circuit "MustDedup" attributes {annotations = [{
 
 // -----
 
+// Probes of different operations.
+// expected-error@below {{module "Test1" not deduplicated with "Test0"}}
+firrtl.circuit "MustDedup" attributes {annotations = [{
+      class = "firrtl.transforms.MustDeduplicateAnnotation",
+      modules = ["~MustDedup|Test0", "~MustDedup|Test1"]
+    }]} {
+  firrtl.module private @Test0() {
+    %w0 = firrtl.wire sym @sym0 : !firrtl.uint<1>
+    %w1 = firrtl.wire sym @sym1 : !firrtl.uint<1>
+    // expected-note @below {{operations have different targets, first operation has op %w0}}
+    %0 = firrtl.ref.rwprobe <@Test0::@sym0> : !firrtl.rwprobe<uint<1>>
+  }
+  firrtl.module private @Test1() {
+    %w0 = firrtl.wire sym @sym0 : !firrtl.uint<1>
+    %w1 = firrtl.wire sym @sym1 : !firrtl.uint<1>
+    // expected-note @below {{second operation has op %w1}}
+    %0 = firrtl.ref.rwprobe <@Test1::@sym1> : !firrtl.rwprobe<uint<1>>
+  }
+  firrtl.module @MustDedup() {
+    firrtl.instance test0 @Test0()
+    firrtl.instance test1 @Test1()
+  }
+}
+
+// -----
+
 // expected-error@below {{module "Test1" not deduplicated with "Test0"}}
 firrtl.circuit "MustDedup" attributes {annotations = [{
       class = "firrtl.transforms.MustDeduplicateAnnotation",
@@ -0,0 +1,47 @@
+// RUN: circt-opt --pass-pipeline='builtin.module(firrtl.circuit(firrtl-infer-widths))' --mlir-pass-statistics %s 2>&1 | FileCheck %s
+
+// Top and Leaf are tied together by Leaf's uninferred output port. Known only
+// has known port widths and Other is never instantiated, so both of them are
+// solved on their own.
+
+// CHECK: InferWidths
+// CHECK-DAG: (S) 2 max-partition-size
+// CHECK-DAG: (S) 3 num-partitions
+
+firrtl.circuit "Top" {
+  // CHECK-LABEL: firrtl.module @Top
+  firrtl.module @Top(in %a: !firrtl.uint<4>, out %b: !firrtl.uint, out %c: !firrtl.uint<4>) {
+    // CHECK: firrtl.instance leaf @Leaf(in a: !firrtl.uint<4>, out b: !firrtl.uint<5>)
+    %leaf_a, %leaf_b = firrtl.instance leaf @Leaf(in a: !firrtl.uint<4>, out b: !firrtl.uint)
+    %known_a, %known_b = firrtl.instance known @Known(in a: !firrtl.uint<4>, out b: !firrtl.uint<4>)
+    firrtl.connect %leaf_a, %a : !firrtl.uint<4>, !firrtl.uint<4>
+    firrtl.connect %known_a, %a : !firrtl.uint<4>, !firrtl.uint<4>
+    // CHECK: %w = firrtl.wire : !firrtl.uint<5>
+    %w = firrtl.wire : !firrtl.uint
+    firrtl.connect %w, %leaf_b : !firrtl.uint, !firrtl.uint
+    firrtl.connect %b, %w : !firrtl.uint, !firrtl.uint
+    firrtl.connect %c, %known_b : !firrtl.uint<4>, !firrtl.uint<4>
+  }
+
+  // CHECK-LABEL: firrtl.module private @Leaf
+  // CHECK-SAME: out %b: !firrtl.uint<5>
+  firrtl.module private @Leaf(in %a: !firrtl.uint<4>, out %b: !firrtl.uint) {
+    %0 = firrtl.add %a, %a : (!firrtl.uint<4>, !firrtl.uint<4>) -> !firrtl.uint
+    firrtl.connect %b, %0 : !firrtl.uint, !firrtl.uint
+  }
+
+  // CHECK-LABEL: firrtl.module private @Known
+  firrtl.module private @Known(in %a: !firrtl.uint<4>, out %b: !firrtl.uint<4>) {
+    // CHECK: %w = firrtl.wire : !firrtl.uint<4>
+    %w = firrtl.wire : !firrtl.uint
+    firrtl.connect %w, %a : !firrtl.uint, !firrtl.uint<4>
+    firrtl.connect %b, %w : !firrtl.uint<4>, !firrtl.uint
+  }
+
+  // CHECK-LABEL: firrtl.module private @Other
+  firrtl.module private @Other(in %a: !firrtl.uint<2>) {
+    // CHECK: %w = firrtl.wire : !firrtl.uint<2>
+    %w = firrtl.wire : !firrtl.uint
+    firrtl.connect %w, %a : !firrtl.uint, !firrtl.uint<2>
+  }
+}
@@ -1,5 +1,6 @@
 // RUN: circt-opt %s -ssp-roundtrip=verify
 // RUN: circt-opt %s -ssp-schedule="scheduler=simplex options=cycle-time=5.0" | FileCheck %s -check-prefixes=CHECK,SIMPLEX
+// RUN: circt-opt %s -ssp-schedule="scheduler=simplex options=cycle-time=5.0,tableau=dense" | FileCheck %s -check-prefixes=CHECK,SIMPLEX
 
 // Note: Cycle time is only evaluated for scheduler test; ignored by the problem test!
 
@@ -1,5 +1,6 @@
 // RUN: circt-opt %s -ssp-roundtrip=verify
 // RUN: circt-opt %s -ssp-schedule=scheduler=simplex | FileCheck %s -check-prefixes=CHECK,SIMPLEX
+// RUN: circt-opt %s -ssp-schedule="scheduler=simplex options=tableau=dense" | FileCheck %s -check-prefixes=CHECK,SIMPLEX
 // RUN: %if or-tools %{ circt-opt %s -ssp-schedule=scheduler=lp | FileCheck %s -check-prefixes=CHECK,LP %} 
 
 // CHECK-LABEL: cyclic
@@ -1,5 +1,6 @@
 // RUN: circt-opt %s -ssp-roundtrip=verify
 // RUN: circt-opt %s -ssp-schedule=scheduler=simplex | FileCheck %s -check-prefixes=CHECK,SIMPLEX
+// RUN: circt-opt %s -ssp-schedule="scheduler=simplex options=tableau=dense" | FileCheck %s -check-prefixes=CHECK,SIMPLEX
 
 // CHECK-LABEL: canis14_fig2
 // SIMPLEX-SAME: [II<4>]
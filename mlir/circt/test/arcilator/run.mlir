@@ -0,0 +1,65 @@
+// RUN: rm -rf %t
+// RUN: split-file %s %t
+// RUN: arcilator %t/top.mlir --run --stimulus=%t/top.stim | FileCheck %s
+// RUN: arcilator %t/top.mlir --run --stimulus=%t/top.stim --jit-cache-dir=%t/cache | FileCheck %s
+// RUN: ls %t/cache | FileCheck %s --check-prefix=CACHE
+// RUN: arcilator %t/top.mlir --run --stimulus=%t/top.stim --jit-cache-dir=%t/cache --state-file=%t/cached-state.json | FileCheck %s
+// RUN: arcilator %t/top.mlir --state-file=%t/state.json -o %t/top.ll
+// RUN: diff %t/state.json %t/cached-state.json
+// RUN: arcilator %t/top.mlir --run --stimulus=%t/top.stim --jit-cache-dir=%t/cache --print-debug-info | FileCheck %s
+// RUN: ls %t/cache | FileCheck %s --check-prefix=CACHE-DEBUG
+// RUN: arcilator %t/top.mlir --run --batch=4 --stimulus=%t/batch.stim | FileCheck %s --check-prefix=BATCH
+// RUN: not arcilator %t/top.mlir --run --stimulus=%t/bad.stim 2>&1 | FileCheck %s --check-prefix=ERR
+
+// CHECK:      out = 0
+// CHECK-NEXT: out = 15
+// CHECK-NEXT: out = 5
+// CHECK-NEXT: i0 = 1
+
+// CACHE: {{^[0-9a-f]+\.json$}}
+// CACHE: {{^[0-9a-f]+\.o$}}
+
+// Debug info yields a different model, which is cached separately.
+// CACHE-DEBUG-COUNT-2: {{^[0-9a-f]+\.o$}}
+
+// BATCH:      out = 15
+// BATCH-NEXT: out = 0
+
+// ERR: bad.stim:2: error: unknown signal `nope`
+
+//--- top.mlir
+hw.module @Top(in %clock : !seq.clock, in %i0 : i4, in %i1 : i4, out out : i4) {
+  %0 = comb.add %i0, %i1 : i4
+  %1 = comb.xor %0, %i0 : i4
+  %2 = comb.xor %0, %i1 : i4
+  %foo = seq.compreg %1, %clock : i4
+  %bar = seq.compreg %2, %clock : i4
+  %3 = comb.mul %foo, %bar : i4
+  hw.output %3 : i4
+}
+
+//--- top.stim
+# (3 + 5) ^ 3 = 11, (3 + 5) ^ 5 = 13, 11 * 13 = 15 (mod 16)
+set i0 3
+set i1 5
+eval
+print out
+tick clock
+print out
+# (1 + 5) ^ 1 = 7, (1 + 5) ^ 5 = 3, 7 * 3 = 5 (mod 16)
+set i0 0x1
+tick clock 2
+print out i0
+
+//--- batch.stim
+copy 1
+set i0 3
+set i1 5
+tick clock
+print out
+copy 0
+print out
+
+//--- bad.stim
+set i0 3
+set nope 1
@@ -0,0 +1,48 @@
+// UNSUPPORTED: system-windows
+//   See https://github.com/llvm/circt/issues/4129
+// RUN: split-file %s %t
+// RUN: circt-reduce %t/prune.mlir --test /usr/bin/env --test-arg grep --test-arg -q --test-arg "hw.module @Foo" --keep-best=0 --include operation-pruner -j 4 | FileCheck %s --check-prefix=PRUNE
+// RUN: circt-reduce %t/merge.mlir --test /bin/sh --test-arg -c --test-arg 'grep -q "hw.module @Foo" "$0" || grep -q "hw.module @Bar" "$0"' --keep-best=0 --include operation-pruner -j 2 | FileCheck %s --check-prefix=MERGE
+
+//--- prune.mlir
+
+// PRUNE-NOT: hw.module @Bar
+hw.module @Bar(in %arg0: i32, out out: i32) {
+  hw.output %arg0 : i32
+}
+
+// PRUNE-NOT: hw.module @Baz
+hw.module @Baz(in %arg0: i32, out out: i32) {
+  hw.output %arg0 : i32
+}
+
+// PRUNE-LABEL: hw.module @Foo
+hw.module @Foo(in %arg0: i32, out out: i32) {
+  hw.output %arg0 : i32
+}
+
+// PRUNE-NOT: hw.module @Qux
+hw.module @Qux(in %arg0: i32, out out: i32) {
+  hw.output %arg0 : i32
+}
+
+// PRUNE-NOT: hw.module @Quux
+hw.module @Quux(in %arg0: i32, out out: i32) {
+  hw.output %arg0 : i32
+}
+
+//--- merge.mlir
+
+// Removing either module on its own keeps the test interesting, but removing
+// both does not. The two candidates are accepted, their merge is rejected, and
+// the reduction falls back to the first candidate.
+
+// MERGE-NOT: hw.module @Foo
+hw.module @Foo(in %arg0: i32, out out: i32) {
+  hw.output %arg0 : i32
+}
+
+// MERGE: hw.module @Bar
+hw.module @Bar(in %arg0: i32, out out: i32) {
+  hw.output %arg0 : i32
+}
@@ -0,0 +1,41 @@
+#!/bin/sh
+# Start a firtool compile server in the given directory, send it a request for
+# the given input through `--connect`, and shut it down again.
+#
+# Usage: compile-server.sh <firtool> <directory> <input>
+#
+# Writes the compiled output to `served.sv` and the diagnostics of a request
+# for a missing file to `error.log` in the directory.
+set -e
+firtool=$1
+cd "$2"
+
+# Use a relative socket path; the absolute one may be too long for a socket.
+"$firtool" --serve=socket 2> server.log &
+server=$!
+trap 'kill $server 2> /dev/null || true' EXIT
+
+tries=0
+while [ ! -S socket ]; do
+  tries=$((tries + 1))
+  if [ $tries -gt 600 ]; then
+    echo "compile server did not start" >&2
+    cat server.log >&2
+    exit 1
+  fi
+  sleep 0.1
+done
+
+"$firtool" --connect=socket "$3" -o served.sv
+
+# Failing requests report their diagnostics and exit code to the client.
+if "$firtool" --connect=socket does-not-exist.fir -o /dev/null 2> error.log; then
+  echo "request for a missing file succeeded" >&2
+  exit 1
+fi
+
+# The server finishes on SIGTERM and removes its socket.
+kill $server
+wait $server
+trap - EXIT
+test ! -e socket
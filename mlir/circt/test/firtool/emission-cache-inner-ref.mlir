@@ -0,0 +1,44 @@
+// RUN: rm -rf %t %t.cache
+// RUN: split-file %s %t
+// RUN: firtool %t/foo.mlir --format=mlir -split-verilog -o=%t/first --emission-cache-dir=%t.cache
+// RUN: firtool %t/bar.mlir --format=mlir -split-verilog -o=%t/second --emission-cache-dir=%t.cache -mlir-pass-statistics 2>&1 | FileCheck %s --check-prefix=STATS
+// RUN: FileCheck %s --check-prefix=FOO < %t/first/Top.sv
+// RUN: FileCheck %s --check-prefix=BAR < %t/second/Top.sv
+
+// Top.sv names a wire inside Child through an inner symbol. Renaming that wire
+// changes Top.sv even though Top and the ports of Child are unchanged, so
+// neither file may be reused from the cache.
+
+// STATS: ExportSplitVerilog
+// STATS: (S) 0 num-cache-hits
+
+// FOO: // Child wire: foo
+// BAR: // Child wire: bar
+
+//--- foo.mlir
+hw.module @Child(in %a: i1, out b: i1) {
+  %foo = sv.wire sym @w : !hw.inout<i1>
+  sv.assign %foo, %a : i1
+  %0 = sv.read_inout %foo : !hw.inout<i1>
+  hw.output %0 : i1
+}
+
+hw.module @Top(in %x: i1, out y: i1) {
+  %0 = hw.instance "child" @Child(a: %x: i1) -> (b: i1)
+  sv.verbatim "// Child wire: {{0}}" {symbols = [#hw.innerNameRef<@Child::@w>]}
+  hw.output %0 : i1
+}
+
+//--- bar.mlir
+hw.module @Child(in %a: i1, out b: i1) {
+  %bar = sv.wire sym @w : !hw.inout<i1>
+  sv.assign %bar, %a : i1
+  %0 = sv.read_inout %bar : !hw.inout<i1>
+  hw.output %0 : i1
+}
+
+hw.module @Top(in %x: i1, out y: i1) {
+  %0 = hw.instance "child" @Child(a: %x: i1) -> (b: i1)
+  sv.verbatim "// Child wire: {{0}}" {symbols = [#hw.innerNameRef<@Child::@w>]}
+  hw.output %0 : i1
+}
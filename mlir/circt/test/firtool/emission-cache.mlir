@@ -0,0 +1,26 @@
+// RUN: rm -rf %t %t.cache
+// RUN: firtool %s --format=mlir -split-verilog -o=%t/first --emission-cache-dir=%t.cache -mlir-pass-statistics 2>&1 | FileCheck %s --check-prefix=FIRST
+// RUN: firtool %s --format=mlir -split-verilog -o=%t/second --emission-cache-dir=%t.cache -mlir-pass-statistics 2>&1 | FileCheck %s --check-prefix=SECOND
+// RUN: diff %t/first/Child.sv %t/second/Child.sv
+// RUN: diff %t/first/Top.sv %t/second/Top.sv
+// RUN: FileCheck %s --check-prefix=TOP < %t/second/Top.sv
+
+// FIRST: ExportSplitVerilog
+// FIRST: (S) 0 num-cache-hits
+
+// SECOND: ExportSplitVerilog
+// SECOND: (S) 2 num-cache-hits
+
+hw.module @Child(in %a: i1, out b: i1) {
+  hw.output %a : i1
+}
+
+// TOP-LABEL: module Top(
+// TOP:         Child child (
+// TOP-NEXT:      .a (x),
+// TOP-NEXT:      .b (y)
+// TOP-NEXT:    );
+hw.module @Top(in %x: i1, out y: i1) {
+  %0 = hw.instance "child" @Child(a: %x: i1) -> (b: i1)
+  hw.output %0 : i1
+}
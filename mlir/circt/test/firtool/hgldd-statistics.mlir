@@ -0,0 +1,22 @@
+// RUN: firtool %s --format=mlir --emit-hgldd -o %t.sv -mlir-pass-statistics 2>&1 | FileCheck %s
+// RUN: rm -rf %t
+// RUN: firtool %s --format=mlir --emit-hgldd -split-verilog -o=%t -mlir-pass-statistics 2>&1 | FileCheck %s --check-prefix=SPLIT
+
+// CHECK: EmitHGLDDPass
+// CHECK-DAG: (S) {{[1-9][0-9]*}} num-bytes
+// CHECK-DAG: (S) {{[1-9][0-9]*}} num-files
+// CHECK-DAG: (S) {{[1-9][0-9]*}} num-objects
+
+// SPLIT: EmitSplitHGLDDPass
+// SPLIT-DAG: (S) {{[1-9][0-9]*}} num-bytes
+// SPLIT-DAG: (S) 2 num-files
+// SPLIT-DAG: (S) {{[1-9][0-9]*}} num-objects
+
+hw.module @Child(in %a: i1, out b: i1) {
+  hw.output %a : i1
+}
+
+hw.module @Top(in %x: i1, out y: i1) {
+  %0 = hw.instance "child" @Child(a: %x: i1) -> (b: i1)
+  hw.output %0 : i1
+}
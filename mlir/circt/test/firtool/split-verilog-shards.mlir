@@ -0,0 +1,48 @@
+// RUN: rm -rf %t.unsharded %t.sharded %t.shard1 %t.three0 %t.three1 %t.three2
+// RUN: firtool %s --format=mlir -split-verilog -o=%t.unsharded
+// RUN: firtool %s --format=mlir -split-verilog -o=%t.sharded --split-verilog-num-shards=2 --split-verilog-shard-index=0
+// RUN: firtool %s --format=mlir -split-verilog -o=%t.sharded --split-verilog-num-shards=2 --split-verilog-shard-index=1
+// RUN: diff -r %t.unsharded %t.sharded
+// RUN: firtool %s --format=mlir -split-verilog -o=%t.shard1 --split-verilog-num-shards=2 --split-verilog-shard-index=1
+// RUN: ls %t.shard1 | FileCheck %s --implicit-check-not=Big.sv --implicit-check-not=filelist.f
+// RUN: not firtool %s --format=mlir -split-verilog -o=%t.invalid --split-verilog-num-shards=2 --split-verilog-shard-index=2 2>&1 | FileCheck %s --check-prefix=INVALID
+
+// Emit three shards into separate directories. Listed together, they must
+// name every file of the unsharded run exactly once: a file emitted by two
+// shards shows up twice and a file emitted by none is missing.
+// RUN: firtool %s --format=mlir -split-verilog -o=%t.three0 --split-verilog-num-shards=3 --split-verilog-shard-index=0
+// RUN: firtool %s --format=mlir -split-verilog -o=%t.three1 --split-verilog-num-shards=3 --split-verilog-shard-index=1
+// RUN: firtool %s --format=mlir -split-verilog -o=%t.three2 --split-verilog-num-shards=3 --split-verilog-shard-index=2
+// RUN: ls %t.three0 > %t.files
+// RUN: ls %t.three1 >> %t.files
+// RUN: ls %t.three2 >> %t.files
+// RUN: sort %t.files > %t.files.sorted
+// RUN: ls %t.unsharded | sort > %t.files.expected
+// RUN: diff %t.files.expected %t.files.sorted
+
+// CHECK: Small.sv
+
+// INVALID: error: invalid shard 2 of 2 shards
+
+hw.module @Big(in %a: i8, in %b: i8, out c: i8) {
+  %0 = comb.add %a, %b : i8
+  %1 = comb.mul %0, %a : i8
+  %2 = comb.xor %1, %b : i8
+  hw.output %2 : i8
+}
+
+hw.module @Medium(in %a: i8, in %b: i8, out c: i8) {
+  %0 = comb.add %a, %b : i8
+  hw.output %0 : i8
+}
+
+hw.module @Small(in %a: i8, out b: i8) {
+  hw.output %a : i8
+}
+
+hw.module @Top(in %a: i8, in %b: i8, out c: i8, out d: i8, out e: i8) {
+  %0 = hw.instance "big" @Big(a: %a: i8, b: %b: i8) -> (c: i8)
+  %1 = hw.instance "medium" @Medium(a: %a: i8, b: %b: i8) -> (c: i8)
+  %2 = hw.instance "small" @Small(a: %a: i8) -> (b: i8)
+  hw.output %0, %1, %2 : i8, i8, i8
+}
@@ -46,10 +46,13 @@ class StateInfo:
   typ: StateType
   stride: Optional[int]
   depth: Optional[int]
+  copyStride: Optional[int]
+  dirtyFlag: Optional[int]
 
   def decode(d: dict) -> "StateInfo":
     return StateInfo(d["name"], d["offset"], d["numBits"], StateType(d["type"]),
-                     d.get("stride"), d.get("depth"))
+                     d.get("stride"), d.get("depth"), d.get("copyStride"),
+                     d.get("dirtyFlag"))
 
 
 @dataclass
@@ -63,12 +66,18 @@ class StateHierarchy:
 class ModelInfo:
   name: str
   numStateBytes: int
+  partitioned: bool
+  batch: int
+  dirtyFlagsOffset: int
+  numDirtyFlags: int
   states: List[StateInfo]
   io: List[StateInfo]
   hierarchy: List[StateHierarchy]
 
   def decode(d: dict) -> "ModelInfo":
-    return ModelInfo(d["name"], d["numStateBytes"],
+    return ModelInfo(d["name"], d["numStateBytes"], d.get("partitioned", False),
+                     d.get("batch", 1), d.get("dirtyFlagsOffset", 0),
+                     d.get("numDirtyFlags", 0),
                      [StateInfo.decode(d) for d in d["states"]], list(), list())
 
 
@@ -136,8 +145,12 @@ def format_signal(state: StateInfo) -> str:
       f"\"{state.name}\"", state.offset, state.numBits,
       f"Signal::{state.typ.value.capitalize()}"
   ]
-  if state.typ == StateType.MEMORY:
-    fields += [state.stride, state.depth]
+  if state.typ == StateType.MEMORY or state.copyStride or state.dirtyFlag:
+    fields += [state.stride or 0, state.depth or 0]
+  if state.copyStride or state.dirtyFlag:
+    fields += [state.copyStride or 0]
+  if state.dirtyFlag:
+    fields += [state.dirtyFlag]
   fields = ", ".join((str(f) for f in fields))
   return f"Signal{{{fields}}}"
 
@@ -206,6 +219,8 @@ def format_view_hierarchy(hierarchy: StateHierarchy, depth: int) -> str:
 
 
 def state_cpp_ref(state: StateInfo) -> str:
+  if state.copyStride:
+    return f"*({state_cpp_type(state)}*)(state+{state.offset}+copy*{state.copyStride})"
   return f"*({state_cpp_type(state)}*)(state+{state.offset})"
 
 
@@ -233,7 +248,7 @@ print("#include \"arcilator-runtime.h\"")
 for model in models:
   sys.stderr.write(f"Generating `{model.name}` model\n")
 
-  reserved = {"state"}
+  reserved = {"state", "copy"}
 
   for io in model.io:
     if io.name in reserved:
@@ -241,6 +256,17 @@ for model in models:
 
   print('extern "C" {')
   print(f"void {model.name}_eval(void* state);")
+  if model.partitioned:
+    print(f"void {model.name}_partition(void* state, uint32_t index);")
+    # The header may be included from several translation units. The hook is
+    # only called from the model, so force its emission where it is inline.
+    print(
+        f"__attribute__((used)) inline void {model.name}_run_partitions(void* state, uint32_t first, uint32_t count) {{"
+    )
+    print(
+        f"  PartitionRunner::get().run({model.name}_partition, state, first, count);"
+    )
+    print("}")
   print('}')
 
   # Generate the model layout.
@@ -250,23 +276,33 @@ for model in models:
   print(f"  static const char *name;")
   print(f"  static const unsigned numStates;")
   print(f"  static const unsigned numStateBytes;")
+  print(f"  static const unsigned batchSize;")
+  print(f"  static const unsigned dirtyFlagsOffset;")
+  print(f"  static const unsigned numDirtyFlags;")
   print(f"  static const std::array<Signal, {len(model.io)}> io;")
   print(f"  static const Hierarchy hierarchy;")
   print("};")
   print()
-  print(f"const char *{model.name}Layout::name = \"{model.name}\";")
-  print(f"const unsigned {model.name}Layout::numStates = {len(model.states)};")
+  print(f"inline const char *{model.name}Layout::name = \"{model.name}\";")
+  print(f"inline const unsigned {model.name}Layout::numStates = {len(model.states)};")
+  print(
+      f"inline const unsigned {model.name}Layout::numStateBytes = {model.numStateBytes};"
+  )
+  print(f"inline const unsigned {model.name}Layout::batchSize = {model.batch};")
   print(
-      f"const unsigned {model.name}Layout::numStateBytes = {model.numStateBytes};"
+      f"inline const unsigned {model.name}Layout::dirtyFlagsOffset = {model.dirtyFlagsOffset};"
   )
   print(
-      f"const std::array<Signal, {len(model.io)}> {model.name}Layout::io = {{")
+      f"inline const unsigned {model.name}Layout::numDirtyFlags = {model.numDirtyFlags};"
+  )
+  print(
+      f"inline const std::array<Signal, {len(model.io)}> {model.name}Layout::io = {{")
   for io in model.io:
     print(f"  {format_signal(io)},")
   print("};")
   print()
   print(
-      f"const Hierarchy {model.name}Layout::hierarchy = {indent(format_hierarchy(model.hierarchy[0]))};"
+      f"inline const Hierarchy {model.name}Layout::hierarchy = {indent(format_hierarchy(model.hierarchy[0]))};"
   )
 
   # Generate the model view.
@@ -280,7 +316,7 @@ for model in models:
   )
   print("  uint8_t *state;")
   print()
-  print(f"  {model.name}View(uint8_t *state) :")
+  print(f"  {model.name}View(uint8_t *state, unsigned copy = 0) :")
   for io in model.io:
     print(f"    {io.name}({state_cpp_ref(io)}),")
   print(
@@ -293,7 +329,7 @@ for model in models:
   print()
   print(f"class {model.name} {{")
   print("public:")
-  print(f"  std::vector<uint8_t> storage;")
+  print(f"  std::vector<uint8_t, CacheAlignedAllocator<uint8_t>> storage;")
   print(f"  {model.name}View view;")
   print()
   print(
@@ -301,13 +337,26 @@ for model in models:
   )
   print(f"  void eval() {{ {model.name}_eval(&storage[0]); }}")
   print(
-      f"  ValueChangeDump<{model.name}Layout> vcd(std::basic_ostream<char> &os) {{"
+      f"  {model.name}View at(unsigned copy) {{ return {model.name}View(&storage[0], copy); }}"
+  )
+  print(
+      f"  ValueChangeDump<{model.name}Layout> vcd(std::basic_ostream<char> &os, unsigned copy = 0) {{"
   )
-  print(f"    ValueChangeDump<{model.name}Layout> vcd(os, &storage[0]);")
+  print(f"    ValueChangeDump<{model.name}Layout> vcd(os, &storage[0], copy);")
   print("    vcd.writeHeader();")
   print("    vcd.writeDumpvars();")
   print("    return vcd;")
   print("  }")
+  print(
+      f"  std::unique_ptr<BinaryTrace<{model.name}Layout>> trace(std::basic_ostream<char> &os, unsigned copy = 0) {{"
+  )
+  print(
+      f"    auto trace = std::make_unique<BinaryTrace<{model.name}Layout>>(os, &storage[0], copy);"
+  )
+  print("    trace->writeHeader();")
+  print("    trace->writeDumpvars();")
+  print("    return trace;")
+  print("  }")
   print("};")
 
   # Generate a port name macro.
@@ -1,10 +1,18 @@
 // NOLINTBEGIN
 #pragma once
 #include <array>
+#include <atomic>
+#include <condition_variable>
 #include <cstdint>
+#include <cstdlib>
 #include <cstring>
 #include <functional>
+#include <memory>
+#include <mutex>
+#include <new>
 #include <ostream>
+#include <string>
+#include <thread>
 #include <vector>
 
 struct Signal {
@@ -15,6 +23,12 @@ struct Signal {
   // for memories:
   unsigned stride;
   unsigned depth;
+  // for batched models, the byte separation between the copies of the signal
+  // for consecutive copies of the design:
+  unsigned copyStride;
+  // for models compiled with `--dirty-flags`, the offset of the byte the model
+  // sets whenever it writes the signal, or 0 if it has none:
+  unsigned dirtyFlag;
 };
 
 struct Hierarchy {
@@ -37,11 +51,185 @@ struct Memory {
   } words[Depth];
 };
 
+// Allocates memory aligned to cache lines, such that the per-partition state
+// regions laid out by `arc-allocate-state` do not share cache lines.
+template <typename T>
+struct CacheAlignedAllocator {
+  using value_type = T;
+  static constexpr std::size_t alignment = 64;
+
+  CacheAlignedAllocator() = default;
+  template <typename U>
+  CacheAlignedAllocator(const CacheAlignedAllocator<U> &) {}
+
+  T *allocate(std::size_t n) {
+    return static_cast<T *>(
+        ::operator new(n * sizeof(T), std::align_val_t(alignment)));
+  }
+  void deallocate(T *p, std::size_t) {
+    ::operator delete(p, std::align_val_t(alignment));
+  }
+  template <typename U>
+  bool operator==(const CacheAlignedAllocator<U> &) const {
+    return true;
+  }
+  template <typename U>
+  bool operator!=(const CacheAlignedAllocator<U> &) const {
+    return false;
+  }
+};
+
+// Runs the partitions of a model's clock trees on a pool of threads. The
+// calling thread takes part in the evaluation, and partition `i` is always
+// evaluated by thread `i % n`, where `n` is the number of threads used for the
+// clock tree, such that each partition's state stays in the same core's cache
+// across cycles. `run` returns once all partitions have been evaluated, which
+// acts as a barrier between clock trees.
+//
+// At most as many threads as there are partitions are used. Workers are
+// started the first time they are needed, up to the hardware concurrency, or
+// the `ARC_NUM_THREADS` environment variable if it is set. Idle workers spin
+// briefly, since the next clock tree usually follows right away, and then park
+// on a condition variable.
+class PartitionRunner {
+public:
+  using PartitionFn = void (*)(void *state, uint32_t index);
+
+  static PartitionRunner &get() {
+    static PartitionRunner runner(getDefaultNumThreads());
+    return runner;
+  }
+
+  explicit PartitionRunner(unsigned maxThreads)
+      : maxThreads(maxThreads ? maxThreads : 1) {}
+
+  ~PartitionRunner() {
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      stop.store(true, std::memory_order_relaxed);
+      generation.fetch_add(1, std::memory_order_release);
+    }
+    wakeup.notify_all();
+    for (auto &worker : workers)
+      worker.join();
+  }
+
+  PartitionRunner(const PartitionRunner &) = delete;
+  PartitionRunner &operator=(const PartitionRunner &) = delete;
+
+  void run(PartitionFn fn, void *state, uint32_t first, uint32_t count) {
+    unsigned numActive = count < maxThreads ? count : maxThreads;
+    if (numActive < 2) {
+      for (uint32_t i = 0; i < count; ++i)
+        fn(state, first + i);
+      return;
+    }
+
+    // Start any workers this clock tree needs that are not running yet. They
+    // only look at jobs published after this point.
+    uint64_t current = generation.load(std::memory_order_relaxed);
+    while (workers.size() + 1 < numActive) {
+      unsigned thread = workers.size() + 1;
+      workers.emplace_back(
+          [this, thread, current] { workerLoop(thread, current); });
+    }
+
+    // Every worker acknowledges every job, including the ones that have no
+    // partitions to evaluate in it, such that `job` is not overwritten while
+    // a worker may still read it.
+    job = {fn, state, first, count, numActive};
+    pending.store(workers.size(), std::memory_order_relaxed);
+    bool anyParked;
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      generation.fetch_add(1, std::memory_order_release);
+      anyParked = numParked != 0;
+    }
+    if (anyParked)
+      wakeup.notify_all();
+
+    runShare(0);
+    for (unsigned spins = 0; pending.load(std::memory_order_acquire) != 0;)
+      backoff(spins);
+  }
+
+private:
+  struct Job {
+    PartitionFn fn;
+    void *state;
+    uint32_t first;
+    uint32_t count;
+    unsigned numActive;
+  };
+
+  /// How often an idle worker checks for a new job before it parks.
+  static constexpr unsigned maxSpins = 1 << 14;
+
+  static unsigned getDefaultNumThreads() {
+    if (const char *env = std::getenv("ARC_NUM_THREADS"))
+      return std::strtoul(env, nullptr, 10);
+    return std::thread::hardware_concurrency();
+  }
+
+  static void backoff(unsigned &spins) {
+    if (++spins > 1024)
+      std::this_thread::yield();
+  }
+
+  void runShare(unsigned thread) {
+    for (uint32_t i = thread; i < job.count; i += job.numActive)
+      job.fn(job.state, job.first + i);
+  }
+
+  // Wait for a job newer than `seenGeneration` and return its generation.
+  uint64_t waitForJob(uint64_t seenGeneration) {
+    uint64_t current;
+    for (unsigned spins = 0; spins < maxSpins; backoff(spins))
+      if ((current = generation.load(std::memory_order_acquire)) !=
+          seenGeneration)
+        return current;
+
+    // `run` bumps the generation while holding the mutex, so it cannot slip in
+    // between the check and the wait.
+    std::unique_lock<std::mutex> lock(mutex);
+    ++numParked;
+    wakeup.wait(lock, [&] {
+      current = generation.load(std::memory_order_acquire);
+      return current != seenGeneration;
+    });
+    --numParked;
+    return current;
+  }
+
+  void workerLoop(unsigned thread, uint64_t seenGeneration) {
+    while (true) {
+      seenGeneration = waitForJob(seenGeneration);
+      if (stop.load(std::memory_order_relaxed))
+        return;
+      if (thread < job.numActive)
+        runShare(thread);
+      pending.fetch_sub(1, std::memory_order_release);
+    }
+  }
+
+  const unsigned maxThreads;
+  std::vector<std::thread> workers;
+  Job job = {};
+  alignas(64) std::atomic<uint64_t> generation{0};
+  alignas(64) std::atomic<unsigned> pending{0};
+  std::atomic<bool> stop{false};
+  std::mutex mutex;
+  std::condition_variable wakeup;
+  // The number of workers waiting on `wakeup`. Guarded by `mutex`.
+  unsigned numParked = 0;
+};
+
 template <class ModelLayout>
 class ValueChangeDump {
 public:
-  ValueChangeDump(std::basic_ostream<char> &os, const uint8_t *state)
-      : os(os), state(state) {}
+  ValueChangeDump(std::basic_ostream<char> &os, const uint8_t *state,
+                  unsigned copy = 0)
+      : os(os), state(state), copy(copy) {}
 
   void writeHeader(bool withHierarchy = true) {
     os << "$date\n    October 21, 2015\n$end\n";
@@ -53,7 +241,8 @@ public:
     auto writeSignal = [&](const Signal &state) {
       if (state.type != Signal::Memory) {
         auto &signal =
-            allocSignal(state, state.offset, (state.numBits + 7) / 8);
+            allocSignal(state, state.offset + copy * state.copyStride,
+                        (state.numBits + 7) / 8);
         if (state.type == Signal::Register) {
           os << "$var reg " << state.numBits << " " << signal.abbrev << " "
              << state.name;
@@ -66,8 +255,9 @@ public:
         os << " $end\n";
       } else {
         for (unsigned i = 0; i < state.depth; ++i) {
-          auto &signal = allocSignal(state, state.offset + i * state.stride,
-                                     (state.numBits + 7) / 8);
+          auto &signal = allocSignal(
+              state, state.offset + copy * state.copyStride + i * state.stride,
+              (state.numBits + 7) / 8);
           os << "$var reg " << state.numBits << " " << signal.abbrev << " "
              << state.name << "[" << i << "]";
           if (state.numBits > 1)
@@ -155,8 +345,328 @@ private:
 
   std::basic_ostream<char> &os;
   const uint8_t *state;
+  unsigned copy;
   std::vector<VcdSignal> signals;
   std::vector<uint8_t> previousValues;
 };
 
+// Writes a compact binary trace of a model's signals. This is a faster
+// alternative to `ValueChangeDump`: the simulation thread only determines which
+// signals changed and appends their new values to a buffer, while encoding the
+// changes and writing them out happens on a background thread. The two threads
+// trade a pair of buffers, each holding many timesteps, such that they only
+// synchronize once per buffer.
+//
+// If the model was compiled with `--dirty-flags`, signals the model has not
+// written since the previous timestep are skipped without looking at their
+// value. Inputs are compared on every timestep. Other signals changed directly
+// through a view are only picked up once the model writes them again.
+//
+// The trace starts with the magic `ARCTRACE`, a format version, and the signal
+// definitions, followed by blocks of value changes and an end marker carrying
+// the final time. Within a block, each timestep is encoded as the increment in
+// time, the indices of the changed signals as deltas, and the XOR of the new
+// and previous values of those signals, in which runs of zero bytes are
+// run-length encoded. All integers are LEB128 varints. The
+// `arcilator-trace-to-vcd.py` script converts traces to VCD.
+template <class ModelLayout>
+class BinaryTrace {
+public:
+  static constexpr unsigned formatVersion = 1;
+  // The number of bytes of value changes after which the simulation thread
+  // hands its buffer over to the background thread.
+  static constexpr size_t chunkSize = 1 << 20;
+
+  BinaryTrace(std::basic_ostream<char> &os, uint8_t *state, unsigned copy = 0)
+      : os(os), state(state), copy(copy) {}
+  ~BinaryTrace() { close(); }
+
+  BinaryTrace(const BinaryTrace &) = delete;
+  BinaryTrace &operator=(const BinaryTrace &) = delete;
+
+  void writeHeader(bool withHierarchy = true) {
+    std::vector<uint8_t> out;
+    const char magic[] = "ARCTRACE";
+    out.insert(out.end(), magic, magic + 8);
+    appendVarint(out, formatVersion);
+
+    auto writeScope = [&](const char *name) {
+      out.push_back('S');
+      appendString(out, name, std::strlen(name));
+    };
+    auto writeVar = [&](const Signal &state, unsigned offset,
+                        const std::string &name) {
+      out.push_back('V');
+      out.push_back(state.type == Signal::Register ||
+                    state.type == Signal::Memory);
+      appendVarint(out, state.numBits);
+      appendString(out, name.data(), name.size());
+      unsigned numBytes = (state.numBits + 7) / 8;
+      signals.push_back(TraceSignal{offset, numBytes,
+                                    unsigned(currentValues.size()),
+                                    state.dirtyFlag});
+      currentValues.resize(currentValues.size() + numBytes);
+    };
+    auto writeSignal = [&](const Signal &state) {
+      unsigned offset = state.offset + copy * state.copyStride;
+      if (state.type != Signal::Memory) {
+        writeVar(state, offset, state.name);
+        return;
+      }
+      for (unsigned i = 0; i < state.depth; ++i)
+        writeVar(state, offset + i * state.stride,
+                 std::string(state.name) + "[" + std::to_string(i) + "]");
+    };
+    std::function<void(const Hierarchy &)> writeHierarchy =
+        [&](const Hierarchy &hierarchy) {
+          writeScope(hierarchy.name);
+          for (unsigned i = 0; i < hierarchy.numStates; ++i)
+            writeSignal(hierarchy.states[i]);
+          for (unsigned i = 0; i < hierarchy.numChildren; ++i)
+            writeHierarchy(hierarchy.children[i]);
+          out.push_back('U');
+        };
+
+    writeScope(ModelLayout::name);
+    for (auto &port : ModelLayout::io)
+      writeSignal(port);
+    if (withHierarchy)
+      writeHierarchy(ModelLayout::hierarchy);
+    out.push_back('U');
+    out.push_back('D');
+    os.write(reinterpret_cast<const char *>(out.data()), out.size());
+
+    previousValues.resize(currentValues.size());
+    worker = std::thread([this] { workerLoop(); });
+  }
+
+  void writeValues(bool includeUnchanged = false) {
+    size_t start = front.size();
+    appendRaw<uint64_t>(front, time);
+    appendRaw<uint32_t>(front, 0);
+    uint32_t numChanges = 0;
+    for (uint32_t index = 0; index < signals.size(); ++index) {
+      auto &signal = signals[index];
+      if (!includeUnchanged && signal.dirtyFlag && !state[signal.dirtyFlag])
+        continue;
+      const uint8_t *valNew = state + signal.offset;
+      uint8_t *valOld = &currentValues[signal.valueOffset];
+      if (!includeUnchanged &&
+          std::memcmp(valNew, valOld, signal.numBytes) == 0)
+        continue;
+      std::memcpy(valOld, valNew, signal.numBytes);
+      appendRaw<uint32_t>(front, index);
+      front.insert(front.end(), valNew, valNew + signal.numBytes);
+      ++numChanges;
+    }
+    std::memset(state + ModelLayout::dirtyFlagsOffset, 0,
+                ModelLayout::numDirtyFlags);
+
+    // Timesteps without any changes are omitted from the trace.
+    if (numChanges == 0) {
+      front.resize(start);
+      return;
+    }
+    std::memcpy(&front[start + sizeof(uint64_t)], &numChanges,
+                sizeof(numChanges));
+    if (front.size() >= chunkSize)
+      handOff();
+  }
+
+  void writeDumpvars() { writeValues(true); }
+
+  void writeTimestep(size_t timeIncrement) {
+    time += timeIncrement;
+    writeValues();
+  }
+
+  // Wait until all timesteps recorded so far have been written to the stream.
+  void flush() {
+    if (!worker.joinable())
+      return;
+    if (!front.empty())
+      handOff();
+    std::unique_lock<std::mutex> lock(mutex);
+    condition.wait(lock, [&] { return !backFull; });
+    os.flush();
+  }
+
+  // Write all remaining timesteps and the end marker, and stop the background
+  // thread. Called by the destructor if not called explicitly.
+  void close() {
+    if (!worker.joinable())
+      return;
+    if (!front.empty())
+      handOff();
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      stop = true;
+    }
+    condition.notify_all();
+    worker.join();
+    std::vector<uint8_t> out;
+    out.push_back('E');
+    appendVarint(out, time);
+    os.write(reinterpret_cast<const char *>(out.data()), out.size());
+    os.flush();
+  }
+
+  size_t time = 0;
+
+private:
+  struct TraceSignal {
+    unsigned offset;
+    unsigned numBytes;
+    unsigned valueOffset;
+    unsigned dirtyFlag;
+  };
+
+  static void appendVarint(std::vector<uint8_t> &out, uint64_t value) {
+    while (value >= 0x80) {
+      out.push_back(uint8_t(value) | 0x80);
+      value >>= 7;
+    }
+    out.push_back(uint8_t(value));
+  }
+
+  static void appendString(std::vector<uint8_t> &out, const char *data,
+                           size_t size) {
+    appendVarint(out, size);
+    out.insert(out.end(), data, data + size);
+  }
+
+  template <typename T>
+  static void appendRaw(std::vector<uint8_t> &out, T value) {
+    size_t size = out.size();
+    out.resize(size + sizeof(T));
+    std::memcpy(&out[size], &value, sizeof(T));
+  }
+
+  template <typename T>
+  static T readRaw(const uint8_t *&data) {
+    T value;
+    std::memcpy(&value, data, sizeof(T));
+    data += sizeof(T);
+    return value;
+  }
+
+  // Encode `data` as alternating runs of zero bytes and literal bytes. Single
+  // zero bytes are kept in literal runs, since a run costs at least two bytes.
+  static void appendRunLength(std::vector<uint8_t> &out,
+                              const std::vector<uint8_t> &data) {
+    size_t size = data.size();
+    for (size_t i = 0; i < size;) {
+      size_t zerosEnd = i;
+      while (zerosEnd < size && data[zerosEnd] == 0)
+        ++zerosEnd;
+      size_t literalsEnd = zerosEnd;
+      while (literalsEnd < size &&
+             (data[literalsEnd] != 0 ||
+              (literalsEnd + 1 < size && data[literalsEnd + 1] != 0)))
+        ++literalsEnd;
+      appendVarint(out, zerosEnd - i);
+      appendVarint(out, literalsEnd - zerosEnd);
+      out.insert(out.end(), data.begin() + zerosEnd,
+                 data.begin() + literalsEnd);
+      i = literalsEnd;
+    }
+  }
+
+  // Pass the buffer filled by the simulation thread to the background thread,
+  // waiting for it to finish the previous one first.
+  void handOff() {
+    std::unique_lock<std::mutex> lock(mutex);
+    condition.wait(lock, [&] { return !backFull; });
+    std::swap(front, back);
+    backFull = true;
+    lock.unlock();
+    condition.notify_all();
+    front.clear();
+  }
+
+  void workerLoop() {
+    std::vector<uint8_t> block;
+    while (true) {
+      std::unique_lock<std::mutex> lock(mutex);
+      condition.wait(lock, [&] { return backFull || stop; });
+      if (!backFull)
+        return;
+      lock.unlock();
+      block.clear();
+      encodeBlock(back, block);
+      os.write(reinterpret_cast<const char *>(block.data()), block.size());
+      lock.lock();
+      back.clear();
+      backFull = false;
+      lock.unlock();
+      condition.notify_all();
+    }
+  }
+
+  // Encode the timesteps in a buffer filled by `writeValues` as one block.
+  void encodeBlock(const std::vector<uint8_t> &chunk,
+                   std::vector<uint8_t> &block) {
+    payload.clear();
+    const uint8_t *data = chunk.data();
+    const uint8_t *end = data + chunk.size();
+    uint64_t firstTime = 0, lastTime = 0;
+    size_t numSteps = 0;
+    while (data != end) {
+      uint64_t stepTime = readRaw<uint64_t>(data);
+      uint32_t numChanges = readRaw<uint32_t>(data);
+      if (numSteps++ == 0)
+        firstTime = lastTime = stepTime;
+      appendVarint(payload, stepTime - lastTime);
+      appendVarint(payload, numChanges);
+      lastTime = stepTime;
+
+      deltas.clear();
+      uint32_t nextIndex = 0;
+      for (uint32_t i = 0; i < numChanges; ++i) {
+        uint32_t index = readRaw<uint32_t>(data);
+        appendVarint(payload, index - nextIndex);
+        nextIndex = index + 1;
+        auto &signal = signals[index];
+        uint8_t *previous = &previousValues[signal.valueOffset];
+        for (unsigned n = 0; n < signal.numBytes; ++n) {
+          deltas.push_back(data[n] ^ previous[n]);
+          previous[n] = data[n];
+        }
+        data += signal.numBytes;
+      }
+      appendRunLength(payload, deltas);
+    }
+
+    block.push_back('B');
+    appendVarint(block, firstTime);
+    appendVarint(block, numSteps);
+    appendVarint(block, payload.size());
+    block.insert(block.end(), payload.begin(), payload.end());
+  }
+
+  std::basic_ostream<char> &os;
+  uint8_t *state;
+  unsigned copy;
+  std::vector<TraceSignal> signals;
+
+  // Owned by the simulation thread: the values as of the last timestep, and
+  // the buffer the timesteps are recorded into.
+  std::vector<uint8_t> currentValues;
+  std::vector<uint8_t> front;
+
+  // Owned by the background thread: the values as of the last timestep it
+  // encoded, and scratch space for encoding.
+  std::vector<uint8_t> previousValues;
+  std::vector<uint8_t> payload;
+  std::vector<uint8_t> deltas;
+
+  // The buffer handed over to the background thread, if `backFull` is set.
+  std::vector<uint8_t> back;
+  bool backFull = false;
+  bool stop = false;
+  std::mutex mutex;
+  std::condition_variable condition;
+  std::thread worker;
+};
+
 // NOLINTEND
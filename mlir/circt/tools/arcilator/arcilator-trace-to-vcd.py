@@ -0,0 +1,160 @@
+#!/usr/bin/env python3
+import argparse
+import sys
+from dataclasses import dataclass
+from typing import *
+
+# Parse command line arguments.
+parser = argparse.ArgumentParser(
+    description="Convert a binary trace written by `BinaryTrace` to VCD")
+parser.add_argument("trace",
+                    metavar="TRACE",
+                    help="binary trace file to convert")
+parser.add_argument("-o",
+                    metavar="VCD",
+                    dest="output",
+                    help="output file (defaults to stdout)")
+args = parser.parse_args()
+
+FORMAT_VERSION = 1
+
+
+class Reader:
+
+  def __init__(self, data: bytes):
+    self.data = data
+    self.pos = 0
+
+  def at_end(self) -> bool:
+    return self.pos >= len(self.data)
+
+  def byte(self) -> int:
+    if self.at_end():
+      sys.exit("error: unexpected end of trace")
+    b = self.data[self.pos]
+    self.pos += 1
+    return b
+
+  def bytes(self, n: int) -> bytes:
+    if self.pos + n > len(self.data):
+      sys.exit("error: unexpected end of trace")
+    b = self.data[self.pos:self.pos + n]
+    self.pos += n
+    return b
+
+  def varint(self) -> int:
+    value = 0
+    shift = 0
+    while True:
+      b = self.byte()
+      value |= (b & 0x7f) << shift
+      shift += 7
+      if b < 0x80:
+        return value
+
+  def string(self) -> str:
+    return self.bytes(self.varint()).decode("utf-8")
+
+
+@dataclass
+class TraceSignal:
+  abbrev: str
+  numBits: int
+  value: bytearray
+
+
+def make_abbrev(index: int) -> str:
+  # Matches the identifiers `ValueChangeDump` assigns.
+  abbrev = ""
+  rest = index + 1
+  while rest != 0:
+    c = (rest % 84) + 33
+    if c >= ord('0'):
+      c += 10
+    abbrev += chr(c)
+    rest //= 84
+  return abbrev
+
+
+with open(args.trace, "rb") as f:
+  reader = Reader(f.read())
+out = open(args.output, "w") if args.output else sys.stdout
+
+if reader.bytes(8) != b"ARCTRACE":
+  sys.exit("error: not an arcilator trace")
+version = reader.varint()
+if version != FORMAT_VERSION:
+  sys.exit(f"error: unsupported trace format version {version}")
+
+# Translate the signal definitions.
+out.write("$version\n    arcilator binary trace\n$end\n")
+out.write("$timescale 1ns $end\n")
+signals: List[TraceSignal] = []
+while True:
+  record = chr(reader.byte())
+  if record == "D":
+    break
+  if record == "S":
+    out.write(f"$scope module {reader.string()} $end\n")
+  elif record == "U":
+    out.write("$upscope $end\n")
+  elif record == "V":
+    kind = "reg" if reader.byte() else "wire"
+    numBits = reader.varint()
+    name = reader.string()
+    signal = TraceSignal(make_abbrev(len(signals)), numBits,
+                         bytearray((numBits + 7) // 8))
+    signals.append(signal)
+    out.write(f"$var {kind} {numBits} {signal.abbrev} {name}")
+    if numBits > 1:
+      out.write(f" [{numBits - 1}:0]")
+    out.write(" $end\n")
+  else:
+    sys.exit(f"error: unknown record `{record}` in definitions")
+out.write("$enddefinitions $end\n")
+
+
+def write_value(signal: TraceSignal):
+  value = int.from_bytes(signal.value, "little")
+  if signal.numBits > 1:
+    out.write(f"b{value:0{signal.numBits}b} {signal.abbrev}\n")
+  else:
+    out.write(f"{value & 1}{signal.abbrev}\n")
+
+
+# Replay the value changes.
+first_step = True
+while True:
+  record = chr(reader.byte())
+  if record == "E":
+    out.write(f"#{reader.varint()}\n")
+    break
+  if record != "B":
+    sys.exit(f"error: unknown record `{record}` in value changes")
+  time = reader.varint()
+  numSteps = reader.varint()
+  block = Reader(reader.bytes(reader.varint()))
+  for _ in range(numSteps):
+    time += block.varint()
+    changed = []
+    index = 0
+    for _ in range(block.varint()):
+      index += block.varint()
+      changed.append(signals[index])
+      index += 1
+
+    # Undo the run-length encoding of the XOR deltas.
+    total = sum(len(s.value) for s in changed)
+    deltas = bytearray()
+    while len(deltas) < total:
+      deltas += bytes(block.varint())
+      deltas += block.bytes(block.varint())
+
+    out.write("$dumpvars\n" if first_step else f"#{time}\n")
+    first_step = False
+    pos = 0
+    for signal in changed:
+      for n in range(len(signal.value)):
+        signal.value[n] ^= deltas[pos + n]
+      pos += len(signal.value)
+      write_value(signal)
@@ -31,6 +31,7 @@
 #include "mlir/Dialect/LLVMIR/LLVMDialect.h"
 #include "mlir/Dialect/LLVMIR/Transforms/Passes.h"
 #include "mlir/Dialect/SCF/IR/SCF.h"
+#include "mlir/ExecutionEngine/OptUtils.h"
 #include "mlir/IR/AsmState.h"
 #include "mlir/IR/BuiltinOps.h"
 #include "mlir/IR/OperationSupport.h"
@@ -45,14 +46,27 @@
 #include "mlir/Target/LLVMIR/Export.h"
 #include "mlir/Transforms/GreedyPatternRewriteDriver.h"
 #include "mlir/Transforms/Passes.h"
+#include "llvm/ADT/ScopeExit.h"
+#include "llvm/ADT/StringExtras.h"
+#include "llvm/ExecutionEngine/ObjectCache.h"
+#include "llvm/ExecutionEngine/Orc/CompileUtils.h"
+#include "llvm/ExecutionEngine/Orc/ExecutionUtils.h"
+#include "llvm/ExecutionEngine/Orc/LLJIT.h"
 #include "llvm/IR/LLVMContext.h"
 #include "llvm/IR/Module.h"
 #include "llvm/Support/CommandLine.h"
 #include "llvm/Support/FileSystem.h"
+#include "llvm/Support/FileUtilities.h"
 #include "llvm/Support/InitLLVM.h"
+#include "llvm/Support/JSON.h"
+#include "llvm/Support/MemAlloc.h"
 #include "llvm/Support/Path.h"
+#include "llvm/Support/Process.h"
+#include "llvm/Support/SHA256.h"
 #include "llvm/Support/SourceMgr.h"
+#include "llvm/Support/TargetSelect.h"
 #include "llvm/Support/ToolOutputFile.h"
+#include "llvm/TargetParser/Host.h"
 
 #include <iostream>
 #include <optional>
@@ -104,6 +118,48 @@ static cl::opt<bool>
                    cl::desc("Optimize arcs into lookup tables"), cl::init(true),
                    cl::cat(mainCategory));
 
+static cl::opt<unsigned> numPartitions(
+    "partitions",
+    cl::desc("Split each clock tree into up to this many partitions that the "
+             "runtime evaluates in parallel"),
+    cl::init(1), cl::cat(mainCategory));
+
+static cl::opt<unsigned> batchSize(
+    "batch",
+    cl::desc("Simulate this many independent copies of the design in one "
+             "model, evaluated one after the other"),
+    cl::init(1), cl::cat(mainCategory));
+
+static cl::opt<bool> addDirtyFlags(
+    "dirty-flags",
+    cl::desc("Flag the states the model writes, such that waveform tracing "
+             "can skip the states that have not been written"),
+    cl::init(false), cl::cat(mainCategory));
+
+static cl::opt<bool>
+    runJIT("run",
+           cl::desc("Compile the model in-process and simulate it with the "
+                    "stimulus given by --stimulus, instead of emitting it"),
+           cl::init(false), cl::cat(mainCategory));
+
+static cl::opt<std::string>
+    stimulusFile("stimulus",
+                 cl::desc("Stimulus file to drive the model with in --run "
+                          "mode"),
+                 cl::value_desc("filename"), cl::init(""),
+                 cl::cat(mainCategory));
+
+static cl::opt<std::string> jitCacheDir(
+    "jit-cache-dir",
+    cl::desc("Directory in which --run caches compiled models, keyed by a "
+             "hash of the input and options"),
+    cl::value_desc("directory"), cl::init(""), cl::cat(mainCategory));
+
+static cl::opt<unsigned>
+    jitOptLevel("jit-opt-level",
+                cl::desc("Optimization level of the model compiled by --run"),
+                cl::init(2), cl::cat(mainCategory));
+
 static cl::opt<bool> printDebugInfo("print-debug-info",
                                     cl::desc("Print debug information"),
                                     cl::init(false), cl::cat(mainCategory));
@@ -172,8 +228,9 @@ static cl::opt<OutputFormat> outputFormat(
 //===----------------------------------------------------------------------===//
 
 /// Populate a pass manager with the arc simulator pipeline for the given
-/// command line options.
-static void populatePipeline(PassManager &pm) {
+/// command line options. The state layout is written to `stateFilePath` if it
+/// is not empty.
+static void populatePipeline(PassManager &pm, StringRef stateFilePath) {
   auto untilReached = [](Until until) {
     return until >= runUntilBefore || until > runUntilAfter;
   };
@@ -266,10 +323,15 @@ static void populatePipeline(PassManager &pm) {
   // Allocate states.
   if (untilReached(UntilStateAlloc))
     return;
+  if (numPartitions > 1)
+    pm.nest<arc::ModelOp>().addPass(
+        arc::createPartitionClockTreesPass(numPartitions));
   pm.addPass(arc::createLowerArcsToFuncsPass());
-  pm.nest<arc::ModelOp>().addPass(arc::createAllocateStatePass());
-  if (!stateFile.empty())
-    pm.addPass(arc::createPrintStateInfoPass(stateFile));
+  pm.nest<arc::ModelOp>().addPass(arc::createAllocateStatePass(batchSize));
+  if (addDirtyFlags)
+    pm.nest<arc::ModelOp>().addPass(arc::createAddDirtyFlagsPass());
+  if (!stateFilePath.empty())
+    pm.addPass(arc::createPrintStateInfoPass(stateFilePath));
   pm.addPass(arc::createLowerClocksToFuncsPass()); // no CSE between state alloc
                                                    // and clock func lowering
   pm.addPass(createCSEPass());
@@ -284,9 +346,388 @@ static void populatePipeline(PassManager &pm) {
   pm.addPass(arc::createArcCanonicalizerPass());
 }
 
+//===----------------------------------------------------------------------===//
+// In-Process Execution
+//===----------------------------------------------------------------------===//
+
+namespace {
+/// A signal of a model that a stimulus file can access, as described in the
+/// state file.
+struct JITSignal {
+  unsigned offset;
+  unsigned numBits;
+  unsigned copyStride;
+  bool isMemory;
+};
+
+/// The layout of a model's storage, as described in the state file.
+struct JITModelLayout {
+  std::string name;
+  unsigned numStateBytes = 0;
+  unsigned batchSize = 1;
+  llvm::StringMap<JITSignal> signals;
+};
+
+/// An object cache that stores the compiled model on disk, such that later
+/// runs on the same input can skip the compilation entirely.
+class JITObjectCache : public llvm::ObjectCache {
+public:
+  explicit JITObjectCache(StringRef path) : path(path) {}
+  void notifyObjectCompiled(const llvm::Module *module,
+                            llvm::MemoryBufferRef object) override;
+  std::unique_ptr<llvm::MemoryBuffer>
+  getObject(const llvm::Module *module) override {
+    return nullptr;
+  }
+
+private:
+  std::string path;
+};
+} // namespace
+
+/// Write a file into the JIT cache. The file is written under a temporary name
+/// and renamed into place, such that concurrent runs sharing a cache directory
+/// never observe partially written entries.
+static void storeInJITCache(StringRef contents, StringRef cachePath) {
+  SmallString<128> tempPath;
+  int fd;
+  if (llvm::sys::fs::createUniqueFile(cachePath + ".tmp-%%%%%%%%", fd,
+                                      tempPath))
+    return;
+  {
+    llvm::raw_fd_ostream os(fd, /*shouldClose=*/true);
+    os << contents;
+    os.close();
+    if (os.has_error()) {
+      os.clear_error();
+      llvm::sys::fs::remove(tempPath);
+      return;
+    }
+  }
+  if (llvm::sys::fs::rename(tempPath, cachePath))
+    llvm::sys::fs::remove(tempPath);
+}
+
+void JITObjectCache::notifyObjectCompiled(const llvm::Module *module,
+                                          llvm::MemoryBufferRef object) {
+  storeInJITCache(object.getBuffer(), path);
+}
+
+/// Compute the key under which `--run` caches the model compiled from an input.
+/// This covers the input itself, the compiler version, the host the model is
+/// compiled for, the pass pipeline the model is compiled with, and all options
+/// that affect the compiled model.
+static std::string getJITCacheKey(MLIRContext &context, StringRef input) {
+  SmallString<128> options;
+  llvm::raw_svector_ostream os(options);
+  os << getCirctVersion() << '\0' << llvm::sys::getProcessTriple() << '\0'
+     << llvm::sys::getHostCPUName() << '\0' << observePorts << observeWires
+     << observeNamedValues << shouldInline << shouldDedup << shouldMakeLUTs
+     << addDirtyFlags << printDebugInfo << ' ' << numPartitions << ' '
+     << batchSize << ' ' << jitOptLevel << '\0';
+
+  // Pass options that the flags above do not cover show up in the textual
+  // pipeline. The state file is written to a different place on every run, so
+  // use a placeholder for its path.
+  PassManager pm(&context);
+  populatePipeline(pm, "<state-file>");
+  pm.printAsTextualPipeline(os);
+  os << '\0';
+  llvm::SHA256 hash;
+  hash.update(options);
+  hash.update(input);
+  return llvm::toHex(hash.final(), /*LowerCase=*/true);
+}
+
+/// Extract the layout of the single model in a state file.
+static FailureOr<JITModelLayout> parseModelLayout(StringRef stateJSON) {
+  auto json = llvm::json::parse(stateJSON);
+  if (!json) {
+    llvm::errs() << "invalid state file: " << toString(json.takeError())
+                 << "\n";
+    return failure();
+  }
+  auto *models = json->getAsArray();
+  if (!models || models->size() != 1) {
+    llvm::errs() << "--run requires the input to contain exactly one model\n";
+    return failure();
+  }
+
+  JITModelLayout layout;
+  auto *model = models->front().getAsObject();
+  if (!model)
+    return failure();
+  if (auto name = model->getString("name"))
+    layout.name = name->str();
+  if (auto numStateBytes = model->getInteger("numStateBytes"))
+    layout.numStateBytes = *numStateBytes;
+  if (auto batch = model->getInteger("batch"))
+    layout.batchSize = *batch;
+  if (auto *states = model->getArray("states")) {
+    for (auto &stateValue : *states) {
+      auto *state = stateValue.getAsObject();
+      if (!state)
+        continue;
+      auto name = state->getString("name");
+      if (!name)
+        continue;
+      JITSignal signal;
+      signal.offset = state->getInteger("offset").value_or(0);
+      signal.numBits = state->getInteger("numBits").value_or(0);
+      signal.copyStride = state->getInteger("copyStride").value_or(0);
+      signal.isMemory = state->getString("type") == "memory";
+      layout.signals.insert({*name, signal});
+    }
+  }
+  return layout;
+}
+
+/// Drive a model with the commands in a stimulus file. Each line holds one of
+/// the following commands:
+///
+///   set <signal> <value>    Set a signal to a value
+///   eval                    Evaluate the model
+///   tick <clock> [<count>]  Raise and lower a clock, evaluating after each
+///                           edge, the given number of times
+///   print <signal>...       Print the current values of signals
+///   copy <index>            Select the copy of the design the following
+///                           commands access in a batched model
+///
+/// Values are decimal, or hexadecimal with a `0x` prefix. Everything after a
+/// `#` is a comment.
+static LogicalResult runStimulus(const JITModelLayout &layout,
+                                 void (*eval)(void *), StringRef stimulus,
+                                 raw_ostream &os) {
+  // The model assumes its storage to be zero-initialized, and aligned such
+  // that each group of states allocated together starts on a cache line.
+  size_t numBytes = std::max(layout.numStateBytes, 1U);
+  auto *storage =
+      static_cast<uint8_t *>(llvm::allocate_buffer(numBytes, /*Alignment=*/64));
+  auto freeStorage = llvm::make_scope_exit(
+      [&] { llvm::deallocate_buffer(storage, numBytes, 64); });
+  std::memset(storage, 0, numBytes);
+
+  unsigned copy = 0;
+  unsigned lineNumber = 0;
+  SmallVector<StringRef> args;
+  for (auto line : llvm::split(stimulus, '\n')) {
+    ++lineNumber;
+    args.clear();
+    llvm::SplitString(line.split('#').first, args);
+    if (args.empty())
+      continue;
+
+    auto error = [&]() -> raw_ostream & {
+      return llvm::errs() << stimulusFile << ":" << lineNumber << ": error: ";
+    };
+    auto getSignal = [&](StringRef name) -> uint8_t * {
+      auto it = layout.signals.find(name);
+      if (it == layout.signals.end()) {
+        error() << "unknown signal `" << name << "`\n";
+        return nullptr;
+      }
+      if (it->second.isMemory) {
+        error() << "cannot access memory `" << name << "`\n";
+        return nullptr;
+      }
+      return storage + it->second.offset + copy * it->second.copyStride;
+    };
+    auto store = [&](StringRef name, const APInt &value) {
+      auto *ptr = getSignal(name);
+      if (!ptr)
+        return false;
+      auto numBits = layout.signals.lookup(name).numBits;
+      llvm::StoreIntToMemory(value.zextOrTrunc(numBits), ptr,
+                             (numBits + 7) / 8);
+      return true;
+    };
+
+    auto command = args[0];
+    if (command == "eval" && args.size() == 1) {
+      eval(storage);
+      continue;
+    }
+
+    if (command == "set" && args.size() == 3) {
+      APInt value;
+      if (args[2].getAsInteger(0, value)) {
+        error() << "invalid value `" << args[2] << "`\n";
+        return failure();
+      }
+      if (!store(args[1], value))
+        return failure();
+      continue;
+    }
+
+    if (command == "tick" && (args.size() == 2 || args.size() == 3)) {
+      unsigned count = 1;
+      if (args.size() == 3 && args[2].getAsInteger(10, count)) {
+        error() << "invalid count `" << args[2] << "`\n";
+        return failure();
+      }
+      for (unsigned i = 0; i < count; ++i) {
+        if (!store(args[1], APInt(1, 1)))
+          return failure();
+        eval(storage);
+        store(args[1], APInt(1, 0));
+        eval(storage);
+      }
+      continue;
+    }
+
+    if (command == "print" && args.size() > 1) {
+      for (auto name : ArrayRef(args).drop_front()) {
+        auto *ptr = getSignal(name);
+        if (!ptr)
+          return failure();
+        auto numBits = layout.signals.lookup(name).numBits;
+        APInt value(numBits, 0);
+        llvm::LoadIntFromMemory(value, ptr, (numBits + 7) / 8);
+        os << name << " = " << llvm::toString(value, 10, /*Signed=*/false)
+           << "\n";
+      }
+      continue;
+    }
+
+    if (command == "copy" && args.size() == 2) {
+      if (args[1].getAsInteger(10, copy) || copy >= layout.batchSize) {
+        error() << "invalid copy `" << args[1] << "`; batch has "
+                << layout.batchSize << " copies\n";
+        return failure();
+      }
+      continue;
+    }
+
+    error() << "invalid command `" << line.trim() << "`\n";
+    return failure();
+  }
+  return success();
+}
+
+/// Compile a model in-process and simulate it with the stimulus file. The
+/// model is either given as an LLVM IR module, or as an object file compiled
+/// by an earlier run. If a cache path is given, the object compiled from the
+/// LLVM IR module is stored there.
+static LogicalResult runModel(TimingScope &ts,
+                              std::unique_ptr<llvm::LLVMContext> llvmContext,
+                              std::unique_ptr<llvm::Module> llvmModule,
+                              std::unique_ptr<llvm::MemoryBuffer> object,
+                              StringRef stateJSON, StringRef cachePath,
+                              raw_ostream &os) {
+  auto reportError = [](llvm::Error error) {
+    llvm::logAllUnhandledErrors(std::move(error), llvm::errs(),
+                                "arcilator: ");
+    return failure();
+  };
+
+  auto layout = parseModelLayout(stateJSON);
+  if (failed(layout))
+    return failure();
+  std::string errorMessage;
+  auto stimulus = openInputFile(stimulusFile, &errorMessage);
+  if (!stimulus) {
+    llvm::errs() << errorMessage << "\n";
+    return failure();
+  }
+
+  // Set up the JIT. If we compile the model, hand the compiled object to the
+  // cache.
+  auto jitTimer = ts.nest("JIT compile model");
+  llvm::InitializeNativeTarget();
+  llvm::InitializeNativeTargetAsmPrinter();
+  auto jtmb = llvm::orc::JITTargetMachineBuilder::detectHost();
+  if (!jtmb)
+    return reportError(jtmb.takeError());
+  std::unique_ptr<JITObjectCache> objectCache;
+  if (llvmModule && !cachePath.empty())
+    objectCache = std::make_unique<JITObjectCache>(cachePath);
+  auto jit =
+      llvm::orc::LLJITBuilder()
+          .setJITTargetMachineBuilder(*jtmb)
+          .setCompileFunctionCreator(
+              [cache = objectCache.get()](llvm::orc::JITTargetMachineBuilder
+                                              jtmb)
+                  -> Expected<std::unique_ptr<
+                      llvm::orc::IRCompileLayer::IRCompiler>> {
+                auto tm = jtmb.createTargetMachine();
+                if (!tm)
+                  return tm.takeError();
+                return std::make_unique<llvm::orc::TMOwningSimpleCompiler>(
+                    std::move(*tm), cache);
+              })
+          .create();
+  if (!jit)
+    return reportError(jit.takeError());
+
+  // Resolve calls into the C library and other symbols of this process.
+  auto generator =
+      llvm::orc::DynamicLibrarySearchGenerator::GetForCurrentProcess(
+          (*jit)->getDataLayout().getGlobalPrefix());
+  if (!generator)
+    return reportError(generator.takeError());
+  (*jit)->getMainJITDylib().addGenerator(std::move(*generator));
+
+  if (llvmModule) {
+    auto tm = jtmb->createTargetMachine();
+    if (!tm)
+      return reportError(tm.takeError());
+    llvmModule->setDataLayout((*jit)->getDataLayout());
+    llvmModule->setTargetTriple((*jit)->getTargetTriple().str());
+    auto optimize = makeOptimizingTransformer(jitOptLevel, /*sizeLevel=*/0,
+                                              tm->get());
+    if (auto error = optimize(llvmModule.get()))
+      return reportError(std::move(error));
+    if (auto error = (*jit)->addIRModule(llvm::orc::ThreadSafeModule(
+            std::move(llvmModule), std::move(llvmContext))))
+      return reportError(std::move(error));
+  } else {
+    if (auto error = (*jit)->addObjectFile(std::move(object)))
+      return reportError(std::move(error));
+  }
+
+  // Looking up the eval function compiles the model.
+  auto evalAddr = (*jit)->lookup(layout->name + "_eval");
+  if (!evalAddr)
+    return reportError(evalAddr.takeError());
+  auto *eval = evalAddr->toPtr<void (*)(void *)>();
+  jitTimer.stop();
+
+  auto runTimer = ts.nest("Run stimulus");
+  return runStimulus(*layout, eval, stimulus->getBuffer(), os);
+}
+
 static LogicalResult processBuffer(
     MLIRContext &context, TimingScope &ts, llvm::SourceMgr &sourceMgr,
     std::optional<std::unique_ptr<llvm::ToolOutputFile>> &outputFile) {
+  // In run mode, reuse the model compiled by an earlier run on the same input
+  // if there is one, which skips the entire pipeline.
+  SmallString<128> cachePath;
+  if (runJIT && !jitCacheDir.empty()) {
+    cachePath = jitCacheDir;
+    auto input =
+        sourceMgr.getMemoryBuffer(sourceMgr.getMainFileID())->getBuffer();
+    llvm::sys::path::append(cachePath, getJITCacheKey(context, input));
+    auto object = llvm::MemoryBuffer::getFile(cachePath + ".o");
+    auto stateJSON = llvm::MemoryBuffer::getFile(cachePath + ".json");
+    if (object && stateJSON) {
+      // The pipeline would have written the state file, so write the cached
+      // copy in its place.
+      if (!stateFile.empty()) {
+        std::string errorMessage;
+        auto output = openOutputFile(stateFile, &errorMessage);
+        if (!output) {
+          llvm::errs() << errorMessage << "\n";
+          return failure();
+        }
+        output->os() << (*stateJSON)->getBuffer();
+        output->keep();
+      }
+      return runModel(ts, nullptr, nullptr, std::move(*object),
+                      (*stateJSON)->getBuffer(), {},
+                      outputFile.value()->os());
+    }
+  }
+
   mlir::OwningOpRef<mlir::ModuleOp> module;
   {
     auto parserTimer = ts.nest("Parse MLIR input");
@@ -295,12 +736,26 @@ static LogicalResult processBuffer(
   if (!module)
     return failure();
 
+  // In run mode, the state layout is needed to apply the stimulus. Write it to
+  // a temporary file unless the user asked for a state file.
+  SmallString<128> stateFilePath(stateFile);
+  std::optional<FileRemover> stateFileRemover;
+  if (runJIT && stateFilePath.empty()) {
+    if (auto error = llvm::sys::fs::createTemporaryFile(
+            "arcilator-state", "json", stateFilePath)) {
+      llvm::errs() << "cannot create temporary state file: " << error.message()
+                   << "\n";
+      return failure();
+    }
+    stateFileRemover.emplace(stateFilePath);
+  }
+
   PassManager pm(&context);
   pm.enableVerifier(verifyPasses);
   pm.enableTiming(ts);
   if (failed(applyPassManagerCLOptions(pm)))
     return failure();
-  populatePipeline(pm);
+  populatePipeline(pm, stateFilePath);
 
   if (printDebugInfo && outputFormat == OutputLLVM)
     pm.nest<LLVM::LLVMFuncOp>().addPass(LLVM::createDIScopeForLLVMFuncOpPass());
@@ -308,6 +763,32 @@ static LogicalResult processBuffer(
   if (failed(pm.run(module.get())))
     return failure();
 
+  // Handle in-process execution.
+  if (runJIT) {
+    auto stateJSON = llvm::MemoryBuffer::getFile(stateFilePath);
+    if (!stateJSON) {
+      llvm::errs() << "cannot read state file: "
+                   << stateJSON.getError().message() << "\n";
+      return failure();
+    }
+    auto llvmContext = std::make_unique<llvm::LLVMContext>();
+    std::unique_ptr<llvm::Module> llvmModule;
+    {
+      auto translateTimer = ts.nest("Translate to LLVM IR");
+      llvmModule = mlir::translateModuleToLLVMIR(module.get(), *llvmContext);
+    }
+    if (!llvmModule)
+      return failure();
+    SmallString<128> objectPath;
+    if (!cachePath.empty()) {
+      storeInJITCache((*stateJSON)->getBuffer(), cachePath + ".json");
+      objectPath = cachePath + ".o";
+    }
+    return runModel(ts, std::move(llvmContext), std::move(llvmModule), nullptr,
+                    (*stateJSON)->getBuffer(), objectPath,
+                    outputFile.value()->os());
+  }
+
   // Handle MLIR output.
   if (runUntilBefore != UntilEnd || runUntilAfter != UntilEnd ||
       outputFormat == OutputMLIR) {
@@ -378,6 +859,37 @@ static LogicalResult executeArcilator(MLIRContext &context) {
   applyDefaultTimingManagerCLOptions(tm);
   auto ts = tm.getRootScope();
 
+  if (numPartitions > 1 && batchSize > 1) {
+    llvm::errs() << "--partitions and --batch cannot be combined\n";
+    return failure();
+  }
+  if (addDirtyFlags && batchSize > 1) {
+    llvm::errs() << "--dirty-flags and --batch cannot be combined\n";
+    return failure();
+  }
+  if (runJIT) {
+    if (stimulusFile.empty()) {
+      llvm::errs() << "--run requires a --stimulus file\n";
+      return failure();
+    }
+    if (runUntilBefore != UntilEnd || runUntilAfter != UntilEnd) {
+      llvm::errs() << "--run cannot be combined with --until-before or "
+                      "--until-after\n";
+      return failure();
+    }
+    if (numPartitions > 1) {
+      llvm::errs() << "--run does not support --partitions\n";
+      return failure();
+    }
+    if (!jitCacheDir.empty()) {
+      if (auto error = llvm::sys::fs::create_directories(jitCacheDir)) {
+        llvm::errs() << "cannot create JIT cache directory \"" << jitCacheDir
+                     << "\": " << error.message() << "\n";
+        return failure();
+      }
+    }
+  }
+
   // Set up the input file.
   std::string errorMessage;
   auto input = openInputFile(inputFilename, &errorMessage);
@@ -13,6 +13,7 @@
 //===----------------------------------------------------------------------===//
 
 #include "circt/InitAllDialects.h"
+#include "circt/LogicalEquivalence/IncrementalChecker.h"
 #include "circt/LogicalEquivalence/LogicExporter.h"
 #include "circt/LogicalEquivalence/Solver.h"
 #include "circt/LogicalEquivalence/Utility.h"
@@ -58,6 +59,17 @@ static cl::opt<bool>
             cl::desc("Print extensive execution progress information"),
             cl::cat(mainCategory));
 
+static cl::opt<bool> hierarchical(
+    "hierarchical", cl::init(false),
+    cl::desc("Check the pairs of instanced modules separately, bottom-up"),
+    cl::cat(mainCategory));
+
+static cl::opt<std::string>
+    cacheFile("cache",
+              cl::desc("Reuse and record the proofs of a hierarchical check "
+                       "in a file (implies -hierarchical)"),
+              cl::value_desc("file"), cl::cat(mainCategory));
+
 // The following options are stored externally for their value to be accessible
 // to other components of the tool.
 bool statisticsOpt;
@@ -70,6 +82,40 @@ static cl::opt<bool, true> statistics(
 // Tool implementation
 //===----------------------------------------------------------------------===//
 
+/// Return the module named `name` in `file`, or its first module if no name
+/// is given.
+static hw::HWModuleOp lookupModule(ModuleOp file, StringRef name) {
+  for (auto hwModule : file.getOps<hw::HWModuleOp>())
+    if (name.empty() || hwModule.getName() == name)
+      return hwModule;
+  file.emitError("module not found");
+  return {};
+}
+
+/// Check the two circuits one pair of instanced modules at a time, reusing the
+/// proofs recorded in the cache file if any.
+static LogicalResult executeHierarchicalLEC(MLIRContext &context,
+                                            ModuleOp file1, ModuleOp file2) {
+  hw::HWModuleOp c1 = lookupModule(file1, moduleName1);
+  if (!c1)
+    return failure();
+  hw::HWModuleOp c2 = lookupModule(file2, moduleName2);
+  if (!c2)
+    return failure();
+
+  IncrementalChecker checker(&context, statisticsOpt);
+  if (!cacheFile.empty() && failed(checker.loadCache(cacheFile)))
+    return failure();
+  if (verbose)
+    lec::outs() << "Solving constraints hierarchically\n";
+  // The proofs of the instanced modules are worth keeping even if the
+  // top-level modules differ.
+  LogicalResult outcome = checker.solve(c1, c2);
+  if (!cacheFile.empty() && failed(checker.saveCache(cacheFile)))
+    return failure();
+  return outcome;
+}
+
 /// This functions initializes the various components of the tool and
 /// orchestrates the work to be done. It first parses the input files, then it
 /// traverses their IR to export the logical constraints from the given circuit
@@ -93,6 +139,14 @@ static LogicalResult executeLEC(MLIRContext &context) {
   } else if (verbose)
     lec::outs() << "Second input file not specified\n";
 
+  ModuleOp m = file1.get();
+  // In case a second input file was not specified, the first input file will
+  // be used instead.
+  ModuleOp m2 = fileName2.empty() ? m : file2.get();
+
+  if (hierarchical || !cacheFile.empty())
+    return executeHierarchicalLEC(context, m, m2);
+
   // Initiliaze the constraints solver and the circuits to be compared.
   Solver s(&context, statisticsOpt);
   Solver::Circuit *c1 = s.addCircuit(moduleName1);
@@ -103,7 +157,6 @@ static LogicalResult executeLEC(MLIRContext &context) {
   if (verbose)
     lec::outs() << "Analyzing the first circuit\n";
   auto exporter = std::make_unique<LogicExporter>(moduleName1, c1);
-  ModuleOp m = file1.get();
   if (failed(exporter->run(m)))
     return failure();
 
@@ -111,9 +164,6 @@ static LogicalResult executeLEC(MLIRContext &context) {
   if (verbose)
     lec::outs() << "Analyzing the second circuit\n";
   auto exporter2 = std::make_unique<LogicExporter>(moduleName2, c2);
-  // In case a second input file was not specified, the first input file will
-  // be used instead.
-  ModuleOp m2 = fileName2.empty() ? m : file2.get();
   if (failed(exporter2->run(m2)))
     return failure();
 
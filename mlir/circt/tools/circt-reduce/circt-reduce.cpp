@@ -120,6 +120,11 @@ static cl::opt<unsigned>
                           "ops per chunk (granularity upper bound)"),
                  cl::cat(granularityCategory));
 
+static cl::opt<unsigned>
+    numJobs("j", cl::init(1),
+            cl::desc("Number of reduction candidates to test concurrently"),
+            cl::cat(mainCategory));
+
 static cl::opt<bool> testMustFail(
     "test-must-fail", cl::init(false),
     cl::desc("Consider an input to be interesting on non-zero exit status."),
@@ -238,38 +243,51 @@ static LogicalResult execute(MLIRContext &context) {
       if (maxChunkSize > 0)
         rangeLength = std::min<size_t>(rangeLength, maxChunkSize);
 
+      // Apply the pattern to the subsets of operations starting at each of the
+      // given `bases` and `rangeLength` long, in a copy of the module. Returns
+      // the number of operations the pattern applies to.
+      auto applyPattern = [&](ModuleOp newModule, ArrayRef<size_t> bases) {
+        size_t opIdx = 0;
+        pattern.beforeReduction(newModule);
+        SmallVector<std::pair<Operation *, uint64_t>, 16> opBenefits;
+        SmallDenseSet<Operation *> opsTouched;
+        pattern.notifyOpErasedCallback = [&](Operation *op) {
+          opsTouched.insert(op);
+        };
+        newModule->walk([&](Operation *op) {
+          uint64_t benefit = pattern.match(op);
+          if (benefit > 0) {
+            opIdx++;
+            opBenefits.push_back(std::make_pair(op, benefit));
+          }
+        });
+        std::sort(opBenefits.begin(), opBenefits.end(),
+                  [](auto a, auto b) { return a.second > b.second; });
+        for (auto base : bases) {
+          for (size_t idx = base, num = 0;
+               num < rangeLength && idx < opBenefits.size(); ++idx) {
+            auto *op = opBenefits[idx].first;
+            if (opsTouched.contains(op))
+              continue;
+            if (pattern.match(op)) {
+              op->walk([&](Operation *subop) { opsTouched.insert(subop); });
+              (void)pattern.rewrite(op);
+              ++num;
+            }
+          }
+        }
+        pattern.afterReduction(newModule);
+        pattern.notifyOpErasedCallback = nullptr;
+        return opIdx;
+      };
+
       // Apply the pattern to the subset of operations selected by `rangeBase`
       // and `rangeLength`.
-      size_t opIdx = 0;
-      mlir::OwningOpRef<mlir::ModuleOp> newModule = module->clone();
-      pattern.beforeReduction(*newModule);
-      SmallVector<std::pair<Operation *, uint64_t>, 16> opBenefits;
-      SmallDenseSet<Operation *> opsTouched;
-      pattern.notifyOpErasedCallback = [&](Operation *op) {
-        opsTouched.insert(op);
-      };
-      newModule->walk([&](Operation *op) {
-        uint64_t benefit = pattern.match(op);
-        if (benefit > 0) {
-          opIdx++;
-          opBenefits.push_back(std::make_pair(op, benefit));
-        }
-      });
-      std::sort(opBenefits.begin(), opBenefits.end(),
-                [](auto a, auto b) { return a.second > b.second; });
-      for (size_t idx = rangeBase, num = 0;
-           num < rangeLength && idx < opBenefits.size(); ++idx) {
-        auto *op = opBenefits[idx].first;
-        if (opsTouched.contains(op))
-          continue;
-        if (pattern.match(op)) {
-          op->walk([&](Operation *subop) { opsTouched.insert(subop); });
-          (void)pattern.rewrite(op);
-          ++num;
-        }
-      }
-      pattern.afterReduction(*newModule);
-      pattern.notifyOpErasedCallback = nullptr;
+      SmallVector<mlir::OwningOpRef<mlir::ModuleOp>> candidates;
+      SmallVector<size_t> candidateBases;
+      candidates.push_back(module->clone());
+      candidateBases.push_back(rangeBase);
+      size_t opIdx = applyPattern(*candidates.back(), rangeBase);
       if (opIdx == 0) {
         VERBOSE({
           clearSummary();
@@ -279,16 +297,34 @@ static LogicalResult execute(MLIRContext &context) {
       }
 
       // Reduce the chunk size to achieve the minimum number of chunks requested
-      // by the user.
-      if (minChunks > 0)
-        rangeLength = std::min<size_t>(rangeLength,
-                                       std::max<size_t>(opIdx / minChunks, 1));
+      // by the user. The number of operations is only known once the pattern
+      // has been applied, so redo the first candidate if its chunk shrinks.
+      if (minChunks > 0) {
+        size_t minChunkLength = std::min<size_t>(
+            rangeLength, std::max<size_t>(opIdx / minChunks, 1));
+        if (minChunkLength != rangeLength) {
+          rangeLength = minChunkLength;
+          candidates.back() = module->clone();
+          applyPattern(*candidates.back(), rangeBase);
+        }
+      }
+
+      // If the user asked for multiple jobs, speculatively prepare candidates
+      // for the subsequent subsets of operations as well. These are disjoint
+      // and are tested concurrently.
+      for (size_t base = rangeBase + std::min(rangeLength, opIdx);
+           candidates.size() < numJobs && base < opIdx; base += rangeLength) {
+        candidates.push_back(module->clone());
+        candidateBases.push_back(base);
+        applyPattern(*candidates.back(), base);
+      }
 
       // Show some progress indication.
       VERBOSE({
         size_t boundLength = std::min(rangeLength, opIdx);
-        size_t numDone = rangeBase / boundLength + 1;
+        size_t numDone = rangeBase / boundLength + candidates.size();
         size_t numTotal = (opIdx + boundLength - 1) / boundLength;
+        numDone = std::min(numDone, numTotal);
         clearSummary();
         llvm::errs() << "  [" << numDone << "/" << numTotal << "; "
                      << (numDone * 100 / numTotal) << "%; " << opIdx << " ops, "
@@ -297,38 +333,89 @@ static LogicalResult execute(MLIRContext &context) {
         errsPosAfterLastSummary = llvm::errs().tell();
       });
 
-      // Check if this reduced module is still interesting, and its overall size
-      // is smaller than what we had before.
-      auto shouldAccept = [&](TestCase &test) {
+      // Check if the reduced modules are still interesting, and their overall
+      // size is smaller than what we had before.
+      auto shouldTest = [&](TestCase &test) {
         if (!test.isValid())
           return false; // don't write to disk if module is busted
         if (test.getSize() >= bestSize && !pattern.acceptSizeIncrease())
           return false; // don't run test if size already bad
-        return test.isInteresting();
+        return true;
+      };
+      auto shouldAccept = [&](TestCase &test) {
+        return shouldTest(test) && test.isInteresting();
       };
-      auto test = tester.get(newModule.get());
-      if (shouldAccept(test)) {
+      SmallVector<TestCase> tests;
+      SmallVector<TestCase *> testsToRun;
+      tests.reserve(candidates.size());
+      for (auto &candidate : candidates) {
+        tests.push_back(tester.get(candidate.get()));
+        if (shouldTest(tests.back()))
+          testsToRun.push_back(&tests.back());
+      }
+      tester.runConcurrently(testsToRun);
+      SmallVector<unsigned> accepted;
+      for (unsigned i = 0, e = tests.size(); i != e; ++i)
+        if (shouldAccept(tests[i]))
+          accepted.push_back(i);
+
+      // If multiple candidates were accepted, try to merge them by applying
+      // the pattern to all of their subsets of operations at once. Otherwise,
+      // or if the merged module is no longer interesting, go with the first
+      // accepted candidate.
+      mlir::OwningOpRef<mlir::ModuleOp> newModule;
+      size_t newSize = 0;
+      bool merged = false;
+      if (accepted.size() > 1) {
+        SmallVector<size_t> mergedBases;
+        for (auto i : accepted)
+          mergedBases.push_back(candidateBases[i]);
+        mlir::OwningOpRef<mlir::ModuleOp> mergedModule = module->clone();
+        applyPattern(*mergedModule, mergedBases);
+        auto test = tester.get(mergedModule.get());
+        if (shouldAccept(test)) {
+          newModule = std::move(mergedModule);
+          newSize = test.getSize();
+          merged = true;
+        }
+      }
+      if (!newModule && !accepted.empty()) {
+        newModule = std::move(candidates[accepted[0]]);
+        newSize = tests[accepted[0]].getSize();
+      }
+
+      if (newModule) {
         // Make this reduced module the new baseline and reset our search
         // strategy to start again from the beginning, since this reduction may
         // have created additional opportunities.
         patternDidReduce = true;
-        bestSize = test.getSize();
+        bestSize = newSize;
         VERBOSE({
           clearSummary();
-          llvm::errs() << "- Accepting module of size " << bestSize << "\n";
+          llvm::errs() << "- Accepting module of size " << bestSize;
+          if (merged)
+            llvm::errs() << " (" << accepted.size() << " candidates merged)";
+          llvm::errs() << "\n";
         });
         module = std::move(newModule);
-
-        // We leave `rangeBase` and `rangeLength` untouched in this case. This
-        // causes the next iteration of the loop to try the same pattern again
-        // at the same offset. If the pattern has reached a fixed point, nothing
-        // changes and we proceed. If the pattern has removed an operation, this
-        // will already operate on the next batch of operations which have
-        // likely moved to this point. The only exception are operations that
-        // are marked as "one shot", which explicitly ask to not be re-applied
-        // at the same location.
+        if (accepted.size() != candidates.size() ||
+            (accepted.size() > 1 && !merged))
+          allDidReduce = false;
+
+        // We leave `rangeBase` and `rangeLength` untouched in this case, apart
+        // from skipping the candidates that were rejected before the first
+        // accepted one. This causes the next iteration of the loop to try the
+        // same pattern again at the same offset. If the pattern has reached a
+        // fixed point, nothing changes and we proceed. If the pattern has
+        // removed an operation, this will already operate on the next batch of
+        // operations which have likely moved to this point. The only exception
+        // are operations that are marked as "one shot", which explicitly ask to
+        // not be re-applied at the same location.
         if (pattern.isOneShot())
-          rangeBase += rangeLength;
+          rangeBase += (merged ? candidates.size() : accepted[0] + 1) *
+                       rangeLength;
+        else
+          rangeBase += accepted[0] * rangeLength;
 
         // Write the current state to disk if the user asked for it.
         if (keepBest)
@@ -337,7 +424,7 @@ static LogicalResult execute(MLIRContext &context) {
       } else {
         allDidReduce = false;
         // Try the pattern on the next `rangeLength` number of operations.
-        rangeBase += rangeLength;
+        rangeBase += candidates.size() * rangeLength;
       }
 
       // If we have gone past the end of the input, reduce the size of the chunk
@@ -0,0 +1,228 @@
+//===- circt-scheduling-bench.cpp - Simplex scheduler benchmark -----------===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+//
+// Schedule synthetic dependence graphs, shaped like large HLS loop bodies, with
+// the simplex schedulers using the dense and the sparse tableau, and compare
+// the run times. Both tableaus must yield the same schedule.
+//
+//===----------------------------------------------------------------------===//
+
+#include "circt/Scheduling/Algorithms.h"
+#include "circt/Scheduling/Problems.h"
+#include "mlir/IR/Builders.h"
+#include "mlir/IR/BuiltinOps.h"
+#include "mlir/IR/MLIRContext.h"
+#include "llvm/Support/CommandLine.h"
+#include "llvm/Support/Format.h"
+#include "llvm/Support/InitLLVM.h"
+#include "llvm/Support/raw_ostream.h"
+
+#include <chrono>
+#include <optional>
+#include <random>
+#include <type_traits>
+
+using namespace mlir;
+using namespace circt;
+using namespace circt::scheduling;
+
+static llvm::cl::list<unsigned>
+    sizes("sizes", llvm::cl::desc("Number of operations in each problem"),
+          llvm::cl::CommaSeparated);
+
+static llvm::cl::opt<unsigned> maxDenseOps(
+    "max-dense-ops",
+    llvm::cl::desc("Only use the dense tableau for problems up to this size"),
+    llvm::cl::init(4000));
+
+static llvm::cl::opt<unsigned>
+    window("window",
+           llvm::cl::desc("How far back an operation's predecessors may be"),
+           llvm::cl::init(32));
+
+static llvm::cl::opt<unsigned>
+    seed("seed", llvm::cl::desc("Seed for the graph generator"),
+         llvm::cl::init(1));
+
+namespace {
+/// The operator types in the generated problems. Only memory ports are
+/// limited, as is typical for HLS.
+struct OperatorTypeInfo {
+  const char *name;
+  unsigned latency;
+  unsigned limit;
+};
+} // namespace
+
+static const OperatorTypeInfo operatorTypes[] = {
+    {"wire", 0, 0}, {"add", 1, 0}, {"mul", 3, 0}, {"mem", 2, 2}};
+
+namespace {
+/// A synthetic dependence graph. Every operation depends on one to three of the
+/// `window` operations before it, and about one in twenty has a loop-carried
+/// dependence on an operation up to `window` operations after it. The last
+/// operation is the only sink.
+struct Graph {
+  SmallVector<unsigned> operatorTypes;
+  SmallVector<std::pair<unsigned, unsigned>> deps;
+  /// Source, destination and distance.
+  SmallVector<std::tuple<unsigned, unsigned, unsigned>> backEdges;
+};
+} // namespace
+
+static Graph generateGraph(unsigned numOps, std::mt19937 &rng) {
+  Graph graph;
+  SmallVector<bool> hasSuccessor(numOps, false);
+  for (unsigned i = 0; i < numOps; ++i) {
+    // Mostly additions; one in twenty operations is a memory access.
+    unsigned kind = rng() % 20;
+    unsigned opr = 1;
+    if (kind == 0)
+      opr = 3;
+    else if (kind < 4)
+      opr = 2;
+    else if (kind < 7)
+      opr = 0;
+    graph.operatorTypes.push_back(opr);
+    if (i == 0 || i == numOps - 1)
+      continue;
+    unsigned numPreds = 1 + rng() % 3;
+    for (unsigned p = 0; p < numPreds; ++p) {
+      unsigned pred = i - 1 - rng() % std::min(i, (unsigned)window);
+      graph.deps.push_back({pred, i});
+      hasSuccessor[pred] = true;
+    }
+    if (rng() % 20 == 0) {
+      unsigned src = std::min(numOps - 2, i + (unsigned)(rng() % window));
+      graph.backEdges.push_back({src, i, 1 + rng() % 2});
+    }
+  }
+
+  // Make the last operation the only sink.
+  for (unsigned i = 0; i + 1 < numOps; ++i)
+    if (!hasSuccessor[i])
+      graph.deps.push_back({i, numOps - 1});
+  return graph;
+}
+
+template <typename ProblemT>
+static ProblemT buildProblem(const Graph &graph, ModuleOp module,
+                             ArrayRef<Operation *> ops) {
+  auto prob = ProblemT::get(module);
+  SmallVector<Problem::OperatorType> oprs;
+  for (auto &info : operatorTypes) {
+    auto opr = prob.getOrInsertOperatorType(info.name);
+    prob.setLatency(opr, info.latency);
+    if constexpr (std::is_base_of_v<SharedOperatorsProblem, ProblemT>)
+      if (info.limit > 0)
+        prob.setLimit(opr, info.limit);
+    oprs.push_back(opr);
+  }
+
+  for (auto [op, opr] : llvm::zip(ops, graph.operatorTypes)) {
+    prob.insertOperation(op);
+    prob.setLinkedOperatorType(op, oprs[opr]);
+  }
+  for (auto [src, dst] : graph.deps)
+    (void)prob.insertDependence(Problem::Dependence(ops[src], ops[dst]));
+  if constexpr (std::is_base_of_v<CyclicProblem, ProblemT>) {
+    for (auto [src, dst, distance] : graph.backEdges) {
+      Problem::Dependence dep(ops[src], ops[dst]);
+      (void)prob.insertDependence(dep);
+      prob.setDistance(dep, distance);
+    }
+  }
+  return prob;
+}
+
+/// Schedule the problem with both tableaus, and print the run times.
+template <typename ProblemT>
+static void runBenchmark(StringRef name, const Graph &graph, ModuleOp module,
+                         ArrayRef<Operation *> ops) {
+  llvm::outs() << name << ", " << ops.size() << " ops:";
+
+  std::optional<SmallVector<unsigned>> denseSchedule;
+  double denseTime = 0;
+  for (auto tableau : {SimplexTableauKind::Dense, SimplexTableauKind::Sparse}) {
+    bool isDense = tableau == SimplexTableauKind::Dense;
+    if (isDense && ops.size() > maxDenseOps) {
+      llvm::outs() << "  dense: skipped";
+      continue;
+    }
+
+    auto prob = buildProblem<ProblemT>(graph, module, ops);
+    if (failed(prob.check())) {
+      llvm::errs() << "\ngenerated problem is invalid\n";
+      exit(1);
+    }
+    auto start = std::chrono::steady_clock::now();
+    if (failed(scheduleSimplex(prob, ops.back(), tableau)) ||
+        failed(prob.verify())) {
+      llvm::errs() << "\nscheduling failed\n";
+      exit(1);
+    }
+    std::chrono::duration<double> elapsed =
+        std::chrono::steady_clock::now() - start;
+
+    SmallVector<unsigned> schedule;
+    for (auto *op : ops)
+      schedule.push_back(*prob.getStartTime(op));
+    if constexpr (std::is_base_of_v<CyclicProblem, ProblemT>)
+      schedule.push_back(*prob.getInitiationInterval());
+
+    llvm::outs() << "  " << (isDense ? "dense" : "sparse") << ": "
+                 << llvm::format("%.3f", elapsed.count()) << " s";
+    if (isDense) {
+      denseSchedule = std::move(schedule);
+      denseTime = elapsed.count();
+      continue;
+    }
+    if (denseSchedule) {
+      llvm::outs() << " (" << llvm::format("%.1f", denseTime / elapsed.count())
+                   << "x)";
+      if (schedule != *denseSchedule) {
+        llvm::errs() << "\nthe schedules differ\n";
+        exit(1);
+      }
+    }
+  }
+  llvm::outs() << "\n";
+}
+
+int main(int argc, char **argv) {
+  llvm::InitLLVM y(argc, argv);
+  llvm::cl::ParseCommandLineOptions(
+      argc, argv, "Compare the simplex schedulers' dense and sparse tableaus\n");
+  if (sizes.empty())
+    for (unsigned size : {250, 1000, 4000, 16000})
+      sizes.push_back(size);
+
+  MLIRContext context;
+  context.allowUnregisteredDialects();
+  auto loc = UnknownLoc::get(&context);
+  std::mt19937 rng(seed);
+
+  for (unsigned numOps : sizes) {
+    if (numOps < 2) {
+      llvm::errs() << "problems need at least two operations\n";
+      return 1;
+    }
+    auto graph = generateGraph(numOps, rng);
+
+    OwningOpRef<ModuleOp> module = ModuleOp::create(loc);
+    OpBuilder builder = OpBuilder::atBlockEnd(module->getBody());
+    OperationState state(loc, "bench.op");
+    SmallVector<Operation *> ops;
+    for (unsigned i = 0; i < numOps; ++i)
+      ops.push_back(builder.create(state));
+
+    runBenchmark<Problem>("Problem", graph, *module, ops);
+    runBenchmark<ModuloProblem>("ModuloProblem", graph, *module, ops);
+  }
+  return 0;
+}
@@ -53,8 +53,10 @@
 #include "mlir/Support/ToolUtilities.h"
 #include "mlir/Tools/Plugins/PassPlugin.h"
 #include "mlir/Transforms/Passes.h"
+#include "llvm/Config/llvm-config.h"
 #include "llvm/Support/Chrono.h"
 #include "llvm/Support/CommandLine.h"
+#include "llvm/Support/Errno.h"
 #include "llvm/Support/FileSystem.h"
 #include "llvm/Support/InitLLVM.h"
 #include "llvm/Support/Path.h"
@@ -62,6 +64,16 @@
 #include "llvm/Support/SourceMgr.h"
 #include "llvm/Support/ToolOutputFile.h"
 
+#ifdef LLVM_ON_UNIX
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
 using namespace llvm;
 using namespace mlir;
 using namespace circt;
@@ -241,8 +253,31 @@ static cl::opt<bool>
                           cl::desc("Log executions of toplevel module passes"),
                           cl::init(false), cl::cat(mainCategory));
 
+static cl::opt<bool> analysisStatistics(
+    "analysis-statistics",
+    cl::desc("Report how many times each analysis was computed and the time "
+             "spent computing it"),
+    cl::init(false), cl::cat(mainCategory));
+
+static cl::opt<std::string> memoryStatistics(
+    "memory-statistics",
+    cl::desc("Write the memory usage of each pass as JSON to the specified "
+             "file"),
+    cl::value_desc("filename"), cl::init(""), cl::cat(mainCategory));
+
 static LoweringOptionsOption loweringOptions(mainCategory);
 
+static cl::opt<std::string> serveSocket(
+    "serve",
+    cl::desc("Run as a compile server accepting requests on a Unix socket"),
+    cl::init(""), cl::value_desc("socket"), cl::cat(mainCategory));
+
+static cl::opt<std::string> connectSocket(
+    "connect",
+    cl::desc("Forward this invocation to a compile server started with "
+             "--serve"),
+    cl::init(""), cl::value_desc("socket"), cl::cat(mainCategory));
+
 /// Check output stream before writing bytecode to it.
 /// Warn and return true if output is known to be displayed.
 static bool checkBytecodeOutputToConsole(raw_ostream &os) {
@@ -274,25 +309,47 @@ static debug::EmitHGLDDOptions getHGLDDOptions() {
   return opts;
 }
 
+/// Common base of the HGLDD emission passes, reporting the size of the
+/// output as pass statistics.
+template <typename ConcretePass>
+struct EmitHGLDDPassBase
+    : public PassWrapper<ConcretePass, OperationPass<mlir::ModuleOp>> {
+protected:
+  void recordStatistics(const debug::EmitHGLDDStatistics &statistics) {
+    numFiles += statistics.numFiles;
+    numObjects += statistics.numObjects;
+    numBytes += statistics.numBytes;
+  }
+
+  Pass::Statistic numFiles{this, "num-files", "Number of HGLDD files emitted"};
+  Pass::Statistic numObjects{this, "num-objects",
+                             "Number of modules, instances, and variables"};
+  Pass::Statistic numBytes{this, "num-bytes", "Number of bytes emitted"};
+};
+
 /// Wrapper pass to call the `emitHGLDD` translation.
-struct EmitHGLDDPass
-    : public PassWrapper<EmitHGLDDPass, OperationPass<mlir::ModuleOp>> {
+struct EmitHGLDDPass : public EmitHGLDDPassBase<EmitHGLDDPass> {
   llvm::raw_ostream &os;
   EmitHGLDDPass(llvm::raw_ostream &os) : os(os) {}
   void runOnOperation() override {
     markAllAnalysesPreserved();
-    if (failed(debug::emitHGLDD(getOperation(), os, getHGLDDOptions())))
+    debug::EmitHGLDDStatistics statistics;
+    if (failed(debug::emitHGLDD(getOperation(), os, getHGLDDOptions(),
+                                &statistics)))
       return signalPassFailure();
+    recordStatistics(statistics);
   }
 };
 
 /// Wrapper pass to call the `emitSplitHGLDD` translation.
-struct EmitSplitHGLDDPass
-    : public PassWrapper<EmitSplitHGLDDPass, OperationPass<mlir::ModuleOp>> {
+struct EmitSplitHGLDDPass : public EmitHGLDDPassBase<EmitSplitHGLDDPass> {
   void runOnOperation() override {
     markAllAnalysesPreserved();
-    if (failed(debug::emitSplitHGLDD(getOperation(), getHGLDDOptions())))
+    debug::EmitHGLDDStatistics statistics;
+    if (failed(debug::emitSplitHGLDD(getOperation(), getHGLDDOptions(),
+                                     &statistics)))
       return signalPassFailure();
+    recordStatistics(statistics);
   }
 };
 
@@ -358,6 +415,19 @@ static LogicalResult processBuffer(
                  << " sec\n";
   }
 
+  // The memory report is written when the pass manager is destroyed, so the
+  // file must outlive it.
+  std::unique_ptr<llvm::ToolOutputFile> memoryStatisticsFile;
+  if (!memoryStatistics.empty()) {
+    std::string errorMessage;
+    memoryStatisticsFile = openOutputFile(memoryStatistics, &errorMessage);
+    if (!memoryStatisticsFile) {
+      llvm::errs() << errorMessage;
+      return failure();
+    }
+    memoryStatisticsFile->keep();
+  }
+
   // Apply any pass manager command line options.
   PassManager pm(&context);
   pm.enableVerifier(verifyPasses);
@@ -367,6 +437,14 @@ static LogicalResult processBuffer(
         std::make_unique<
             VerbosePassInstrumentation<firrtl::CircuitOp, mlir::ModuleOp>>(
             "firtool"));
+  if (analysisStatistics)
+    pm.addInstrumentation(
+        std::make_unique<AnalysisStatisticsInstrumentation>(llvm::errs()));
+  if (memoryStatisticsFile)
+    pm.addInstrumentation(
+        std::make_unique<
+            MemoryStatisticsInstrumentation<firrtl::CircuitOp, mlir::ModuleOp>>(
+            memoryStatisticsFile->os()));
   if (failed(applyPassManagerCLOptions(pm)))
     return failure();
 
@@ -566,6 +644,14 @@ processInput(MLIRContext &context, TimingScope &ts,
       llvm::outs());
 }
 
+/// Load the dialects firtool works with into the context.
+static void loadDialects(MLIRContext &context) {
+  context.loadDialect<chirrtl::CHIRRTLDialect, firrtl::FIRRTLDialect,
+                      hw::HWDialect, comb::CombDialect, seq::SeqDialect,
+                      om::OMDialect, sv::SVDialect, verif::VerifDialect,
+                      ltl::LTLDialect, debug::DebugDialect>();
+}
+
 /// This implements the top-level logic for the firtool command, invoked once
 /// command line options are parsed and LLVM/MLIR are all set up and ready to
 /// go.
@@ -626,10 +712,7 @@ static LogicalResult executeFirtool(MLIRContext &context) {
   }
 
   // Register our dialects.
-  context.loadDialect<chirrtl::CHIRRTLDialect, firrtl::FIRRTLDialect,
-                      hw::HWDialect, comb::CombDialect, seq::SeqDialect,
-                      om::OMDialect, sv::SVDialect, verif::VerifDialect,
-                      ltl::LTLDialect, debug::DebugDialect>();
+  loadDialects(context);
 
   // Process the input.
   if (failed(processInput(context, ts, std::move(input), outputFile)))
@@ -642,6 +725,406 @@ static LogicalResult executeFirtool(MLIRContext &context) {
   return success();
 }
 
+//===----------------------------------------------------------------------===//
+// Compile Server
+//===----------------------------------------------------------------------===//
+//
+// With `--serve=<socket>`, firtool starts up once, registers its passes, loads
+// its dialects, and then accepts compile requests on a Unix socket. A
+// `firtool --connect=<socket> <args>...` client forwards its command line,
+// working directory, and standard streams to the server, which forks a child
+// off the warm process for every request. The child parses the request's
+// command line and runs the regular `executeFirtool`, such that every request
+// sees exactly the state a fresh process would and cannot affect any other
+// request. The server sends the child's exit status back to the client, which
+// exits with it.
+//
+// Options that configure the `MLIRContext` itself, such as
+// `--mlir-disable-threading`, take effect when the context is created and are
+// therefore fixed by the server's command line.
+//
+//===----------------------------------------------------------------------===//
+
+#ifdef LLVM_ON_UNIX
+
+/// The number of file descriptors (stdin, stdout, stderr) that accompany each
+/// request.
+static constexpr unsigned numRequestFDs = 3;
+
+/// Pipe written to by the server's signal handler to wake up its loop.
+static int signalPipe[2] = {-1, -1};
+
+/// Whether the server has been asked to shut down.
+static volatile sig_atomic_t stopServer = 0;
+
+static void handleServerSignal(int signal) {
+  int savedErrno = errno;
+  if (signal != SIGCHLD)
+    stopServer = 1;
+  char c = 0;
+  (void)!::write(signalPipe[1], &c, 1);
+  errno = savedErrno;
+}
+
+/// Fill in the Unix domain socket address for the given path.
+static bool getSocketAddress(StringRef path, sockaddr_un &addr) {
+  memset(&addr, 0, sizeof(addr));
+  addr.sun_family = AF_UNIX;
+  if (path.size() >= sizeof(addr.sun_path)) {
+    llvm::errs() << "socket path too long: " << path << "\n";
+    return false;
+  }
+  memcpy(addr.sun_path, path.data(), path.size());
+  return true;
+}
+
+/// Send an entire buffer over a socket.
+static bool sendAll(int fd, const void *data, size_t size) {
+  const char *ptr = static_cast<const char *>(data);
+  while (size > 0) {
+    auto n = ::send(fd, ptr, size, MSG_NOSIGNAL);
+    if (n < 0 && errno == EINTR)
+      continue;
+    if (n <= 0)
+      return false;
+    ptr += n;
+    size -= n;
+  }
+  return true;
+}
+
+/// Receive an entire buffer from a socket.
+static bool receiveAll(int fd, void *data, size_t size) {
+  char *ptr = static_cast<char *>(data);
+  while (size > 0) {
+    auto n = ::recv(fd, ptr, size, 0);
+    if (n < 0 && errno == EINTR)
+      continue;
+    if (n <= 0)
+      return false;
+    ptr += n;
+    size -= n;
+  }
+  return true;
+}
+
+/// Send a request to the server. A request consists of the size of its
+/// payload, which carries along the client's standard streams as `SCM_RIGHTS`
+/// ancillary data, followed by the payload itself. The payload is the client's
+/// working directory and command line arguments as NUL-terminated strings.
+static bool sendRequest(int fd, StringRef payload) {
+  uint32_t size = payload.size();
+  iovec iov{&size, sizeof(size)};
+  int fds[numRequestFDs] = {STDIN_FILENO, STDOUT_FILENO, STDERR_FILENO};
+  alignas(cmsghdr) char control[CMSG_SPACE(sizeof(fds))];
+  msghdr msg{};
+  msg.msg_iov = &iov;
+  msg.msg_iovlen = 1;
+  msg.msg_control = control;
+  msg.msg_controllen = sizeof(control);
+  auto *cmsg = CMSG_FIRSTHDR(&msg);
+  cmsg->cmsg_level = SOL_SOCKET;
+  cmsg->cmsg_type = SCM_RIGHTS;
+  cmsg->cmsg_len = CMSG_LEN(sizeof(fds));
+  memcpy(CMSG_DATA(cmsg), fds, sizeof(fds));
+
+  ssize_t n;
+  do
+    n = ::sendmsg(fd, &msg, MSG_NOSIGNAL);
+  while (n < 0 && errno == EINTR);
+  if (n != sizeof(size))
+    return false;
+  return sendAll(fd, payload.data(), payload.size());
+}
+
+/// Receive a request sent by `sendRequest`.
+static bool receiveRequest(int fd, std::string &payload,
+                           SmallVectorImpl<int> &fds) {
+  uint32_t size;
+  iovec iov{&size, sizeof(size)};
+  alignas(cmsghdr) char control[CMSG_SPACE(sizeof(int) * numRequestFDs)];
+  msghdr msg{};
+  msg.msg_iov = &iov;
+  msg.msg_iovlen = 1;
+  msg.msg_control = control;
+  msg.msg_controllen = sizeof(control);
+
+  ssize_t n;
+  do
+    n = ::recvmsg(fd, &msg, 0);
+  while (n < 0 && errno == EINTR);
+  if (n <= 0)
+    return false;
+  for (auto *cmsg = CMSG_FIRSTHDR(&msg); cmsg; cmsg = CMSG_NXTHDR(&msg, cmsg)) {
+    if (cmsg->cmsg_level != SOL_SOCKET || cmsg->cmsg_type != SCM_RIGHTS)
+      continue;
+    unsigned numFDs = (cmsg->cmsg_len - CMSG_LEN(0)) / sizeof(int);
+    auto *data = reinterpret_cast<int *>(CMSG_DATA(cmsg));
+    fds.append(data, data + numFDs);
+  }
+
+  auto fail = [&] {
+    for (int fd : fds)
+      ::close(fd);
+    fds.clear();
+    return false;
+  };
+  if (fds.size() != numRequestFDs || (msg.msg_flags & MSG_CTRUNC))
+    return fail();
+  if (n < (ssize_t)sizeof(size) &&
+      !receiveAll(fd, reinterpret_cast<char *>(&size) + n, sizeof(size) - n))
+    return fail();
+  payload.resize(size);
+  if (!receiveAll(fd, payload.data(), size) || payload.empty() ||
+      payload.back() != '\0')
+    return fail();
+  return true;
+}
+
+/// Forward a firtool invocation to a compile server and return the exit code
+/// it reports.
+static int runClient(StringRef socketPath, ArrayRef<const char *> args) {
+  sockaddr_un addr;
+  if (!getSocketAddress(socketPath, addr))
+    return 1;
+  int fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+  if (fd < 0 ||
+      ::connect(fd, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) < 0) {
+    llvm::errs() << "cannot connect to compile server '" << socketPath
+                 << "': " << sys::StrError() << "\n";
+    return 1;
+  }
+
+  SmallString<128> cwd;
+  if (auto error = sys::fs::current_path(cwd)) {
+    llvm::errs() << "cannot determine working directory: " << error.message()
+                 << "\n";
+    return 1;
+  }
+  std::string payload(cwd.str());
+  payload.push_back('\0');
+  for (auto *arg : args) {
+    payload += arg;
+    payload.push_back('\0');
+  }
+  if (!sendRequest(fd, payload)) {
+    llvm::errs() << "cannot send request to compile server '" << socketPath
+                 << "': " << sys::StrError() << "\n";
+    return 1;
+  }
+
+  int32_t exitCode;
+  if (!receiveAll(fd, &exitCode, sizeof(exitCode))) {
+    llvm::errs() << "compile server '" << socketPath
+                 << "' closed the connection without a result\n";
+    return 1;
+  }
+  ::close(fd);
+  return exitCode;
+}
+
+/// Handle a single request in a child process forked off the server. This
+/// never returns.
+[[noreturn]] static void runRequest(MLIRContext &context, ArrayRef<int> fds,
+                                    StringRef payload) {
+  // Move the client's streams into place. Go through descriptors above the
+  // standard ones first, since the received descriptors may overlap them.
+  SmallVector<int, numRequestFDs> movedFDs;
+  for (int fd : fds) {
+    movedFDs.push_back(::fcntl(fd, F_DUPFD, numRequestFDs));
+    ::close(fd);
+  }
+  for (auto [targetFD, fd] : llvm::enumerate(movedFDs)) {
+    ::dup2(fd, targetFD);
+    ::close(fd);
+  }
+
+  SmallVector<StringRef> parts;
+  payload.drop_back().split(parts, '\0');
+  if (::chdir(parts[0].data()) < 0) {
+    llvm::errs() << "cannot change to directory '" << parts[0]
+                 << "': " << sys::StrError() << "\n";
+    exit(1);
+  }
+
+  // The payload strings are NUL-terminated and can be passed on directly.
+  SmallVector<const char *> argv;
+  argv.push_back("firtool");
+  for (auto arg : llvm::drop_begin(parts))
+    argv.push_back(arg.data());
+  cl::ResetAllOptionOccurrences();
+  if (!cl::ParseCommandLineOptions(argv.size(), argv.data(),
+                                   "MLIR-based FIRRTL compiler\n",
+                                   &llvm::errs()))
+    exit(1);
+  if (!serveSocket.empty()) {
+    llvm::errs() << "compile requests cannot start another server\n";
+    exit(1);
+  }
+
+  exit(failed(executeFirtool(context)));
+}
+
+/// Run the compile server, accepting requests until interrupted.
+static LogicalResult runServer(MLIRContext &context) {
+  sockaddr_un addr;
+  if (!getSocketAddress(serveSocket, addr))
+    return failure();
+
+  // Replace a stale socket left behind by a previous server, but never
+  // clobber any other kind of file.
+  sys::fs::file_status status;
+  if (!sys::fs::status(serveSocket, status)) {
+    if (status.type() != sys::fs::file_type::socket_file) {
+      llvm::errs() << "cannot create compile server socket '" << serveSocket
+                   << "': file exists\n";
+      return failure();
+    }
+    ::unlink(serveSocket.c_str());
+  }
+
+  int listenFD = ::socket(AF_UNIX, SOCK_STREAM, 0);
+  if (listenFD < 0 ||
+      ::bind(listenFD, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) <
+          0 ||
+      ::listen(listenFD, SOMAXCONN) < 0) {
+    llvm::errs() << "cannot create compile server socket '" << serveSocket
+                 << "': " << sys::StrError() << "\n";
+    return failure();
+  }
+
+  // Wake up the server loop whenever a request's child process exits, or when
+  // the server is interrupted. The latter lets the server finish the requests
+  // in flight and remove its socket.
+  if (::pipe(signalPipe) < 0) {
+    llvm::errs() << "cannot create pipe: " << sys::StrError() << "\n";
+    return failure();
+  }
+  for (int fd : signalPipe)
+    ::fcntl(fd, F_SETFL, O_NONBLOCK);
+  struct sigaction action = {};
+  action.sa_handler = handleServerSignal;
+  action.sa_flags = SA_RESTART | SA_NOCLDSTOP;
+  for (int signal : {SIGCHLD, SIGINT, SIGTERM, SIGHUP})
+    ::sigaction(signal, &action, nullptr);
+
+  // Load the dialects up front such that every request starts out with a
+  // warm context. The context creates its threads lazily, so none exist yet
+  // at the point where requests are forked off.
+  loadDialects(context);
+  llvm::errs() << "[firtool] Serving on " << serveSocket << "\n";
+
+  // The connection of each request in flight, by child process.
+  DenseMap<pid_t, int> pendingRequests;
+  while (!stopServer || !pendingRequests.empty()) {
+    pollfd pollFDs[2] = {{signalPipe[0], POLLIN, 0}, {listenFD, POLLIN, 0}};
+    if (::poll(pollFDs, stopServer ? 1 : 2, -1) < 0) {
+      if (errno == EINTR)
+        continue;
+      llvm::errs() << "compile server failed: " << sys::StrError() << "\n";
+      return failure();
+    }
+
+    // Report the exit status of finished requests back to their clients.
+    if (pollFDs[0].revents & POLLIN) {
+      char buffer[64];
+      while (::read(signalPipe[0], buffer, sizeof(buffer)) > 0)
+        ;
+      int status;
+      pid_t pid;
+      while ((pid = ::waitpid(-1, &status, WNOHANG)) > 0) {
+        auto it = pendingRequests.find(pid);
+        if (it == pendingRequests.end())
+          continue;
+        int32_t exitCode = WIFEXITED(status) ? WEXITSTATUS(status)
+                                             : 128 + WTERMSIG(status);
+        (void)sendAll(it->second, &exitCode, sizeof(exitCode));
+        ::close(it->second);
+        pendingRequests.erase(it);
+      }
+    }
+
+    if (stopServer || !(pollFDs[1].revents & POLLIN))
+      continue;
+    int connFD = ::accept(listenFD, nullptr, nullptr);
+    if (connFD < 0)
+      continue;
+
+    // The request is read by the child, such that a slow or stuck client
+    // cannot hold up the server from accepting other requests.
+    pid_t pid = ::fork();
+    if (pid == 0) {
+      ::close(listenFD);
+      for (int fd : signalPipe)
+        ::close(fd);
+      for (auto [otherPid, otherFD] : pendingRequests)
+        ::close(otherFD);
+      for (int signal : {SIGCHLD, SIGINT, SIGTERM, SIGHUP})
+        ::signal(signal, SIG_DFL);
+      std::string payload;
+      SmallVector<int, numRequestFDs> fds;
+      if (!receiveRequest(connFD, payload, fds))
+        exit(1);
+      ::close(connFD);
+      runRequest(context, fds, payload);
+    }
+    if (pid < 0) {
+      llvm::errs() << "cannot fork compile request: " << sys::StrError()
+                   << "\n";
+      int32_t exitCode = 1;
+      (void)sendAll(connFD, &exitCode, sizeof(exitCode));
+      ::close(connFD);
+      continue;
+    }
+    pendingRequests.insert({pid, connFD});
+  }
+
+  ::close(listenFD);
+  ::unlink(serveSocket.c_str());
+  return success();
+}
+
+#else // LLVM_ON_UNIX
+
+static int runClient(StringRef socketPath, ArrayRef<const char *> args) {
+  llvm::errs() << "compile server not supported on this platform\n";
+  return 1;
+}
+
+static LogicalResult runServer(MLIRContext &context) {
+  llvm::errs() << "compile server not supported on this platform\n";
+  return failure();
+}
+
+#endif // LLVM_ON_UNIX
+
+/// Check whether the command line asks to forward the invocation to a compile
+/// server. If it does, return the server's socket and collect the remaining
+/// arguments in `forwardedArgs`.
+static std::optional<std::string>
+getConnectSocket(int argc, char **argv,
+                 SmallVectorImpl<const char *> &forwardedArgs) {
+  std::optional<std::string> socket;
+  for (int i = 1; i < argc; ++i) {
+    StringRef arg = argv[i];
+    if (arg == "--") {
+      forwardedArgs.append(argv + i, argv + argc);
+      break;
+    }
+    if (!arg.consume_front("--connect") && !arg.consume_front("-connect")) {
+      forwardedArgs.push_back(argv[i]);
+      continue;
+    }
+    if (arg.consume_front("="))
+      socket = arg.str();
+    else if (arg.empty() && i + 1 < argc)
+      socket = argv[++i];
+    else
+      forwardedArgs.push_back(argv[i]);
+  }
+  return socket;
+}
+
 /// Main driver for firtool command.  This sets up LLVM and MLIR, and parses
 /// command line options before passing off to 'executeFirtool'.  This is set up
 /// so we can `exit(0)` at the end of the program to avoid teardown of the
@@ -649,6 +1132,12 @@ static LogicalResult executeFirtool(MLIRContext &context) {
 int main(int argc, char **argv) {
   InitLLVM y(argc, argv);
 
+  // Forward the invocation to a compile server if requested. This happens
+  // before any registration to keep the client as lightweight as possible.
+  SmallVector<const char *> forwardedArgs;
+  if (auto socket = getConnectSocket(argc, argv, forwardedArgs))
+    exit(runClient(*socket, forwardedArgs));
+
   // Set the bug report message to indicate users should file issues on
   // llvm/circt and not llvm/llvm-project.
   setBugReportMsg(circtBugReportMsg);
@@ -711,6 +1200,10 @@ int main(int argc, char **argv) {
 
   MLIRContext context;
 
+  // Keep the process around to serve compile requests if requested.
+  if (!serveSocket.empty())
+    exit(failed(runServer(context)));
+
   // Do the guts of the firtool process.
   auto result = executeFirtool(context);
 
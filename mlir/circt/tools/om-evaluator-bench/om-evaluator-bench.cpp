@@ -0,0 +1,189 @@
+//===- om-evaluator-bench.cpp - OM evaluator benchmark --------------------===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+//
+// Evaluate a synthetic object model, shaped like the metadata of a large SoC,
+// with and without instance memoization, and compare the evaluation times and
+// the memory held by the results. Both must yield the same objects.
+//
+//===----------------------------------------------------------------------===//
+
+#include "circt/Dialect/OM/Evaluator/Evaluator.h"
+#include "circt/Dialect/OM/OMDialect.h"
+#include "mlir/IR/BuiltinOps.h"
+#include "mlir/IR/MLIRContext.h"
+#include "mlir/Parser/Parser.h"
+#include "llvm/ADT/Hashing.h"
+#include "llvm/Support/CommandLine.h"
+#include "llvm/Support/Format.h"
+#include "llvm/Support/InitLLVM.h"
+#include "llvm/Support/Process.h"
+#include "llvm/Support/raw_ostream.h"
+
+#include <chrono>
+#include <optional>
+#include <string>
+
+using namespace mlir;
+using namespace circt;
+using namespace circt::om;
+
+static llvm::cl::opt<unsigned>
+    depth("depth", llvm::cl::desc("Number of levels of the object hierarchy"),
+          llvm::cl::init(4));
+
+static llvm::cl::opt<unsigned>
+    fanout("fanout", llvm::cl::desc("Number of children of each object"),
+           llvm::cl::init(8));
+
+static llvm::cl::opt<unsigned> distinct(
+    "distinct",
+    llvm::cl::desc("Number of distinct parameters among an object's children"),
+    llvm::cl::init(2));
+
+static llvm::cl::opt<bool>
+    skipUnmemoized("skip-unmemoized",
+                   llvm::cl::desc("Only evaluate with memoization"),
+                   llvm::cl::init(false));
+
+/// Generate the object model. Each level instantiates the level below
+/// `fanout` times, cycling through `distinct` parameter values, and the leaves
+/// carry a few fields of their own.
+static std::string generateModule() {
+  std::string str;
+  llvm::raw_string_ostream os(str);
+  auto classType = [](unsigned level) {
+    return "!om.class.type<@Level" + std::to_string(level) + ">";
+  };
+
+  os << "om.class @Level0(%kind: !om.string) {\n"
+     << "  %leaf = om.constant \"leaf\" : !om.string\n"
+     << "  %tags = om.list_create %kind, %leaf : !om.string\n"
+     << "  om.class.field @kind, %kind : !om.string\n"
+     << "  om.class.field @tags, %tags : !om.list<!om.string>\n"
+     << "}\n";
+
+  for (unsigned level = 1; level <= depth; ++level) {
+    auto childType = classType(level - 1);
+    os << "om.class @Level" << level << "(%kind: !om.string) {\n";
+    for (unsigned i = 0; i < fanout; ++i)
+      os << "  %c" << i << " = om.constant \"kind" << i % distinct
+         << "\" : !om.string\n"
+         << "  %o" << i << " = om.object @Level" << level - 1 << "(%c" << i
+         << ") : (!om.string) -> " << childType << "\n";
+    os << "  %children = om.list_create ";
+    for (unsigned i = 0; i < fanout; ++i)
+      os << (i ? ", " : "") << "%o" << i;
+    os << " : " << childType << "\n"
+       << "  om.class.field @kind, %kind : !om.string\n"
+       << "  om.class.field @children, %children : !om.list<" << childType
+       << ">\n"
+       << "}\n";
+  }
+
+  os << "om.class @Top() {\n"
+     << "  %kind = om.constant \"top\" : !om.string\n"
+     << "  %root = om.object @Level" << depth << "(%kind) : (!om.string) -> "
+     << classType(depth) << "\n"
+     << "  om.class.field @root, %root : " << classType(depth) << "\n"
+     << "}\n";
+  return str;
+}
+
+namespace {
+/// What a walk over the evaluated objects saw.
+struct Summary {
+  size_t numObjects = 0;
+  llvm::hash_code hash = llvm::hash_value(0);
+
+  bool operator==(const Summary &other) const {
+    return numObjects == other.numObjects && hash == other.hash;
+  }
+};
+} // namespace
+
+/// Walk the objects reachable from `value`, visiting shared values once per
+/// reference, and hash the leaves' kinds in walk order.
+static void summarize(const evaluator::EvaluatorValue *value,
+                      Summary &summary) {
+  if (auto *object = dyn_cast<evaluator::ObjectValue>(value)) {
+    ++summary.numObjects;
+    for (auto name : {"kind", "root", "children"}) {
+      auto field = object->getFields().lookup(
+          StringAttr::get(value->getContext(), name));
+      if (field)
+        summarize(field.get(), summary);
+    }
+  } else if (auto *list = dyn_cast<evaluator::ListValue>(value)) {
+    for (auto &element : list->getElements())
+      summarize(element.get(), summary);
+  } else if (auto *attr = dyn_cast<evaluator::AttributeValue>(value)) {
+    summary.hash = llvm::hash_combine(summary.hash, attr->getAttr());
+  }
+}
+
+int main(int argc, char **argv) {
+  llvm::InitLLVM y(argc, argv);
+  llvm::cl::ParseCommandLineOptions(
+      argc, argv, "Compare OM evaluation with and without memoization\n");
+  if (fanout == 0 || distinct == 0) {
+    llvm::errs() << "fanout and distinct must be positive\n";
+    return 1;
+  }
+
+  MLIRContext context;
+  context.loadDialect<OMDialect>();
+  auto module =
+      parseSourceString<ModuleOp>(generateModule(), ParserConfig(&context));
+  if (!module)
+    return 1;
+
+  llvm::outs() << "depth " << depth << ", fanout " << fanout << ", distinct "
+               << distinct << ":";
+  std::optional<Summary> unmemoizedSummary;
+  double unmemoizedTime = 0;
+  for (bool memoize : {false, true}) {
+    if (!memoize && skipUnmemoized)
+      continue;
+
+    size_t startHeap = llvm::sys::Process::GetMallocUsage();
+    auto start = std::chrono::steady_clock::now();
+    Summary summary;
+    {
+      Evaluator evaluator(*module, memoize);
+      auto result = evaluator.instantiate(StringAttr::get(&context, "Top"), {});
+      if (failed(result)) {
+        llvm::errs() << "\nevaluation failed\n";
+        return 1;
+      }
+      std::chrono::duration<double> elapsed =
+          std::chrono::steady_clock::now() - start;
+      size_t heap = llvm::sys::Process::GetMallocUsage() - startHeap;
+      summarize(result->get(), summary);
+
+      llvm::outs() << "\n  " << (memoize ? "memoized" : "unmemoized") << ": "
+                   << summary.numObjects << " objects, "
+                   << llvm::format("%.3f", elapsed.count()) << " s, "
+                   << llvm::format("%.1f", heap / (1024.0 * 1024.0)) << " MiB";
+      if (!memoize) {
+        unmemoizedSummary = summary;
+        unmemoizedTime = elapsed.count();
+        continue;
+      }
+      if (unmemoizedSummary)
+        llvm::outs() << " ("
+                     << llvm::format("%.1f", unmemoizedTime / elapsed.count())
+                     << "x)";
+    }
+    if (unmemoizedSummary && !(summary == *unmemoizedSummary)) {
+      llvm::errs() << "\nthe evaluated objects differ\n";
+      return 1;
+    }
+  }
+  llvm::outs() << "\n";
+  return 0;
+}
@@ -0,0 +1,161 @@
+//===- pretty-printer-bench.cpp - Pretty printer benchmark ----------------===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+//
+// Pretty print a synthetic module, shaped like the Verilog emitted for a large
+// design, with and without a lookahead limit, and compare the throughput and
+// the number of tokens buffered by the printer. Both must print the same text.
+//
+//===----------------------------------------------------------------------===//
+
+#include "circt/Support/PrettyPrinter.h"
+#include "circt/Support/PrettyPrinterHelpers.h"
+#include "llvm/ADT/StringExtras.h"
+#include "llvm/Support/CommandLine.h"
+#include "llvm/Support/Format.h"
+#include "llvm/Support/InitLLVM.h"
+#include "llvm/Support/raw_ostream.h"
+
+#include <chrono>
+#include <optional>
+#include <string>
+
+using namespace circt;
+using namespace circt::pretty;
+
+static llvm::cl::opt<unsigned>
+    width("width", llvm::cl::desc("Number of operands of each concatenation"),
+          llvm::cl::init(4096));
+
+static llvm::cl::opt<unsigned>
+    assigns("assigns", llvm::cl::desc("Number of concatenation assignments"),
+            llvm::cl::init(16));
+
+static llvm::cl::opt<unsigned>
+    cases("cases", llvm::cl::desc("Number of items of the case statement"),
+          llvm::cl::init(65536));
+
+static llvm::cl::opt<unsigned>
+    margin("margin", llvm::cl::desc("Target line length"), llvm::cl::init(90));
+
+static llvm::cl::opt<unsigned> lookaheadLimit(
+    "lookahead-limit",
+    llvm::cl::desc("Lookahead limit of the bounded run (0 uses the limit "
+                   "ExportVerilog sets for the margin)"),
+    llvm::cl::init(0));
+
+/// Stream the module. Operands are wrapped in their own boxes the way the
+/// expression emitter does, so the stream carries many zero-width tokens.
+static void emitModule(TokenStream<> &ps) {
+  ps << "module Bench(";
+  ps.scopedBox(PP::ibox0, [&]() {
+    ps << "input [" << PPSaveString(std::to_string(width)) << ":0] in,"
+       << PP::space << "output [31:0] out";
+  });
+  ps << ");" << PP::newline;
+
+  for (unsigned i = 0; i < assigns; ++i) {
+    ps.scopedBox(PP::ibox2, [&]() {
+      ps << "assign " << PPSaveString("cat_" + std::to_string(i)) << " ="
+         << PP::space;
+      ps.scopedBox(PP::ibox0, [&]() {
+        ps << "{";
+        for (unsigned j = 0; j < width; ++j) {
+          if (j)
+            ps << "," << PP::space;
+          ps.scopedBox(PP::ibox0, [&]() {
+            ps << "in[" << PPSaveString(std::to_string((i + j) % width))
+               << "]";
+          });
+        }
+        ps << "};";
+      });
+    });
+    ps << PP::newline;
+  }
+
+  ps << "always_comb begin";
+  ps.scopedBox(PP::bbox2, [&]() {
+    ps << PP::newline << "case (in[31:0])";
+    ps.scopedBox(PP::bbox2, [&]() {
+      for (unsigned i = 0; i < cases; ++i) {
+        ps << PP::newline;
+        ps.scopedBox(PP::ibox2, [&]() {
+          ps << PPSaveString("32'h" + llvm::utohexstr(i)) << ":" << PP::space
+             << "out =" << PP::space;
+          ps.scopedBox(PP::ibox0, [&]() {
+            ps << PPSaveString("cat_" + std::to_string(i % assigns))
+               << "[31:0]" << PP::space << "^" << PP::space
+               << PPSaveString("32'h" + llvm::utohexstr(~i)) << ";";
+          });
+        });
+      }
+      ps << PP::newline << "default:" << PP::space << "out = 32'h0;";
+    });
+    ps << PP::newline << "endcase";
+  });
+  ps << PP::newline << "end" << PP::newline << "endmodule" << PP::newline;
+}
+
+int main(int argc, char **argv) {
+  llvm::InitLLVM y(argc, argv);
+  llvm::cl::ParseCommandLineOptions(
+      argc, argv,
+      "Compare pretty printing with and without a lookahead limit\n");
+  if (width == 0 || assigns == 0) {
+    llvm::errs() << "width and assigns must be positive\n";
+    return 1;
+  }
+  unsigned limit = lookaheadLimit ? lookaheadLimit.getValue()
+                                  : std::max(8192U, 16 * margin);
+
+  llvm::outs() << "width " << width << ", assigns " << assigns << ", cases "
+               << cases << ", margin " << margin << ":";
+  std::optional<std::string> unboundedOutput;
+  for (unsigned runLimit : {0U, limit}) {
+    std::string output;
+    llvm::raw_string_ostream os(output);
+    auto start = std::chrono::steady_clock::now();
+    uint64_t numTokens;
+    size_t peakLookahead;
+    {
+      TokenStringSaver saver;
+      PrettyPrinter pp(os, margin);
+      pp.setListener(&saver);
+      pp.setLookaheadLimit(runLimit);
+      TokenStream<> ps(pp, saver);
+      emitModule(ps);
+      ps << PP::eof;
+      numTokens = pp.getNumTokens();
+      peakLookahead = pp.getPeakLookahead();
+    }
+    std::chrono::duration<double> elapsed =
+        std::chrono::steady_clock::now() - start;
+
+    llvm::outs() << "\n  ";
+    if (runLimit)
+      llvm::outs() << "lookahead limit " << runLimit;
+    else
+      llvm::outs() << "unbounded";
+    llvm::outs() << ": " << numTokens << " tokens, "
+                 << llvm::format("%.3f", elapsed.count()) << " s ("
+                 << llvm::format("%.1f", numTokens / elapsed.count() / 1e6)
+                 << " Mtokens/s), peak lookahead " << peakLookahead
+                 << " tokens";
+
+    if (!unboundedOutput) {
+      unboundedOutput = std::move(output);
+      continue;
+    }
+    if (output != *unboundedOutput) {
+      llvm::errs() << "\nthe printed text differs\n";
+      return 1;
+    }
+  }
+  llvm::outs() << "\n";
+  return 0;
+}
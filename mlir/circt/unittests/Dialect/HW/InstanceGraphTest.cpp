@@ -37,4 +37,45 @@ TEST(InstanceGraphTest, PostOrderTraversal) {
   ASSERT_EQ(range.end(), it);
 }
 
+TEST(InstanceGraphTest, CachedPostOrder) {
+  MLIRContext context;
+  InstanceGraph graph(fixtures::createModule(&context));
+
+  // The cached order is the same as the post-order traversal.
+  auto postOrder = graph.getPostOrder();
+  ASSERT_TRUE(llvm::equal(postOrder, llvm::post_order(&graph)));
+  ASSERT_EQ(postOrder.data(), graph.getPostOrder().data());
+
+  // Each module is in a level above the modules it instantiates.
+  auto levels = graph.getLevels();
+  ASSERT_EQ(5u, levels.size());
+  ASSERT_EQ("Cat", levels[0][0]->getModule().getModuleName());
+  ASSERT_EQ("Bear", levels[1][0]->getModule().getModuleName());
+  ASSERT_EQ("Alligator", levels[2][0]->getModule().getModuleName());
+  ASSERT_EQ("Top", levels[3][0]->getModule().getModuleName());
+  ASSERT_EQ(graph.getTopLevelNode(), levels[4][0]);
+
+  // Removing an edge recomputes the orders. Alligator and Bear are no longer
+  // reachable.
+  auto *top = graph.lookup(StringAttr::get(&context, "Top"));
+  (*top->begin())->erase();
+  postOrder = graph.getPostOrder();
+  ASSERT_EQ(3u, postOrder.size());
+  ASSERT_EQ("Cat", postOrder[0]->getModule().getModuleName());
+  ASSERT_EQ("Top", postOrder[1]->getModule().getModuleName());
+  ASSERT_EQ(graph.getTopLevelNode(), postOrder[2]);
+  ASSERT_EQ(3u, graph.getLevels().size());
+
+  // The storage of erased nodes and records is reused.
+  auto *alligator = graph.lookup(StringAttr::get(&context, "Alligator"));
+  auto alligatorModule = alligator->getModule();
+  auto *bearRecord = *alligator->begin();
+  auto bearInstance = bearRecord->getInstance();
+  auto *bear = bearRecord->getTarget();
+  graph.erase(alligator);
+  ASSERT_EQ(alligator, graph.addModule(alligatorModule));
+  ASSERT_EQ(bearRecord, alligator->addInstance(bearInstance, bear));
+  ASSERT_EQ(3u, graph.getPostOrder().size());
+}
+
 } // namespace
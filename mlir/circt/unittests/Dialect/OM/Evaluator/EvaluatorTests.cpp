@@ -613,4 +613,122 @@ TEST(EvaluatorTests, InstantiateCycle) {
   ASSERT_TRUE(failed(result));
 }
 
+TEST(EvaluatorTests, InstantiateSharedInstances) {
+  StringRef module = "!ty = !om.class.type<@Leaf>"
+                     "om.class @Leaf(%x: !om.string) {"
+                     "  %list = om.list_create %x : !om.string"
+                     "  om.class.field @list, %list : !om.list<!om.string>"
+                     "}"
+                     "om.class @Top() {"
+                     "  %a = om.constant \"a\" : !om.string"
+                     "  %a2 = om.constant \"a\" : !om.string"
+                     "  %b = om.constant \"b\" : !om.string"
+                     "  %0 = om.object @Leaf(%a) : (!om.string) -> !ty"
+                     "  %1 = om.object @Leaf(%a2) : (!om.string) -> !ty"
+                     "  %2 = om.object @Leaf(%b) : (!om.string) -> !ty"
+                     "  om.class.field @field0, %0 : !ty"
+                     "  om.class.field @field1, %1 : !ty"
+                     "  om.class.field @field2, %2 : !ty"
+                     "}";
+
+  DialectRegistry registry;
+  registry.insert<OMDialect>();
+
+  MLIRContext context(registry);
+  context.getOrLoadDialect<OMDialect>();
+
+  OwningOpRef<ModuleOp> owning =
+      parseSourceString<ModuleOp>(module, ParserConfig(&context));
+
+  for (bool memoize : {true, false}) {
+    Evaluator evaluator(owning.get(), memoize);
+
+    auto result = evaluator.instantiate(StringAttr::get(&context, "Top"), {});
+
+    ASSERT_TRUE(succeeded(result));
+
+    auto getLeaf = [&](StringRef name) {
+      return llvm::cast<evaluator::ObjectValue>(
+          llvm::cast<evaluator::ObjectValue>(result.value().get())
+              ->getField(name)
+              .value()
+              .get());
+    };
+    auto getList = [&](StringRef name) {
+      return llvm::cast<evaluator::ListValue>(
+          getLeaf(name)->getField("list").value().get());
+    };
+
+    // Every instance is a distinct object.
+    ASSERT_NE(getLeaf("field0"), getLeaf("field1"));
+    ASSERT_NE(getLeaf("field0"), getLeaf("field2"));
+
+    // The class body is only shared between instances with equal parameters.
+    ASSERT_EQ(memoize, getList("field0") == getList("field1"));
+    ASSERT_NE(getList("field0"), getList("field2"));
+
+    ASSERT_EQ("a", llvm::cast<evaluator::AttributeValue>(
+                       getList("field1")->getElements()[0].get())
+                       ->getAs<StringAttr>()
+                       .getValue());
+    ASSERT_EQ("b", llvm::cast<evaluator::AttributeValue>(
+                       getList("field2")->getElements()[0].get())
+                       ->getAs<StringAttr>()
+                       .getValue());
+  }
+}
+
+TEST(EvaluatorTests, InstantiateSharedInstancesByValue) {
+  StringRef module =
+      "om.class @Leaf(%l: !om.list<!om.string>) {"
+      "  %list = om.list_create %l : !om.list<!om.string>"
+      "  om.class.field @list, %list : !om.list<!om.list<!om.string>>"
+      "}";
+
+  DialectRegistry registry;
+  registry.insert<OMDialect>();
+
+  MLIRContext context(registry);
+  context.getOrLoadDialect<OMDialect>();
+
+  OwningOpRef<ModuleOp> owning =
+      parseSourceString<ModuleOp>(module, ParserConfig(&context));
+
+  // Build a fresh list of strings, so that equal parameters never share a
+  // pointer.
+  auto loc = UnknownLoc::get(&context);
+  auto stringType = StringType::get(&context);
+  auto makeList = [&](StringRef str) -> evaluator::EvaluatorValuePtr {
+    SmallVector<evaluator::EvaluatorValuePtr> elements = {
+        std::make_shared<evaluator::AttributeValue>(
+            StringAttr::get(str, stringType))};
+    return std::make_shared<evaluator::ListValue>(
+        ListType::get(&context, stringType), std::move(elements), loc);
+  };
+
+  Evaluator evaluator(owning.get());
+
+  auto instantiate = [&](StringRef str) {
+    auto result =
+        evaluator.instantiate(StringAttr::get(&context, "Leaf"), makeList(str));
+    EXPECT_TRUE(succeeded(result));
+    return result.value();
+  };
+  auto a0 = instantiate("a");
+  auto a1 = instantiate("a");
+  auto b = instantiate("b");
+
+  auto getList = [&](const evaluator::EvaluatorValuePtr &leaf) {
+    return llvm::cast<evaluator::ObjectValue>(leaf.get())
+        ->getField("list")
+        .value()
+        .get();
+  };
+
+  // Instances whose parameters are equal lists share the class body.
+  ASSERT_NE(a0, a1);
+  ASSERT_EQ(getList(a0), getList(a1));
+  ASSERT_NE(getList(a0), getList(b));
+}
+
 } // namespace
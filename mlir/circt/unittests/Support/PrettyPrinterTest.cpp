@@ -445,6 +445,61 @@ TEST(PrettyPrinterTest, LargeStreamScan) {
   ps << PP::end;
 }
 
+TEST(PrettyPrinterTest, LookaheadLimit) {
+  SmallVector<Token> tokens;
+  BufferingPP buffer(tokens);
+  TokenBuilder<BufferingPP> b(buffer);
+  b.literal("foo(");
+  b.cbox();
+  auto args = {"int a", "int b", "int c", "int d", "int e", "int f"};
+  llvm::interleave(
+      args, [&](auto *arg) { b.literal(arg); },
+      [&]() {
+        b.literal(",");
+        b.space();
+      });
+  b.literal(");");
+  b.end();
+
+  auto print = [&](uint32_t margin, uint32_t lookaheadLimit) {
+    std::string out;
+    raw_string_ostream os(out);
+    PrettyPrinter pp(os, margin);
+    pp.setLookaheadLimit(lookaheadLimit);
+    pp.addTokens(tokens);
+    pp.eof();
+    return out;
+  };
+
+  // A limit above the number of tokens of the group doesn't change a thing.
+  for (auto margin : {20, 40, 2048})
+    EXPECT_EQ(print(margin, 32), print(margin, 0));
+
+  // A lower limit breaks the group even though it would fit.
+  EXPECT_EQ(print(2048, 32), "foo(int a, int b, int c, int d, int e, int f);");
+  EXPECT_EQ(print(2048, 8),
+            "foo(int a,\n    int b,\n    int c,\n    int d,\n    int e,\n"
+            "    int f);");
+}
+
+TEST(PrettyPrinterTest, LargeStreamZeroWidth) {
+  SmallString<16> out;
+  raw_svector_ostream os(out);
+  PrettyPrinter pp(os, 20);
+  pp.setLookaheadLimit(1024);
+  TokenStringSaver saver;
+  TokenStream<> ps(pp, saver);
+
+  // Zero-width tokens don't bring the buffer any closer to the margin.
+  ps << PP::ibox0;
+  for (uint32_t i = 1U << 16; i; --i)
+    ps << PP::ibox0 << PP::end;
+  ps << "x" << PP::end << PP::eof;
+  EXPECT_EQ(out.str(), "x");
+  EXPECT_EQ(pp.getNumTokens(), (1U << 17) + 3);
+  EXPECT_LE(pp.getPeakLookahead(), 1024U);
+}
+
 TEST(PrettyPrinterTest, IndentStyle) {
   SmallString<128> out;
   raw_svector_ostream os(out);
@@ -1033,4 +1088,21 @@ TEST_F(TokenStreamCompareTest, Numeric) {
   test(1. / 3.);
 }
 
+TEST(PrettyPrinterTest, RingBufferPushOwnElement) {
+  // Pushing one of the buffer's own elements when it is full must not read
+  // the element after growing has freed it.
+  detail::RingBuffer<std::string> buffer;
+  buffer.push_back(std::string(32, 'a'));
+  while (buffer.size() < buffer.capacity())
+    buffer.push_back(std::string(32, 'b'));
+  buffer.pop_front();
+  buffer.push_back(buffer.back());
+  buffer.push_back(buffer.front());
+  EXPECT_EQ(buffer.size(), 17U);
+  EXPECT_EQ(buffer.capacity(), 32U);
+  EXPECT_EQ(buffer.back(), std::string(32, 'b'));
+  for (size_t i = 0, e = buffer.size(); i != e; ++i)
+    EXPECT_EQ(buffer[i], std::string(32, 'b'));
+}
+
 } // end anonymous namespace
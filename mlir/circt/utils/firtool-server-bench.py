@@ -0,0 +1,99 @@
+#!/usr/bin/env python3
+##===- utils/firtool-server-bench.py ------------------------ *- Python -*-===##
+#
+# Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+# See https://llvm.org/LICENSE.txt for license information.
+# SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+#
+##===----------------------------------------------------------------------===##
+#
+# This script compares the throughput of compiling a set of inputs with
+# separate firtool processes against forwarding the same compiles to a
+# `firtool --serve` compile server. It also checks that both produce identical
+# output and exit codes.
+#
+# Usage: firtool-server-bench.py [--firtool PATH] [-j N] [-n N] INPUT...
+#            [-- FIRTOOL-ARGS...]
+#
+##===----------------------------------------------------------------------===##
+
+import argparse
+import os
+import subprocess
+import sys
+import tempfile
+import time
+from concurrent.futures import ThreadPoolExecutor
+
+parser = argparse.ArgumentParser(
+    description="Benchmark firtool invocations against a firtool server")
+parser.add_argument("inputs", metavar="INPUT", nargs="+", help="input files")
+parser.add_argument("--firtool", default="firtool", help="firtool binary")
+parser.add_argument("-j",
+                    dest="jobs",
+                    type=int,
+                    default=1,
+                    help="number of compiles to run concurrently")
+parser.add_argument("-n",
+                    dest="repeat",
+                    type=int,
+                    default=10,
+                    help="number of times to compile each input")
+argv = sys.argv[1:]
+firtool_args = []
+if "--" in argv:
+  firtool_args = argv[argv.index("--") + 1:]
+  argv = argv[:argv.index("--")]
+args = parser.parse_args(argv)
+
+
+def compile_all(prefix):
+  """Compile every input `repeat` times and return the elapsed time and the
+  results of the first round."""
+
+  def run(input):
+    result = subprocess.run(prefix + [input] + firtool_args,
+                            stdin=subprocess.DEVNULL,
+                            stdout=subprocess.PIPE,
+                            stderr=subprocess.PIPE)
+    return result.returncode, result.stdout, result.stderr
+
+  work = args.inputs * args.repeat
+  start = time.perf_counter()
+  with ThreadPoolExecutor(max_workers=args.jobs) as pool:
+    results = list(pool.map(run, work))
+  return time.perf_counter() - start, results[:len(args.inputs)]
+
+
+with tempfile.TemporaryDirectory() as tmp:
+  socket = os.path.join(tmp, "firtool.sock")
+  server = subprocess.Popen([args.firtool, f"--serve={socket}"],
+                            stderr=subprocess.DEVNULL)
+  try:
+    deadline = time.monotonic() + 30
+    while not os.path.exists(socket):
+      if server.poll() is not None or time.monotonic() > deadline:
+        sys.exit("error: firtool server failed to start")
+      time.sleep(0.01)
+
+    local_time, local_results = compile_all([args.firtool])
+    server_time, server_results = compile_all(
+        [args.firtool, f"--connect={socket}"])
+  finally:
+    server.terminate()
+    server.wait()
+
+num_compiles = len(args.inputs) * args.repeat
+for name, elapsed in [("firtool", local_time),
+                      ("firtool --serve", server_time)]:
+  print(f"{name:16} {num_compiles} compiles in {elapsed:.3f} s "
+        f"({num_compiles / elapsed:.1f} compiles/s)")
+print(f"speedup          {local_time / server_time:.2f}x")
+
+mismatches = [
+    input for input, local, served in zip(args.inputs, local_results,
+                                          server_results) if local != served
+]
+for input in mismatches:
+  print(f"error: output mismatch for {input}", file=sys.stderr)
+sys.exit(1 if mismatches else 0)
@@ -0,0 +1,178 @@
+#pragma once
+
+#include <llvm/ADT/SmallPtrSet.h>
+#include <mlir/IR/Builders.h>
+#include <mlir/IR/BuiltinOps.h>
+#include <mlir/IR/MLIRContext.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace swift_hdl {
+
+/**
+ An index into the name table of a `BulkBuilder`.
+ - note: `0` is reserved for "no name".
+ */
+using NameID = uint32_t;
+
+/**
+ An index into the value table of the module currently being built by a
+ `BulkBuilder`. Input ports are numbered first, in order, followed by the
+ results of instructions in the order they were appended.
+ */
+using ValueID = uint32_t;
+
+/**
+ The operations a `BulkInstruction` can create.
+ */
+enum class BulkOpcode : uint8_t {
+  /// `hw.constant` of `width` bits with the value `immediate`.
+  Constant,
+  /// Binary `comb` operations on `operands[0]` and `operands[1]`.
+  Add,
+  Sub,
+  Mul,
+  And,
+  Or,
+  Xor,
+  Shl,
+  ShrU,
+  /// `comb.icmp` of `operands[0]` and `operands[1]`, producing an `i1`.
+  ICmpEq,
+  ICmpNe,
+  ICmpULT,
+  /// `comb.mux` selecting `operands[1]` if `operands[0]` is set, and
+  /// `operands[2]` otherwise.
+  Mux,
+  /// `comb.concat` of `operands[0]` (high bits) and `operands[1]`.
+  Concat,
+  /// `comb.extract` of `width` bits of `operands[0]`, starting at bit
+  /// `immediate`.
+  Extract,
+  /// `seq.compreg` of `width` bits clocked by `operands[0]`. Its input is set
+  /// later with `RegisterNext`, which allows registers to feed back into the
+  /// logic driving them.
+  Register,
+  /// Set the input of the register `operands[0]` to `operands[1]`. This
+  /// instruction does not produce a value.
+  RegisterNext,
+};
+
+/**
+ A single operation to create, laid out so that Swift can fill in a contiguous
+ buffer of instructions without allocating per operation.
+ */
+struct BulkInstruction {
+  BulkOpcode opcode;
+  /// The bit width of the result, where the opcode does not imply it.
+  uint32_t width;
+  ValueID operands[3];
+  /// The name of the result, or `0` for none.
+  NameID name;
+  uint64_t immediate;
+};
+
+/**
+ A port of a module created by a `BulkBuilder`.
+ */
+struct BulkPort {
+  NameID name;
+  uint32_t width;
+  bool isOutput;
+  /// Whether this is a `!seq.clock` port, in which case `width` is ignored.
+  bool isClock;
+};
+
+/**
+ Builds HW, Comb, and Seq operations in bulk from buffers of
+ `BulkInstruction`s.
+
+ Names are interned once into a table and referred to by index afterwards, and
+ integer types are cached per width, so creating an operation involves no
+ bridging of strings and no hashing of names or types.
+ - note: `BulkBuilder` is immovable, so it is created and destroyed through
+ static methods which Swift can call.
+ */
+class BulkBuilder {
+public:
+  static BulkBuilder *
+  create(mlir::MLIRContext *context); // NOLINT: readibility-identifier-naming
+  static void destroy(BulkBuilder *builder);
+
+  /// Intern a name, returning its index in the name table.
+  NameID internName(const char *data, size_t length);
+
+  /// Intern `count` names stored back to back in `data`, where name `i` spans
+  /// `[offsets[i], offsets[i + 1])`. The resulting indices are written to
+  /// `result`, which must have room for `count` elements.
+  void internNames(const char *data, const uint32_t *offsets, size_t count,
+                   NameID *result);
+
+  /// Begin a new `hw.module`. The input ports are assigned the first value
+  /// IDs, in order.
+  bool beginModule(NameID name, const BulkPort *ports, size_t count);
+
+  /// Append operations to the module being built. Returns `false` at the first
+  /// malformed instruction, in which case none of the instructions are applied.
+  bool append(const BulkInstruction *instructions, size_t count);
+
+  /// Finish the module being built, driving its output ports with the
+  /// specified values. Returns `false` and emits an error, leaving the module
+  /// open, if the values don't match the output ports or a register was never
+  /// given its next value.
+  bool endModule(const ValueID *outputs, size_t count);
+
+  /// The number of values in the module being built, which is the ID the next
+  /// value-producing instruction will be assigned.
+  size_t getNumValues() const { return values.size(); }
+
+  /// The number of operations created so far, across all modules, including
+  /// the placeholder inputs of registers.
+  size_t getNumOperations() const { return numOperations; }
+
+  mlir::ModuleOp getModule() { return *module; }
+
+  /// Print the modules built so far.
+  std::string print();
+
+  BulkBuilder(const BulkBuilder &) = delete;
+  void operator=(const BulkBuilder &) = delete;
+
+private:
+  explicit BulkBuilder(mlir::MLIRContext *context);
+
+  mlir::Type getIntegerType(uint32_t width);
+  mlir::Value getValue(ValueID id);
+  bool appendOne(const BulkInstruction &instruction);
+  void rollBack(size_t numValues);
+
+  mlir::MLIRContext *context;
+  mlir::OwningOpRef<mlir::ModuleOp> module;
+  mlir::OpBuilder builder;
+  mlir::Location loc;
+
+  /// Interned names, indexed by `NameID`. Entry 0 is the null attribute.
+  std::vector<mlir::StringAttr> names;
+  /// Integer types, indexed by width.
+  std::vector<mlir::Type> integerTypes;
+  mlir::Type clockType;
+  mlir::StringAttr nameHintAttr;
+
+  /// The values of the module being built, indexed by `ValueID`.
+  std::vector<mlir::Value> values;
+  /// The constants standing in for the inputs of registers whose
+  /// `RegisterNext` has not been appended yet.
+  llvm::SmallPtrSet<mlir::Operation *, 8> registerPlaceholders;
+  /// The operations created by the `append` in progress, and the registers
+  /// whose input it set along with their previous inputs, such that a failed
+  /// `append` can be rolled back.
+  std::vector<mlir::Operation *> appendedOps;
+  std::vector<std::pair<mlir::Operation *, mlir::Value>> appendedNexts;
+  mlir::Operation *currentModule = nullptr;
+  size_t numOperations = 0;
+};
+
+} // namespace swift_hdl
@@ -5,3 +5,4 @@
 
 // Includes
 #include <circt/Firtool/Firtool.h>
+#include <swift-hdl/BulkBuilder.h>
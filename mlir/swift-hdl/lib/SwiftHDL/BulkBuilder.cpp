@@ -0,0 +1,325 @@
+#include "swift-hdl/BulkBuilder.h"
+
+#include <circt/Dialect/Comb/CombOps.h>
+#include <circt/Dialect/HW/HWOps.h>
+#include <circt/Dialect/Seq/SeqOps.h>
+#include <circt/Dialect/Seq/SeqTypes.h>
+#include <llvm/ADT/STLExtras.h>
+#include <llvm/ADT/StringRef.h>
+#include <llvm/Support/raw_ostream.h>
+
+using namespace mlir;
+using namespace circt;
+using namespace swift_hdl;
+
+BulkBuilder *BulkBuilder::create(MLIRContext *context) {
+  return new BulkBuilder(context);
+}
+
+void BulkBuilder::destroy(BulkBuilder *builder) { delete builder; }
+
+BulkBuilder::BulkBuilder(MLIRContext *context)
+    : context(context), builder(context), loc(UnknownLoc::get(context)) {
+  context->loadDialect<hw::HWDialect, comb::CombDialect, seq::SeqDialect>();
+  module = ModuleOp::create(loc);
+  names.push_back({});
+  clockType = seq::ClockType::get(context);
+  nameHintAttr = StringAttr::get(context, "sv.namehint");
+}
+
+NameID BulkBuilder::internName(const char *data, size_t length) {
+  names.push_back(StringAttr::get(context, llvm::StringRef(data, length)));
+  return names.size() - 1;
+}
+
+void BulkBuilder::internNames(const char *data, const uint32_t *offsets,
+                              size_t count, NameID *result) {
+  names.reserve(names.size() + count);
+  for (size_t i = 0; i < count; ++i)
+    result[i] = internName(data + offsets[i], offsets[i + 1] - offsets[i]);
+}
+
+Type BulkBuilder::getIntegerType(uint32_t width) {
+  if (width >= integerTypes.size())
+    integerTypes.resize(width + 1);
+  auto &type = integerTypes[width];
+  if (!type)
+    type = builder.getIntegerType(width);
+  return type;
+}
+
+Value BulkBuilder::getValue(ValueID id) {
+  if (id >= values.size())
+    return {};
+  return values[id];
+}
+
+bool BulkBuilder::beginModule(NameID name, const BulkPort *ports,
+                              size_t count) {
+  if (currentModule || name == 0 || name >= names.size())
+    return false;
+
+  SmallVector<hw::PortInfo> portInfos;
+  portInfos.reserve(count);
+  size_t numInputs = 0, numOutputs = 0;
+  for (const auto &port : llvm::ArrayRef(ports, count)) {
+    if (port.name == 0 || port.name >= names.size())
+      return false;
+    hw::PortInfo info;
+    info.name = names[port.name];
+    info.type = port.isClock ? clockType : getIntegerType(port.width);
+    info.dir = port.isOutput ? hw::ModulePort::Direction::Output
+                             : hw::ModulePort::Direction::Input;
+    info.argNum = port.isOutput ? numOutputs++ : numInputs++;
+    portInfos.push_back(info);
+  }
+
+  builder.setInsertionPointToEnd(module->getBody());
+  auto hwModule = builder.create<hw::HWModuleOp>(loc, names[name], portInfos);
+  currentModule = hwModule;
+  ++numOperations;
+
+  values.clear();
+  auto *body = hwModule.getBodyBlock();
+  values.assign(body->args_begin(), body->args_end());
+  builder.setInsertionPoint(body->getTerminator());
+  return true;
+}
+
+bool BulkBuilder::append(const BulkInstruction *instructions, size_t count) {
+  if (!currentModule)
+    return false;
+  size_t numValues = values.size();
+  values.reserve(numValues + count);
+  for (const auto &instruction : llvm::ArrayRef(instructions, count)) {
+    if (!appendOne(instruction)) {
+      rollBack(numValues);
+      return false;
+    }
+  }
+
+  // Drop the placeholder inputs of the registers whose input is now set.
+  for (auto [reg, input] : appendedNexts)
+    if (auto *placeholder = input.getDefiningOp();
+        registerPlaceholders.erase(placeholder))
+      placeholder->erase();
+  numOperations += appendedOps.size();
+  appendedOps.clear();
+  appendedNexts.clear();
+  return true;
+}
+
+void BulkBuilder::rollBack(size_t numValues) {
+  for (auto [reg, input] : llvm::reverse(appendedNexts))
+    cast<seq::CompRegOp>(reg).getInputMutable().assign(input);
+  for (auto *op : llvm::reverse(appendedOps)) {
+    registerPlaceholders.erase(op);
+    op->erase();
+  }
+  appendedOps.clear();
+  appendedNexts.clear();
+  values.resize(numValues);
+}
+
+/// Whether `lhs` and `rhs` are integers of the same width.
+static bool areSameIntegers(Value lhs, Value rhs) {
+  return lhs && rhs && isa<IntegerType>(lhs.getType()) &&
+         lhs.getType() == rhs.getType();
+}
+
+bool BulkBuilder::appendOne(const BulkInstruction &instruction) {
+  auto lhs = getValue(instruction.operands[0]);
+  auto rhs = getValue(instruction.operands[1]);
+  if (instruction.opcode > BulkOpcode::RegisterNext ||
+      instruction.name >= names.size())
+    return false;
+
+  // Check the instruction before creating anything.
+  switch (instruction.opcode) {
+  case BulkOpcode::Constant:
+    if (instruction.width == 0 ||
+        (instruction.width < 64 && instruction.immediate >> instruction.width))
+      return false;
+    break;
+  case BulkOpcode::Add:
+  case BulkOpcode::Sub:
+  case BulkOpcode::Mul:
+  case BulkOpcode::And:
+  case BulkOpcode::Or:
+  case BulkOpcode::Xor:
+  case BulkOpcode::Shl:
+  case BulkOpcode::ShrU:
+  case BulkOpcode::ICmpEq:
+  case BulkOpcode::ICmpNe:
+  case BulkOpcode::ICmpULT:
+    if (!areSameIntegers(lhs, rhs))
+      return false;
+    break;
+  case BulkOpcode::Mux:
+    if (!lhs || lhs.getType() != getIntegerType(1) ||
+        !areSameIntegers(rhs, getValue(instruction.operands[2])))
+      return false;
+    break;
+  case BulkOpcode::Concat:
+    if (!lhs || !rhs || !isa<IntegerType>(lhs.getType()) ||
+        !isa<IntegerType>(rhs.getType()))
+      return false;
+    break;
+  case BulkOpcode::Extract: {
+    auto type = lhs ? dyn_cast<IntegerType>(lhs.getType()) : IntegerType();
+    if (!type || instruction.width == 0 ||
+        instruction.immediate > type.getWidth() ||
+        instruction.width > type.getWidth() - instruction.immediate)
+      return false;
+    break;
+  }
+  case BulkOpcode::Register:
+    if (!lhs || lhs.getType() != clockType || instruction.width == 0 ||
+        instruction.name == 0)
+      return false;
+    break;
+  case BulkOpcode::RegisterNext: {
+    auto reg = lhs ? lhs.getDefiningOp<seq::CompRegOp>() : seq::CompRegOp();
+    if (!reg || !rhs || rhs.getType() != reg.getType())
+      return false;
+    break;
+  }
+  }
+
+  Operation *op = nullptr;
+  switch (instruction.opcode) {
+  case BulkOpcode::Constant:
+    op = builder.create<hw::ConstantOp>(
+        loc, APInt(instruction.width, instruction.immediate));
+    break;
+  case BulkOpcode::Add:
+    op = builder.create<comb::AddOp>(loc, lhs, rhs, /*twoState=*/false);
+    break;
+  case BulkOpcode::Sub:
+    op = builder.create<comb::SubOp>(loc, lhs, rhs, /*twoState=*/false);
+    break;
+  case BulkOpcode::Mul:
+    op = builder.create<comb::MulOp>(loc, lhs, rhs, /*twoState=*/false);
+    break;
+  case BulkOpcode::And:
+    op = builder.create<comb::AndOp>(loc, lhs, rhs, /*twoState=*/false);
+    break;
+  case BulkOpcode::Or:
+    op = builder.create<comb::OrOp>(loc, lhs, rhs, /*twoState=*/false);
+    break;
+  case BulkOpcode::Xor:
+    op = builder.create<comb::XorOp>(loc, lhs, rhs, /*twoState=*/false);
+    break;
+  case BulkOpcode::Shl:
+    op = builder.create<comb::ShlOp>(loc, lhs, rhs, /*twoState=*/false);
+    break;
+  case BulkOpcode::ShrU:
+    op = builder.create<comb::ShrUOp>(loc, lhs, rhs, /*twoState=*/false);
+    break;
+  case BulkOpcode::ICmpEq:
+  case BulkOpcode::ICmpNe:
+  case BulkOpcode::ICmpULT: {
+    auto predicate = instruction.opcode == BulkOpcode::ICmpEq
+                         ? comb::ICmpPredicate::eq
+                     : instruction.opcode == BulkOpcode::ICmpNe
+                         ? comb::ICmpPredicate::ne
+                         : comb::ICmpPredicate::ult;
+    op = builder.create<comb::ICmpOp>(loc, predicate, lhs, rhs,
+                                      /*twoState=*/false);
+    break;
+  }
+  case BulkOpcode::Mux:
+    op = builder.create<comb::MuxOp>(loc, lhs, rhs,
+                                     getValue(instruction.operands[2]),
+                                     /*twoState=*/false);
+    break;
+  case BulkOpcode::Concat:
+    op = builder.create<comb::ConcatOp>(loc, lhs, rhs);
+    break;
+  case BulkOpcode::Extract:
+    op = builder.create<comb::ExtractOp>(loc, lhs, instruction.immediate,
+                                         instruction.width);
+    break;
+  case BulkOpcode::Register: {
+    // The input is replaced by a later `RegisterNext`.
+    auto placeholder = builder.create<hw::ConstantOp>(
+        loc, APInt(instruction.width, 0));
+    registerPlaceholders.insert(placeholder);
+    appendedOps.push_back(placeholder);
+    op = builder.create<seq::CompRegOp>(loc, placeholder, lhs,
+                                        names[instruction.name]);
+    appendedOps.push_back(op);
+    values.push_back(op->getResult(0));
+    return true;
+  }
+  case BulkOpcode::RegisterNext: {
+    // The previous input is dropped once the whole `append` succeeded.
+    auto reg = lhs.getDefiningOp<seq::CompRegOp>();
+    appendedNexts.emplace_back(reg, reg.getInput());
+    reg.getInputMutable().assign(rhs);
+    return true;
+  }
+  }
+  appendedOps.push_back(op);
+
+  if (instruction.name != 0)
+    op->setAttr(nameHintAttr, names[instruction.name]);
+  values.push_back(op->getResult(0));
+  return true;
+}
+
+bool BulkBuilder::endModule(const ValueID *outputs, size_t count) {
+  if (!currentModule)
+    return false;
+  auto hwModule = cast<hw::HWModuleOp>(currentModule);
+
+  // Every register must have been given its input.
+  for (auto *placeholder : registerPlaceholders) {
+    auto reg = cast<seq::CompRegOp>(*placeholder->user_begin());
+    mlir::emitError(reg.getLoc())
+        << "register " << reg.getNameAttr() << " in module "
+        << hwModule.getModuleNameAttr() << " has no next value";
+    return false;
+  }
+
+  auto outputTypes = hwModule.getOutputTypes();
+  if (count != outputTypes.size()) {
+    mlir::emitError(hwModule.getLoc())
+        << "module " << hwModule.getModuleNameAttr() << " expects "
+        << outputTypes.size() << " output values, but got " << count;
+    return false;
+  }
+  SmallVector<Value> outputValues;
+  outputValues.reserve(count);
+  for (auto [index, id] : llvm::enumerate(llvm::ArrayRef(outputs, count))) {
+    auto value = getValue(id);
+    if (!value) {
+      mlir::emitError(hwModule.getLoc())
+          << "output " << index << " of module "
+          << hwModule.getModuleNameAttr() << " is driven by unknown value "
+          << id;
+      return false;
+    }
+    if (value.getType() != outputTypes[index]) {
+      mlir::emitError(hwModule.getLoc())
+          << "output " << index << " of module "
+          << hwModule.getModuleNameAttr() << " has type "
+          << outputTypes[index] << ", but is driven by a value of type "
+          << value.getType();
+      return false;
+    }
+    outputValues.push_back(value);
+  }
+  hwModule.getBodyBlock()->getTerminator()->setOperands(outputValues);
+  currentModule = nullptr;
+  values.clear();
+  registerPlaceholders.clear();
+  return true;
+}
+
+std::string BulkBuilder::print() {
+  std::string result;
+  llvm::raw_string_ostream os(result);
+  module->print(os);
+  return os.str();
+}
@@ -0,0 +1,136 @@
+// RUN: swift-hdl-bulk-builder-test 2>&1 | FileCheck %s
+
+#include <llvm/Support/raw_ostream.h>
+#include <mlir/IR/MLIRContext.h>
+#include <swift-hdl/BulkBuilder.h>
+
+#include <cstdint>
+#include <iterator>
+#include <utility>
+
+using namespace mlir;
+using namespace swift_hdl;
+
+int main() {
+  // CHECK-LABEL: @bulkBuilderTest
+  llvm::errs() << "@bulkBuilderTest\n";
+
+  auto context = MLIRContext();
+  auto *builder = BulkBuilder::create(&context);
+
+  // Intern all names in one go, as Swift would from a single buffer.
+  const char *names = "Counterclockenablecountnext";
+  uint32_t offsets[] = {0, 7, 12, 18, 23, 27};
+  NameID ids[5];
+  builder->internNames(names, offsets, 5, ids);
+  auto [counter, clock, enable, count, next] = ids;
+
+  // CHECK: hw.module @Counter(in %clock : !seq.clock, in %enable : i1, out count : i8) {
+  BulkPort ports[] = {{clock, 0, false, true},
+                      {enable, 1, false, false},
+                      {count, 8, true, false}};
+  if (!builder->beginModule(counter, ports, 3))
+    return 1;
+
+  // The placeholder input of the register is gone once its input is set.
+  // CHECK-NEXT: %c1_i8 = hw.constant 1 : i8
+  // CHECK-NEXT: %count = seq.compreg %[[MUX:.+]], %clock : i8
+  // CHECK-NEXT: %[[NEXT:.+]] = comb.add %count, %c1_i8 {sv.namehint = "next"} : i8
+  // CHECK-NEXT: %[[MUX]] = comb.mux %enable, %[[NEXT]], %count : i8
+  // CHECK-NEXT: hw.output %count : i8
+  BulkInstruction instructions[] = {
+      {BulkOpcode::Constant, 8, {}, 0, 1},
+      {BulkOpcode::Register, 8, {0}, count, 0},
+      {BulkOpcode::Add, 8, {3, 2}, next, 0},
+      {BulkOpcode::Mux, 8, {1, 4, 3}, 0, 0},
+      {BulkOpcode::RegisterNext, 0, {3, 5}, 0, 0},
+  };
+  if (!builder->append(instructions, std::size(instructions)))
+    return 1;
+  ValueID output = 3;
+  if (!builder->endModule(&output, 1))
+    return 1;
+  llvm::errs() << builder->print();
+
+  // The register counts its placeholder input, which has been erased since.
+  // CHECK: operations: 6
+  llvm::errs() << "operations: " << builder->getNumOperations() << "\n";
+
+  // Malformed instructions are rejected before creating any operation.
+  // CHECK-NEXT: unknown value: rejected
+  // CHECK-NEXT: width mismatch: rejected
+  // CHECK-NEXT: extract out of range: rejected
+  // CHECK-NEXT: extract offset overflow: rejected
+  // CHECK-NEXT: zero-width constant: rejected
+  // CHECK-NEXT: constant out of range: rejected
+  NameID invalid = builder->internName("Invalid", 7);
+  BulkPort invalidPorts[] = {{enable, 1, false, false},
+                             {count, 8, false, false}};
+  if (!builder->beginModule(invalid, invalidPorts, 2))
+    return 1;
+  std::pair<const char *, BulkInstruction> malformed[] = {
+      {"unknown value", {BulkOpcode::Add, 8, {42, 0}, 0, 0}},
+      {"width mismatch", {BulkOpcode::Add, 8, {0, 1}, 0, 0}},
+      {"extract out of range", {BulkOpcode::Extract, 4, {1}, 0, 6}},
+      {"extract offset overflow",
+       {BulkOpcode::Extract, 4, {1}, 0, UINT64_MAX - 1}},
+      {"zero-width constant", {BulkOpcode::Constant, 0, {}, 0, 0}},
+      {"constant out of range", {BulkOpcode::Constant, 4, {}, 0, 16}},
+  };
+  for (auto &[what, instruction] : malformed)
+    llvm::errs() << what << ": "
+                 << (builder->append(&instruction, 1) ? "accepted"
+                                                      : "rejected")
+                 << "\n";
+
+  // A rejected batch leaves none of its operations behind.
+  // CHECK-NEXT: batch: rejected, 2 values
+  // CHECK: hw.module @Invalid(in %enable : i1, in %count : i8) {
+  // CHECK-NEXT: hw.output
+  // CHECK-NEXT: }
+  // CHECK: operations: 7
+  BulkInstruction batch[] = {
+      {BulkOpcode::Constant, 8, {}, 0, 1},
+      {BulkOpcode::Add, 8, {1, 2}, 0, 0},
+      {BulkOpcode::Add, 8, {0, 3}, 0, 0},
+  };
+  llvm::errs() << "batch: "
+               << (builder->append(batch, std::size(batch)) ? "accepted"
+                                                            : "rejected")
+               << ", " << builder->getNumValues() << " values\n";
+  if (!builder->endModule(nullptr, 0))
+    return 1;
+  llvm::errs() << builder->print();
+  llvm::errs() << "operations: " << builder->getNumOperations() << "\n";
+
+  // Modules are only finished once their registers and outputs are complete.
+  // CHECK: error: register "count" in module "Pending" has no next value
+  // CHECK-NEXT: missing next: rejected
+  // CHECK-NEXT: error: module "Pending" expects 1 output values, but got 0
+  // CHECK-NEXT: output count: rejected
+  // CHECK-NEXT: error: output 0 of module "Pending" has type i8, but is driven by a value of type !seq.clock
+  // CHECK-NEXT: output type: rejected
+  // CHECK-NEXT: complete: accepted
+  NameID pending = builder->internName("Pending", 7);
+  BulkPort pendingPorts[] = {{clock, 0, false, true}, {count, 8, true, false}};
+  if (!builder->beginModule(pending, pendingPorts, 2))
+    return 1;
+  BulkInstruction reg = {BulkOpcode::Register, 8, {0}, count, 0};
+  if (!builder->append(&reg, 1))
+    return 1;
+  ValueID regValue = 1, clockValue = 0;
+  auto report = [&](const char *what, bool accepted) {
+    llvm::errs() << what << ": " << (accepted ? "accepted" : "rejected")
+                 << "\n";
+  };
+  report("missing next", builder->endModule(&regValue, 1));
+  BulkInstruction regNext = {BulkOpcode::RegisterNext, 0, {1, 1}, 0, 0};
+  if (!builder->append(&regNext, 1))
+    return 1;
+  report("output count", builder->endModule(nullptr, 0));
+  report("output type", builder->endModule(&clockValue, 1));
+  report("complete", builder->endModule(&regValue, 1));
+
+  BulkBuilder::destroy(builder);
+  exit(0);
+}
@@ -0,0 +1,129 @@
+#include <circt/Dialect/Comb/CombOps.h>
+#include <circt/Dialect/HW/HWOps.h>
+#include <llvm/Support/CommandLine.h>
+#include <llvm/Support/Format.h>
+#include <llvm/Support/raw_ostream.h>
+#include <mlir/IR/BuiltinOps.h>
+#include <mlir/IR/MLIRContext.h>
+#include <swift-hdl/BulkBuilder.h>
+
+#include <chrono>
+#include <string>
+#include <vector>
+
+using namespace mlir;
+using namespace circt;
+using namespace swift_hdl;
+
+static llvm::cl::opt<unsigned>
+    numOps("num-ops", llvm::cl::desc("Number of operations to create"),
+           llvm::cl::init(1000000));
+
+static llvm::cl::opt<unsigned>
+    numRuns("num-runs", llvm::cl::desc("Number of runs of each builder"),
+            llvm::cl::init(3));
+
+/// The names of the created operations, as a generator written in Swift would
+/// hold them before handing them to the C++ side.
+struct Names {
+  std::string storage;
+  std::vector<uint32_t> offsets;
+
+  explicit Names(unsigned count) {
+    offsets.reserve(count + 1);
+    offsets.push_back(0);
+    for (unsigned i = 0; i < count; ++i) {
+      storage += "n" + std::to_string(i);
+      offsets.push_back(storage.size());
+    }
+  }
+
+  llvm::StringRef get(unsigned i) const {
+    return llvm::StringRef(storage.data() + offsets[i],
+                           offsets[i + 1] - offsets[i]);
+  }
+};
+
+/// Create a chain of additions one operation at a time, bridging each name
+/// through a `Twine` as the Swift bindings do today.
+static size_t buildPerOperation(MLIRContext &context, const Names &names) {
+  OpBuilder builder(&context);
+  auto loc = UnknownLoc::get(&context);
+  auto module = ModuleOp::create(loc);
+  builder.setInsertionPointToEnd(module.getBody());
+
+  auto i32 = builder.getIntegerType(32);
+  hw::PortInfo ports[] = {
+      {{StringAttr::get(&context, "a"), i32, hw::ModulePort::Direction::Input},
+       0},
+      {{StringAttr::get(&context, "b"), i32, hw::ModulePort::Direction::Output},
+       0}};
+  auto hwModule = builder.create<hw::HWModuleOp>(
+      loc, StringAttr::get(&context, "Bench"), ports);
+  auto *body = hwModule.getBodyBlock();
+  builder.setInsertionPoint(body->getTerminator());
+
+  Value value = body->getArgument(0);
+  for (unsigned i = 0; i < numOps; ++i) {
+    auto add = builder.create<comb::AddOp>(loc, value, body->getArgument(0),
+                                           /*twoState=*/false);
+    add->setAttr(StringAttr::get(&context, llvm::Twine("sv.namehint")),
+                 StringAttr::get(&context, llvm::Twine(names.get(i))));
+    value = add;
+  }
+  body->getTerminator()->setOperands(value);
+  module.erase();
+  return numOps;
+}
+
+/// Create the same chain of additions from a single buffer of instructions.
+static size_t buildBulk(MLIRContext &context, const Names &names) {
+  auto *builder = BulkBuilder::create(&context);
+
+  std::vector<NameID> nameIDs(numOps);
+  builder->internNames(names.storage.data(), names.offsets.data(), numOps,
+                       nameIDs.data());
+  NameID moduleName = builder->internName("Bench", 5);
+  BulkPort ports[] = {{builder->internName("a", 1), 32, false, false},
+                      {builder->internName("b", 1), 32, true, false}};
+  builder->beginModule(moduleName, ports, 2);
+
+  std::vector<BulkInstruction> instructions(numOps);
+  for (unsigned i = 0; i < numOps; ++i)
+    instructions[i] = {BulkOpcode::Add, 32, {i, 0, 0}, nameIDs[i], 0};
+  builder->append(instructions.data(), instructions.size());
+
+  ValueID output = builder->getNumValues() - 1;
+  builder->endModule(&output, 1);
+
+  BulkBuilder::destroy(builder);
+  return numOps;
+}
+
+/// Time each run in a fresh context, so that no run benefits from strings and
+/// types that an earlier run already uniqued.
+template <typename Fn>
+static void runBenchmark(llvm::StringRef name, const Names &names, Fn fn) {
+  for (unsigned run = 0; run < numRuns; ++run) {
+    MLIRContext context;
+    context.loadDialect<hw::HWDialect, comb::CombDialect>();
+    auto start = std::chrono::steady_clock::now();
+    auto ops = fn(context, names);
+    std::chrono::duration<double> elapsed =
+        std::chrono::steady_clock::now() - start;
+    llvm::outs() << name << ": " << ops << " ops in "
+                 << llvm::format("%.3f", elapsed.count()) << " s, "
+                 << llvm::format("%.0f", ops / elapsed.count()) << " ops/s\n";
+  }
+}
+
+int main(int argc, char **argv) {
+  llvm::cl::ParseCommandLineOptions(
+      argc, argv, "Measure the throughput of the SwiftHDL builders\n");
+
+  Names names(numOps);
+
+  runBenchmark("per-operation", names, buildPerOperation);
+  runBenchmark("bulk", names, buildBulk);
+  return 0;
+}